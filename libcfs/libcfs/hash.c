@@ -233,6 +233,13 @@ cfs_hash_lock_setup(struct cfs_hash *hs)
         }
 }
 
+/*
+ * Entries are linked with the _rcu list primitives, so that users which
+ * free their objects after a grace period can walk a chain of a hash that
+ * is never rehashed under rcu_read_lock(), without the bucket lock.
+ * A chain walked that way may miss entries being added or removed.
+ */
+
 /**
  * Simple hash head without depth tracking
  * new element is always added to head of hlist
@@ -260,7 +267,7 @@ static int
 cfs_hash_hh_hnode_add(struct cfs_hash *hs, struct cfs_hash_bd *bd,
 		      struct hlist_node *hnode)
 {
-	hlist_add_head(hnode, cfs_hash_hh_hhead(hs, bd));
+	hlist_add_head_rcu(hnode, cfs_hash_hh_hhead(hs, bd));
 	return -1; /* unknown depth */
 }
 
@@ -304,7 +311,7 @@ cfs_hash_hd_hnode_add(struct cfs_hash *hs, struct cfs_hash_bd *bd,
 
 	hh = container_of(cfs_hash_hd_hhead(hs, bd),
 			  struct cfs_hash_head_dep, hd_head);
-	hlist_add_head(hnode, &hh->hd_head);
+	hlist_add_head_rcu(hnode, &hh->hd_head);
 	return ++hh->hd_depth;
 }
 
@@ -353,9 +360,9 @@ cfs_hash_dh_hnode_add(struct cfs_hash *hs, struct cfs_hash_bd *bd,
 	dh = container_of(cfs_hash_dh_hhead(hs, bd),
 			  struct cfs_hash_dhead, dh_head);
 	if (dh->dh_tail != NULL) /* not empty */
-		hlist_add_behind(hnode, dh->dh_tail);
+		hlist_add_behind_rcu(hnode, dh->dh_tail);
 	else /* empty list */
-		hlist_add_head(hnode, &dh->dh_head);
+		hlist_add_head_rcu(hnode, &dh->dh_head);
 	dh->dh_tail = hnode;
 	return -1; /* unknown depth */
 }
@@ -410,9 +417,9 @@ cfs_hash_dd_hnode_add(struct cfs_hash *hs, struct cfs_hash_bd *bd,
 	dh = container_of(cfs_hash_dd_hhead(hs, bd),
 			  struct cfs_hash_dhead_dep, dd_head);
 	if (dh->dd_tail != NULL) /* not empty */
-		hlist_add_behind(hnode, dh->dd_tail);
+		hlist_add_behind_rcu(hnode, dh->dd_tail);
 	else /* empty list */
-		hlist_add_head(hnode, &dh->dd_head);
+		hlist_add_head_rcu(hnode, &dh->dd_head);
 	dh->dd_tail = hnode;
 	return ++dh->dd_depth;
 }
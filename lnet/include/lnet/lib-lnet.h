@@ -189,6 +189,7 @@ lnet_net_lock_current(void)
 extern struct kmem_cache *lnet_mes_cachep;	 /* MEs kmem_cache */
 extern struct kmem_cache *lnet_small_mds_cachep; /* <= LNET_SMALL_MD_SIZE bytes
 						  * MDs kmem_cache */
+extern struct kmem_cache *lnet_msgs_cachep;	 /* lnet_msg kmem_cache */
 
 static inline struct lnet_eq *
 lnet_eq_alloc (void)
@@ -477,9 +478,10 @@ lnet_msg_alloc(void)
 {
 	struct lnet_msg *msg;
 
-	LIBCFS_ALLOC(msg, sizeof(*msg));
+	/* the slab's per-CPU freelists keep this off any shared lock or
+	 * counter on the fast path */
+	msg = kmem_cache_alloc(lnet_msgs_cachep, GFP_NOFS | __GFP_ZERO);
 
-	/* no need to zero, LIBCFS_ALLOC does for us */
 	return (msg);
 }
 
@@ -487,7 +489,7 @@ static inline void
 lnet_msg_free(struct lnet_msg *msg)
 {
 	LASSERT(!msg->msg_onactivelist);
-	LIBCFS_FREE(msg, sizeof(*msg));
+	kmem_cache_free(lnet_msgs_cachep, msg);
 }
 
 static inline struct lnet_rsp_tracker *
@@ -555,8 +557,11 @@ void lnet_lib_exit(void);
 extern unsigned lnet_transaction_timeout;
 extern unsigned lnet_retry_count;
 extern unsigned int lnet_numa_range;
+extern unsigned int lnet_latency_select;
+extern unsigned int lnet_latency_hysteresis;
 extern unsigned int lnet_health_sensitivity;
 extern unsigned int lnet_peer_discovery_disabled;
+extern unsigned int lnet_peer_discovery_batch;
 extern int portal_rotor;
 
 int lnet_notify(struct lnet_ni *ni, lnet_nid_t peer, int alive,
@@ -571,6 +576,7 @@ void lnet_destroy_routes(void);
 int lnet_get_route(int idx, __u32 *net, __u32 *hops,
 		   lnet_nid_t *gateway, __u32 *alive, __u32 *priority);
 int lnet_get_rtr_pool_cfg(int idx, struct lnet_ioctl_pool_cfg *pool_cfg);
+int lnet_get_rtrpool_stats(struct lnet_ioctl_rtrpool_stats *stats);
 struct lnet_ni *lnet_get_next_ni_locked(struct lnet_net *mynet,
 					struct lnet_ni *prev);
 struct lnet_ni *lnet_get_ni_idx_locked(int idx);
@@ -603,6 +609,7 @@ int  lnet_rtrpools_adjust(int tiny, int small, int large);
 int lnet_rtrpools_enable(void);
 void lnet_rtrpools_disable(void);
 void lnet_rtrpools_free(int keep_pools);
+void lnet_rtrpools_adapt(void);
 struct lnet_remotenet *lnet_find_rnet_locked(__u32 net);
 int lnet_dyn_add_net(struct lnet_ioctl_config_data *conf);
 int lnet_dyn_del_net(__u32 net);
@@ -675,6 +682,7 @@ struct lnet_match_table *lnet_mt_of_attach(unsigned int index,
 					   enum lnet_ins_pos pos);
 int lnet_mt_match_md(struct lnet_match_table *mtable,
 		     struct lnet_match_info *info, struct lnet_msg *msg);
+void lnet_mt_grow_uhash(struct lnet_match_table *mtable);
 
 /* portals match/attach functions */
 void lnet_ptl_attach_md(struct lnet_me *me, struct lnet_libmd *md,
@@ -706,6 +714,9 @@ void lnet_set_reply_msg_len(struct lnet_ni *ni, struct lnet_msg *msg,
 void lnet_detach_rsp_tracker(struct lnet_libmd *md, int cpt);
 
 void lnet_finalize(struct lnet_msg *msg, int rc);
+void lnet_finalize_queue(struct lnet_msg *msg, int rc,
+			 struct list_head *ready);
+void lnet_finalize_ready(struct list_head *ready);
 bool lnet_send_error_simulation(struct lnet_msg *msg,
 				enum lnet_msg_hstatus *hstatus);
 
@@ -1002,6 +1013,58 @@ lnet_inc_healthv(atomic_t *healthv)
 	atomic_add_unless(healthv, 1, LNET_MAX_HEALTH_VALUE);
 }
 
+/* weight of a new sample in the latency moving average is 1/8 */
+#define LNET_LATENCY_EWMA_WEIGHT	8
+/* latencies not refreshed for this many seconds are ignored */
+#define LNET_LATENCY_STALE		2
+
+static inline void
+lnet_latency_sample(struct lnet_latency *lat, s64 ns)
+{
+	s64 avg = atomic64_read(&lat->lat_ewma_ns);
+
+	/* racing senders may lose a sample, which an average can afford */
+	if (avg == 0)
+		avg = ns;
+	else
+		avg += (ns - avg) / LNET_LATENCY_EWMA_WEIGHT;
+	atomic64_set(&lat->lat_ewma_ns, max_t(s64, avg, 1));
+	lat->lat_stamp = ktime_get_seconds();
+}
+
+/* average latency in ns, or 0 if there is no recent measurement */
+static inline s64
+lnet_latency_get(struct lnet_latency *lat)
+{
+	if (ktime_get_seconds() - lat->lat_stamp > LNET_LATENCY_STALE)
+		return 0;
+
+	return atomic64_read(&lat->lat_ewma_ns);
+}
+
+/*
+ * Compare two average latencies for Multi-Rail selection.
+ *
+ * \retval -1 if \a lat is lower than \a best_lat by more than
+ *	lnet_latency_hysteresis percent
+ * \retval 1 if it is higher by more than that
+ * \retval 0 if they are close, either one is unknown or the latency
+ *	selection policy is off
+ */
+static inline int
+lnet_latency_cmp(s64 lat, s64 best_lat)
+{
+	s64 pct = 100 + lnet_latency_hysteresis;
+
+	if (!lnet_latency_select || lat == 0 || best_lat == 0)
+		return 0;
+	if (lat * 100 > best_lat * pct)
+		return 1;
+	if (lat * pct < best_lat * 100)
+		return -1;
+	return 0;
+}
+
 void lnet_incr_stats(struct lnet_element_stats *stats,
 		     enum lnet_msg_type msg_type,
 		     enum lnet_stats_type stats_type);
@@ -159,6 +159,8 @@ struct lnet_msg {
 	/* the NI the message was sent or received over */
 	struct lnet_ni       *msg_txni;
 	struct lnet_ni       *msg_rxni;
+	/* when the message was handed to the LND for sending */
+	ktime_t			msg_send_time;
 
 	unsigned int          msg_len;
 	unsigned int          msg_wanted;
@@ -409,6 +411,14 @@ struct lnet_net {
 	enum lnet_net_state	net_state;
 };
 
+/* how quickly sends over an NI or to a peer NI complete */
+struct lnet_latency {
+	/* moving average of send completion time, 0 until measured */
+	atomic64_t		lat_ewma_ns;
+	/* when the last completion was measured, in seconds */
+	time64_t		lat_stamp;
+};
+
 struct lnet_ni {
 	/* chain on the lnet_net structure */
 	struct list_head	ni_netlist;
@@ -482,6 +492,9 @@ struct lnet_ni {
 	 */
 	atomic_t		ni_healthv;
 
+	/* send completion latency, see lnet_latency_select */
+	struct lnet_latency	ni_latency;
+
 	/*
 	 * Set to 1 by the LND when it receives an event telling it the device
 	 * has gone into a fatal state. Set to 0 when the LND receives an
@@ -591,6 +604,8 @@ struct lnet_peer_ni {
 	atomic_t		lpni_refcount;
 	/* health value for the peer */
 	atomic_t		lpni_healthv;
+	/* send completion latency, see lnet_latency_select */
+	struct lnet_latency	lpni_latency;
 	/* recovery ping mdh */
 	struct lnet_handle_md	lpni_recovery_ping_mdh;
 	/* CPT this peer attached on */
@@ -685,9 +700,15 @@ struct lnet_peer {
 	/* Error encountered during discovery. */
 	int			lp_dc_error;
 
-	/* time it was put on the ln_dc_working queue */
+	/* time it was put on the pt_dc_working queue */
 	time64_t		lp_last_queued;
 
+	/* when discovery of this peer was requested */
+	ktime_t			lp_dc_start;
+
+	/* discovery queue lp_dc_list is on, LNET_DC_QUEUE_* */
+	int			lp_dc_queue;
+
 	/* link on discovery-related lists */
 	struct list_head	lp_dc_list;
 
@@ -788,8 +809,27 @@ struct lnet_peer_table {
 	struct list_head	pt_zombie_list;	/* zombie peer_ni */
 	int			pt_zombies;	/* # zombie peers_ni */
 	spinlock_t		pt_zombie_lock;	/* protect list and count */
+	/*
+	 * Discovery of the peers in this table is done by the discovery
+	 * thread of the CPT, these are protected by lnet_net_lock/EX.
+	 */
+	struct list_head	pt_dc_request;	/* peers to look at */
+	struct list_head	pt_dc_working;	/* peers with Ping/Push sent */
+	int			pt_dc_nrequest;	/* # on pt_dc_request */
+	int			pt_dc_nworking;	/* # on pt_dc_working */
+	wait_queue_head_t	pt_dc_waitq;	/* discovery thread waits */
+	__u64			pt_dc_completed; /* # discoveries completed */
+	/* total and longest time taken by those discoveries, ns */
+	__u64			pt_dc_time_ns;
+	__u64			pt_dc_time_max_ns;
 };
 
+/* Discovery queue a peer is on, see lnet_peer::lp_dc_queue */
+#define LNET_DC_QUEUE_NONE		0
+#define LNET_DC_QUEUE_REQUEST		1
+#define LNET_DC_QUEUE_WORKING		2
+#define LNET_DC_QUEUE_EXPIRED		3
+
 /* peer aliveness is enabled only on routers for peers in a network where the
  * struct lnet_ni::ni_peertimeout has been set to a positive value
  */
@@ -843,6 +883,15 @@ struct lnet_rtrbufpool {
 	int			rbp_credits;
 	/* low water mark */
 	int			rbp_mincredits;
+	/* low water mark since the last adaptive sizing check */
+	int			rbp_adapt_mincredits;
+	/* # consecutive checks that found the pool mostly idle */
+	int			rbp_idle_checks;
+	/* # times adaptive sizing grew/shrank the pool */
+	__u32			rbp_grown;
+	__u32			rbp_shrunk;
+	/* occupancy seen by routed messages, see LNET_RTRPOOL_HIST_BUCKETS */
+	__u64			rbp_hist[LNET_RTRPOOL_HIST_BUCKETS];
 };
 
 struct lnet_rtrbuf {
@@ -895,6 +944,12 @@ struct lnet_match_info {
 #define LNET_MT_BITS_U64		6	/* 2^6 bits */
 #define LNET_MT_EXHAUSTED_BITS		(LNET_MT_HASH_BITS - LNET_MT_BITS_U64)
 #define LNET_MT_EXHAUSTED_BMAP		((1 << LNET_MT_EXHAUSTED_BITS) + 1)
+/* unique portals outgrow mt_mhash into mt_uhash, grown 4x at a time
+ * whenever the average chain gets longer than LNET_MT_UHASH_CHAIN */
+#define LNET_MT_UHASH_CHAIN		4
+#define LNET_MT_UHASH_BITS_MAX		16
+/* # log2 buckets in the match-walk length histogram */
+#define LNET_MT_WALK_BUCKETS		12
 
 /* portal match table */
 struct lnet_match_table {
@@ -907,6 +962,13 @@ struct lnet_match_table {
 	/* bitmap to flag whether MEs on mt_hash are exhausted or not */
 	__u64			mt_exhausted[LNET_MT_EXHAUSTED_BMAP];
 	struct list_head	*mt_mhash;	/* matching hash */
+	/* larger hash replacing mt_mhash for a busy unique portal */
+	struct list_head	*mt_uhash;
+	unsigned int		mt_uhash_bits;
+	/* # MEs hashed on this table of a unique portal */
+	unsigned int		mt_nmes;
+	/* # matches by # of MEs walked: 0, 1, 2-3, 4-7, ... */
+	__u64			mt_walk_hist[LNET_MT_WALK_BUCKETS];
 };
 
 /* these are only useful for wildcard portal */
@@ -960,6 +1022,17 @@ struct lnet_msg_container {
 	struct list_head	msc_active;	/* active message list */
 	/* threads doing finalization */
 	void			**msc_finalizers;
+	/* # of times the finalize path took this CPT's lock */
+	__u64			msc_lock_count;
+	/* # of messages completed by finalizers on this CPT */
+	__u64			msc_completed;
+	/* total and longest single hold of the lock by the finalize path,
+	 * ns; time with the lock dropped to send an ACK or forward a
+	 * message is not counted */
+	__u64			msc_hold_ns;
+	__u64			msc_hold_max_ns;
+	/* when the current finalize path hold started, ns */
+	__u64			msc_lock_start;
 };
 
 /* Peer Discovery states */
@@ -1063,14 +1136,12 @@ struct lnet {
 
 	/* discovery event queue handle */
 	struct lnet_handle_eq		ln_dc_eqh;
-	/* discovery requests */
-	struct list_head		ln_dc_request;
-	/* discovery working list */
-	struct list_head		ln_dc_working;
 	/* discovery expired list */
 	struct list_head		ln_dc_expired;
 	/* discovery thread wait queue */
 	wait_queue_head_t		ln_dc_waitq;
+	/* # running per-CPT discovery threads */
+	atomic_t			ln_dc_nthreads;
 	/* discovery startup/shutdown state */
 	int				ln_dc_state;
 
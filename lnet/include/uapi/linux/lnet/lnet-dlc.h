@@ -80,9 +80,16 @@ struct lnet_ioctl_config_o2iblnd_tunables {
 	__u16 lnd_ntx;
 };
 
+struct lnet_ioctl_config_socklnd_tunables {
+	__u32 lnd_version;
+	__u16 lnd_conns_per_peer;
+	__u16 lnd_pad;
+};
+
 struct lnet_lnd_tunables {
 	union {
 		struct lnet_ioctl_config_o2iblnd_tunables lnd_o2ib;
+		struct lnet_ioctl_config_socklnd_tunables lnd_sock;
 	} lnd_tun_u;
 };
 
@@ -115,6 +122,32 @@ struct lnet_ioctl_pool_cfg {
 	__u32 pl_routing;
 };
 
+/* occupancy histogram of a router buffer pool: the share of buffers in use
+ * seen by each routed message in 10% steps, the last bucket counts the
+ * messages that found the pool empty and had to block */
+#define LNET_RTRPOOL_HIST_BUCKETS	11
+
+struct lnet_rtrpool_stats {
+	__u32 rps_npages;
+	__u32 rps_nbuffers;
+	__u32 rps_req_nbuffers;
+	__u32 rps_min_nbuffers;		/* adaptive sizing bounds */
+	__u32 rps_max_nbuffers;
+	__s32 rps_credits;
+	__s32 rps_mincredits;
+	__u32 rps_grown;		/* # times grown by adaptive sizing */
+	__u32 rps_shrunk;		/* # times shrunk by adaptive sizing */
+	__u32 rps_padding;
+	__u64 rps_hist[LNET_RTRPOOL_HIST_BUCKETS];
+};
+
+struct lnet_ioctl_rtrpool_stats {
+	struct libcfs_ioctl_hdr rps_hdr;
+	__u32 rps_cpt;			/* in: CPT to report */
+	__u32 rps_adaptive;		/* out: pools are resized on load */
+	struct lnet_rtrpool_stats rps_pools[LNET_NRBPOOLS];
+};
+
 struct lnet_ioctl_ping_data {
 	struct libcfs_ioctl_hdr ping_hdr;
 
@@ -189,6 +222,7 @@ struct lnet_ioctl_local_ni_hstats {
 	__u32 hlni_local_timeout;
 	__u32 hlni_local_error;
 	__s32 hlni_health_value;
+	__u32 hlni_latency_us;		/* average send completion time */
 };
 
 struct lnet_ioctl_peer_ni_hstats {
@@ -197,6 +231,7 @@ struct lnet_ioctl_peer_ni_hstats {
 	__u32 hlpni_remote_error;
 	__u32 hlpni_network_timeout;
 	__s32 hlpni_health_value;
+	__u32 hlpni_latency_us;		/* average send completion time */
 };
 
 struct lnet_ioctl_element_msg_stats {
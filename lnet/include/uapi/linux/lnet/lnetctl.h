@@ -67,6 +67,17 @@ enum {
 #define HSTATUS_NETWORK_TIMEOUT_BIT	(1 << 10)
 #define HSTATUS_RANDOM			0xffffffff
 
+/** latency distribution of a delay rule */
+enum lnet_delay_dist {
+	/** latency +/- jitter, a fixed latency if jitter is zero */
+	LNET_DELAY_DIST_UNIFORM	= 0,
+	/** normal distribution, jitter is the standard deviation */
+	LNET_DELAY_DIST_NORMAL	= 1,
+	/** latency plus a pareto tail, jitter is the mean of the tail */
+	LNET_DELAY_DIST_PARETO	= 2,
+	LNET_DELAY_DIST_MAX,
+};
+
 /** ioctl parameter for LNet fault simulation */
 struct lnet_fault_attr {
 	/**
@@ -119,6 +130,27 @@ struct lnet_fault_attr {
 			__u32			la_interval;
 			/** latency to delay */
 			__u32			la_latency;
+			/**
+			 * latency to delay in microseconds, it overrides
+			 * la_latency if it is non-zero
+			 */
+			__u32			la_latency_us;
+			/** spread of the latency in microseconds */
+			__u32			la_jitter_us;
+			/** distribution of latency, see lnet_delay_dist */
+			__u32			la_dist;
+			/**
+			 * bandwidth cap in KiB/s of all messages matching
+			 * this rule, zero means no cap
+			 */
+			__u32			la_bandwidth;
+			/** depth of the bandwidth token bucket in KiB */
+			__u32			la_burst;
+			/**
+			 * reorder rate, 1 of every la_reorder matched
+			 * messages overtakes those already delayed
+			 */
+			__u32			la_reorder;
 		} delay;
 		__u64			space[8];
 	} u;
@@ -145,6 +177,10 @@ struct lnet_fault_stat {
 		struct {
 			/** total # delayed messages */
 			__u64			ls_delayed;
+			/** # messages held back by the bandwidth cap */
+			__u64			ls_throttled;
+			/** # messages which overtook delayed messages */
+			__u64			ls_reordered;
 		} delay;
 		__u64			space[8];
 	} u;
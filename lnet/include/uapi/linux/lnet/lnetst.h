@@ -39,9 +39,11 @@
 
 #define LST_FEAT_NONE		(0)
 #define LST_FEAT_BULK_LEN	(1 << 0)	/* enable variable page size */
+#define LST_FEAT_LAT_HIST	(1 << 1)	/* RPC latency histograms */
 
 #define LST_FEATS_EMPTY		(LST_FEAT_NONE)
-#define LST_FEATS_MASK		(LST_FEAT_NONE | LST_FEAT_BULK_LEN)
+#define LST_FEATS_MASK		(LST_FEAT_NONE | LST_FEAT_BULK_LEN | \
+				 LST_FEAT_LAT_HIST)
 
 #define LST_NAME_SIZE		32		/* max name buffer length */
 
@@ -64,6 +66,7 @@
 #define LSTIO_TEST_ADD		0xC26		/* add test (to batch) */
 #define LSTIO_BATCH_QUERY	0xC27		/* query batch status */
 #define LSTIO_STAT_QUERY	0xC30		/* get stats */
+#define LSTIO_STAT_LAT		0xC31		/* get RPC latency histograms */
 
 struct lst_sid {
 	lnet_nid_t	ses_nid;	/* nid of console node */
@@ -512,4 +515,42 @@ struct sfw_counters {
 	__u32 ping_errors;
 } WIRE_ATTR;
 
+/*
+ * Round-trip times of test RPCs issued by a node, in microseconds.
+ * Buckets split every power of two in halves: bucket 2n holds
+ * [2^n, 1.5 * 2^n), bucket 2n + 1 holds [1.5 * 2^n, 2^(n+1)), and the
+ * last bucket also takes everything slower.  Bucket counts only grow;
+ * lat_max_us is the slowest RPC since the previous query.
+ */
+#define LST_LAT_BUCKETS		40
+
+struct sfw_lat_counters {
+	__u32 lat_max_us;
+	__u32 lat_buckets[LST_LAT_BUCKETS];
+} WIRE_ATTR;
+
+static inline unsigned int lst_lat_bucket(__u64 us)
+{
+	unsigned int idx;
+	int e;
+
+	if (us < 2)
+		return us;
+
+	for (e = 63; (us & (1ULL << e)) == 0; e--)
+		;
+	idx = 2 * e + ((us >> (e - 1)) & 1);
+
+	return idx < LST_LAT_BUCKETS ? idx : LST_LAT_BUCKETS - 1;
+}
+
+/* lowest round-trip time, in microseconds, counted in bucket \a idx */
+static inline __u64 lst_lat_bucket_low(unsigned int idx)
+{
+	if (idx < 2)
+		return idx;
+
+	return (1ULL << (idx / 2)) + ((__u64)(idx & 1) << (idx / 2 - 1));
+}
+
 #endif
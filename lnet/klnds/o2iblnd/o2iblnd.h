@@ -85,6 +85,8 @@
 #define IBLND_PEER_HASH_SIZE		101	/* # peer_ni lists */
 /* # scheduler loops before reschedule */
 #define IBLND_RESCHED			100
+/* # completions a scheduler handles before finalizing their lnet msgs */
+#define IBLND_FINALIZE_BATCH		16
 
 #define IBLND_N_SCHED			2
 #define IBLND_N_SCHED_HIGH		4
@@ -568,6 +570,8 @@ struct kib_rx {					/* receive message */
 	struct ib_recv_wr	rx_wrq;
 	/* ...and its memory */
 	struct ib_sge		rx_sge;
+	/* lnet msgs to finalize while being handled, NULL otherwise */
+	struct list_head       *rx_finalize;
 };
 
 #define IBLND_POSTRX_DONT_POST    0             /* don't post */
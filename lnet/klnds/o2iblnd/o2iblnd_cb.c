@@ -51,8 +51,12 @@ static void kiblnd_queue_tx(struct kib_tx *tx, struct kib_conn *conn);
 static void kiblnd_unmap_tx(struct kib_tx *tx);
 static void kiblnd_check_sends_locked(struct kib_conn *conn);
 
-void
-kiblnd_tx_done(struct kib_tx *tx)
+/*
+ * Release \a tx and queue the lnet msgs it carries on \a ready; the caller
+ * completes them with lnet_finalize_ready() once it is done with the batch.
+ */
+static void
+kiblnd_tx_done_queue(struct kib_tx *tx, struct list_head *ready)
 {
 	struct lnet_msg *lntmsg[2];
 	int         rc;
@@ -90,15 +94,26 @@ kiblnd_tx_done(struct kib_tx *tx)
 		if (i == 0 && lntmsg[i])
 			lntmsg[i]->msg_health_status = tx->tx_hstatus;
 
-		lnet_finalize(lntmsg[i], rc);
+		lnet_finalize_queue(lntmsg[i], rc, ready);
 	}
 }
 
+void
+kiblnd_tx_done(struct kib_tx *tx)
+{
+	LIST_HEAD(ready);
+
+	/* a GET completes its REPLY in the same go */
+	kiblnd_tx_done_queue(tx, &ready);
+	lnet_finalize_ready(&ready);
+}
+
 void
 kiblnd_txlist_done(struct list_head *txlist, int status,
 		   enum lnet_msg_hstatus hstatus)
 {
 	struct kib_tx *tx;
+	LIST_HEAD(ready);
 
 	while (!list_empty(txlist)) {
 		tx = list_entry(txlist->next, struct kib_tx, tx_list);
@@ -108,8 +123,10 @@ kiblnd_txlist_done(struct list_head *txlist, int status,
 		tx->tx_waiting = 0;
 		tx->tx_status = status;
 		tx->tx_hstatus = hstatus;
-		kiblnd_tx_done(tx);
+		kiblnd_tx_done_queue(tx, &ready);
 	}
+
+	lnet_finalize_ready(&ready);
 }
 
 static struct kib_tx *
@@ -260,7 +277,8 @@ kiblnd_find_waiting_tx_locked(struct kib_conn *conn, int txtype, u64 cookie)
 }
 
 static void
-kiblnd_handle_completion(struct kib_conn *conn, int txtype, int status, u64 cookie)
+kiblnd_handle_completion(struct kib_conn *conn, int txtype, int status,
+			 u64 cookie, struct list_head *ready)
 {
 	struct kib_tx *tx;
 	struct lnet_ni *ni = conn->ibc_peer->ibp_ni;
@@ -296,7 +314,7 @@ kiblnd_handle_completion(struct kib_conn *conn, int txtype, int status, u64 cook
 	spin_unlock(&conn->ibc_lock);
 
 	if (idle)
-		kiblnd_tx_done(tx);
+		kiblnd_tx_done_queue(tx, ready);
 }
 
 static void
@@ -319,7 +337,7 @@ kiblnd_send_completion(struct kib_conn *conn, int type, int status, u64 cookie)
 }
 
 static void
-kiblnd_handle_rx(struct kib_rx *rx)
+kiblnd_handle_rx(struct kib_rx *rx, struct list_head *ready)
 {
 	struct kib_msg *msg = rx->rx_msg;
 	struct kib_conn   *conn = rx->rx_conn;
@@ -388,8 +406,11 @@ kiblnd_handle_rx(struct kib_rx *rx)
 
         case IBLND_MSG_IMMEDIATE:
                 post_credit = IBLND_POSTRX_DONT_POST;
+                /* kiblnd_recv() queues the msg here if it isn't delayed */
+                rx->rx_finalize = ready;
                 rc = lnet_parse(ni, &msg->ibm_u.immediate.ibim_hdr,
                                 msg->ibm_srcnid, rx, 0);
+                rx->rx_finalize = NULL;
                 if (rc < 0)                     /* repost on error */
                         post_credit = IBLND_POSTRX_PEER_CREDIT;
                 break;
@@ -408,7 +429,8 @@ kiblnd_handle_rx(struct kib_rx *rx)
                 post_credit = IBLND_POSTRX_RSRVD_CREDIT;
                 kiblnd_handle_completion(conn, IBLND_MSG_PUT_REQ,
                                          msg->ibm_u.completion.ibcm_status,
-                                         msg->ibm_u.completion.ibcm_cookie);
+                                         msg->ibm_u.completion.ibcm_cookie,
+                                         ready);
                 break;
 
         case IBLND_MSG_PUT_ACK:
@@ -453,7 +475,8 @@ kiblnd_handle_rx(struct kib_rx *rx)
                 post_credit = IBLND_POSTRX_PEER_CREDIT;
                 kiblnd_handle_completion(conn, IBLND_MSG_PUT_ACK,
                                          msg->ibm_u.completion.ibcm_status,
-                                         msg->ibm_u.completion.ibcm_cookie);
+                                         msg->ibm_u.completion.ibcm_cookie,
+                                         ready);
                 break;
 
         case IBLND_MSG_GET_REQ:
@@ -468,7 +491,8 @@ kiblnd_handle_rx(struct kib_rx *rx)
                 post_credit = IBLND_POSTRX_RSRVD_CREDIT;
                 kiblnd_handle_completion(conn, IBLND_MSG_GET_REQ,
                                          msg->ibm_u.completion.ibcm_status,
-                                         msg->ibm_u.completion.ibcm_cookie);
+                                         msg->ibm_u.completion.ibcm_cookie,
+                                         ready);
                 break;
         }
 
@@ -480,7 +504,8 @@ kiblnd_handle_rx(struct kib_rx *rx)
 }
 
 static void
-kiblnd_rx_complete(struct kib_rx *rx, int status, int nob)
+kiblnd_rx_complete(struct kib_rx *rx, int status, int nob,
+		   struct list_head *ready)
 {
 	struct kib_msg *msg = rx->rx_msg;
 	struct kib_conn   *conn = rx->rx_conn;
@@ -540,7 +565,7 @@ kiblnd_rx_complete(struct kib_rx *rx, int status, int nob)
 		}
 		write_unlock_irqrestore(g_lock, flags);
         }
-        kiblnd_handle_rx(rx);
+        kiblnd_handle_rx(rx, ready);
         return;
 
  failed:
@@ -1081,7 +1106,7 @@ kiblnd_check_sends_locked(struct kib_conn *conn)
 }
 
 static void
-kiblnd_tx_complete(struct kib_tx *tx, int status)
+kiblnd_tx_complete(struct kib_tx *tx, int status, struct list_head *ready)
 {
         int           failed = (status != IB_WC_SUCCESS);
 	struct kib_conn   *conn = tx->tx_conn;
@@ -1128,7 +1153,7 @@ kiblnd_tx_complete(struct kib_tx *tx, int status)
 	spin_unlock(&conn->ibc_lock);
 
 	if (idle)
-		kiblnd_tx_done(tx);
+		kiblnd_tx_done_queue(tx, ready);
 }
 
 static void
@@ -1888,7 +1913,12 @@ kiblnd_recv(struct lnet_ni *ni, void *private, struct lnet_msg *lntmsg,
                                            IBLND_MSG_SIZE, rxmsg,
 					   offsetof(struct kib_msg, ibm_u.immediate.ibim_payload),
                                            mlen);
-		lnet_finalize(lntmsg, 0);
+		/* the payload has been copied out, so the scheduler can
+		 * finalize it with the rest of its batch */
+		if (!delayed && rx->rx_finalize != NULL)
+			lnet_finalize_queue(lntmsg, 0, rx->rx_finalize);
+		else
+			lnet_finalize(lntmsg, 0);
 		break;
 
 	case IBLND_MSG_PUT_REQ: {
@@ -2102,6 +2132,7 @@ kiblnd_handle_early_rxs(struct kib_conn *conn)
 {
 	unsigned long flags;
 	struct kib_rx *rx;
+	LIST_HEAD(ready);
 
 	LASSERT(!in_interrupt());
 	LASSERT(conn->ibc_state >= IBLND_CONN_ESTABLISHED);
@@ -2113,11 +2144,13 @@ kiblnd_handle_early_rxs(struct kib_conn *conn)
 		list_del(&rx->rx_list);
 		write_unlock_irqrestore(&kiblnd_data.kib_global_lock, flags);
 
-		kiblnd_handle_rx(rx);
+		kiblnd_handle_rx(rx, &ready);
 
 		write_lock_irqsave(&kiblnd_data.kib_global_lock, flags);
 	}
 	write_unlock_irqrestore(&kiblnd_data.kib_global_lock, flags);
+
+	lnet_finalize_ready(&ready);
 }
 
 static void
@@ -3649,7 +3682,7 @@ kiblnd_qp_event(struct ib_event *event, void *arg)
 }
 
 static void
-kiblnd_complete (struct ib_wc *wc)
+kiblnd_complete(struct ib_wc *wc, struct list_head *ready)
 {
 	switch (kiblnd_wreqid2type(wc->wr_id)) {
 	default:
@@ -3673,12 +3706,13 @@ kiblnd_complete (struct ib_wc *wc)
                 return;
 
         case IBLND_WID_TX:
-                kiblnd_tx_complete(kiblnd_wreqid2ptr(wc->wr_id), wc->status);
+                kiblnd_tx_complete(kiblnd_wreqid2ptr(wc->wr_id), wc->status,
+                                   ready);
                 return;
 
         case IBLND_WID_RX:
                 kiblnd_rx_complete(kiblnd_wreqid2ptr(wc->wr_id), wc->status,
-                                   wc->byte_len);
+                                   wc->byte_len, ready);
                 return;
         }
 }
@@ -3733,6 +3767,8 @@ kiblnd_scheduler(void *arg)
 	wait_queue_entry_t      wait;
 	unsigned long		flags;
 	struct ib_wc		wc;
+	LIST_HEAD(ready);
+	int			nready = 0;
 	int			did_something;
 	int			busy_loops = 0;
 	int			rc;
@@ -3757,6 +3793,9 @@ kiblnd_scheduler(void *arg)
 		if (busy_loops++ >= IBLND_RESCHED) {
 			spin_unlock_irqrestore(&sched->ibs_lock, flags);
 
+			lnet_finalize_ready(&ready);
+			nready = 0;
+
 			cond_resched();
 			busy_loops = 0;
 
@@ -3837,7 +3876,15 @@ kiblnd_scheduler(void *arg)
 
 			if (rc != 0) {
 				spin_unlock_irqrestore(&sched->ibs_lock, flags);
-				kiblnd_complete(&wc);
+				kiblnd_complete(&wc, &ready);
+
+				/* finalize the lnet msgs of a batch of
+				 * completions in one go, but bound how long
+				 * the first of them waits */
+				if (++nready >= IBLND_FINALIZE_BATCH) {
+					lnet_finalize_ready(&ready);
+					nready = 0;
+				}
 
 				spin_lock_irqsave(&sched->ibs_lock, flags);
                         }
@@ -3849,6 +3896,15 @@ kiblnd_scheduler(void *arg)
                 if (did_something)
                         continue;
 
+		if (!list_empty(&ready)) {
+			/* no more completions: don't sit on these */
+			spin_unlock_irqrestore(&sched->ibs_lock, flags);
+			lnet_finalize_ready(&ready);
+			nready = 0;
+			spin_lock_irqsave(&sched->ibs_lock, flags);
+			continue;
+		}
+
 		set_current_state(TASK_INTERRUPTIBLE);
 		add_wait_queue_exclusive(&sched->ibs_waitq, &wait);
 		spin_unlock_irqrestore(&sched->ibs_lock, flags);
@@ -3863,6 +3919,8 @@ kiblnd_scheduler(void *arg)
 
 	spin_unlock_irqrestore(&sched->ibs_lock, flags);
 
+	lnet_finalize_ready(&ready);
+
 	kiblnd_thread_fini();
 	return 0;
 }
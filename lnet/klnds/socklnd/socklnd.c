@@ -81,6 +81,8 @@ ksocknal_create_route(__u32 ipaddr, int port)
         route->ksnr_deleted = 0;
         route->ksnr_conn_count = 0;
         route->ksnr_share_count = 0;
+	memset(route->ksnr_conns, 0, sizeof(route->ksnr_conns));
+	route->ksnr_max_conns = 0;
 
         return (route);
 }
@@ -120,6 +122,7 @@ ksocknal_create_peer(struct ksock_peer_ni **peerp, struct lnet_ni *ni,
 	peer_ni->ksnp_proto = NULL;
 	peer_ni->ksnp_last_alive = 0;
 	peer_ni->ksnp_zc_next_cookie = SOCKNAL_KEEPALIVE_PING + 1;
+	atomic_set(&peer_ni->ksnp_tx_seq, 0);
 
 	INIT_LIST_HEAD(&peer_ni->ksnp_conns);
 	INIT_LIST_HEAD(&peer_ni->ksnp_routes);
@@ -356,6 +359,7 @@ ksocknal_associate_route_conn_locked(struct ksock_route *route, struct ksock_con
 
         route->ksnr_connected |= (1<<type);
         route->ksnr_conn_count++;
+	route->ksnr_conns[type]++;
 
         /* Successful connection => further attempts can
          * proceed immediately */
@@ -662,11 +666,27 @@ ksocknal_get_conn_by_idx(struct lnet_ni *ni, int index)
 	return NULL;
 }
 
+/* Does \a sched already serve a connection of \a type to \a peer_ni? */
+static bool
+ksocknal_sched_has_conn_locked(struct ksock_sched *sched,
+			       struct ksock_peer_ni *peer_ni, int type)
+{
+	struct ksock_conn *conn;
+
+	list_for_each_entry(conn, &peer_ni->ksnp_conns, ksnc_list) {
+		if (conn->ksnc_scheduler == sched && conn->ksnc_type == type)
+			return true;
+	}
+	return false;
+}
+
 static struct ksock_sched *
-ksocknal_choose_scheduler_locked(unsigned int cpt)
+ksocknal_choose_scheduler_locked(unsigned int cpt,
+				 struct ksock_peer_ni *peer_ni, int type)
 {
 	struct ksock_sched_info	*info = ksocknal_data.ksnd_sched_info[cpt];
 	struct ksock_sched *sched;
+	struct ksock_sched *s;
 	int i;
 
 	if (info->ksi_nthreads == 0) {
@@ -681,12 +701,29 @@ ksocknal_choose_scheduler_locked(unsigned int cpt)
 	}
 
 select_sched:
-	sched = &info->ksi_scheds[0];
 	/*
 	 * NB: it's safe so far, but info->ksi_nthreads could be changed
 	 * at runtime when we have dynamic LNet configuration, then we
 	 * need to take care of this.
+	 *
+	 * Parallel bulk connections to one peer_ni only help if they are
+	 * driven by different threads, so prefer the least loaded scheduler
+	 * not serving a connection of the same type to this peer_ni yet.
 	 */
+	sched = NULL;
+	if (ksocknal_conns_per_type(peer_ni->ksnp_ni, type) > 1) {
+		for (i = 0; i < info->ksi_nthreads; i++) {
+			s = &info->ksi_scheds[i];
+			if (ksocknal_sched_has_conn_locked(s, peer_ni, type))
+				continue;
+			if (sched == NULL || sched->kss_nconns > s->kss_nconns)
+				sched = s;
+		}
+		if (sched != NULL)
+			return sched;
+	}
+
+	sched = &info->ksi_scheds[0];
 	for (i = 1; i < info->ksi_nthreads; i++) {
 		if (sched->kss_nconns > info->ksi_scheds[i].kss_nconns)
 			sched = &info->ksi_scheds[i];
@@ -1220,8 +1257,13 @@ ksocknal_create_conn(struct lnet_ni *ni, struct ksock_route *route,
         }
 
 	/* Refuse to duplicate an existing connection, unless this is a
-	 * loopback connection */
+	 * loopback connection or one more of the bulk connections allowed
+	 * by conns_per_peer. The CONN_NONE HELLO reply to a refused
+	 * passive connection tells the peer_ni how many bulk connections
+	 * I accept. */
 	if (conn->ksnc_ipaddr != conn->ksnc_myipaddr) {
+		int nconns = 0;
+
 		list_for_each(tmp, &peer_ni->ksnp_conns) {
 			conn2 = list_entry(tmp, struct ksock_conn, ksnc_list);
 
@@ -1230,6 +1272,10 @@ ksocknal_create_conn(struct lnet_ni *ni, struct ksock_route *route,
                             conn2->ksnc_type != conn->ksnc_type)
                                 continue;
 
+			if (++nconns < ksocknal_conns_per_type(ni,
+							conn->ksnc_type))
+				continue;
+
                         /* Reply on a passive connection attempt so the peer_ni
                          * realises we're connected. */
                         LASSERT (rc == 0);
@@ -1271,7 +1317,8 @@ ksocknal_create_conn(struct lnet_ni *ni, struct ksock_route *route,
 	peer_ni->ksnp_send_keepalive = 0;
 	peer_ni->ksnp_error = 0;
 
-	sched = ksocknal_choose_scheduler_locked(cpt);
+	sched = ksocknal_choose_scheduler_locked(cpt, peer_ni,
+						 conn->ksnc_type);
 	if (!sched) {
 		CERROR("no schedulers available. node is unhealthy\n");
 		goto failed_2;
@@ -1437,8 +1484,6 @@ ksocknal_close_conn_locked(struct ksock_conn *conn, int error)
          * Caller holds ksnd_global_lock exclusively in irq context */
 	struct ksock_peer_ni *peer_ni = conn->ksnc_peer;
 	struct ksock_route *route;
-	struct ksock_conn *conn2;
-	struct list_head *tmp;
 
 	LASSERT(peer_ni->ksnp_error == 0);
 	LASSERT(!conn->ksnc_closing);
@@ -1452,20 +1497,15 @@ ksocknal_close_conn_locked(struct ksock_conn *conn, int error)
 		/* dissociate conn from route... */
 		LASSERT(!route->ksnr_deleted);
 		LASSERT((route->ksnr_connected & (1 << conn->ksnc_type)) != 0);
+		LASSERT(route->ksnr_conns[conn->ksnc_type] > 0);
 
-		conn2 = NULL;
-		list_for_each(tmp, &peer_ni->ksnp_conns) {
-			conn2 = list_entry(tmp, struct ksock_conn, ksnc_list);
-
-			if (conn2->ksnc_route == route &&
-			    conn2->ksnc_type == conn->ksnc_type)
-				break;
-
-			conn2 = NULL;
-		}
-		if (conn2 == NULL)
+		if (--route->ksnr_conns[conn->ksnc_type] == 0)
 			route->ksnr_connected &= ~(1 << conn->ksnc_type);
 
+		/* renegotiate the # bulk conns on the next connection */
+		if (route->ksnr_connected == 0)
+			route->ksnr_max_conns = 0;
+
 		conn->ksnc_route = NULL;
 
 		ksocknal_route_decref(route);	/* drop conn's ref on route */
@@ -2547,9 +2587,13 @@ ksocknal_debug_peerhash(struct lnet_ni *ni)
 		list_for_each(tmp, &peer_ni->ksnp_routes) {
 			route = list_entry(tmp, struct ksock_route, ksnr_list);
 			CWARN ("Route: ref %d, schd %d, conn %d, cnted %d, "
-			       "del %d\n", atomic_read(&route->ksnr_refcount),
+			       "del %d, bulk %d/%d max %d\n",
+			       atomic_read(&route->ksnr_refcount),
 			       route->ksnr_scheduled, route->ksnr_connecting,
-			       route->ksnr_connected, route->ksnr_deleted);
+			       route->ksnr_connected, route->ksnr_deleted,
+			       route->ksnr_conns[SOCKLND_CONN_BULK_IN],
+			       route->ksnr_conns[SOCKLND_CONN_BULK_OUT],
+			       route->ksnr_max_conns);
 		}
 
 		list_for_each(tmp, &peer_ni->ksnp_conns) {
@@ -2826,6 +2870,9 @@ ksocknal_startup(struct lnet_ni *ni)
 		ni->ni_net->net_tunables_set = true;
 	}
 
+	rc = ksocknal_tunables_setup(ni);
+	if (rc != 0)
+		goto fail_1;
 
 	if (ni->ni_interfaces[0] == NULL) {
 		rc = ksocknal_enumerate_interfaces(net);
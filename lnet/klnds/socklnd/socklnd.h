@@ -72,6 +72,7 @@
 
 #define SOCKNAL_PEER_HASH_SIZE  101             /* # peer_ni lists */
 #define SOCKNAL_RESCHED         100             /* # scheduler loops before reschedule */
+#define SOCKNAL_FINALIZE_BATCH  16              /* # completions before finalizing their lnet msgs */
 #define SOCKNAL_INSANITY_RECONN 5000            /* connd is trying on reconn infinitely */
 #define SOCKNAL_ENOMEM_RETRY    1		/* seconds between retries */
 
@@ -80,6 +81,8 @@
 
 #define SOCKNAL_VERSION_DEBUG       0           /* enable protocol version debugging */
 
+#define SOCKNAL_CONNS_PER_PEER_MAX  16          /* max # bulk conns of one type per route */
+
 /* risk kmap deadlock on multi-frag I/O (backs off to single-frag if disabled).
  * no risk if we're not running on a CONFIG_HIGHMEM platform. */
 #ifdef CONFIG_HIGHMEM
@@ -140,6 +143,7 @@ struct ksock_tunables {
         int              *ksnd_max_reconnectms; /* ...exponentially increasing to this */
         int              *ksnd_eager_ack;       /* make TCP ack eagerly? */
         int              *ksnd_typed_conns;     /* drive sockets by type? */
+	int		 *ksnd_conns_per_peer;	/* # bulk conns of each type per peer */
         int              *ksnd_min_bulk;        /* smallest "large" message */
         int              *ksnd_tx_buffer_size;  /* socket tx buffer size */
         int              *ksnd_rx_buffer_size;  /* socket rx buffer size */
@@ -159,6 +163,7 @@ struct ksock_tunables {
         unsigned int     *ksnd_zc_min_payload;  /* minimum zero copy payload size */
         int              *ksnd_zc_recv;         /* enable ZC receive (for Chelsio TOE) */
         int              *ksnd_zc_recv_min_nfrags; /* minimum # of fragments to enable ZC receive */
+	int		 *ksnd_rx_read_sock;	/* receive bulk via tcp_read_sock() */
 #ifdef CPU_AFFINITY
         int              *ksnd_irq_affinity;    /* enable IRQ affinity? */
 #endif
@@ -376,6 +381,8 @@ struct ksock_conn {
 	int			ksnc_tx_scheduled;
 	/* time stamp of the last posted TX */
 	time64_t		ksnc_tx_last_post;
+	/* peer_ni's TX sequence when this conn was last chosen */
+	unsigned int		ksnc_tx_seq;
 };
 
 struct ksock_route {
@@ -394,6 +401,10 @@ struct ksock_route {
         unsigned int          ksnr_deleted:1;   /* been removed from peer_ni? */
         unsigned int          ksnr_share_count; /* created explicitly? */
         int                   ksnr_conn_count;  /* # conns established by this route */
+	/* # conns of each type currently established */
+	int			ksnr_conns[SOCKLND_CONN_NTYPES];
+	/* # bulk conns of one type the peer accepts, 0 if not known */
+	int			ksnr_max_conns;
 };
 
 #define SOCKNAL_KEEPALIVE_PING          1       /* cookie for keepalive ping */
@@ -408,6 +419,8 @@ struct ksock_peer_ni {
 	int                   ksnp_accepting;/* # passive connections pending */
 	int                   ksnp_error;    /* errno on closing last conn */
 	__u64                 ksnp_zc_next_cookie;/* ZC completion cookie */
+	/* TX sequence, spreads TXs over the conns of one type */
+	atomic_t		ksnp_tx_seq;
 	__u64                 ksnp_incarnation;   /* latest known peer_ni incarnation */
 	struct ksock_proto   *ksnp_proto;    /* latest known peer_ni protocol */
 	struct list_head	ksnp_conns;	/* all active connections */
@@ -490,6 +503,47 @@ ksocknal_route_mask(void)
                 (1 << SOCKLND_CONN_BULK_OUT));
 }
 
+static inline bool
+ksocknal_conn_type_is_bulk(int type)
+{
+	return type == SOCKLND_CONN_BULK_IN || type == SOCKLND_CONN_BULK_OUT;
+}
+
+/* # connections of \a type wanted on each route to a peer of \a ni */
+static inline int
+ksocknal_conns_per_type(struct lnet_ni *ni, int type)
+{
+	if (!ksocknal_conn_type_is_bulk(type))
+		return 1;
+
+	return ni->ni_lnd_tunables.lnd_tun_u.lnd_sock.lnd_conns_per_peer;
+}
+
+/* connection types this route still has to establish */
+static inline int
+ksocknal_route_wanted(struct ksock_route *route)
+{
+	struct lnet_ni *ni = route->ksnr_peer->ksnp_ni;
+	int mask = ksocknal_route_mask();
+	int wanted = mask & ~route->ksnr_connected;
+	int type;
+	int max;
+
+	for (type = SOCKLND_CONN_BULK_IN; type <= SOCKLND_CONN_BULK_OUT;
+	     type++) {
+		if ((mask & (1 << type)) == 0)
+			continue;
+
+		max = ksocknal_conns_per_type(ni, type);
+		if (route->ksnr_max_conns != 0 && route->ksnr_max_conns < max)
+			max = route->ksnr_max_conns;
+		if (route->ksnr_conns[type] < max)
+			wanted |= (1 << type);
+	}
+
+	return wanted;
+}
+
 static inline struct list_head *
 ksocknal_nid2peerlist (lnet_nid_t nid)
 {
@@ -671,6 +725,7 @@ extern int ksocknal_lib_get_conn_tunables(struct ksock_conn *conn, int *txmem,
 					  int *rxmem, int *nagle);
 
 extern int ksocknal_tunables_init(void);
+extern int ksocknal_tunables_setup(struct lnet_ni *ni);
 
 extern void ksocknal_lib_csum_tx(struct ksock_tx *tx);
 
@@ -389,8 +389,13 @@ ksocknal_receive(struct ksock_conn *conn)
         RETURN (rc);
 }
 
-void
-ksocknal_tx_done(struct lnet_ni *ni, struct ksock_tx *tx, int rc)
+/*
+ * Free \a tx and queue its lnet msg on \a ready; the caller completes the
+ * batch with lnet_finalize_ready().
+ */
+static void
+ksocknal_tx_done_queue(struct lnet_ni *ni, struct ksock_tx *tx, int rc,
+		       struct list_head *ready)
 {
 	struct lnet_msg *lnetmsg = tx->tx_lnetmsg;
 	enum lnet_msg_hstatus hstatus = tx->tx_hstatus;
@@ -413,16 +418,26 @@ ksocknal_tx_done(struct lnet_ni *ni, struct ksock_tx *tx, int rc)
 			CERROR("tx failure rc = %d, hstatus = %d\n", rc,
 			       hstatus);
 		lnetmsg->msg_health_status = hstatus;
-		lnet_finalize(lnetmsg, rc);
+		lnet_finalize_queue(lnetmsg, rc, ready);
 	}
 
 	EXIT;
 }
 
+void
+ksocknal_tx_done(struct lnet_ni *ni, struct ksock_tx *tx, int rc)
+{
+	LIST_HEAD(ready);
+
+	ksocknal_tx_done_queue(ni, tx, rc, &ready);
+	lnet_finalize_ready(&ready);
+}
+
 void
 ksocknal_txlist_done(struct lnet_ni *ni, struct list_head *txlist, int error)
 {
 	struct ksock_tx *tx;
+	LIST_HEAD(ready);
 
 	while (!list_empty(txlist)) {
 		tx = list_entry(txlist->next, struct ksock_tx, tx_list);
@@ -456,8 +471,10 @@ ksocknal_txlist_done(struct lnet_ni *ni, struct list_head *txlist, int error)
 		}
 
 		LASSERT(atomic_read(&tx->tx_refcount) == 1);
-		ksocknal_tx_done(ni, tx, error);
+		ksocknal_tx_done_queue(ni, tx, error, &ready);
 	}
+
+	lnet_finalize_ready(&ready);
 }
 
 static void
@@ -641,7 +658,7 @@ ksocknal_launch_connection_locked(struct ksock_route *route)
 
         LASSERT (!route->ksnr_scheduled);
         LASSERT (!route->ksnr_connecting);
-        LASSERT ((ksocknal_route_mask() & ~route->ksnr_connected) != 0);
+	LASSERT(ksocknal_route_wanted(route) != 0);
 
         route->ksnr_scheduled = 1;              /* scheduling conn for connd */
         ksocknal_route_addref(route);           /* extra ref for connd */
@@ -700,19 +717,21 @@ ksocknal_find_conn_locked(struct ksock_peer_ni *peer_ni, struct ksock_tx *tx, in
                 case SOCKNAL_MATCH_NO: /* protocol rejected the tx */
                         continue;
 
-                case SOCKNAL_MATCH_YES: /* typed connection */
-                        if (typed == NULL || tnob > nob ||
-                            (tnob == nob && *ksocknal_tunables.ksnd_round_robin &&
-			     typed->ksnc_tx_last_post > c->ksnc_tx_last_post)) {
+		case SOCKNAL_MATCH_YES: /* typed connection */
+			/* with several conns of a type, rotate over them when
+			 * they are equally loaded */
+			if (typed == NULL || tnob > nob ||
+			    (tnob == nob && *ksocknal_tunables.ksnd_round_robin &&
+			     (int)(typed->ksnc_tx_seq - c->ksnc_tx_seq) > 0)) {
                                 typed = c;
                                 tnob  = nob;
                         }
                         break;
 
                 case SOCKNAL_MATCH_MAY: /* fallback connection */
-                        if (fallback == NULL || fnob > nob ||
-                            (fnob == nob && *ksocknal_tunables.ksnd_round_robin &&
-			     fallback->ksnc_tx_last_post > c->ksnc_tx_last_post)) {
+			if (fallback == NULL || fnob > nob ||
+			    (fnob == nob && *ksocknal_tunables.ksnd_round_robin &&
+			     (int)(fallback->ksnc_tx_seq - c->ksnc_tx_seq) > 0)) {
                                 fallback = c;
                                 fnob     = nob;
                         }
@@ -723,8 +742,10 @@ ksocknal_find_conn_locked(struct ksock_peer_ni *peer_ni, struct ksock_tx *tx, in
         /* prefer the typed selection */
         conn = (typed != NULL) ? typed : fallback;
 
-        if (conn != NULL)
+	if (conn != NULL) {
 		conn->ksnc_tx_last_post = ktime_get_seconds();
+		conn->ksnc_tx_seq = atomic_inc_return(&peer_ni->ksnp_tx_seq);
+	}
 
         return conn;
 }
@@ -842,9 +863,9 @@ ksocknal_find_connectable_route_locked(struct ksock_peer_ni *peer_ni)
                 if (route->ksnr_scheduled)      /* connections being established */
                         continue;
 
-                /* all route types connected ? */
-                if ((ksocknal_route_mask() & ~route->ksnr_connected) == 0)
-                        continue;
+		/* all route types connected ? */
+		if (ksocknal_route_wanted(route) == 0)
+			continue;
 
                 if (!(route->ksnr_retry_interval == 0 || /* first attempt */
 		      now >= route->ksnr_timeout)) {
@@ -1162,8 +1183,9 @@ ksocknal_new_packet(struct ksock_conn *conn, int nob_to_skip)
         return (0);
 }
 
+/* NB: completed lnet msgs are queued on \a ready for the caller to finalize */
 static int
-ksocknal_process_receive(struct ksock_conn *conn)
+ksocknal_process_receive(struct ksock_conn *conn, struct list_head *ready)
 {
 	struct lnet_hdr *lhdr;
 	struct lnet_process_id *id;
@@ -1345,7 +1367,7 @@ ksocknal_process_receive(struct ksock_conn *conn)
                                         le64_to_cpu(lhdr->src_nid) != id->nid);
                 }
 
-		lnet_finalize(conn->ksnc_cookie, rc);
+		lnet_finalize_queue(conn->ksnc_cookie, rc, ready);
 
                 if (rc != 0) {
                         ksocknal_new_packet(conn, 0);
@@ -1449,6 +1471,8 @@ int ksocknal_scheduler(void *arg)
 	struct ksock_sched *sched;
 	struct ksock_conn *conn;
 	struct ksock_tx	*tx;
+	LIST_HEAD(ready);
+	int nready = 0;
 	int rc;
 	int nloops = 0;
 	long id = (long)arg;
@@ -1486,7 +1510,8 @@ int ksocknal_scheduler(void *arg)
                         conn->ksnc_rx_ready = 0;
 			spin_unlock_bh(&sched->kss_lock);
 
-			rc = ksocknal_process_receive(conn);
+			rc = ksocknal_process_receive(conn, &ready);
+			nready++;
 
 			spin_lock_bh(&sched->kss_lock);
 
@@ -1563,7 +1588,12 @@ int ksocknal_scheduler(void *arg)
 					     &conn->ksnc_tx_queue);
 			} else {
 				/* Complete send; tx -ref */
-				ksocknal_tx_decref(tx);
+				LASSERT(atomic_read(&tx->tx_refcount) > 0);
+				if (atomic_dec_and_test(&tx->tx_refcount)) {
+					ksocknal_tx_done_queue(NULL, tx, 0,
+							       &ready);
+					nready++;
+				}
 
 				spin_lock_bh(&sched->kss_lock);
                                 /* assume space for more */
@@ -1586,6 +1616,17 @@ int ksocknal_scheduler(void *arg)
 
                         did_something = 1;
                 }
+                if (nready >= SOCKNAL_FINALIZE_BATCH ||
+                    (!did_something && !list_empty(&ready))) {
+			/* finalize a batch of completions in one go, but
+			 * bound how long the first of them waits */
+			spin_unlock_bh(&sched->kss_lock);
+			lnet_finalize_ready(&ready);
+			nready = 0;
+			spin_lock_bh(&sched->kss_lock);
+			continue;
+		}
+
                 if (!did_something ||           /* nothing to do */
                     ++nloops == SOCKNAL_RESCHED) { /* hogging CPU? */
 			spin_unlock_bh(&sched->kss_lock);
@@ -1606,6 +1647,7 @@ int ksocknal_scheduler(void *arg)
 	}
 
 	spin_unlock_bh(&sched->kss_lock);
+	lnet_finalize_ready(&ready);
 	ksocknal_thread_fini();
 	return 0;
 }
@@ -1919,7 +1961,7 @@ ksocknal_connect(struct ksock_route *route)
         route->ksnr_connecting = 1;
 
         for (;;) {
-                wanted = ksocknal_route_mask() & ~route->ksnr_connected;
+		wanted = ksocknal_route_wanted(route);
 
                 /* stop connecting if peer_ni/route got closed under me, or
                  * route got connected while queued */
@@ -1983,6 +2025,18 @@ ksocknal_connect(struct ksock_route *route)
                                libcfs_nid2str(peer_ni->ksnp_id.nid));
 
 		write_lock_bh(&ksocknal_data.ksnd_global_lock);
+
+		/* The peer_ni refused one more bulk connection of a type I
+		 * already have: it runs with a smaller conns_per_peer, so
+		 * settle for the connections established so far. */
+		if (rc == EALREADY && ksocknal_conn_type_is_bulk(type) &&
+		    route->ksnr_conns[type] > 0) {
+			CDEBUG(D_NET, "peer_ni %s accepts %d bulk conns\n",
+			       libcfs_nid2str(peer_ni->ksnp_id.nid),
+			       route->ksnr_conns[type]);
+			route->ksnr_max_conns = route->ksnr_conns[type];
+			retry_later = 0;
+		}
         }
 
         route->ksnr_scheduled = 0;
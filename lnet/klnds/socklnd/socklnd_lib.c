@@ -300,6 +300,118 @@ ksocknal_lib_kiov_vmap(lnet_kiov_t *kiov, int niov,
         return addr;
 }
 
+struct ksock_read_desc {
+	lnet_kiov_t		*krd_kiov;	/* current fragment */
+	unsigned int		 krd_nkiov;	/* # fragments left */
+	unsigned int		 krd_offset;	/* offset in current fragment */
+	__u32			 krd_csum;	/* running checksum */
+	bool			 krd_do_csum;
+};
+
+/*
+ * tcp_read_sock() actor: copy \a len bytes at \a offset in \a skb straight
+ * into the destination pages, folding in the checksum while the data is
+ * still in cache.  Called with the socket locked.
+ */
+static int
+ksocknal_lib_read_actor(read_descriptor_t *desc, struct sk_buff *skb,
+			unsigned int offset, size_t len)
+{
+	struct ksock_read_desc *krd = desc->arg.data;
+	size_t copied = 0;
+
+	len = min_t(size_t, len, desc->count);
+
+	while (copied < len && krd->krd_nkiov > 0) {
+		lnet_kiov_t *kiov = krd->krd_kiov;
+		unsigned int fragnob;
+		void *addr;
+		char *base;
+
+		fragnob = min_t(size_t, kiov->kiov_len - krd->krd_offset,
+				len - copied);
+
+		addr = kmap_atomic(kiov->kiov_page);
+		base = addr + kiov->kiov_offset + krd->krd_offset;
+		if (skb_copy_bits(skb, offset + copied, base, fragnob) != 0) {
+			kunmap_atomic(addr);
+			desc->error = -EFAULT;
+			break;
+		}
+		if (krd->krd_do_csum)
+			krd->krd_csum = ksocknal_csum(krd->krd_csum, base,
+						      fragnob);
+		kunmap_atomic(addr);
+
+		copied += fragnob;
+		krd->krd_offset += fragnob;
+		if (krd->krd_offset == kiov->kiov_len) {
+			krd->krd_kiov++;
+			krd->krd_nkiov--;
+			krd->krd_offset = 0;
+		}
+	}
+
+	desc->count -= copied;
+	return copied;
+}
+
+/*
+ * Receive into the kiov pages with a single copy out of the socket buffers,
+ * without mapping the whole destination up front (no vmap() and its TLB
+ * flush on vunmap, no kmap() of every fragment) and without a second pass
+ * over the data for the checksum.
+ *
+ * \retval >0		bytes received
+ * \retval 0		peer closed the connection
+ * \retval -EAGAIN	nothing queued on the socket yet
+ * \retval -ve		socket error
+ */
+static int
+ksocknal_lib_recv_kiov_read_sock(struct ksock_conn *conn)
+{
+	struct sock *sk = conn->ksnc_sock->sk;
+	struct ksock_read_desc krd = {
+		.krd_kiov	= conn->ksnc_rx_kiov,
+		.krd_nkiov	= conn->ksnc_rx_nkiov,
+		.krd_csum	= conn->ksnc_rx_csum,
+		.krd_do_csum	= conn->ksnc_msg.ksm_csum != 0,
+	};
+	read_descriptor_t desc = {
+		.arg.data	= &krd,
+	};
+	int nob;
+	int rc;
+	int i;
+
+	for (nob = i = 0; i < conn->ksnc_rx_nkiov; i++)
+		nob += conn->ksnc_rx_kiov[i].kiov_len;
+
+	LASSERT(nob <= conn->ksnc_rx_nob_wanted);
+	desc.count = nob;
+
+	lock_sock(sk);
+	rc = tcp_read_sock(sk, &desc, ksocknal_lib_read_actor);
+	if (rc == 0) {
+		/* tcp_read_sock() returns 0 both for an empty queue and
+		 * for EOF; our caller takes 0 to mean EOF */
+		if (sk->sk_err != 0)
+			rc = sock_error(sk);
+		else if (!(sk->sk_shutdown & RCV_SHUTDOWN) &&
+			 !sock_flag(sk, SOCK_DONE))
+			rc = -EAGAIN;
+	}
+	release_sock(sk);
+
+	if (desc.error != 0 && rc <= 0)
+		rc = desc.error;
+
+	if (rc > 0 && krd.krd_do_csum)
+		conn->ksnc_rx_csum = krd.krd_csum;
+
+	return rc;
+}
+
 int
 ksocknal_lib_recv_kiov(struct ksock_conn *conn)
 {
@@ -329,6 +441,10 @@ ksocknal_lib_recv_kiov(struct ksock_conn *conn)
         int          fragnob;
 	int n;
 
+	if (*ksocknal_tunables.ksnd_rx_read_sock &&
+	    conn->ksnc_rx_nob_wanted >= *ksocknal_tunables.ksnd_zc_min_payload)
+		return ksocknal_lib_recv_kiov_read_sock(conn);
+
         /* NB we can't trust socket ops to either consume our iovs
          * or leave them alone. */
 	if ((addr = ksocknal_lib_kiov_vmap(kiov, niov, scratchiov, pages)) != NULL) {
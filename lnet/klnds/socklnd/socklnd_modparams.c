@@ -21,6 +21,8 @@
 
 #include "socklnd.h"
 
+#define CURRENT_LND_VERSION 1
+
 static int sock_timeout = 50;
 module_param(sock_timeout, int, 0644);
 MODULE_PARM_DESC(sock_timeout, "dead socket timeout (seconds)");
@@ -71,6 +73,10 @@ static int typed_conns = 1;
 module_param(typed_conns, int, 0444);
 MODULE_PARM_DESC(typed_conns, "use different sockets for bulk");
 
+static int conns_per_peer = 1;
+module_param(conns_per_peer, int, 0444);
+MODULE_PARM_DESC(conns_per_peer, "# bulk connections of each direction per peer");
+
 static int min_bulk = (1<<10);
 module_param(min_bulk, int, 0644);
 MODULE_PARM_DESC(min_bulk, "smallest 'large' message");
@@ -139,6 +145,10 @@ static unsigned int zc_recv_min_nfrags = 16;
 module_param(zc_recv_min_nfrags, int, 0644);
 MODULE_PARM_DESC(zc_recv_min_nfrags, "minimum # of fragments to enable ZC recv");
 
+static int rx_read_sock = 1;
+module_param(rx_read_sock, int, 0644);
+MODULE_PARM_DESC(rx_read_sock, "copy bulk payloads >= zc_min_payload straight from socket buffers into pages");
+
 #ifdef SOCKNAL_BACKOFF
 static int backoff_init = 3;
 module_param(backoff_init, int, 0644);
@@ -169,6 +179,7 @@ int ksocknal_tunables_init(void)
         ksocknal_tunables.ksnd_max_reconnectms    = &max_reconnectms;
         ksocknal_tunables.ksnd_eager_ack          = &eager_ack;
         ksocknal_tunables.ksnd_typed_conns        = &typed_conns;
+	ksocknal_tunables.ksnd_conns_per_peer	  = &conns_per_peer;
         ksocknal_tunables.ksnd_min_bulk           = &min_bulk;
         ksocknal_tunables.ksnd_tx_buffer_size     = &tx_buffer_size;
         ksocknal_tunables.ksnd_rx_buffer_size     = &rx_buffer_size;
@@ -188,6 +199,7 @@ int ksocknal_tunables_init(void)
         ksocknal_tunables.ksnd_zc_min_payload     = &zc_min_payload;
         ksocknal_tunables.ksnd_zc_recv            = &zc_recv;
         ksocknal_tunables.ksnd_zc_recv_min_nfrags = &zc_recv_min_nfrags;
+	ksocknal_tunables.ksnd_rx_read_sock	  = &rx_read_sock;
 
 #ifdef CPU_AFFINITY
 	if (enable_irq_affinity) {
@@ -213,3 +225,30 @@ int ksocknal_tunables_init(void)
 
 	return 0;
 };
+
+int ksocknal_tunables_setup(struct lnet_ni *ni)
+{
+	struct lnet_ioctl_config_socklnd_tunables *tunables;
+
+	tunables = &ni->ni_lnd_tunables.lnd_tun_u.lnd_sock;
+	if (!ni->ni_lnd_tunables_set)
+		memset(tunables, 0, sizeof(*tunables));
+
+	/* Current API version */
+	tunables->lnd_version = CURRENT_LND_VERSION;
+
+	if (!tunables->lnd_conns_per_peer)
+		tunables->lnd_conns_per_peer = conns_per_peer;
+
+	if (tunables->lnd_conns_per_peer < 1)
+		tunables->lnd_conns_per_peer = 1;
+
+	if (tunables->lnd_conns_per_peer > SOCKNAL_CONNS_PER_PEER_MAX) {
+		CWARN("conns_per_peer %u is too large, using %d\n",
+		      tunables->lnd_conns_per_peer,
+		      SOCKNAL_CONNS_PER_PEER_MAX);
+		tunables->lnd_conns_per_peer = SOCKNAL_CONNS_PER_PEER_MAX;
+	}
+
+	return 0;
+}
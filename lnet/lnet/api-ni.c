@@ -78,6 +78,31 @@ module_param(lnet_numa_range, uint, 0444);
 MODULE_PARM_DESC(lnet_numa_range,
 		"NUMA range to consider during Multi-Rail selection");
 
+/*
+ * With lnet_latency_select set, Multi-Rail prefers NIs and peer NIs whose
+ * sends have recently been completing faster, once health and NUMA
+ * distance are equal. Latencies closer than lnet_latency_hysteresis
+ * percent are treated as equal.
+ */
+unsigned int lnet_latency_select;
+module_param(lnet_latency_select, uint, 0644);
+MODULE_PARM_DESC(lnet_latency_select,
+		"Prefer faster NIs and peer NIs during Multi-Rail selection");
+
+unsigned int lnet_latency_hysteresis = 20;
+module_param(lnet_latency_hysteresis, uint, 0644);
+MODULE_PARM_DESC(lnet_latency_hysteresis,
+		"Percent by which latencies must differ to affect selection");
+
+/*
+ * Each CPT has its own discovery thread, which keeps at most
+ * lnet_peer_discovery_batch peers with a Ping or Push in flight.
+ */
+unsigned int lnet_peer_discovery_batch = 256;
+module_param(lnet_peer_discovery_batch, uint, 0644);
+MODULE_PARM_DESC(lnet_peer_discovery_batch,
+		"Max # of peers being discovered per CPT, 0 for no limit");
+
 /*
  * lnet_health_sensitivity determines by how much we decrement the health
  * value on sending error. The value defaults to 0, which means health
@@ -445,6 +470,7 @@ lnet_fini_locks(void)
 struct kmem_cache *lnet_mes_cachep;	   /* MEs kmem_cache */
 struct kmem_cache *lnet_small_mds_cachep;  /* <= LNET_SMALL_MD_SIZE bytes
 					    *  MDs kmem_cache */
+struct kmem_cache *lnet_msgs_cachep;	   /* lnet_msg kmem_cache */
 
 static int
 lnet_descriptor_setup(void)
@@ -463,6 +489,12 @@ lnet_descriptor_setup(void)
 	if (!lnet_small_mds_cachep)
 		return -ENOMEM;
 
+	lnet_msgs_cachep = kmem_cache_create("lnet_msgs",
+					     sizeof(struct lnet_msg), 0, 0,
+					     NULL);
+	if (!lnet_msgs_cachep)
+		return -ENOMEM;
+
 	return 0;
 }
 
@@ -470,6 +502,11 @@ static void
 lnet_descriptor_cleanup(void)
 {
 
+	if (lnet_msgs_cachep) {
+		kmem_cache_destroy(lnet_msgs_cachep);
+		lnet_msgs_cachep = NULL;
+	}
+
 	if (lnet_small_mds_cachep) {
 		kmem_cache_destroy(lnet_small_mds_cachep);
 		lnet_small_mds_cachep = NULL;
@@ -985,8 +1022,6 @@ lnet_prepare(lnet_pid_t requested_pid)
 	INIT_LIST_HEAD(&the_lnet.ln_routers);
 	INIT_LIST_HEAD(&the_lnet.ln_drop_rules);
 	INIT_LIST_HEAD(&the_lnet.ln_delay_rules);
-	INIT_LIST_HEAD(&the_lnet.ln_dc_request);
-	INIT_LIST_HEAD(&the_lnet.ln_dc_working);
 	INIT_LIST_HEAD(&the_lnet.ln_dc_expired);
 	INIT_LIST_HEAD(&the_lnet.ln_mt_localNIRecovq);
 	INIT_LIST_HEAD(&the_lnet.ln_mt_peerNIRecovq);
@@ -3296,6 +3331,10 @@ lnet_get_local_ni_hstats(struct lnet_ioctl_local_ni_hstats *stats)
 	stats->hlni_local_timeout = atomic_read(&ni->ni_hstats.hlt_local_timeout);
 	stats->hlni_local_error = atomic_read(&ni->ni_hstats.hlt_local_error);
 	stats->hlni_health_value = atomic_read(&ni->ni_healthv);
+	if (stats->hlni_hdr.ioc_len >= sizeof(*stats))
+		stats->hlni_latency_us = div_u64(
+			atomic64_read(&ni->ni_latency.lat_ewma_ns),
+			NSEC_PER_USEC);
 
 unlock:
 	lnet_net_unlock(cpt);
@@ -3554,7 +3593,10 @@ LNetCtl(unsigned int cmd, void *arg)
 	case IOC_LIBCFS_GET_LOCAL_HSTATS: {
 		struct lnet_ioctl_local_ni_hstats *stats = arg;
 
-		if (stats->hlni_hdr.ioc_len < sizeof(*stats))
+		/* hlni_latency_us is only filled in for tools that know it */
+		if (stats->hlni_hdr.ioc_len <
+		    offsetof(struct lnet_ioctl_local_ni_hstats,
+			     hlni_latency_us))
 			return -EINVAL;
 
 		mutex_lock(&the_lnet.ln_api_mutex);
@@ -3578,6 +3620,18 @@ LNetCtl(unsigned int cmd, void *arg)
 		return rc;
 	}
 
+	case IOC_LIBCFS_GET_RTRPOOL_STATS: {
+		struct lnet_ioctl_rtrpool_stats *stats = arg;
+
+		if (stats->rps_hdr.ioc_len < sizeof(*stats))
+			return -EINVAL;
+
+		mutex_lock(&the_lnet.ln_api_mutex);
+		rc = lnet_get_rtrpool_stats(stats);
+		mutex_unlock(&the_lnet.ln_api_mutex);
+		return rc;
+	}
+
 	case IOC_LIBCFS_ADD_PEER_NI: {
 		struct lnet_ioctl_peer_cfg *cfg = arg;
 
@@ -76,6 +76,7 @@ LNetMEAttach(unsigned int portal,
 	     struct lnet_handle_me *handle)
 {
 	struct lnet_match_table *mtable;
+	struct lnet_portal	*ptl;
 	struct lnet_me		*me;
 	struct list_head	*head;
 
@@ -89,6 +90,10 @@ LNetMEAttach(unsigned int portal,
 	if (mtable == NULL) /* can't match portal type */
 		return -EPERM;
 
+	ptl = the_lnet.ln_portals[portal];
+	if (lnet_ptl_is_unique(ptl))
+		lnet_mt_grow_uhash(mtable);
+
 	me = lnet_me_alloc();
 	if (me == NULL)
 		return -ENOMEM;
@@ -109,7 +114,13 @@ LNetMEAttach(unsigned int portal,
 	else
 		head = lnet_mt_match_head(mtable, match_id, match_bits);
 
-	me->me_pos = head - &mtable->mt_mhash[0];
+	if (lnet_ptl_is_unique(ptl)) {
+		/* exhausted chains are only tracked for wildcard portals */
+		me->me_pos = 0;
+		mtable->mt_nmes++;
+	} else {
+		me->me_pos = head - &mtable->mt_mhash[0];
+	}
 	if (pos == LNET_INS_AFTER || pos == LNET_INS_LOCAL)
 		list_add_tail(&me->me_list, head);
 	else
@@ -258,8 +269,16 @@ EXPORT_SYMBOL(LNetMEUnlink);
 void
 lnet_me_unlink(struct lnet_me *me)
 {
+	struct lnet_portal *ptl = the_lnet.ln_portals[me->me_portal];
+
 	list_del(&me->me_list);
 
+	if (lnet_ptl_is_unique(ptl)) {
+		int cpt = lnet_cpt_of_cookie(me->me_lh.lh_cookie);
+
+		ptl->ptl_mtables[cpt]->mt_nmes--;
+	}
+
 	if (me->me_md != NULL) {
 		struct lnet_libmd *md = me->me_md;
 
@@ -46,6 +46,11 @@ static int local_nid_dist_zero = 1;
 module_param(local_nid_dist_zero, int, 0444);
 MODULE_PARM_DESC(local_nid_dist_zero, "Reserved");
 
+static int local_nid_loopback = 1;
+module_param(local_nid_loopback, int, 0644);
+MODULE_PARM_DESC(local_nid_loopback,
+		 "Deliver messages to this node's own NIDs through the loopback NI");
+
 struct lnet_send_data {
 	struct lnet_ni *sd_best_ni;
 	struct lnet_peer_ni *sd_best_lpni;
@@ -763,6 +768,7 @@ lnet_ni_send(struct lnet_ni *ni, struct lnet_msg *msg)
 	LASSERT (LNET_NETTYP(LNET_NIDNET(ni->ni_nid)) == LOLND ||
 		 (msg->msg_txcredit && msg->msg_peertxcredit));
 
+	msg->msg_send_time = ktime_get();
 	rc = (ni->ni_net->net_lnd->lnd_send)(ni, priv, msg);
 	if (rc < 0) {
 		msg->msg_no_resend = true;
@@ -1093,6 +1099,15 @@ lnet_post_routed_recv_locked(struct lnet_msg *msg, int do_recv)
 		rbp->rbp_credits--;
 		if (rbp->rbp_credits < rbp->rbp_mincredits)
 			rbp->rbp_mincredits = rbp->rbp_credits;
+		if (rbp->rbp_credits < rbp->rbp_adapt_mincredits)
+			rbp->rbp_adapt_mincredits = rbp->rbp_credits;
+
+		if (rbp->rbp_credits < 0)
+			rbp->rbp_hist[LNET_RTRPOOL_HIST_BUCKETS - 1]++;
+		else
+			rbp->rbp_hist[min((rbp->rbp_nbuffers -
+					   rbp->rbp_credits) * 10 /
+					  rbp->rbp_nbuffers, 9)]++;
 
 		if (rbp->rbp_credits < 0) {
 			/* must have checked eager_recv before here */
@@ -1457,6 +1472,7 @@ lnet_get_best_ni(struct lnet_net *local_net, struct lnet_ni *best_ni,
 	unsigned int shortest_distance;
 	int best_credits;
 	int best_healthv;
+	s64 best_lat;
 
 	/*
 	 * If there is no peer_ni that we can send to on this network,
@@ -1469,11 +1485,13 @@ lnet_get_best_ni(struct lnet_net *local_net, struct lnet_ni *best_ni,
 		shortest_distance = UINT_MAX;
 		best_credits = INT_MIN;
 		best_healthv = 0;
+		best_lat = 0;
 	} else {
 		shortest_distance = cfs_cpt_distance(lnet_cpt_table(), md_cpt,
 						     best_ni->ni_dev_cpt);
 		best_credits = atomic_read(&best_ni->ni_tx_credits);
 		best_healthv = atomic_read(&best_ni->ni_healthv);
+		best_lat = lnet_latency_get(&best_ni->ni_latency);
 	}
 
 	while ((ni = lnet_get_next_ni_locked(local_net, ni))) {
@@ -1481,10 +1499,13 @@ lnet_get_best_ni(struct lnet_net *local_net, struct lnet_ni *best_ni,
 		int ni_credits;
 		int ni_healthv;
 		int ni_fatal;
+		s64 ni_lat;
+		int lat_cmp;
 
 		ni_credits = atomic_read(&ni->ni_tx_credits);
 		ni_healthv = atomic_read(&ni->ni_healthv);
 		ni_fatal = atomic_read(&ni->ni_fatal_error_on);
+		ni_lat = lnet_latency_get(&ni->ni_latency);
 
 		/*
 		 * calculate the distance from the CPT on which
@@ -1509,9 +1530,11 @@ lnet_get_best_ni(struct lnet_net *local_net, struct lnet_ni *best_ni,
 			distance = lnet_numa_range;
 
 		/*
-		 * Select on health, shorter distance, available
-		 * credits, then round-robin.
+		 * Select on health, shorter distance, latency (if the
+		 * latency policy is on), available credits, then
+		 * round-robin.
 		 */
+		lat_cmp = lnet_latency_cmp(ni_lat, best_lat);
 		if (ni_fatal) {
 			continue;
 		} else if (ni_healthv < best_healthv) {
@@ -1531,6 +1554,10 @@ lnet_get_best_ni(struct lnet_net *local_net, struct lnet_ni *best_ni,
 			continue;
 		} else if (distance < shortest_distance) {
 			shortest_distance = distance;
+		} else if (lat_cmp > 0) {
+			continue;
+		} else if (lat_cmp < 0) {
+			/* faster, take it whatever its credits */
 		} else if (ni_credits < best_credits) {
 			continue;
 		} else if (ni_credits == best_credits) {
@@ -1539,6 +1566,7 @@ lnet_get_best_ni(struct lnet_net *local_net, struct lnet_ni *best_ni,
 		}
 		best_ni = ni;
 		best_credits = ni_credits;
+		best_lat = ni_lat;
 	}
 
 	CDEBUG(D_NET, "selected best_ni %s\n",
@@ -1729,6 +1757,9 @@ lnet_select_peer_ni(struct lnet_send_data *sd, struct lnet_peer *peer,
 	bool ni_is_pref;
 	int best_lpni_healthv = 0;
 	int lpni_healthv;
+	s64 best_lpni_lat = 0;
+	s64 lpni_lat;
+	int lat_cmp;
 
 	while ((lpni = lnet_get_next_peer_ni_locked(peer, peer_net, lpni))) {
 		/*
@@ -1739,6 +1770,8 @@ lnet_select_peer_ni(struct lnet_send_data *sd, struct lnet_peer *peer,
 							  best_ni->ni_nid);
 
 		lpni_healthv = atomic_read(&lpni->lpni_healthv);
+		lpni_lat = lnet_latency_get(&lpni->lpni_latency);
+		lat_cmp = lnet_latency_cmp(lpni_lat, best_lpni_lat);
 
 		CDEBUG(D_NET, "%s ni_is_pref = %d\n",
 		       libcfs_nid2str(best_ni->ni_nid), ni_is_pref);
@@ -1763,6 +1796,11 @@ lnet_select_peer_ni(struct lnet_send_data *sd, struct lnet_peer *peer,
 			 * it.
 			 */
 			continue;
+		} else if (lat_cmp > 0) {
+			/* noticeably slower than the best so far */
+			continue;
+		} else if (lat_cmp < 0) {
+			/* noticeably faster, take it whatever its credits */
 		} else if (lpni->lpni_txcredits < best_lpni_credits) {
 			/*
 			 * We already have a peer that has more credits
@@ -1785,6 +1823,7 @@ lnet_select_peer_ni(struct lnet_send_data *sd, struct lnet_peer *peer,
 
 		best_lpni = lpni;
 		best_lpni_credits = lpni->lpni_txcredits;
+		best_lpni_lat = lpni_lat;
 	}
 
 	/* if we still can't find a peer ni then we can't reach it */
@@ -2504,6 +2543,32 @@ again:
 		return LNET_CREDIT_OK;
 	}
 
+	/*
+	 * The destination is one of our own NIs, e.g. a client mounted on
+	 * a server node, or lnet_selftest run against itself.  Hand the
+	 * message to lolnd rather than pushing it through the network
+	 * LND's stack to ourselves.  Unlike the 0@lo case above, the NIDs
+	 * in the header are left alone, so the receiver still sees the
+	 * real source and replies come back along the same path.
+	 */
+	if (local_nid_loopback && !msg->msg_routing &&
+	    lnet_nid2ni_locked(dst_nid, cpt) != NULL) {
+		lnet_ni_addref_locked(the_lnet.ln_loni, cpt);
+		msg->msg_hdr.dest_nid = cpu_to_le64(dst_nid);
+		if (src_nid == LNET_NID_ANY ||
+		    LNET_NETTYP(LNET_NIDNET(src_nid)) == LOLND)
+			src_nid = dst_nid;
+		msg->msg_hdr.src_nid = cpu_to_le64(src_nid);
+		msg->msg_target.nid = dst_nid;
+		lnet_msg_commit(msg, cpt);
+		msg->msg_txni = the_lnet.ln_loni;
+		lnet_net_unlock(cpt);
+
+		CDEBUG(D_NET, "%s -> %s: local NID, sent via loopback\n",
+		       libcfs_nid2str(src_nid), libcfs_nid2str(dst_nid));
+		return LNET_CREDIT_OK;
+	}
+
 	/*
 	 * find an existing peer_ni, or create one and mark it as having been
 	 * created due to network traffic. This call will create the
@@ -3279,6 +3344,8 @@ lnet_monitor_thread(void *arg)
 
 		lnet_resend_pending_msgs();
 
+		lnet_rtrpools_adapt();
+
 		wakeup_counter++;
 		if (wakeup_counter >= lnet_transaction_timeout / 2) {
 			lnet_finalize_expired_responses(false);
@@ -4023,7 +4090,9 @@ lnet_parse(struct lnet_ni *ni, struct lnet_hdr *hdr, lnet_nid_t from_nid,
 	dest_pid = le32_to_cpu(hdr->dest_pid);
 	payload_length = le32_to_cpu(hdr->payload_length);
 
-	for_me = (ni->ni_nid == dest_nid);
+	/* lolnd also carries messages addressed to our other local NIDs */
+	for_me = (ni->ni_nid == dest_nid) ||
+		 (ni == the_lnet.ln_loni && lnet_islocalnid(dest_nid));
 	cpt = lnet_cpt_of_nid(from_nid, ni);
 
 	CDEBUG(D_NET, "TRACE: %s(%s) <- %s : %s - %s\n",
@@ -385,6 +385,34 @@ lnet_msg_detach_md(struct lnet_msg *msg, int status)
 	msg->msg_md = NULL;
 }
 
+/*
+ * Take and drop lnet_net_lock(\a cpt) on the finalize path, accounting each
+ * hold in the message container's statistics.  The CPT lock is exclusive,
+ * so the start time of the current hold can live in the container.
+ */
+static inline void
+lnet_finalize_lock(int cpt)
+{
+	struct lnet_msg_container *container = the_lnet.ln_msg_containers[cpt];
+
+	lnet_net_lock(cpt);
+	container->msc_lock_count++;
+	container->msc_lock_start = ktime_get_ns();
+}
+
+static inline void
+lnet_finalize_unlock(int cpt)
+{
+	struct lnet_msg_container *container = the_lnet.ln_msg_containers[cpt];
+	__u64 hold = ktime_get_ns() - container->msc_lock_start;
+
+	container->msc_hold_ns += hold;
+	if (hold > container->msc_hold_max_ns)
+		container->msc_hold_max_ns = hold;
+	lnet_net_unlock(cpt);
+}
+
+/* NB: called with lnet_finalize_lock(\a cpt) held, may drop and retake it */
 static int
 lnet_complete_msg_locked(struct lnet_msg *msg, int cpt)
 {
@@ -400,7 +428,7 @@ lnet_complete_msg_locked(struct lnet_msg *msg, int cpt)
 		lnet_msg_decommit(msg, cpt, 0);
 
 		msg->msg_ack = 0;
-		lnet_net_unlock(cpt);
+		lnet_finalize_unlock(cpt);
 
 		LASSERT(msg->msg_ev.type == LNET_EVENT_PUT);
 		LASSERT(!msg->msg_routing);
@@ -417,7 +445,7 @@ lnet_complete_msg_locked(struct lnet_msg *msg, int cpt)
 		 * parameter (router NID) if it's routed message */
 		rc = lnet_send(msg->msg_ev.target.nid, msg, LNET_NID_ANY);
 
-		lnet_net_lock(cpt);
+		lnet_finalize_lock(cpt);
 		/*
 		 * NB: message is committed for sending, we should return
 		 * on success because LND will finalize this message later.
@@ -435,11 +463,11 @@ lnet_complete_msg_locked(struct lnet_msg *msg, int cpt)
 		   (msg->msg_routing && !msg->msg_sending)) {
 		/* not forwarded */
 		LASSERT(!msg->msg_receiving);	/* called back recv already */
-		lnet_net_unlock(cpt);
+		lnet_finalize_unlock(cpt);
 
 		rc = lnet_send(LNET_NID_ANY, msg, LNET_NID_ANY);
 
-		lnet_net_lock(cpt);
+		lnet_finalize_lock(cpt);
 		/*
 		 * NB: message is committed for sending, we should return
 		 * on success because LND will finalize this message later.
@@ -653,6 +681,14 @@ lnet_health_check(struct lnet_msg *msg)
 		if (msg->msg_txpeer)
 			lnet_inc_healthv(&msg->msg_txpeer->lpni_healthv);
 
+		if (!lo && ktime_to_ns(msg->msg_send_time) != 0) {
+			s64 ns = ktime_to_ns(ktime_sub(ktime_get(),
+						       msg->msg_send_time));
+
+			lnet_latency_sample(&msg->msg_txni->ni_latency, ns);
+			lnet_latency_sample(&msg->msg_txpeer->lpni_latency, ns);
+		}
+
 		/* we can finalize this message */
 		return -1;
 	case LNET_MSG_STATUS_LOCAL_INTERRUPT:
@@ -841,20 +877,14 @@ lnet_send_error_simulation(struct lnet_msg *msg,
 }
 EXPORT_SYMBOL(lnet_send_error_simulation);
 
-void
-lnet_finalize(struct lnet_msg *msg, int status)
+/*
+ * First step of finalizing \a msg: record its status and drop what it
+ * holds that does not need the net lock.
+ */
+static void
+lnet_finalize_start(struct lnet_msg *msg, int status)
 {
-	struct lnet_msg_container *container;
-	int my_slot;
 	int cpt;
-	int rc;
-	int i;
-	bool hc;
-
-	LASSERT(!in_interrupt());
-
-	if (msg == NULL)
-		return;
 
 	msg->msg_ev.status = status;
 
@@ -871,8 +901,20 @@ lnet_finalize(struct lnet_msg *msg, int status)
 	/* if the message is successfully sent, no need to keep the MD around */
 	if (msg->msg_md != NULL && !status)
 		lnet_detach_md(msg, status);
+}
+
+/*
+ * Decide what happens to \a msg next.
+ *
+ * \retval true	\a msg must be completed under its CPT lock
+ * \retval false	\a msg has been freed or queued for resend
+ */
+static bool
+lnet_finalize_check(struct lnet_msg *msg)
+{
+	int status = msg->msg_ev.status;
+	bool hc;
 
-again:
 	hc = lnet_is_health_check(msg);
 
 	/*
@@ -890,12 +932,11 @@ again:
 	if (msg->msg_md != NULL && !hc)
 		lnet_detach_md(msg, status);
 
-	rc = 0;
 	if (!msg->msg_tx_committed && !msg->msg_rx_committed) {
 		/* not committed to network yet */
 		LASSERT(!msg->msg_onactivelist);
 		lnet_msg_free(msg);
-		return;
+		return false;
 	}
 
 	if (hc) {
@@ -912,7 +953,7 @@ again:
 		 * put on the resend queue.
 		 */
 		if (!lnet_health_check(msg))
-			return;
+			return false;
 
 		/*
 		 * if we get here then we need to clean up the md because we're
@@ -922,16 +963,36 @@ again:
 			lnet_detach_md(msg, status);
 	}
 
+	return true;
+}
+
+static inline int
+lnet_msg_finalize_cpt(struct lnet_msg *msg)
+{
 	/*
 	 * NB: routed message can be committed for both receiving and sending,
 	 * we should finalize in LIFO order and keep counters correct.
 	 * (finalize sending first then finalize receiving)
 	 */
-	cpt = msg->msg_tx_committed ? msg->msg_tx_cpt : msg->msg_rx_cpt;
-	lnet_net_lock(cpt);
+	return msg->msg_tx_committed ? msg->msg_tx_cpt : msg->msg_rx_cpt;
+}
 
-	container = the_lnet.ln_msg_containers[cpt];
-	list_add_tail(&msg->msg_list, &container->msc_finalizing);
+/*
+ * Complete the messages queued on the finalizing list of \a cpt.  Called
+ * and returns with lnet_finalize_lock(\a cpt) held.
+ *
+ * \retval NULL	the list has been drained, or another finalizer owns it
+ * \retval msg	a message whose completion failed to send and has to be
+ *		checked and queued again
+ */
+static struct lnet_msg *
+lnet_finalize_locked(int cpt)
+{
+	struct lnet_msg_container *container = the_lnet.ln_msg_containers[cpt];
+	struct lnet_msg *msg;
+	struct lnet_msg *retry = NULL;
+	int my_slot;
+	int i;
 
 	/* Recursion breaker.  Don't complete the message here if I am (or
 	 * enough other threads are) already completing messages */
@@ -945,10 +1006,8 @@ again:
 			my_slot = i;
 	}
 
-	if (i < container->msc_nfinalizers || my_slot < 0) {
-		lnet_net_unlock(cpt);
-		return;
-	}
+	if (i < container->msc_nfinalizers || my_slot < 0)
+		return NULL;
 
 	container->msc_finalizers[my_slot] = current;
 
@@ -960,25 +1019,117 @@ again:
 
 		/* NB drops and regains the lnet lock if it actually does
 		 * anything, so my finalizing friends can chomp along too */
-		rc = lnet_complete_msg_locked(msg, cpt);
-		if (rc != 0)
+		if (lnet_complete_msg_locked(msg, cpt) != 0) {
+			retry = msg;
 			break;
+		}
+		container->msc_completed++;
 	}
 
 	if (unlikely(!list_empty(&the_lnet.ln_delay_rules))) {
-		lnet_net_unlock(cpt);
+		lnet_finalize_unlock(cpt);
 		lnet_delay_rule_check();
-		lnet_net_lock(cpt);
+		lnet_finalize_lock(cpt);
 	}
 
 	container->msc_finalizers[my_slot] = NULL;
-	lnet_net_unlock(cpt);
 
-	if (rc != 0)
-		goto again;
+	return retry;
+}
+
+static void
+lnet_finalize_one(struct lnet_msg *msg)
+{
+	int cpt;
+
+	while (msg != NULL && lnet_finalize_check(msg)) {
+		cpt = lnet_msg_finalize_cpt(msg);
+		lnet_finalize_lock(cpt);
+		list_add_tail(&msg->msg_list,
+			      &the_lnet.ln_msg_containers[cpt]->msc_finalizing);
+		msg = lnet_finalize_locked(cpt);
+		lnet_finalize_unlock(cpt);
+	}
+}
+
+void
+lnet_finalize(struct lnet_msg *msg, int status)
+{
+	LASSERT(!in_interrupt());
+
+	if (msg == NULL)
+		return;
+
+	lnet_finalize_start(msg, status);
+	lnet_finalize_one(msg);
 }
 EXPORT_SYMBOL(lnet_finalize);
 
+/**
+ * Prepare \a msg for finalizing with \a status, as lnet_finalize() does,
+ * but leave it on \a ready instead of completing it.  An LND that reaps
+ * several completions in one pass queues them here and then hands the
+ * whole batch to lnet_finalize_ready(), so the CPT lock is taken once
+ * per run of messages instead of once per message.
+ *
+ * \param msg	message to finalize, may be NULL
+ * \param status	completion status of \a msg
+ * \param ready	list the prepared message is linked on through msg_list
+ */
+void
+lnet_finalize_queue(struct lnet_msg *msg, int status, struct list_head *ready)
+{
+	LASSERT(!in_interrupt());
+
+	if (msg == NULL)
+		return;
+
+	lnet_finalize_start(msg, status);
+	if (lnet_finalize_check(msg))
+		list_add_tail(&msg->msg_list, ready);
+}
+EXPORT_SYMBOL(lnet_finalize_queue);
+
+/**
+ * Complete every message queued on \a ready by lnet_finalize_queue().
+ * Consecutive messages that complete on the same CPT are moved to its
+ * finalizing list under a single lnet_net_lock().
+ *
+ * \param ready	list of prepared messages, empty on return
+ */
+void
+lnet_finalize_ready(struct list_head *ready)
+{
+	struct lnet_msg_container *container;
+	struct lnet_msg *msg;
+	struct lnet_msg *retry;
+	int cpt;
+
+	LASSERT(!in_interrupt());
+
+	while (!list_empty(ready)) {
+		msg = list_entry(ready->next, struct lnet_msg, msg_list);
+		cpt = lnet_msg_finalize_cpt(msg);
+		container = the_lnet.ln_msg_containers[cpt];
+
+		lnet_finalize_lock(cpt);
+		do {
+			list_move_tail(&msg->msg_list,
+				       &container->msc_finalizing);
+			if (list_empty(ready))
+				break;
+			msg = list_entry(ready->next, struct lnet_msg,
+					 msg_list);
+		} while (lnet_msg_finalize_cpt(msg) == cpt);
+
+		retry = lnet_finalize_locked(cpt);
+		lnet_finalize_unlock(cpt);
+
+		lnet_finalize_one(retry);
+	}
+}
+EXPORT_SYMBOL(lnet_finalize_ready);
+
 void
 lnet_msg_container_cleanup(struct lnet_msg_container *container)
 {
@@ -354,21 +354,118 @@ lnet_mt_set_exhausted(struct lnet_match_table *mtable, int pos, int exhausted)
 		*bmap |= 1ULL << pos;
 }
 
+static inline unsigned long
+lnet_mt_unique_hash(struct lnet_process_id id, __u64 mbits, unsigned int bits)
+{
+	return hash_long(mbits + id.nid + id.pid, bits);
+}
+
 struct list_head *
 lnet_mt_match_head(struct lnet_match_table *mtable,
 		   struct lnet_process_id id, __u64 mbits)
 {
 	struct lnet_portal *ptl = the_lnet.ln_portals[mtable->mt_portal];
+	unsigned long hash;
 
-	if (lnet_ptl_is_wildcard(ptl)) {
+	if (lnet_ptl_is_wildcard(ptl))
 		return &mtable->mt_mhash[mbits & LNET_MT_HASH_MASK];
-	} else {
-		unsigned long hash = mbits + id.nid + id.pid;
 
-		LASSERT(lnet_ptl_is_unique(ptl));
-		hash = hash_long(hash, LNET_MT_HASH_BITS);
-		return &mtable->mt_mhash[hash & LNET_MT_HASH_MASK];
+	LASSERT(lnet_ptl_is_unique(ptl));
+	if (mtable->mt_uhash != NULL) {
+		hash = lnet_mt_unique_hash(id, mbits, mtable->mt_uhash_bits);
+		return &mtable->mt_uhash[hash];
 	}
+
+	hash = lnet_mt_unique_hash(id, mbits, LNET_MT_HASH_BITS);
+	return &mtable->mt_mhash[hash & LNET_MT_HASH_MASK];
+}
+
+static inline unsigned int
+lnet_mt_uhash_bits(struct lnet_match_table *mtable)
+{
+	return mtable->mt_uhash != NULL ? mtable->mt_uhash_bits :
+					  LNET_MT_HASH_BITS;
+}
+
+static inline bool
+lnet_mt_uhash_crowded(struct lnet_match_table *mtable)
+{
+	unsigned int bits = lnet_mt_uhash_bits(mtable);
+
+	return bits < LNET_MT_UHASH_BITS_MAX &&
+	       mtable->mt_nmes > (LNET_MT_UHASH_CHAIN << bits);
+}
+
+/**
+ * Grow the hash of a unique portal's match table once its chains get
+ * long.  ptlrpc posts one ME per outstanding reply and bulk on these
+ * portals, keyed by XID, so a busy node can have many thousands of them
+ * on a table that starts with LNET_MT_HASH_SIZE chains.
+ *
+ * Called without lnet_res_lock; the table is rehashed under it.  The
+ * relative order of MEs with the same key is kept, since they all come
+ * from one old chain and are appended to one new chain in order.
+ */
+void
+lnet_mt_grow_uhash(struct lnet_match_table *mtable)
+{
+	struct list_head *old;
+	struct list_head *uhash;
+	struct lnet_me *me;
+	struct lnet_me *tmp;
+	unsigned int old_bits;
+	unsigned int old_size;
+	unsigned int bits;
+	int i;
+
+	if (!lnet_mt_uhash_crowded(mtable))
+		return;
+
+	bits = min(lnet_mt_uhash_bits(mtable) + 2,
+		   (unsigned int)LNET_MT_UHASH_BITS_MAX);
+	LIBCFS_CPT_ALLOC(uhash, lnet_cpt_table(), mtable->mt_cpt,
+			 sizeof(*uhash) << bits);
+	if (uhash == NULL)
+		return; /* keep going with long chains */
+
+	for (i = 0; i < (1 << bits); i++)
+		INIT_LIST_HEAD(&uhash[i]);
+
+	lnet_res_lock(mtable->mt_cpt);
+	old_bits = lnet_mt_uhash_bits(mtable);
+	if (old_bits >= bits) {
+		/* somebody grew it while we were allocating */
+		lnet_res_unlock(mtable->mt_cpt);
+		LIBCFS_FREE(uhash, sizeof(*uhash) << bits);
+		return;
+	}
+
+	old = mtable->mt_uhash != NULL ? mtable->mt_uhash : mtable->mt_mhash;
+	old_size = 1 << old_bits;
+	for (i = 0; i < old_size; i++) {
+		list_for_each_entry_safe(me, tmp, &old[i], me_list) {
+			list_move_tail(&me->me_list,
+				       &uhash[lnet_mt_unique_hash(
+						me->me_match_id,
+						me->me_match_bits, bits)]);
+		}
+	}
+
+	mtable->mt_uhash = uhash;
+	mtable->mt_uhash_bits = bits;
+	lnet_res_unlock(mtable->mt_cpt);
+
+	CDEBUG(D_NET, "portal %d cpt %d: %u MEs, hash grown to %u chains\n",
+	       mtable->mt_portal, mtable->mt_cpt, mtable->mt_nmes, 1 << bits);
+
+	if (old != mtable->mt_mhash)
+		LIBCFS_FREE(old, sizeof(*old) << old_bits);
+}
+
+static inline void
+lnet_mt_account_walk(struct lnet_match_table *mtable, unsigned int nwalk)
+{
+	mtable->mt_walk_hist[min(fls(nwalk), LNET_MT_WALK_BUCKETS - 1)]++;
 }
 
 int
@@ -378,6 +475,7 @@ lnet_mt_match_md(struct lnet_match_table *mtable,
 	struct list_head	*head;
 	struct lnet_me		*me;
 	struct lnet_me		*tmp;
+	unsigned int		nwalk = 0;
 	int			exhausted = 0;
 	int			rc;
 
@@ -392,6 +490,7 @@ lnet_mt_match_md(struct lnet_match_table *mtable,
 		exhausted = LNET_MATCHMD_EXHAUSTED;
 
 	list_for_each_entry_safe(me, tmp, head, me_list) {
+		nwalk++;
 		/* ME attached but MD not attached yet */
 		if (me->me_md == NULL)
 			continue;
@@ -403,6 +502,7 @@ lnet_mt_match_md(struct lnet_match_table *mtable,
 			exhausted = 0; /* mlist is not empty */
 
 		if ((rc & LNET_MATCHMD_FINISH) != 0) {
+			lnet_mt_account_walk(mtable, nwalk);
 			/* don't return EXHAUSTED bit because we don't know
 			 * whether the mlist is empty or not */
 			return rc & ~LNET_MATCHMD_EXHAUSTED;
@@ -420,6 +520,8 @@ lnet_mt_match_md(struct lnet_match_table *mtable,
 		goto again; /* re-check MEs w/o ignore-bits */
 	}
 
+	lnet_mt_account_walk(mtable, nwalk);
+
 	if (info->mi_opc == LNET_MD_OP_GET ||
 	    !lnet_ptl_is_lazy(the_lnet.ln_portals[info->mi_portal]))
 		return LNET_MATCHMD_DROP | exhausted;
@@ -773,6 +875,22 @@ lnet_ptl_cleanup(struct lnet_portal *ptl)
 		}
 		/* the extra entry is for MEs with ignore bits */
 		LIBCFS_FREE(mhash, sizeof(*mhash) * (LNET_MT_HASH_SIZE + 1));
+
+		if (mtable->mt_uhash == NULL)
+			continue;
+
+		mhash = mtable->mt_uhash;
+		for (j = 0; j < (1 << mtable->mt_uhash_bits); j++) {
+			while (!list_empty(&mhash[j])) {
+				me = list_entry(mhash[j].next,
+						struct lnet_me, me_list);
+				CERROR("Active ME %p on exit\n", me);
+				list_del(&me->me_list);
+				lnet_me_free(me);
+			}
+		}
+		LIBCFS_FREE(mhash, sizeof(*mhash) << mtable->mt_uhash_bits);
+		mtable->mt_uhash = NULL;
 	}
 
 	cfs_percpt_free(ptl->ptl_mtables);
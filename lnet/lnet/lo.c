@@ -42,6 +42,12 @@ lolnd_send(struct lnet_ni *ni, void *private, struct lnet_msg *lntmsg)
 	return lnet_parse(ni, &lntmsg->msg_hdr, ni->ni_nid, lntmsg, 0);
 }
 
+/*
+ * The payload is copied from the sender's MD into the receiver's. Pages
+ * are not handed over: the sink MD's pages belong to its owner and must
+ * still hold the data after this message is finalized, whatever becomes
+ * of the source MD.
+ */
 static int
 lolnd_recv(struct lnet_ni *ni, void *private, struct lnet_msg *lntmsg,
 	   int delayed, unsigned int niov,
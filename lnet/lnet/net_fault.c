@@ -450,9 +450,20 @@ lnet_drop_rule_match(struct lnet_hdr *hdr, enum lnet_msg_hstatus *hstatus)
 /**
  * LNet Delay Simulation
  */
-/** timestamp (second) to send delayed message */
+/** jiffies to send delayed message */
 #define msg_delay_send		 msg_ev.hdr_data
 
+/**
+ * Delayed messages of a rule are hashed into a timer wheel by the jiffy
+ * they should be sent at, so a slot can also hold messages of later rounds.
+ */
+#define LNET_DELAY_WHEEL_BITS	10
+#define LNET_DELAY_WHEEL_SIZE	(1 << LNET_DELAY_WHEEL_BITS)
+#define LNET_DELAY_WHEEL_MASK	(LNET_DELAY_WHEEL_SIZE - 1)
+
+/** upper bound of pareto tail of latency, in multiples of jitter */
+#define LNET_DELAY_PARETO_MAX	64
+
 struct lnet_delay_rule {
 	/** link chain on the_lnet.ln_delay_rules */
 	struct list_head	dl_link;
@@ -477,8 +488,20 @@ struct lnet_delay_rule {
 	time64_t		dl_time_base;
 	/** jiffies to send the next delayed message */
 	unsigned long		dl_msg_send;
-	/** delayed message list */
-	struct list_head	dl_msg_list;
+	/** the next tick (jiffies) of the timer wheel to expire */
+	unsigned long		dl_wheel_tick;
+	/** # delayed messages on the timer wheel */
+	unsigned long		dl_msg_count;
+	/** non-empty slots of the timer wheel */
+	DECLARE_BITMAP(dl_wheel_map, LNET_DELAY_WHEEL_SIZE);
+	/** timer wheel of delayed messages */
+	struct list_head	dl_wheel[LNET_DELAY_WHEEL_SIZE];
+	/** bandwidth cap in bytes per second, zero for no cap */
+	__u64			dl_bw_rate;
+	/** depth of the token bucket, in nanoseconds of dl_bw_rate */
+	__u64			dl_bw_burst;
+	/** nanoseconds at which all admitted messages have been sent */
+	__u64			dl_bw_next;
 	/** statistic of delayed messages */
 	struct lnet_fault_stat	dl_stat;
 	/** timer to wakeup delay_daemon */
@@ -509,30 +532,225 @@ delay_rule_decref(struct lnet_delay_rule *rule)
 {
 	if (atomic_dec_and_test(&rule->dl_refcount)) {
 		LASSERT(list_empty(&rule->dl_sched_link));
-		LASSERT(list_empty(&rule->dl_msg_list));
+		LASSERT(rule->dl_msg_count == 0);
 		LASSERT(list_empty(&rule->dl_link));
 
 		CFS_FREE_PTR(rule);
 	}
 }
 
+static unsigned long
+delay_us2jiffies(__u64 usecs)
+{
+	__u32 rem;
+	__u64 secs = div_u64_rem(usecs, USEC_PER_SEC, &rem);
+
+	return cfs_time_seconds(secs) + usecs_to_jiffies(rem);
+}
+
+/**
+ * Sample the latency of a delayed message from the distribution of
+ * \a attr.
+ *
+ * \retval latency in microseconds
+ */
+static __u64
+delay_rule_latency(struct lnet_fault_attr *attr)
+{
+	__s64	latency = attr->u.delay.la_latency_us;
+	__s64	jitter = attr->u.delay.la_jitter_us;
+	__s64	sum = 0;
+	__u64	tail;
+	int	i;
+
+	if (latency == 0)
+		latency = (__s64)attr->u.delay.la_latency * USEC_PER_SEC;
+
+	if (jitter == 0)
+		return latency;
+
+	switch (attr->u.delay.la_dist) {
+	default:
+	case LNET_DELAY_DIST_UNIFORM:
+		latency += (__s64)(((__u64)cfs_rand() *
+				    (2 * jitter + 1)) >> 32) - jitter;
+		break;
+
+	case LNET_DELAY_DIST_NORMAL:
+		/* Irwin-Hall: the sum of 12 uniform variables approximates
+		 * a normal distribution with a standard deviation of 1 */
+		for (i = 0; i < 12; i++)
+			sum += cfs_rand() & 0xffff;
+		sum -= 6 << 16;
+		latency += div_s64(sum * jitter, 1 << 16);
+		break;
+
+	case LNET_DELAY_DIST_PARETO:
+		/* 1/sqrt(u) is pareto with alpha 2, the mean of its tail
+		 * above 1 is 1, so jitter is the mean of extra latency */
+		tail = div_u64((__u64)jitter << 16, int_sqrt(cfs_rand() | 1));
+		latency += min_t(__u64, tail - jitter,
+				 jitter * LNET_DELAY_PARETO_MAX);
+		break;
+	}
+
+	return latency > 0 ? latency : 0;
+}
+
+/**
+ * Charge \a nob bytes to the token bucket of \a rule.
+ *
+ * \retval nanoseconds to wait until the bucket has enough tokens
+ */
+static __u64
+delay_rule_throttle(struct lnet_delay_rule *rule, unsigned int nob)
+{
+	__u64 now = ktime_get_ns();
+
+	/* the bucket has been refilled up to its depth */
+	if (rule->dl_bw_next + rule->dl_bw_burst < now)
+		rule->dl_bw_next = now - rule->dl_bw_burst;
+
+	rule->dl_bw_next += div64_u64((__u64)nob * NSEC_PER_SEC,
+				      rule->dl_bw_rate);
+
+	return rule->dl_bw_next > now ? rule->dl_bw_next - now : 0;
+}
+
+/**
+ * Arm the timer of \a rule for the first non-empty slot of its wheel.
+ * A slot can be non-empty because of messages of a later round, timer
+ * will fire at most once per round of the wheel for nothing.
+ * Called with hold of rule::dl_lock.
+ */
+static void
+delay_wheel_schedule(struct lnet_delay_rule *rule)
+{
+	unsigned long base = rule->dl_wheel_tick & LNET_DELAY_WHEEL_MASK;
+	unsigned long slot;
+
+	if (rule->dl_msg_count == 0) {
+		del_timer(&rule->dl_timer);
+		rule->dl_msg_send = -1;
+		return;
+	}
+
+	slot = find_next_bit(rule->dl_wheel_map, LNET_DELAY_WHEEL_SIZE, base);
+	if (slot >= LNET_DELAY_WHEEL_SIZE) {
+		slot = find_first_bit(rule->dl_wheel_map,
+				      LNET_DELAY_WHEEL_SIZE) +
+		       LNET_DELAY_WHEEL_SIZE;
+	}
+
+	rule->dl_msg_send = rule->dl_wheel_tick + slot - base;
+	mod_timer(&rule->dl_timer, rule->dl_msg_send);
+}
+
+/**
+ * Put \a msg on the timer wheel of \a rule, it will be sent at jiffies
+ * \a send. Called with hold of rule::dl_lock.
+ */
+static void
+delay_wheel_add(struct lnet_delay_rule *rule, struct lnet_msg *msg,
+		unsigned long send)
+{
+	unsigned int slot;
+
+	if (rule->dl_msg_count == 0)
+		rule->dl_wheel_tick = jiffies;
+
+	/* never hash into a slot which has been expired in this round */
+	if (time_before(send, rule->dl_wheel_tick))
+		send = rule->dl_wheel_tick;
+
+	slot = send & LNET_DELAY_WHEEL_MASK;
+	msg->msg_delay_send = send;
+	list_add_tail(&msg->msg_list, &rule->dl_wheel[slot]);
+	__set_bit(slot, rule->dl_wheel_map);
+	rule->dl_msg_count++;
+
+	if (rule->dl_msg_send == -1 || time_before(send, rule->dl_msg_send)) {
+		rule->dl_msg_send = send;
+		mod_timer(&rule->dl_timer, rule->dl_msg_send);
+	}
+}
+
+/**
+ * Move expired messages on the timer wheel of \a rule to \a msg_list, all
+ * messages are moved if \a all is true.
+ * Called with hold of rule::dl_lock.
+ */
+static void
+delay_wheel_expire(struct lnet_delay_rule *rule, bool all,
+		   struct list_head *msg_list)
+{
+	struct lnet_msg	*msg;
+	struct lnet_msg	*tmp;
+	unsigned long	 now = jiffies;
+	unsigned long	 tick = rule->dl_wheel_tick;
+	unsigned long	 n;
+
+	if (all)
+		n = LNET_DELAY_WHEEL_SIZE;
+	else if (time_before(now, tick))
+		return;
+	else
+		n = min_t(unsigned long, now - tick + 1, LNET_DELAY_WHEEL_SIZE);
+
+	for (; n > 0 && rule->dl_msg_count > 0; tick++, n--) {
+		unsigned int	  slot = tick & LNET_DELAY_WHEEL_MASK;
+		struct list_head *head = &rule->dl_wheel[slot];
+
+		if (!test_bit(slot, rule->dl_wheel_map))
+			continue;
+
+		list_for_each_entry_safe(msg, tmp, head, msg_list) {
+			/* message of a later round of the wheel */
+			if (!all && time_after((unsigned long)
+					       msg->msg_delay_send, now))
+				continue;
+
+			msg->msg_delay_send = 0;
+			list_move_tail(&msg->msg_list, msg_list);
+			rule->dl_msg_count--;
+		}
+
+		if (list_empty(head))
+			__clear_bit(slot, rule->dl_wheel_map);
+	}
+
+	if (!all)
+		rule->dl_wheel_tick = now + 1;
+}
+
 /**
  * check source/destination NID, portal, message type and delay rate,
- * decide whether should delay this message or not
+ * decide whether should delay this message or not, \a nob bytes of the
+ * message are charged to the bandwidth cap of the rule.
  */
 static bool
 delay_rule_match(struct lnet_delay_rule *rule, lnet_nid_t src,
 		lnet_nid_t dst, unsigned int type, unsigned int portal,
-		struct lnet_msg *msg)
+		unsigned int nob, struct lnet_msg *msg)
 {
 	struct lnet_fault_attr	*attr = &rule->dl_attr;
-	bool			 delay;
+	__u64			 wait = 0;
+	bool			 delay = false;
 
 	if (!lnet_fault_attr_match(attr, src, dst, type, portal))
 		return false;
 
 	/* match this rule, check delay rate now */
 	spin_lock(&rule->dl_lock);
+	if (attr->u.delay.la_reorder != 0 && rule->dl_msg_count > 0 &&
+	    cfs_rand() % attr->u.delay.la_reorder == 0) {
+		/* overtake all messages delayed by this rule */
+		rule->dl_stat.fs_count++;
+		rule->dl_stat.u.delay.ls_reordered++;
+		spin_unlock(&rule->dl_lock);
+		return false;
+	}
+
 	if (rule->dl_delay_time != 0) { /* time based delay */
 		time64_t now = ktime_get_seconds();
 
@@ -552,7 +770,7 @@ delay_rule_match(struct lnet_delay_rule *rule, lnet_nid_t src,
 			       rule->dl_delay_time);
 		}
 
-	} else { /* rate based delay */
+	} else if (attr->u.delay.la_rate != 0) { /* rate based delay */
 		__u64 count;
 
 		delay = rule->dl_stat.fs_count++ == rule->dl_delay_at;
@@ -565,23 +783,31 @@ delay_rule_match(struct lnet_delay_rule *rule, lnet_nid_t src,
 			       libcfs_nid2str(attr->fa_src),
 			       libcfs_nid2str(attr->fa_dst), rule->dl_delay_at);
 		}
+
+	} else { /* bandwidth cap only */
+		rule->dl_stat.fs_count++;
 	}
 
-	if (!delay) {
+	if (rule->dl_bw_rate != 0)
+		wait = delay_rule_throttle(rule, nob);
+
+	if (!delay && wait == 0) {
 		spin_unlock(&rule->dl_lock);
 		return false;
 	}
 
 	/* delay this message, update counters */
 	lnet_fault_stat_inc(&rule->dl_stat, type);
-	rule->dl_stat.u.delay.ls_delayed++;
+	if (delay)
+		rule->dl_stat.u.delay.ls_delayed++;
+	if (wait != 0)
+		rule->dl_stat.u.delay.ls_throttled++;
 
-	list_add_tail(&msg->msg_list, &rule->dl_msg_list);
-	msg->msg_delay_send = ktime_get_seconds() + attr->u.delay.la_latency;
-	if (rule->dl_msg_send == -1) {
-		rule->dl_msg_send = msg->msg_delay_send;
-		mod_timer(&rule->dl_timer, rule->dl_msg_send);
-	}
+	wait = div_u64(wait, NSEC_PER_USEC);
+	if (delay)
+		wait += delay_rule_latency(attr);
+
+	delay_wheel_add(rule, msg, jiffies + delay_us2jiffies(wait));
 
 	spin_unlock(&rule->dl_lock);
 	return true;
@@ -598,6 +824,8 @@ lnet_delay_rule_match_locked(struct lnet_hdr *hdr, struct lnet_msg *msg)
 	lnet_nid_t		 src = le64_to_cpu(hdr->src_nid);
 	lnet_nid_t		 dst = le64_to_cpu(hdr->dest_nid);
 	unsigned int		 typ = le32_to_cpu(hdr->type);
+	unsigned int		 nob = sizeof(*hdr) +
+				       le32_to_cpu(hdr->payload_length);
 	unsigned int		 ptl = -1;
 
 	/* NB: called with hold of lnet_net_lock */
@@ -610,7 +838,7 @@ lnet_delay_rule_match_locked(struct lnet_hdr *hdr, struct lnet_msg *msg)
 		ptl = le32_to_cpu(hdr->msg.get.ptl_index);
 
 	list_for_each_entry(rule, &the_lnet.ln_delay_rules, dl_link) {
-		if (delay_rule_match(rule, src, dst, typ, ptl, msg))
+		if (delay_rule_match(rule, src, dst, typ, ptl, nob, msg))
 			return true;
 	}
 
@@ -622,34 +850,14 @@ static void
 delayed_msg_check(struct lnet_delay_rule *rule, bool all,
 		  struct list_head *msg_list)
 {
-	struct lnet_msg *msg;
-	struct lnet_msg *tmp;
-	time64_t now = ktime_get_seconds();
-
-	if (!all && cfs_time_seconds(rule->dl_msg_send) > now)
+	if (!all && (rule->dl_msg_send == -1 ||
+		     time_before(jiffies, rule->dl_msg_send)))
 		return;
 
 	spin_lock(&rule->dl_lock);
-	list_for_each_entry_safe(msg, tmp, &rule->dl_msg_list, msg_list) {
-		if (!all && msg->msg_delay_send > now)
-			break;
-
-		msg->msg_delay_send = 0;
-		list_move_tail(&msg->msg_list, msg_list);
-	}
-
-	if (list_empty(&rule->dl_msg_list)) {
-		del_timer(&rule->dl_timer);
-		rule->dl_msg_send = -1;
-
-	} else if (!list_empty(msg_list)) {
-		/* dequeued some timedout messages, update timer for the
-		 * next delayed message on rule */
-		msg = list_entry(rule->dl_msg_list.next,
-				 struct lnet_msg, msg_list);
-		rule->dl_msg_send = msg->msg_delay_send;
-		mod_timer(&rule->dl_timer, rule->dl_msg_send);
-	}
+	delay_wheel_expire(rule, all, msg_list);
+	/* update timer for the next delayed message on rule */
+	delay_wheel_schedule(rule);
 	spin_unlock(&rule->dl_lock);
 }
 
@@ -781,10 +989,13 @@ lnet_delay_rule_add(struct lnet_fault_attr *attr)
 {
 	struct lnet_delay_rule *rule;
 	int			rc = 0;
+	int			i;
 	ENTRY;
 
-	if (!((attr->u.delay.la_rate == 0) ^
-	      (attr->u.delay.la_interval == 0))) {
+	/* NB: a rule with bandwidth cap can go without delay rate/interval */
+	if ((attr->u.delay.la_rate != 0 && attr->u.delay.la_interval != 0) ||
+	    (attr->u.delay.la_rate == 0 && attr->u.delay.la_interval == 0 &&
+	     attr->u.delay.la_bandwidth == 0)) {
 		CDEBUG(D_NET,
 		       "please provide either delay rate or delay interval, "
 		       "but not both at the same time %d/%d\n",
@@ -792,11 +1003,19 @@ lnet_delay_rule_add(struct lnet_fault_attr *attr)
 		RETURN(-EINVAL);
 	}
 
-	if (attr->u.delay.la_latency == 0) {
+	if ((attr->u.delay.la_rate != 0 || attr->u.delay.la_interval != 0) &&
+	    attr->u.delay.la_latency == 0 && attr->u.delay.la_latency_us == 0) {
 		CDEBUG(D_NET, "delay latency cannot be zero\n");
 		RETURN(-EINVAL);
 	}
 
+	if (attr->u.delay.la_dist >= LNET_DELAY_DIST_MAX ||
+	    attr->u.delay.la_jitter_us > INT_MAX) {
+		CDEBUG(D_NET, "invalid latency distribution %u, jitter %u\n",
+		       attr->u.delay.la_dist, attr->u.delay.la_jitter_us);
+		RETURN(-EINVAL);
+	}
+
 	if (lnet_fault_attr_validate(attr) != 0)
 		RETURN(-EINVAL);
 
@@ -827,8 +1046,9 @@ lnet_delay_rule_add(struct lnet_fault_attr *attr)
 			(unsigned long)rule, 0);
 
 	spin_lock_init(&rule->dl_lock);
-	INIT_LIST_HEAD(&rule->dl_msg_list);
 	INIT_LIST_HEAD(&rule->dl_sched_link);
+	for (i = 0; i < LNET_DELAY_WHEEL_SIZE; i++)
+		INIT_LIST_HEAD(&rule->dl_wheel[i]);
 
 	rule->dl_attr = *attr;
 	if (attr->u.delay.la_interval != 0) {
@@ -836,10 +1056,25 @@ lnet_delay_rule_add(struct lnet_fault_attr *attr)
 				     attr->u.delay.la_interval;
 		rule->dl_delay_time = ktime_get_seconds() +
 				      cfs_rand() % attr->u.delay.la_interval;
-	} else {
+	} else if (attr->u.delay.la_rate != 0) {
 		rule->dl_delay_at = cfs_rand() % attr->u.delay.la_rate;
 	}
 
+	if (attr->u.delay.la_bandwidth != 0) {
+		rule->dl_bw_rate = (__u64)attr->u.delay.la_bandwidth << 10;
+		/* NB: default depth of bucket can take a full size message */
+		if (attr->u.delay.la_burst != 0)
+			rule->dl_bw_burst = div_u64((__u64)
+						    attr->u.delay.la_burst *
+						    NSEC_PER_SEC,
+						    attr->u.delay.la_bandwidth);
+		else
+			rule->dl_bw_burst = div64_u64((__u64)(LNET_MTU +
+						sizeof(struct lnet_hdr)) *
+						NSEC_PER_SEC, rule->dl_bw_rate);
+	}
+
+	rule->dl_wheel_tick = jiffies;
 	rule->dl_msg_send = -1;
 
 	lnet_net_lock(LNET_LOCK_EX);
@@ -847,9 +1082,10 @@ lnet_delay_rule_add(struct lnet_fault_attr *attr)
 	list_add(&rule->dl_link, &the_lnet.ln_delay_rules);
 	lnet_net_unlock(LNET_LOCK_EX);
 
-	CDEBUG(D_NET, "Added delay rule: src %s, dst %s, rate %d\n",
+	CDEBUG(D_NET, "Added delay rule: src %s, dst %s, rate %d, "
+	       "bandwidth %uKiB/s\n",
 	       libcfs_nid2str(attr->fa_src), libcfs_nid2str(attr->fa_src),
-	       attr->u.delay.la_rate);
+	       attr->u.delay.la_rate, attr->u.delay.la_bandwidth);
 
 	mutex_unlock(&delay_dd.dd_mutex);
 	RETURN(0);
@@ -985,7 +1221,7 @@ lnet_delay_rule_reset(void)
 		memset(&rule->dl_stat, 0, sizeof(rule->dl_stat));
 		if (attr->u.delay.la_rate != 0) {
 			rule->dl_delay_at = cfs_rand() % attr->u.delay.la_rate;
-		} else {
+		} else if (attr->u.delay.la_interval != 0) {
 			rule->dl_delay_time = ktime_get_seconds() +
 					      cfs_rand() % attr->u.delay.la_interval;
 			rule->dl_time_base = ktime_get_seconds() +
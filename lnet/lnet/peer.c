@@ -99,6 +99,8 @@ lnet_peer_tables_destroy(void)
 			break;
 
 		LASSERT(list_empty(&ptable->pt_zombie_list));
+		LASSERT(list_empty(&ptable->pt_dc_request));
+		LASSERT(list_empty(&ptable->pt_dc_working));
 
 		ptable->pt_hash = NULL;
 		for (j = 0; j < LNET_PEER_HASH_SIZE; j++)
@@ -140,6 +142,10 @@ lnet_peer_tables_create(void)
 
 		INIT_LIST_HEAD(&ptable->pt_peer_list);
 
+		INIT_LIST_HEAD(&ptable->pt_dc_request);
+		INIT_LIST_HEAD(&ptable->pt_dc_working);
+		init_waitqueue_head(&ptable->pt_dc_waitq);
+
 		for (j = 0; j < LNET_PEER_HASH_SIZE; j++)
 			INIT_LIST_HEAD(&hash[j]);
 		ptable->pt_hash = hash; /* sign of initialization */
@@ -350,7 +356,6 @@ lnet_peer_detach_peer_ni_locked(struct lnet_peer_ni *lpni)
 		/* Discovery isn't running, nothing to do here. */
 	} else if (lp->lp_state & LNET_PEER_DISCOVERED) {
 		lnet_peer_queue_for_discovery(lp);
-		wake_up(&the_lnet.ln_dc_waitq);
 	}
 	CDEBUG(D_NET, "peer %s NID %s\n",
 		libcfs_nid2str(lp->lp_primary_nid),
@@ -821,7 +826,6 @@ lnet_push_update_to_peers(int force)
 		}
 	}
 	lnet_net_unlock(LNET_LOCK_EX);
-	wake_up(&the_lnet.ln_dc_waitq);
 }
 
 /*
@@ -1739,6 +1743,53 @@ lnet_peer_is_uptodate(struct lnet_peer *lp)
 	return rc;
 }
 
+/*
+ * Move a peer to discovery queue \a queue, LNET_DC_QUEUE_NONE takes it
+ * off all queues. Request and working queues belong to the peer table
+ * of the peer, so a peer is always handled by the discovery thread of
+ * the same CPT. The peer goes to the head of the queue if \a head is
+ * true. Call with lnet_net_lock/EX held.
+ */
+static void lnet_peer_dc_move(struct lnet_peer *lp, int queue, bool head)
+{
+	struct lnet_peer_table *ptable = the_lnet.ln_peer_tables[lp->lp_cpt];
+	struct list_head *list = NULL;
+
+	switch (lp->lp_dc_queue) {
+	case LNET_DC_QUEUE_REQUEST:
+		ptable->pt_dc_nrequest--;
+		break;
+	case LNET_DC_QUEUE_WORKING:
+		/* the thread may be waiting for a free slot of its batch */
+		ptable->pt_dc_nworking--;
+		wake_up(&ptable->pt_dc_waitq);
+		break;
+	}
+
+	switch (queue) {
+	case LNET_DC_QUEUE_REQUEST:
+		list = &ptable->pt_dc_request;
+		ptable->pt_dc_nrequest++;
+		wake_up(&ptable->pt_dc_waitq);
+		break;
+	case LNET_DC_QUEUE_WORKING:
+		list = &ptable->pt_dc_working;
+		ptable->pt_dc_nworking++;
+		break;
+	case LNET_DC_QUEUE_EXPIRED:
+		list = &the_lnet.ln_dc_expired;
+		break;
+	}
+
+	lp->lp_dc_queue = queue;
+	if (list == NULL)
+		list_del_init(&lp->lp_dc_list);
+	else if (head)
+		list_move(&lp->lp_dc_list, list);
+	else
+		list_move_tail(&lp->lp_dc_list, list);
+}
+
 /*
  * Queue a peer for the attention of the discovery thread.  Call with
  * lnet_net_lock/EX held. Returns 0 if the peer was queued, and
@@ -1754,8 +1805,8 @@ static int lnet_peer_queue_for_discovery(struct lnet_peer *lp)
 	spin_unlock(&lp->lp_lock);
 	if (list_empty(&lp->lp_dc_list)) {
 		lnet_peer_addref_locked(lp);
-		list_add_tail(&lp->lp_dc_list, &the_lnet.ln_dc_request);
-		wake_up(&the_lnet.ln_dc_waitq);
+		lp->lp_dc_start = ktime_get();
+		lnet_peer_dc_move(lp, LNET_DC_QUEUE_REQUEST, false);
 		rc = 0;
 	} else {
 		rc = -EALREADY;
@@ -1773,16 +1824,26 @@ static int lnet_peer_queue_for_discovery(struct lnet_peer *lp)
  */
 static void lnet_peer_discovery_complete(struct lnet_peer *lp)
 {
+	struct lnet_peer_table *ptable = the_lnet.ln_peer_tables[lp->lp_cpt];
 	struct lnet_msg *msg, *tmp;
 	int rc = 0;
 	struct list_head pending_msgs;
+	__u64 time_ns;
 
 	INIT_LIST_HEAD(&pending_msgs);
 
 	CDEBUG(D_NET, "Discovery complete. Dequeue peer %s\n",
 	       libcfs_nid2str(lp->lp_primary_nid));
 
-	list_del_init(&lp->lp_dc_list);
+	if (!list_empty(&lp->lp_dc_list)) {
+		time_ns = ktime_to_ns(ktime_sub(ktime_get(), lp->lp_dc_start));
+		ptable->pt_dc_completed++;
+		ptable->pt_dc_time_ns += time_ns;
+		if (time_ns > ptable->pt_dc_time_max_ns)
+			ptable->pt_dc_time_max_ns = time_ns;
+	}
+
+	lnet_peer_dc_move(lp, LNET_DC_QUEUE_NONE, false);
 	list_splice_init(&lp->lp_dc_pendq, &pending_msgs);
 	wake_up_all(&lp->lp_dc_waitq);
 
@@ -2004,10 +2065,8 @@ out:
 	 */
 	spin_unlock(&lp->lp_lock);
 	lnet_net_lock(LNET_LOCK_EX);
-	if (!lnet_peer_is_uptodate(lp) && lnet_peer_queue_for_discovery(lp)) {
-		list_move(&lp->lp_dc_list, &the_lnet.ln_dc_request);
-		wake_up(&the_lnet.ln_dc_waitq);
-	}
+	if (!lnet_peer_is_uptodate(lp) && lnet_peer_queue_for_discovery(lp))
+		lnet_peer_dc_move(lp, LNET_DC_QUEUE_REQUEST, true);
 	/* Drop refcount from lookup */
 	lnet_peer_decref_locked(lp);
 	lnet_net_unlock(LNET_LOCK_EX);
@@ -2370,10 +2429,8 @@ static void lnet_discovery_event_handler(struct lnet_event *event)
 
 	/* put peer back at end of request queue, if discovery not already
 	 * done */
-	if (rc == LNET_REDISCOVER_PEER && !lnet_peer_is_uptodate(lp)) {
-		list_move_tail(&lp->lp_dc_list, &the_lnet.ln_dc_request);
-		wake_up(&the_lnet.ln_dc_waitq);
-	}
+	if (rc == LNET_REDISCOVER_PEER && !lnet_peer_is_uptodate(lp))
+		lnet_peer_dc_move(lp, LNET_DC_QUEUE_REQUEST, false);
 	lnet_net_unlock(LNET_LOCK_EX);
 }
 
@@ -2514,7 +2571,7 @@ lnet_peer_set_primary_data(struct lnet_peer *lp, struct lnet_ping_buffer *pbuf)
 	/* Queue lp for discovery, and force it on the request queue. */
 	lnet_net_lock(LNET_LOCK_EX);
 	if (lnet_peer_queue_for_discovery(lp))
-		list_move(&lp->lp_dc_list, &the_lnet.ln_dc_request);
+		lnet_peer_dc_move(lp, LNET_DC_QUEUE_REQUEST, true);
 	lnet_net_unlock(LNET_LOCK_EX);
 
 	LNetInvalidateMDHandle(&mdh);
@@ -2980,8 +3037,6 @@ static int lnet_peer_discovery_wait_for_work(void)
 			break;
 		if (lnet_push_target_resize_needed())
 			break;
-		if (!list_empty(&the_lnet.ln_dc_request))
-			break;
 		if (!list_empty(&the_lnet.ln_msg_resend))
 			break;
 		lnet_net_unlock(cpt);
@@ -3007,6 +3062,55 @@ static int lnet_peer_discovery_wait_for_work(void)
 	return rc;
 }
 
+/*
+ * Whether the discovery thread of a CPT already has the maximum number
+ * of peers with a Ping or Push in flight. Call with lnet_net_lock held.
+ */
+static inline bool
+lnet_peer_discovery_batch_full(struct lnet_peer_table *ptable)
+{
+	return lnet_peer_discovery_batch != 0 &&
+	       ptable->pt_dc_nworking >= lnet_peer_discovery_batch;
+}
+
+/*
+ * Wait for discovery requests on the peer table of \a cpt that can be
+ * started within the batch limit. Returns non-zero if the discovery
+ * thread should shut down.
+ */
+static int lnet_peer_discovery_wait_for_cpt(struct lnet_peer_table *ptable,
+					    int cpt)
+{
+	int rc = 0;
+
+	DEFINE_WAIT(wait);
+
+	lnet_net_lock(cpt);
+	for (;;) {
+		prepare_to_wait(&ptable->pt_dc_waitq, &wait,
+				TASK_INTERRUPTIBLE);
+		if (the_lnet.ln_dc_state == LNET_DC_STATE_STOPPING)
+			break;
+		if (!list_empty(&ptable->pt_dc_request) &&
+		    !lnet_peer_discovery_batch_full(ptable))
+			break;
+		lnet_net_unlock(cpt);
+
+		/* lnet_peer_discovery_batch can be changed at any time */
+		schedule_timeout(cfs_time_seconds(1));
+		finish_wait(&ptable->pt_dc_waitq, &wait);
+		lnet_net_lock(cpt);
+	}
+	finish_wait(&ptable->pt_dc_waitq, &wait);
+
+	if (the_lnet.ln_dc_state == LNET_DC_STATE_STOPPING)
+		rc = -ESHUTDOWN;
+
+	lnet_net_unlock(cpt);
+
+	return rc;
+}
+
 /*
  * Messages that were pending on a destroyed peer will be put on a global
  * resend list. The message resend list will be checked by
@@ -3049,40 +3153,84 @@ static void lnet_resend_msgs(void)
 	}
 }
 
-/* The discovery thread. */
-static int lnet_peer_discovery(void *arg)
+/*
+ * Select an action depending on the state of the peer and whether
+ * discovery is disabled. The check whether discovery is disabled is
+ * done after the code that handles processing for arrived data,
+ * cleanup for failures, and forcing a Ping or Push.
+ */
+static int lnet_peer_discovery_step(struct lnet_peer *lp)
 {
-	struct lnet_peer *lp;
 	int rc;
 
-	CDEBUG(D_NET, "started\n");
-	cfs_block_allsigs();
+	spin_lock(&lp->lp_lock);
+	CDEBUG(D_NET, "peer %s state %#x\n",
+		libcfs_nid2str(lp->lp_primary_nid),
+		lp->lp_state);
+	if (lp->lp_state & LNET_PEER_DATA_PRESENT)
+		rc = lnet_peer_data_present(lp);
+	else if (lp->lp_state & LNET_PEER_PING_FAILED)
+		rc = lnet_peer_ping_failed(lp);
+	else if (lp->lp_state & LNET_PEER_PUSH_FAILED)
+		rc = lnet_peer_push_failed(lp);
+	else if (lp->lp_state & LNET_PEER_FORCE_PING)
+		rc = lnet_peer_send_ping(lp);
+	else if (lp->lp_state & LNET_PEER_FORCE_PUSH)
+		rc = lnet_peer_send_push(lp);
+	else if (lnet_peer_discovery_disabled)
+		rc = lnet_peer_rediscover(lp);
+	else if (!(lp->lp_state & LNET_PEER_NIDS_UPTODATE))
+		rc = lnet_peer_send_ping(lp);
+	else if (lnet_peer_needs_push(lp))
+		rc = lnet_peer_send_push(lp);
+	else
+		rc = lnet_peer_discovered(lp);
+	CDEBUG(D_NET, "peer %s state %#x rc %d\n",
+		libcfs_nid2str(lp->lp_primary_nid),
+		lp->lp_state, rc);
+	spin_unlock(&lp->lp_lock);
 
-	for (;;) {
-		if (lnet_peer_discovery_wait_for_work())
-			break;
+	return rc;
+}
 
-		lnet_resend_msgs();
+/*
+ * The discovery thread of a CPT, it discovers the peers in the peer
+ * table of the CPT. Pings and Pushes are asynchronous, so up to
+ * lnet_peer_discovery_batch peers can be in flight at the same time.
+ */
+static int lnet_peer_discovery_cpt(void *arg)
+{
+	int cpt = (long)arg;
+	struct lnet_peer_table *ptable = the_lnet.ln_peer_tables[cpt];
+	struct lnet_peer *lp;
+	int rc;
 
-		if (lnet_push_target_resize_needed())
-			lnet_push_target_resize();
+	CDEBUG(D_NET, "started on CPT %d\n", cpt);
+	cfs_block_allsigs();
 
-		lnet_net_lock(LNET_LOCK_EX);
-		if (the_lnet.ln_dc_state == LNET_DC_STATE_STOPPING)
+	rc = cfs_cpt_bind(lnet_cpt_table(), cpt);
+	if (rc != 0)
+		CWARN("Failed to bind discovery thread on CPT %d\n", cpt);
+
+	for (;;) {
+		if (lnet_peer_discovery_wait_for_cpt(ptable, cpt))
 			break;
 
 		/*
-		 * Process all incoming discovery work requests.  When
-		 * discovery must wait on a peer to change state, it
-		 * is added to the tail of the ln_dc_working queue. A
+		 * Process incoming discovery work requests until the
+		 * batch is full. When discovery must wait on a peer to
+		 * change state, it stays on the pt_dc_working queue. A
 		 * timestamp keeps track of when the peer was added,
 		 * so we can time out discovery requests that take too
 		 * long.
 		 */
-		while (!list_empty(&the_lnet.ln_dc_request)) {
-			lp = list_first_entry(&the_lnet.ln_dc_request,
+		lnet_net_lock(LNET_LOCK_EX);
+		while (!list_empty(&ptable->pt_dc_request) &&
+		       !lnet_peer_discovery_batch_full(ptable) &&
+		       the_lnet.ln_dc_state == LNET_DC_STATE_RUNNING) {
+			lp = list_first_entry(&ptable->pt_dc_request,
 					      struct lnet_peer, lp_dc_list);
-			list_move(&lp->lp_dc_list, &the_lnet.ln_dc_working);
+			lnet_peer_dc_move(lp, LNET_DC_QUEUE_WORKING, false);
 			/*
 			 * set the time the peer was put on the dc_working
 			 * queue. It shouldn't remain on the queue
@@ -3093,58 +3241,55 @@ static int lnet_peer_discovery(void *arg)
 			lp->lp_last_queued = ktime_get_real_seconds();
 			lnet_net_unlock(LNET_LOCK_EX);
 
-			/*
-			 * Select an action depending on the state of
-			 * the peer and whether discovery is disabled.
-			 * The check whether discovery is disabled is
-			 * done after the code that handles processing
-			 * for arrived data, cleanup for failures, and
-			 * forcing a Ping or Push.
-			 */
-			spin_lock(&lp->lp_lock);
-			CDEBUG(D_NET, "peer %s state %#x\n",
-				libcfs_nid2str(lp->lp_primary_nid),
-				lp->lp_state);
-			if (lp->lp_state & LNET_PEER_DATA_PRESENT)
-				rc = lnet_peer_data_present(lp);
-			else if (lp->lp_state & LNET_PEER_PING_FAILED)
-				rc = lnet_peer_ping_failed(lp);
-			else if (lp->lp_state & LNET_PEER_PUSH_FAILED)
-				rc = lnet_peer_push_failed(lp);
-			else if (lp->lp_state & LNET_PEER_FORCE_PING)
-				rc = lnet_peer_send_ping(lp);
-			else if (lp->lp_state & LNET_PEER_FORCE_PUSH)
-				rc = lnet_peer_send_push(lp);
-			else if (lnet_peer_discovery_disabled)
-				rc = lnet_peer_rediscover(lp);
-			else if (!(lp->lp_state & LNET_PEER_NIDS_UPTODATE))
-				rc = lnet_peer_send_ping(lp);
-			else if (lnet_peer_needs_push(lp))
-				rc = lnet_peer_send_push(lp);
-			else
-				rc = lnet_peer_discovered(lp);
-			CDEBUG(D_NET, "peer %s state %#x rc %d\n",
-				libcfs_nid2str(lp->lp_primary_nid),
-				lp->lp_state, rc);
-			spin_unlock(&lp->lp_lock);
+			rc = lnet_peer_discovery_step(lp);
 
 			lnet_net_lock(LNET_LOCK_EX);
-			if (rc == LNET_REDISCOVER_PEER) {
-				list_move(&lp->lp_dc_list,
-					  &the_lnet.ln_dc_request);
-			} else if (rc) {
+			if (rc == LNET_REDISCOVER_PEER)
+				lnet_peer_dc_move(lp, LNET_DC_QUEUE_REQUEST,
+						  true);
+			else if (rc)
 				lnet_peer_discovery_error(lp, rc);
-			}
 			if (!(lp->lp_state & LNET_PEER_DISCOVERING))
 				lnet_peer_discovery_complete(lp);
-			if (the_lnet.ln_dc_state == LNET_DC_STATE_STOPPING)
-				break;
 		}
-
 		lnet_net_unlock(LNET_LOCK_EX);
 	}
 
+	CDEBUG(D_NET, "stopping on CPT %d\n", cpt);
+	if (atomic_dec_and_test(&the_lnet.ln_dc_nthreads))
+		wake_up(&the_lnet.ln_dc_waitq);
+
+	return 0;
+}
+
+/*
+ * The discovery thread. Peers are discovered by the threads of each
+ * CPT, this one resends messages, resizes the push target and cleans
+ * up the discovery queues at shutdown.
+ */
+static int lnet_peer_discovery(void *arg)
+{
+	struct lnet_peer_table *ptable;
+	struct lnet_peer *lp;
+	int i;
+
+	CDEBUG(D_NET, "started\n");
+	cfs_block_allsigs();
+
+	for (;;) {
+		if (lnet_peer_discovery_wait_for_work())
+			break;
+
+		lnet_resend_msgs();
+
+		if (lnet_push_target_resize_needed())
+			lnet_push_target_resize();
+	}
+
 	CDEBUG(D_NET, "stopping\n");
+	wait_event(the_lnet.ln_dc_waitq,
+		   atomic_read(&the_lnet.ln_dc_nthreads) == 0);
+
 	/*
 	 * Clean up before telling lnet_peer_discovery_stop() that
 	 * we're done. Use wake_up() below to somewhat reduce the
@@ -3156,13 +3301,15 @@ static int lnet_peer_discovery(void *arg)
 
 	/* Queue cleanup 1: stop all pending pings and pushes. */
 	lnet_net_lock(LNET_LOCK_EX);
-	while (!list_empty(&the_lnet.ln_dc_working)) {
-		lp = list_first_entry(&the_lnet.ln_dc_working,
-				      struct lnet_peer, lp_dc_list);
-		list_move(&lp->lp_dc_list, &the_lnet.ln_dc_expired);
-		lnet_net_unlock(LNET_LOCK_EX);
-		lnet_peer_cancel_discovery(lp);
-		lnet_net_lock(LNET_LOCK_EX);
+	cfs_percpt_for_each(ptable, i, the_lnet.ln_peer_tables) {
+		while (!list_empty(&ptable->pt_dc_working)) {
+			lp = list_first_entry(&ptable->pt_dc_working,
+					      struct lnet_peer, lp_dc_list);
+			lnet_peer_dc_move(lp, LNET_DC_QUEUE_EXPIRED, false);
+			lnet_net_unlock(LNET_LOCK_EX);
+			lnet_peer_cancel_discovery(lp);
+			lnet_net_lock(LNET_LOCK_EX);
+		}
 	}
 	lnet_net_unlock(LNET_LOCK_EX);
 
@@ -3170,13 +3317,15 @@ static int lnet_peer_discovery(void *arg)
 	while (!list_empty(&the_lnet.ln_dc_expired))
 		schedule_timeout(cfs_time_seconds(1));
 
-	/* Queue cleanup 3: clear the request queue. */
+	/* Queue cleanup 3: clear the request queues. */
 	lnet_net_lock(LNET_LOCK_EX);
-	while (!list_empty(&the_lnet.ln_dc_request)) {
-		lp = list_first_entry(&the_lnet.ln_dc_request,
-				      struct lnet_peer, lp_dc_list);
-		lnet_peer_discovery_error(lp, -ESHUTDOWN);
-		lnet_peer_discovery_complete(lp);
+	cfs_percpt_for_each(ptable, i, the_lnet.ln_peer_tables) {
+		while (!list_empty(&ptable->pt_dc_request)) {
+			lp = list_first_entry(&ptable->pt_dc_request,
+					      struct lnet_peer, lp_dc_list);
+			lnet_peer_discovery_error(lp, -ESHUTDOWN);
+			lnet_peer_discovery_complete(lp);
+		}
 	}
 	lnet_net_unlock(LNET_LOCK_EX);
 
@@ -3193,6 +3342,7 @@ int lnet_peer_discovery_start(void)
 {
 	struct task_struct *task;
 	int rc;
+	int i;
 
 	if (the_lnet.ln_dc_state != LNET_DC_STATE_SHUTDOWN)
 		return -EALREADY;
@@ -3204,6 +3354,7 @@ int lnet_peer_discovery_start(void)
 	}
 
 	the_lnet.ln_dc_state = LNET_DC_STATE_RUNNING;
+	atomic_set(&the_lnet.ln_dc_nthreads, 0);
 	task = kthread_run(lnet_peer_discovery, NULL, "lnet_discovery");
 	if (IS_ERR(task)) {
 		rc = PTR_ERR(task);
@@ -3213,8 +3364,23 @@ int lnet_peer_discovery_start(void)
 		LNetInvalidateEQHandle(&the_lnet.ln_dc_eqh);
 
 		the_lnet.ln_dc_state = LNET_DC_STATE_SHUTDOWN;
+		goto out;
 	}
 
+	for (i = 0; i < LNET_CPT_NUMBER; i++) {
+		atomic_inc(&the_lnet.ln_dc_nthreads);
+		task = kthread_run(lnet_peer_discovery_cpt, (void *)(long)i,
+				   "lnet_dc_%02d", i);
+		if (IS_ERR(task)) {
+			atomic_dec(&the_lnet.ln_dc_nthreads);
+			rc = PTR_ERR(task);
+			CERROR("Can't start discovery thread for CPT %d: %d\n",
+			       i, rc);
+			lnet_peer_discovery_stop();
+			break;
+		}
+	}
+out:
 	CDEBUG(D_NET, "discovery start: %d\n", rc);
 
 	return rc;
@@ -3223,18 +3389,25 @@ int lnet_peer_discovery_start(void)
 /* ln_api_mutex is held on entry. */
 void lnet_peer_discovery_stop(void)
 {
+	struct lnet_peer_table *ptable;
+	int i;
+
 	if (the_lnet.ln_dc_state == LNET_DC_STATE_SHUTDOWN)
 		return;
 
 	LASSERT(the_lnet.ln_dc_state == LNET_DC_STATE_RUNNING);
 	the_lnet.ln_dc_state = LNET_DC_STATE_STOPPING;
+	cfs_percpt_for_each(ptable, i, the_lnet.ln_peer_tables)
+		wake_up(&ptable->pt_dc_waitq);
 	wake_up(&the_lnet.ln_dc_waitq);
 
 	wait_event(the_lnet.ln_dc_waitq,
 		   the_lnet.ln_dc_state == LNET_DC_STATE_SHUTDOWN);
 
-	LASSERT(list_empty(&the_lnet.ln_dc_request));
-	LASSERT(list_empty(&the_lnet.ln_dc_working));
+	cfs_percpt_for_each(ptable, i, the_lnet.ln_peer_tables) {
+		LASSERT(list_empty(&ptable->pt_dc_request));
+		LASSERT(list_empty(&ptable->pt_dc_working));
+	}
 	LASSERT(list_empty(&the_lnet.ln_dc_expired));
 
 	CDEBUG(D_NET, "discovery stopped\n");
@@ -3441,6 +3614,9 @@ int lnet_get_peer_info(struct lnet_ioctl_peer_cfg *cfg, void __user *bulk)
 		  atomic_read(&lpni->lpni_hstats.hlt_remote_error);
 		lpni_hstats->hlpni_health_value =
 		  atomic_read(&lpni->lpni_healthv);
+		lpni_hstats->hlpni_latency_us =
+		  div_u64(atomic64_read(&lpni->lpni_latency.lat_ewma_ns),
+			  NSEC_PER_USEC);
 		if (copy_to_user(bulk, lpni_hstats, sizeof(*lpni_hstats)))
 			goto out_free_hstats;
 		bulk += sizeof(*lpni_hstats);
@@ -32,6 +32,9 @@
 #define LNET_NRB_LARGE		(LNET_NRB_LARGE_MIN * 4)
 #define LNET_NRB_LARGE_PAGES	((LNET_MTU + PAGE_SIZE - 1) >> \
 				  PAGE_SHIFT)
+#define LNET_NRB_ADAPT_FLOOR	64	/* adaptive sizing never goes below */
+#define LNET_NRB_ADAPT_INTERVAL	5	/* seconds between sizing checks */
+#define LNET_NRB_ADAPT_IDLE	6	/* # idle checks before shrinking */
 
 static char *forwarding = "";
 module_param(forwarding, charp, 0444);
@@ -46,6 +49,12 @@ MODULE_PARM_DESC(small_router_buffers, "# of small (1 page) messages to buffer i
 static int large_router_buffers;
 module_param(large_router_buffers, int, 0444);
 MODULE_PARM_DESC(large_router_buffers, "# of large messages to buffer in the router");
+static int router_buffers_adaptive;
+module_param(router_buffers_adaptive, int, 0644);
+MODULE_PARM_DESC(router_buffers_adaptive, "Resize router buffer pools to the observed load (0 off, 1 on)");
+static int router_buffers_max_factor = 4;
+module_param(router_buffers_max_factor, int, 0644);
+MODULE_PARM_DESC(router_buffers_max_factor, "Adaptive router buffer pools stay within the configured size divided and multiplied by this");
 static int peer_buffer_credits;
 module_param(peer_buffer_credits, int, 0444);
 MODULE_PARM_DESC(peer_buffer_credits, "# router buffer credits per peer");
@@ -1471,6 +1480,11 @@ lnet_rtrpool_init(struct lnet_rtrbufpool *rbp, int npages)
 	rbp->rbp_npages = npages;
 	rbp->rbp_credits = 0;
 	rbp->rbp_mincredits = 0;
+	rbp->rbp_adapt_mincredits = 0;
+	rbp->rbp_idle_checks = 0;
+	rbp->rbp_grown = 0;
+	rbp->rbp_shrunk = 0;
+	memset(rbp->rbp_hist, 0, sizeof(rbp->rbp_hist));
 }
 
 void
@@ -1551,6 +1565,194 @@ lnet_nrb_large_calculate(void)
 	return max(nrbs, LNET_NRB_LARGE_MIN);
 }
 
+static int
+lnet_nrb_calculate(int idx)
+{
+	switch (idx) {
+	case LNET_TINY_BUF_IDX:
+		return lnet_nrb_tiny_calculate();
+	case LNET_SMALL_BUF_IDX:
+		return lnet_nrb_small_calculate();
+	default:
+		return lnet_nrb_large_calculate();
+	}
+}
+
+/* bounds of adaptive sizing for pool \a idx, per CPT */
+static void
+lnet_nrb_adapt_bounds(int idx, int *min_nrb, int *max_nrb)
+{
+	int factor = max(router_buffers_max_factor, 1);
+	int nrb = lnet_nrb_calculate(idx);
+
+	if (nrb < 0) /* invalid setting, keep the pool as it is */
+		nrb = 0;
+
+	*min_nrb = max(nrb / factor, LNET_NRB_ADAPT_FLOOR);
+	*max_nrb = max(nrb * factor, *min_nrb);
+}
+
+/* free buffers beyond rbp_req_nbuffers which are sitting idle in the pool;
+ * buffers in use are dropped by lnet_return_rx_credits_locked() */
+static void
+lnet_rtrpool_trim_bufs(struct lnet_rtrbufpool *rbp, int cpt)
+{
+	struct lnet_rtrbuf *rb;
+	struct list_head tmp;
+
+	INIT_LIST_HEAD(&tmp);
+
+	lnet_net_lock(cpt);
+	while (rbp->rbp_nbuffers > rbp->rbp_req_nbuffers &&
+	       rbp->rbp_credits > 0) {
+		LASSERT(!list_empty(&rbp->rbp_bufs));
+		rb = list_entry(rbp->rbp_bufs.next, struct lnet_rtrbuf,
+				rb_list);
+		list_move(&rb->rb_list, &tmp);
+		rbp->rbp_nbuffers--;
+		rbp->rbp_credits--;
+	}
+	lnet_net_unlock(cpt);
+
+	while (!list_empty(&tmp)) {
+		rb = list_entry(tmp.next, struct lnet_rtrbuf, rb_list);
+		list_del(&rb->rb_list);
+		lnet_destroy_rtrbuf(rb, rbp->rbp_npages);
+	}
+}
+
+/**
+ * Grow a pool which made messages wait for a buffer since the last check,
+ * shrink one which kept more than half of its buffers idle for
+ * LNET_NRB_ADAPT_IDLE checks in a row.
+ */
+static void
+lnet_rtrpool_adapt(struct lnet_rtrbufpool *rbp, int idx, int cpt)
+{
+	int min_nrb;
+	int max_nrb;
+	int nrb;
+	int low;
+	int rc;
+
+	lnet_nrb_adapt_bounds(idx, &min_nrb, &max_nrb);
+
+	lnet_net_lock(cpt);
+	low = rbp->rbp_adapt_mincredits;
+	nrb = rbp->rbp_req_nbuffers;
+	rbp->rbp_adapt_mincredits = rbp->rbp_credits;
+	lnet_net_unlock(cpt);
+
+	if (low < 0) {
+		rbp->rbp_idle_checks = 0;
+		nrb += max(-low, nrb / 4);
+	} else if (low > nrb / 2) {
+		if (++rbp->rbp_idle_checks < LNET_NRB_ADAPT_IDLE)
+			return;
+		rbp->rbp_idle_checks = 0;
+		nrb -= nrb / 4;
+	} else {
+		rbp->rbp_idle_checks = 0;
+	}
+
+	nrb = clamp(nrb, min_nrb, max_nrb);
+	if (nrb == rbp->rbp_req_nbuffers)
+		return;
+
+	CDEBUG(D_NET, "CPT %d: %d page router buffers %d -> %d (low %d)\n",
+	       cpt, rbp->rbp_npages, rbp->rbp_req_nbuffers, nrb, low);
+
+	if (nrb > rbp->rbp_req_nbuffers) {
+		rc = lnet_rtrpool_adjust_bufs(rbp, nrb, cpt);
+		if (rc != 0)
+			return;
+		rbp->rbp_grown++;
+	} else {
+		lnet_rtrpool_adjust_bufs(rbp, nrb, cpt);
+		lnet_rtrpool_trim_bufs(rbp, cpt);
+		rbp->rbp_shrunk++;
+	}
+
+	/* credits sampled since the snapshot above may predate the resize,
+	 * restart the sample from the new pool so that one shortage does not
+	 * grow the pool twice */
+	lnet_net_lock(cpt);
+	rbp->rbp_adapt_mincredits = rbp->rbp_credits;
+	lnet_net_unlock(cpt);
+}
+
+/* called by the monitor thread once a second */
+void
+lnet_rtrpools_adapt(void)
+{
+	static time64_t last_check;
+	struct lnet_rtrbufpool *rtrp;
+	time64_t now;
+	int i;
+	int j;
+
+	if (!router_buffers_adaptive)
+		return;
+
+	now = ktime_get_seconds();
+	if (now - last_check < LNET_NRB_ADAPT_INTERVAL)
+		return;
+	last_check = now;
+
+	/* configuration and shutdown resize and free the pools with
+	 * ln_api_mutex held, just skip this round if they are at it */
+	if (!mutex_trylock(&the_lnet.ln_api_mutex))
+		return;
+
+	if (the_lnet.ln_routing && the_lnet.ln_rtrpools != NULL) {
+		cfs_percpt_for_each(rtrp, i, the_lnet.ln_rtrpools) {
+			for (j = 0; j < LNET_NRBPOOLS; j++)
+				lnet_rtrpool_adapt(&rtrp[j], j, i);
+		}
+	}
+
+	mutex_unlock(&the_lnet.ln_api_mutex);
+}
+
+int
+lnet_get_rtrpool_stats(struct lnet_ioctl_rtrpool_stats *stats)
+{
+	struct lnet_rtrbufpool *rbp;
+	int cpt;
+	int i;
+
+	if (the_lnet.ln_rtrpools == NULL ||
+	    stats->rps_cpt >= LNET_CPT_NUMBER)
+		return -ENOENT;
+
+	cpt = stats->rps_cpt;
+
+	stats->rps_adaptive = !!router_buffers_adaptive;
+	rbp = the_lnet.ln_rtrpools[cpt];
+
+	lnet_net_lock(cpt);
+	for (i = 0; i < LNET_NRBPOOLS; i++) {
+		int min_nrb;
+		int max_nrb;
+
+		lnet_nrb_adapt_bounds(i, &min_nrb, &max_nrb);
+		stats->rps_pools[i].rps_npages = rbp[i].rbp_npages;
+		stats->rps_pools[i].rps_nbuffers = rbp[i].rbp_nbuffers;
+		stats->rps_pools[i].rps_req_nbuffers = rbp[i].rbp_req_nbuffers;
+		stats->rps_pools[i].rps_min_nbuffers = min_nrb;
+		stats->rps_pools[i].rps_max_nbuffers = max_nrb;
+		stats->rps_pools[i].rps_credits = rbp[i].rbp_credits;
+		stats->rps_pools[i].rps_mincredits = rbp[i].rbp_mincredits;
+		stats->rps_pools[i].rps_grown = rbp[i].rbp_grown;
+		stats->rps_pools[i].rps_shrunk = rbp[i].rbp_shrunk;
+		memcpy(stats->rps_pools[i].rps_hist, rbp[i].rbp_hist,
+		       sizeof(rbp[i].rbp_hist));
+	}
+	lnet_net_unlock(cpt);
+
+	return 0;
+}
+
 int
 lnet_rtrpools_alloc(int im_a_router)
 {
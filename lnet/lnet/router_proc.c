@@ -134,6 +134,219 @@ proc_lnet_stats(struct ctl_table *table, int write, void __user *buffer,
 				    __proc_lnet_stats);
 }
 
+static int __proc_lnet_finalize_stats(void *data, int write,
+				      loff_t pos, void __user *buffer, int nob)
+{
+	struct lnet_msg_container *container;
+	char *tmpstr;
+	char *s;
+	int tmpsiz;
+	int rc;
+	int i;
+
+	if (write) {
+		cfs_percpt_for_each(container, i, the_lnet.ln_msg_containers) {
+			lnet_net_lock(i);
+			container->msc_lock_count = 0;
+			container->msc_completed = 0;
+			container->msc_hold_ns = 0;
+			container->msc_hold_max_ns = 0;
+			lnet_net_unlock(i);
+		}
+		return 0;
+	}
+
+	tmpsiz = 128 * (LNET_CPT_NUMBER + 1);
+	LIBCFS_ALLOC(tmpstr, tmpsiz);
+	if (tmpstr == NULL)
+		return -ENOMEM;
+
+	s = tmpstr;
+	s += snprintf(s, tmpstr + tmpsiz - s, "%-4s %-12s %-12s %-14s %s\n",
+		      "cpt", "locks", "completed", "hold_ns", "hold_max_ns");
+
+	cfs_percpt_for_each(container, i, the_lnet.ln_msg_containers) {
+		lnet_net_lock(i);
+		s += snprintf(s, tmpstr + tmpsiz - s,
+			      "%-4d %-12llu %-12llu %-14llu %llu\n", i,
+			      container->msc_lock_count,
+			      container->msc_completed,
+			      container->msc_hold_ns,
+			      container->msc_hold_max_ns);
+		lnet_net_unlock(i);
+	}
+
+	if (pos >= s - tmpstr)
+		rc = 0;
+	else
+		rc = cfs_trace_copyout_string(buffer, nob, tmpstr + pos, NULL);
+
+	LIBCFS_FREE(tmpstr, tmpsiz);
+	return rc;
+}
+
+static int
+proc_lnet_finalize_stats(struct ctl_table *table, int write,
+			 void __user *buffer, size_t *lenp, loff_t *ppos)
+{
+	return lprocfs_call_handler(table->data, write, ppos, buffer, lenp,
+				    __proc_lnet_finalize_stats);
+}
+
+static int __proc_lnet_discovery_stats(void *data, int write,
+				       loff_t pos, void __user *buffer, int nob)
+{
+	struct lnet_peer_table *ptable;
+	char *tmpstr;
+	char *s;
+	int tmpsiz;
+	int rc;
+	int i;
+
+	if (the_lnet.ln_peer_tables == NULL)
+		return 0;
+
+	if (write) {
+		lnet_net_lock(LNET_LOCK_EX);
+		cfs_percpt_for_each(ptable, i, the_lnet.ln_peer_tables) {
+			ptable->pt_dc_completed = 0;
+			ptable->pt_dc_time_ns = 0;
+			ptable->pt_dc_time_max_ns = 0;
+		}
+		lnet_net_unlock(LNET_LOCK_EX);
+		return 0;
+	}
+
+	tmpsiz = 128 * (LNET_CPT_NUMBER + 1);
+	LIBCFS_ALLOC(tmpstr, tmpsiz);
+	if (tmpstr == NULL)
+		return -ENOMEM;
+
+	s = tmpstr;
+	s += snprintf(s, tmpstr + tmpsiz - s, "%-4s %-8s %-8s %-12s %-12s %s\n",
+		      "cpt", "queued", "inflight", "completed", "avg_us",
+		      "max_us");
+
+	lnet_net_lock(LNET_LOCK_EX);
+	cfs_percpt_for_each(ptable, i, the_lnet.ln_peer_tables) {
+		s += snprintf(s, tmpstr + tmpsiz - s,
+			      "%-4d %-8d %-8d %-12llu %-12llu %llu\n", i,
+			      ptable->pt_dc_nrequest, ptable->pt_dc_nworking,
+			      ptable->pt_dc_completed,
+			      ptable->pt_dc_completed == 0 ? 0 :
+			      div64_u64(ptable->pt_dc_time_ns,
+					ptable->pt_dc_completed *
+					NSEC_PER_USEC),
+			      div_u64(ptable->pt_dc_time_max_ns,
+				      NSEC_PER_USEC));
+	}
+	lnet_net_unlock(LNET_LOCK_EX);
+
+	if (pos >= s - tmpstr)
+		rc = 0;
+	else
+		rc = cfs_trace_copyout_string(buffer, nob, tmpstr + pos, NULL);
+
+	LIBCFS_FREE(tmpstr, tmpsiz);
+	return rc;
+}
+
+static int
+proc_lnet_discovery_stats(struct ctl_table *table, int write,
+			  void __user *buffer, size_t *lenp, loff_t *ppos)
+{
+	return lprocfs_call_handler(table->data, write, ppos, buffer, lenp,
+				    __proc_lnet_discovery_stats);
+}
+
+static int __proc_lnet_match_stats(void *data, int write,
+				   loff_t pos, void __user *buffer, int nob)
+{
+	struct lnet_match_table *mtable;
+	struct lnet_portal *ptl;
+	__u64 hist[LNET_MT_WALK_BUCKETS];
+	unsigned int nmes;
+	unsigned int chains;
+	char *tmpstr;
+	char *s;
+	char *end;
+	int tmpsiz;
+	int rc;
+	int i;
+	int j;
+	int k;
+
+	if (write) {
+		for (i = 0; i < the_lnet.ln_nportals; i++) {
+			ptl = the_lnet.ln_portals[i];
+			cfs_percpt_for_each(mtable, j, ptl->ptl_mtables) {
+				lnet_res_lock(j);
+				memset(mtable->mt_walk_hist, 0,
+				       sizeof(mtable->mt_walk_hist));
+				lnet_res_unlock(j);
+			}
+		}
+		return 0;
+	}
+
+	tmpsiz = 512 * (the_lnet.ln_nportals + 1);
+	LIBCFS_ALLOC(tmpstr, tmpsiz);
+	if (tmpstr == NULL)
+		return -ENOMEM;
+
+	s = tmpstr;
+	end = tmpstr + tmpsiz;
+	s += snprintf(s, end - s, "%-6s %-8s %-8s %-8s %s\n",
+		      "portal", "type", "mes", "chains",
+		      "walk: 0 1 2 4 8 16 32 64 128 256 512 1024+");
+
+	for (i = 0; i < the_lnet.ln_nportals; i++) {
+		ptl = the_lnet.ln_portals[i];
+		if (!lnet_ptl_is_unique(ptl) && !lnet_ptl_is_wildcard(ptl))
+			continue;
+
+		memset(hist, 0, sizeof(hist));
+		nmes = 0;
+		chains = 0;
+		cfs_percpt_for_each(mtable, j, ptl->ptl_mtables) {
+			lnet_res_lock(j);
+			nmes += mtable->mt_nmes;
+			chains += mtable->mt_uhash != NULL ?
+				  1 << mtable->mt_uhash_bits :
+				  LNET_MT_HASH_SIZE;
+			for (k = 0; k < LNET_MT_WALK_BUCKETS; k++)
+				hist[k] += mtable->mt_walk_hist[k];
+			lnet_res_unlock(j);
+		}
+
+		s += snprintf(s, end - s, "%-6d %-8s ", i,
+			      lnet_ptl_is_unique(ptl) ? "unique" : "wildcard");
+		if (lnet_ptl_is_unique(ptl))
+			s += snprintf(s, end - s, "%-8u %-8u", nmes, chains);
+		else
+			s += snprintf(s, end - s, "%-8s %-8u", "-", chains);
+		for (k = 0; k < LNET_MT_WALK_BUCKETS; k++)
+			s += snprintf(s, end - s, " %llu", hist[k]);
+		s += snprintf(s, end - s, "\n");
+	}
+
+	if (pos >= s - tmpstr)
+		rc = 0;
+	else
+		rc = cfs_trace_copyout_string(buffer, nob, tmpstr + pos, NULL);
+
+	LIBCFS_FREE(tmpstr, tmpsiz);
+	return rc;
+}
+
+static int
+proc_lnet_match_stats(struct ctl_table *table, int write,
+		      void __user *buffer, size_t *lenp, loff_t *ppos)
+{
+	return lprocfs_call_handler(table->data, write, ppos, buffer, lenp,
+				    __proc_lnet_match_stats);
+}
+
 static int
 proc_lnet_routes(struct ctl_table *table, int write, void __user *buffer,
 		 size_t *lenp, loff_t *ppos)
@@ -914,6 +1127,24 @@ static struct ctl_table lnet_table[] = {
 		.mode		= 0644,
 		.proc_handler	= &proc_lnet_stats,
 	},
+	{
+		INIT_CTL_NAME
+		.procname	= "finalize_stats",
+		.mode		= 0644,
+		.proc_handler	= &proc_lnet_finalize_stats,
+	},
+	{
+		INIT_CTL_NAME
+		.procname	= "match_stats",
+		.mode		= 0644,
+		.proc_handler	= &proc_lnet_match_stats,
+	},
+	{
+		INIT_CTL_NAME
+		.procname	= "discovery_stats",
+		.mode		= 0644,
+		.proc_handler	= &proc_lnet_discovery_stats,
+	},
 	{
 		INIT_CTL_NAME
 		.procname	= "routes",
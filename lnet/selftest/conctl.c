@@ -663,7 +663,7 @@ lst_batch_info_ioctl(struct lstio_batch_info_args *args)
 }
 
 static int
-lst_stat_query_ioctl(struct lstio_stat_args *args)
+lst_stat_query_ioctl(struct lstio_stat_args *args, bool lat)
 {
         int             rc;
 	char           *name = NULL;
@@ -680,9 +680,9 @@ lst_stat_query_ioctl(struct lstio_stat_args *args)
 			return -EINVAL;
 
 		rc = lstcon_nodes_stat(args->lstio_sta_count,
-                                       args->lstio_sta_idsp,
-                                       args->lstio_sta_timeout,
-                                       args->lstio_sta_resultp);
+				       args->lstio_sta_idsp,
+				       args->lstio_sta_timeout, lat,
+				       args->lstio_sta_resultp);
 	} else if (args->lstio_sta_namep != NULL) {
 		if (args->lstio_sta_nmlen <= 0 ||
 		    args->lstio_sta_nmlen > LST_NAME_SIZE)
@@ -696,7 +696,7 @@ lst_stat_query_ioctl(struct lstio_stat_args *args)
 				    args->lstio_sta_nmlen);
 		if (rc == 0)
 			rc = lstcon_group_stat(name, args->lstio_sta_timeout,
-					       args->lstio_sta_resultp);
+					       lat, args->lstio_sta_resultp);
 		else
 			rc = -EFAULT;
 
@@ -906,7 +906,12 @@ lstcon_ioctl_entry(unsigned int cmd, struct libcfs_ioctl_hdr *hdr)
 		rc = lst_test_add_ioctl((struct lstio_test_args *)buf);
 		break;
 	case LSTIO_STAT_QUERY:
-		rc = lst_stat_query_ioctl((struct lstio_stat_args *)buf);
+		rc = lst_stat_query_ioctl((struct lstio_stat_args *)buf,
+					  false);
+		break;
+	case LSTIO_STAT_LAT:
+		rc = lst_stat_query_ioctl((struct lstio_stat_args *)buf,
+					  true);
 		break;
 	default:
 		rc = -EINVAL;
@@ -224,6 +224,9 @@ lstcon_rpc_trans_name(int transop)
         if (transop == LST_TRANS_STATQRY)
                 return "STATQRY";
 
+	if (transop == LST_TRANS_LATQRY)
+		return "LATQRY";
+
         return "Unknown";
 }
 
@@ -699,6 +702,23 @@ lstcon_statrpc_prep(struct lstcon_node *nd, unsigned int feats,
         return 0;
 }
 
+int
+lstcon_latrpc_prep(struct lstcon_node *nd, unsigned int feats,
+		   struct lstcon_rpc **crpc)
+{
+	struct srpc_lat_reqst *lrq;
+	int rc;
+
+	rc = lstcon_rpc_prep(nd, SRPC_SERVICE_QUERY_LAT, feats, 0, 0, crpc);
+	if (rc != 0)
+		return rc;
+
+	lrq = &(*crpc)->crp_rpc->crpc_reqstmsg.msg_body.lat_reqst;
+	lrq->lat_sid = console_session.ses_id;
+
+	return 0;
+}
+
 static struct lnet_process_id_packed *
 lstcon_next_id(int idx, int nkiov, lnet_kiov_t *kiov)
 {
@@ -972,6 +992,7 @@ lstcon_rpc_stat_reply(struct lstcon_rpc_trans *trans, struct srpc_msg *msg,
 	struct srpc_batch_reply *bat_rep;
 	struct srpc_test_reply *test_rep;
 	struct srpc_stat_reply *stat_rep;
+	struct srpc_lat_reply *lat_rep;
 	int rc = 0;
 
 	switch (trans->tas_opc) {
@@ -1073,6 +1094,18 @@ lstcon_rpc_stat_reply(struct lstcon_rpc_trans *trans, struct srpc_msg *msg,
                 rc = stat_rep->str_status;
                 break;
 
+	case LST_TRANS_LATQRY:
+		lat_rep = &msg->msg_body.lat_reply;
+
+		if (lat_rep->lat_status == 0) {
+			lstcon_statqry_stat_success(stat, 1);
+			return;
+		}
+
+		lstcon_statqry_stat_failure(stat, 1);
+		rc = lat_rep->lat_status;
+		break;
+
         default:
                 LBUG();
         }
@@ -1146,6 +1179,9 @@ lstcon_rpc_trans_ndlist(struct list_head *ndlist,
 		case LST_TRANS_STATQRY:
 			rc = lstcon_statrpc_prep(nd, feats, &rpc);
                         break;
+		case LST_TRANS_LATQRY:
+			rc = lstcon_latrpc_prep(nd, feats, &rpc);
+			break;
                 default:
                         rc = -EINVAL;
                         break;
@@ -104,6 +104,7 @@ struct lstcon_rpc_trans {
 #define LST_TRANS_TSBSRVQRY     0x16
 
 #define LST_TRANS_STATQRY       0x21
+#define LST_TRANS_LATQRY	0x22
 
 typedef int (*lstcon_rpc_cond_func_t)(int, struct lstcon_node *, void *);
 typedef int (*lstcon_rpc_readent_func_t)(int, struct srpc_msg *,
@@ -119,6 +120,8 @@ int  lstcon_testrpc_prep(struct lstcon_node *nd, int transop, unsigned version,
 			 struct lstcon_test *test, struct lstcon_rpc **crpc);
 int  lstcon_statrpc_prep(struct lstcon_node *nd, unsigned version,
 			 struct lstcon_rpc **crpc);
+int  lstcon_latrpc_prep(struct lstcon_node *nd, unsigned int version,
+			struct lstcon_rpc **crpc);
 void lstcon_rpc_put(struct lstcon_rpc *crpc);
 int  lstcon_rpc_trans_prep(struct list_head *translist,
 			   int transop, struct lstcon_rpc_trans **transpp);
@@ -1492,17 +1492,37 @@ lstcon_statrpc_readent(int transop, struct srpc_msg *msg,
 }
 
 static int
-lstcon_ndlist_stat(struct list_head *ndlist,
-		   int timeout, struct list_head __user *result_up)
+lstcon_latrpc_readent(int transop, struct srpc_msg *msg,
+		      struct lstcon_rpc_ent __user *ent_up)
+{
+	struct srpc_lat_reply *rep = &msg->msg_body.lat_reply;
+
+	if (rep->lat_status != 0)
+		return 0;
+
+	if (copy_to_user(&ent_up->rpe_payload[0], &rep->lat_counters,
+			 sizeof(rep->lat_counters)))
+		return -EFAULT;
+
+	return 0;
+}
+
+static int
+lstcon_ndlist_stat(struct list_head *ndlist, int timeout, bool lat,
+		   struct list_head __user *result_up)
 {
 	struct list_head    head;
 	struct lstcon_rpc_trans *trans;
 	int		    rc;
 
+	if (lat && (console_session.ses_features & LST_FEAT_LAT_HIST) == 0)
+		return -EOPNOTSUPP;
+
 	INIT_LIST_HEAD(&head);
 
-        rc = lstcon_rpc_trans_ndlist(ndlist, &head,
-                                     LST_TRANS_STATQRY, NULL, NULL, &trans);
+	rc = lstcon_rpc_trans_ndlist(ndlist, &head,
+				     lat ? LST_TRANS_LATQRY : LST_TRANS_STATQRY,
+				     NULL, NULL, &trans);
         if (rc != 0) {
                 CERROR("Can't create transaction: %d\n", rc);
                 return rc;
@@ -1510,15 +1530,16 @@ lstcon_ndlist_stat(struct list_head *ndlist,
 
         lstcon_rpc_trans_postwait(trans, LST_VALIDATE_TIMEOUT(timeout));
 
-        rc = lstcon_rpc_trans_interpreter(trans, result_up,
-                                          lstcon_statrpc_readent);
+	rc = lstcon_rpc_trans_interpreter(trans, result_up,
+					  lat ? lstcon_latrpc_readent :
+						lstcon_statrpc_readent);
         lstcon_rpc_trans_destroy(trans);
 
         return rc;
 }
 
 int
-lstcon_group_stat(char *grp_name, int timeout,
+lstcon_group_stat(char *grp_name, int timeout, bool lat,
 		  struct list_head __user *result_up)
 {
 	struct lstcon_group *grp;
@@ -1530,7 +1551,7 @@ lstcon_group_stat(char *grp_name, int timeout,
                 return rc;
         }
 
-        rc = lstcon_ndlist_stat(&grp->grp_ndl_list, timeout, result_up);
+	rc = lstcon_ndlist_stat(&grp->grp_ndl_list, timeout, lat, result_up);
 
 	lstcon_group_decref(grp);
 
@@ -1539,7 +1560,7 @@ lstcon_group_stat(char *grp_name, int timeout,
 
 int
 lstcon_nodes_stat(int count, struct lnet_process_id __user *ids_up,
-		  int timeout, struct list_head __user *result_up)
+		  int timeout, bool lat, struct list_head __user *result_up)
 {
 	struct lstcon_ndlink *ndl;
 	struct lstcon_group *tmp;
@@ -1574,7 +1595,7 @@ lstcon_nodes_stat(int count, struct lnet_process_id __user *ids_up,
                 return rc;
         }
 
-        rc = lstcon_ndlist_stat(&tmp->grp_ndl_list, timeout, result_up);
+	rc = lstcon_ndlist_stat(&tmp->grp_ndl_list, timeout, lat, result_up);
 
 	lstcon_group_decref(tmp);
 
@@ -410,6 +410,64 @@ sfw_get_stats(struct srpc_stat_reqst *request, struct srpc_stat_reply *reply)
 	return 0;
 }
 
+/* record the round-trip time of a completed test RPC */
+static void
+sfw_record_latency(struct sfw_session *sn, struct srpc_client_rpc *rpc)
+{
+	s64 us = ktime_us_delta(ktime_get(), rpc->crpc_started);
+	int max;
+
+	if (us < 0)
+		us = 0;
+	if (us > INT_MAX)
+		us = INT_MAX;
+
+	atomic_inc(&sn->sn_lat_buckets[lst_lat_bucket(us)]);
+
+	max = atomic_read(&sn->sn_lat_max_us);
+	while (us > max) {
+		int old = atomic_cmpxchg(&sn->sn_lat_max_us, max, us);
+
+		if (old == max)
+			break;
+		max = old;
+	}
+}
+
+/* the buckets only ever grow, the console works out the deltas between
+ * two queries; the maximum is reset so each query sees a fresh one */
+static int
+sfw_get_lat(struct srpc_lat_reqst *request, struct srpc_lat_reply *reply)
+{
+	struct sfw_session *sn = sfw_data.fw_session;
+	struct sfw_lat_counters *cnt = &reply->lat_counters;
+	int i;
+
+	reply->lat_sid = (sn == NULL) ? LST_INVALID_SID : sn->sn_id;
+
+	if (request->lat_sid.ses_nid == LNET_NID_ANY) {
+		reply->lat_status = EINVAL;
+		return 0;
+	}
+
+	if (sn == NULL || !sfw_sid_equal(request->lat_sid, sn->sn_id)) {
+		reply->lat_status = ESRCH;
+		return 0;
+	}
+
+	if ((sn->sn_features & LST_FEAT_LAT_HIST) == 0) {
+		reply->lat_status = EOPNOTSUPP;
+		return 0;
+	}
+
+	for (i = 0; i < LST_LAT_BUCKETS; i++)
+		cnt->lat_buckets[i] = atomic_read(&sn->sn_lat_buckets[i]);
+	cnt->lat_max_us = atomic_xchg(&sn->sn_lat_max_us, 0);
+
+	reply->lat_status = 0;
+	return 0;
+}
+
 int
 sfw_make_session(struct srpc_mksn_reqst *request, struct srpc_mksn_reply *reply)
 {
@@ -880,8 +938,13 @@ sfw_test_rpc_done(struct srpc_client_rpc *rpc)
 {
 	struct sfw_test_unit *tsu = rpc->crpc_priv;
 	struct sfw_test_instance *tsi = tsu->tsu_instance;
+	struct sfw_session *sn = tsi->tsi_batch->bat_session;
         int                  done = 0;
 
+	if (rpc->crpc_status == 0 && sn != NULL &&
+	    (sn->sn_features & LST_FEAT_LAT_HIST) != 0)
+		sfw_record_latency(sn, rpc);
+
         tsi->tsi_ops->tso_done_rpc(tsu, rpc);
 
 	spin_lock(&tsi->tsi_lock);
@@ -1315,6 +1378,11 @@ sfw_handle_server_rpc(struct srpc_server_rpc *rpc)
                                    &reply->msg_body.stat_reply);
                 break;
 
+	case SRPC_SERVICE_QUERY_LAT:
+		rc = sfw_get_lat(&request->msg_body.lat_reqst,
+				 &reply->msg_body.lat_reply);
+		break;
+
         case SRPC_SERVICE_DEBUG:
                 rc = sfw_debug_session(&request->msg_body.dbg_reqst,
                                        &reply->msg_body.dbg_reply);
@@ -1460,6 +1528,26 @@ sfw_unpack_message(struct srpc_msg *msg)
                 return;
         }
 
+	if (msg->msg_type == SRPC_MSG_LAT_REQST) {
+		struct srpc_lat_reqst *req = &msg->msg_body.lat_reqst;
+
+		__swab64s(&req->lat_rpyid);
+		sfw_unpack_sid(req->lat_sid);
+		return;
+	}
+
+	if (msg->msg_type == SRPC_MSG_LAT_REPLY) {
+		struct srpc_lat_reply *rep = &msg->msg_body.lat_reply;
+		int i;
+
+		__swab32s(&rep->lat_status);
+		sfw_unpack_sid(rep->lat_sid);
+		__swab32s(&rep->lat_counters.lat_max_us);
+		for (i = 0; i < LST_LAT_BUCKETS; i++)
+			__swab32s(&rep->lat_counters.lat_buckets[i]);
+		return;
+	}
+
         if (msg->msg_type == SRPC_MSG_MKSN_REQST) {
 		struct srpc_mksn_reqst *req = &msg->msg_body.mksn_reqst;
 
@@ -1607,6 +1695,7 @@ sfw_post_rpc(struct srpc_client_rpc *rpc)
 static struct srpc_service sfw_services[] = {
 	{ .sv_id = SRPC_SERVICE_DEBUG,		.sv_name = "debug", },
 	{ .sv_id = SRPC_SERVICE_QUERY_STAT,	.sv_name = "query stats", },
+	{ .sv_id = SRPC_SERVICE_QUERY_LAT,	.sv_name = "query latency", },
 	{ .sv_id = SRPC_SERVICE_MAKE_SESSION,	.sv_name = "make session", },
 	{ .sv_id = SRPC_SERVICE_REMOVE_SESSION,	.sv_name = "remove session", },
 	{ .sv_id = SRPC_SERVICE_BATCH,		.sv_name = "batch service", },
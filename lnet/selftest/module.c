@@ -94,6 +94,8 @@ lnet_selftest_structure_assertion(void)
 	CLASSERT(sizeof(struct srpc_stat_reply) == 136);
 	CLASSERT(sizeof(struct srpc_stat_reqst) == 28);
 */
+	CLASSERT(sizeof(struct srpc_lat_reply) <=
+		 sizeof(struct srpc_stat_reply));
 }
 
 static int __init
@@ -77,6 +77,7 @@ struct sfw_test_instance;
 #define SRPC_SERVICE_TEST               4
 #define SRPC_SERVICE_QUERY_STAT         5
 #define SRPC_SERVICE_JOIN               6
+#define SRPC_SERVICE_QUERY_LAT          7
 #define SRPC_FRAMEWORK_SERVICE_MAX_ID   10
 /* other services start from SRPC_FRAMEWORK_SERVICE_MAX_ID+1 */
 #define SRPC_SERVICE_BRW                11
@@ -121,6 +122,9 @@ srpc_service2request (int service)
 
         case SRPC_SERVICE_JOIN:
                 return SRPC_MSG_JOIN_REQST;
+
+	case SRPC_SERVICE_QUERY_LAT:
+		return SRPC_MSG_LAT_REQST;
         }
 }
 
@@ -207,6 +211,7 @@ struct srpc_client_rpc {
 	struct stt_timer	crpc_timer;
 	struct swi_workitem	crpc_wi;
 	struct lnet_process_id	crpc_dest;
+	ktime_t			crpc_started;	/* when it was posted */
 
         void               (*crpc_done)(struct srpc_client_rpc *);
         void               (*crpc_fini)(struct srpc_client_rpc *);
@@ -334,6 +339,9 @@ struct sfw_session {
 	atomic_t		sn_brw_errors;
 	atomic_t		sn_ping_errors;
 	ktime_t			sn_started;
+	/* round-trip times of test RPCs, see struct sfw_lat_counters */
+	atomic_t		sn_lat_buckets[LST_LAT_BUCKETS];
+	atomic_t		sn_lat_max_us;
 };
 
 #define sfw_sid_equal(sid0, sid1)     ((sid0).ses_nid == (sid1).ses_nid && \
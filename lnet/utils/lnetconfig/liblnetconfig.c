@@ -2301,6 +2301,22 @@ int lustre_lnet_show_net(char *nw, int detail, int seq_no,
 							== NULL)
 				goto out;
 
+			LIBCFS_IOC_INIT_V2(hstats, hlni_hdr);
+			hstats.hlni_nid = ni_data->lic_nid;
+			/* grab health stats */
+			rc = l_ioctl(LNET_DEV_ID,
+				     IOC_LIBCFS_GET_LOCAL_HSTATS,
+				     &hstats);
+			if (rc != 0) {
+				l_errno = errno;
+				goto continue_without_msg_stats;
+			}
+
+			if (cYAML_create_number(statistics, "latency_us",
+						hstats.hlni_latency_us)
+							== NULL)
+				goto out;
+
 			if (detail < 2)
 				goto continue_without_msg_stats;
 
@@ -2334,16 +2350,6 @@ int lustre_lnet_show_net(char *nw, int detail, int seq_no,
 					goto out;
 			}
 
-			LIBCFS_IOC_INIT_V2(hstats, hlni_hdr);
-			hstats.hlni_nid = ni_data->lic_nid;
-			/* grab health stats */
-			rc = l_ioctl(LNET_DEV_ID,
-				     IOC_LIBCFS_GET_LOCAL_HSTATS,
-				     &hstats);
-			if (rc != 0) {
-				l_errno = errno;
-				goto continue_without_msg_stats;
-			}
 			yhstats = cYAML_create_object(item, "health stats");
 			if (!yhstats)
 				goto out;
@@ -3094,6 +3100,11 @@ int lustre_lnet_show_peer(char *knid, int detail, int seq_no,
 			    == NULL)
 				goto out;
 
+			if (cYAML_create_number(statistics, "latency_us",
+						hstats->hlpni_latency_us)
+			    == NULL)
+				goto out;
+
 			if (detail < 2)
 				continue;
 
@@ -3599,6 +3610,87 @@ int lustre_lnet_show_numa_range(int seq_no, struct cYAML **show_rc,
 					"numa_range", show_rc, err_rc);
 }
 
+/* add the router buffer pools of every CPT, if this node routes */
+static int show_rtrpool_stats(struct cYAML *stats)
+{
+	char *pools[LNET_NRBPOOLS] = {"tiny", "small", "large"};
+	struct lnet_ioctl_rtrpool_stats data;
+	struct cYAML *rtr = NULL, *item, *cpt, *pool, *hist;
+	char node_name[LNET_MAX_STR_LEN];
+	int i, j, k;
+
+	for (i = 0;; i++) {
+		LIBCFS_IOC_INIT_V2(data, rps_hdr);
+		data.rps_cpt = i;
+
+		/* ENOENT past the last CPT or when not routing */
+		if (l_ioctl(LNET_DEV_ID, IOC_LIBCFS_GET_RTRPOOL_STATS,
+			    &data) != 0)
+			return 0;
+
+		if (rtr == NULL) {
+			rtr = cYAML_create_seq(stats, "router_buffers");
+			if (rtr == NULL)
+				return -ENOMEM;
+		}
+
+		snprintf(node_name, sizeof(node_name), "cpt[%d]", i);
+		item = cYAML_create_seq_item(rtr);
+		if (item == NULL)
+			return -ENOMEM;
+
+		cpt = cYAML_create_object(item, node_name);
+		if (cpt == NULL)
+			return -ENOMEM;
+
+		if (cYAML_create_number(cpt, "adaptive",
+					data.rps_adaptive) == NULL)
+			return -ENOMEM;
+
+		for (j = 0; j < LNET_NRBPOOLS; j++) {
+			struct lnet_rtrpool_stats *p = &data.rps_pools[j];
+
+			pool = cYAML_create_object(cpt, pools[j]);
+			if (pool == NULL ||
+			    cYAML_create_number(pool, "npages",
+						p->rps_npages) == NULL ||
+			    cYAML_create_number(pool, "nbuffers",
+						p->rps_nbuffers) == NULL ||
+			    cYAML_create_number(pool, "req_nbuffers",
+						p->rps_req_nbuffers) == NULL ||
+			    cYAML_create_number(pool, "min_nbuffers",
+						p->rps_min_nbuffers) == NULL ||
+			    cYAML_create_number(pool, "max_nbuffers",
+						p->rps_max_nbuffers) == NULL ||
+			    cYAML_create_number(pool, "credits",
+						p->rps_credits) == NULL ||
+			    cYAML_create_number(pool, "mincredits",
+						p->rps_mincredits) == NULL ||
+			    cYAML_create_number(pool, "grown",
+						p->rps_grown) == NULL ||
+			    cYAML_create_number(pool, "shrunk",
+						p->rps_shrunk) == NULL)
+				return -ENOMEM;
+
+			hist = cYAML_create_object(pool, "occupancy");
+			if (hist == NULL)
+				return -ENOMEM;
+
+			for (k = 0; k < LNET_RTRPOOL_HIST_BUCKETS; k++) {
+				if (k == LNET_RTRPOOL_HIST_BUCKETS - 1)
+					snprintf(node_name, sizeof(node_name),
+						 "blocked");
+				else
+					snprintf(node_name, sizeof(node_name),
+						 "%d-%d%%", k * 10, k * 10 + 10);
+				if (cYAML_create_number(hist, node_name,
+							p->rps_hist[k]) == NULL)
+					return -ENOMEM;
+			}
+		}
+	}
+}
+
 int lustre_lnet_show_stats(int seq_no, struct cYAML **show_rc,
 			   struct cYAML **err_rc)
 {
@@ -3729,6 +3821,9 @@ int lustre_lnet_show_stats(int seq_no, struct cYAML **show_rc,
 				data.st_cntrs.drop_length) == NULL)
 		goto out;
 
+	if (show_rtrpool_stats(stats) != 0)
+		goto out;
+
 	if (show_rc == NULL)
 		cYAML_print_tree(root);
 
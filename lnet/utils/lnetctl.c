@@ -137,7 +137,8 @@ command_t net_cmds[] = {
 	 "\t--peer-credits: define the max number of inflight messages\n"
 	 "\t--peer-buffer-credits: the number of buffer credits per peer\n"
 	 "\t--credits: Network Interface credits\n"
-	 "\t--cpt: CPU Partitions configured net uses (e.g. [0,1]\n"},
+	 "\t--cpt: CPU Partitions configured net uses (e.g. [0,1]\n"
+	 "\t--conns-per-peer: number of bulk connections per peer (tcp)\n"},
 	{"del", jt_del_ni, 0, "delete a network\n"
 	 "\t--net: net name (e.g. tcp0)\n"
 	 "\t--if: physical interface (e.g. eth0)\n"},
@@ -703,7 +704,7 @@ static int jt_add_route(int argc, char **argv)
 static int jt_add_ni(int argc, char **argv)
 {
 	char *ip2net = NULL;
-	long int pto = -1, pc = -1, pbc = -1, cre = -1;
+	long int pto = -1, pc = -1, pbc = -1, cre = -1, cpp = -1;
 	struct cYAML *err_rc = NULL;
 	int rc, opt, cpt_rc = -1;
 	struct lnet_dlc_network_descr nw_descr;
@@ -714,7 +715,7 @@ static int jt_add_ni(int argc, char **argv)
 	memset(&tunables, 0, sizeof(tunables));
 	lustre_lnet_init_nw_descr(&nw_descr);
 
-	const char *const short_options = "n:i:p:t:c:b:r:s:";
+	const char *const short_options = "n:i:p:t:c:b:r:s:m:";
 	static const struct option long_options[] = {
 	{ .name = "net",	  .has_arg = required_argument, .val = 'n' },
 	{ .name = "if",		  .has_arg = required_argument, .val = 'i' },
@@ -725,6 +726,8 @@ static int jt_add_ni(int argc, char **argv)
 				  .has_arg = required_argument, .val = 'b' },
 	{ .name = "credits",	  .has_arg = required_argument, .val = 'r' },
 	{ .name = "cpt",	  .has_arg = required_argument, .val = 's' },
+	{ .name = "conns-per-peer",
+				  .has_arg = required_argument, .val = 'm' },
 	{ .name = NULL } };
 
 	rc = check_cmd(net_cmds, "net", "add", 0, argc, argv);
@@ -786,12 +789,20 @@ static int jt_add_ni(int argc, char **argv)
 						     strlen(optarg), 0,
 						     UINT_MAX, &global_cpts);
 			break;
+		case 'm':
+			rc = parse_long(optarg, &cpp);
+			if (rc != 0) {
+				/* ignore option */
+				cpp = -1;
+				continue;
+			}
+			break;
 		default:
 			return 0;
 		}
 	}
 
-	if (pto > 0 || pc > 0 || pbc > 0 || cre > 0) {
+	if (pto > 0 || pc > 0 || pbc > 0 || cre > 0 || cpp > 0) {
 		tunables.lt_cmn.lct_peer_timeout = pto;
 		tunables.lt_cmn.lct_peer_tx_credits = pc;
 		tunables.lt_cmn.lct_peer_rtr_credits = pbc;
@@ -799,6 +810,9 @@ static int jt_add_ni(int argc, char **argv)
 		found = true;
 	}
 
+	if (cpp > 0 && LNET_NETTYP(nw_descr.nw_id) == SOCKLND)
+		tunables.lt_tun.lnd_tun_u.lnd_sock.lnd_conns_per_peer = cpp;
+
 	rc = lustre_lnet_config_ni(&nw_descr,
 				   (cpt_rc == 0) ? global_cpts: NULL,
 				   ip2net, (found) ? &tunables : NULL,
@@ -58,8 +58,10 @@ static struct lst_sid session_id;
 static int                 session_key;
 static int lst_list_commands(int argc, char **argv);
 
-/* All nodes running 2.6.50 or later understand feature LST_FEAT_BULK_LEN */
-static unsigned		session_features = LST_FEATS_MASK;
+/* All nodes running 2.6.50 or later understand feature LST_FEAT_BULK_LEN.
+ * LST_FEAT_LAT_HIST is left out so sessions still work with older nodes,
+ * "lst new_session --lat" asks for it */
+static unsigned		session_features = LST_FEATS_MASK & ~LST_FEAT_LAT_HIST;
 static struct lstcon_trans_stat	trans_stat;
 
 typedef struct list_string {
@@ -546,6 +548,7 @@ jt_lst_new_session(int argc, char **argv)
 	static const struct option session_opts[] = {
 		{ .name = "timeout", .has_arg = required_argument, .val = 't' },
 		{ .name = "force",   .has_arg = no_argument,	   .val = 'f' },
+		{ .name = "lat",     .has_arg = no_argument,	   .val = 'l' },
 		{ .name = NULL } };
 
         if (session_key == 0) {
@@ -556,7 +559,7 @@ jt_lst_new_session(int argc, char **argv)
 
         while (1) {
 
-                c = getopt_long(argc, argv, "ft:",
+                c = getopt_long(argc, argv, "flt:",
                                 session_opts, &optidx);
 
                 if (c == -1)
@@ -566,6 +569,9 @@ jt_lst_new_session(int argc, char **argv)
                 case 'f':
                         force = 1;
                         break;
+		case 'l':
+			session_features |= LST_FEAT_LAT_HIST;
+			break;
                 case 't':
                         timeout = atoi(optarg);
                         break;
@@ -1486,7 +1492,7 @@ jt_lst_list_group(int argc, char **argv)
 
 int
 lst_stat_ioctl(char *name, int count, struct lnet_process_id *idsp,
-	       int timeout, struct list_head *resultp)
+	       int timeout, int lat, struct list_head *resultp)
 {
 	struct lstio_stat_args args = { 0 };
 
@@ -1498,7 +1504,8 @@ lst_stat_ioctl(char *name, int count, struct lnet_process_id *idsp,
 	args.lstio_sta_idsp    = idsp;
 	args.lstio_sta_resultp = resultp;
 
-	return lst_ioctl(LSTIO_STAT_QUERY, &args, sizeof(args));
+	return lst_ioctl(lat ? LSTIO_STAT_LAT : LSTIO_STAT_QUERY,
+			 &args, sizeof(args));
 }
 
 typedef struct {
@@ -1507,6 +1514,7 @@ typedef struct {
         char                   *srp_name;
 	struct lnet_process_id      *srp_ids;
 	struct list_head              srp_result[2];
+	struct list_head	      srp_lat[2];	/* for --lat */
 } lst_stat_req_param_t;
 
 static void
@@ -1514,8 +1522,10 @@ lst_stat_req_param_free(lst_stat_req_param_t *srp)
 {
         int     i;
 
-        for (i = 0; i < 2; i++)
-                lst_free_rpcent(&srp->srp_result[i]);
+	for (i = 0; i < 2; i++) {
+		lst_free_rpcent(&srp->srp_result[i]);
+		lst_free_rpcent(&srp->srp_lat[i]);
+	}
 
         if (srp->srp_ids != NULL)
                 free(srp->srp_ids);
@@ -1524,7 +1534,8 @@ lst_stat_req_param_free(lst_stat_req_param_t *srp)
 }
 
 static int
-lst_stat_req_param_alloc(char *name, lst_stat_req_param_t **srpp, int save_old)
+lst_stat_req_param_alloc(char *name, lst_stat_req_param_t **srpp, int save_old,
+			 int lat)
 {
         lst_stat_req_param_t *srp = NULL;
         int                   count = save_old ? 2 : 1;
@@ -1538,6 +1549,8 @@ lst_stat_req_param_alloc(char *name, lst_stat_req_param_t **srpp, int save_old)
         memset(srp, 0, sizeof(*srp));
 	INIT_LIST_HEAD(&srp->srp_result[0]);
 	INIT_LIST_HEAD(&srp->srp_result[1]);
+	INIT_LIST_HEAD(&srp->srp_lat[0]);
+	INIT_LIST_HEAD(&srp->srp_lat[1]);
 
         rc = lst_get_node_count(LST_OPC_GROUP, name,
                                 &srp->srp_count, NULL);
@@ -1566,6 +1579,16 @@ lst_stat_req_param_alloc(char *name, lst_stat_req_param_t **srpp, int save_old)
                         fprintf(stderr, "Out of memory\n");
                         break;
                 }
+
+		if (!lat)
+			continue;
+
+		rc = lst_alloc_rpcent(&srp->srp_lat[i], srp->srp_count,
+				      sizeof(struct sfw_lat_counters));
+		if (rc != 0) {
+			fprintf(stderr, "Out of memory\n");
+			break;
+		}
         }
 
         if (rc == 0) {
@@ -1870,6 +1893,99 @@ lst_print_stat(char *name, struct list_head *resultp,
 	lst_print_lnet_stat(name, bwrt, rdwr, type, mbs);
 }
 
+/* upper bound of the bucket holding the \a permille'th round-trip time */
+static __u64
+lst_lat_percentile(__u64 *buckets, __u64 total, int permille,
+		   __u32 max_us)
+{
+	__u64 need = (total * permille + 999) / 1000;
+	__u64 sum = 0;
+	int i;
+
+	for (i = 0; i < LST_LAT_BUCKETS - 1; i++) {
+		sum += buckets[i];
+		if (sum >= need)
+			break;
+	}
+
+	if (i == LST_LAT_BUCKETS - 1)
+		return max_us;
+
+	return lst_lat_bucket_low(i + 1) - 1;
+}
+
+static void
+lst_print_lat(char *name, struct list_head *resultp, int idx)
+{
+	struct lstcon_rpc_ent	*new;
+	struct lstcon_rpc_ent	*old;
+	struct sfw_lat_counters	*lat_new;
+	struct sfw_lat_counters	*lat_old;
+	__u64			 buckets[LST_LAT_BUCKETS] = { 0 };
+	__u64			 total = 0;
+	__u32			 max_us = 0;
+	int			 errcount = 0;
+	int			 i;
+
+	old = list_entry(resultp[1 - idx].next, struct lstcon_rpc_ent,
+			 rpe_link);
+
+	list_for_each_entry(new, &resultp[idx], rpe_link) {
+		if (&old->rpe_link == &resultp[1 - idx]) {
+			fprintf(stderr, "Group is changed, re-run stat\n");
+			return;
+		}
+
+		/* first time get stats result, can't calculate diff */
+		if (old->rpe_peer.nid == LNET_NID_ANY)
+			return;
+
+		if (new->rpe_peer.nid != old->rpe_peer.nid ||
+		    new->rpe_peer.pid != old->rpe_peer.pid)
+			return;
+
+		lat_new = (struct sfw_lat_counters *)&new->rpe_payload[0];
+		lat_old = (struct sfw_lat_counters *)&old->rpe_payload[0];
+		old = list_entry(old->rpe_link.next, struct lstcon_rpc_ent,
+				 rpe_link);
+
+		if (new->rpe_rpc_errno != 0 || new->rpe_fwk_errno != 0) {
+			errcount++;
+			continue;
+		}
+
+		for (i = 0; i < LST_LAT_BUCKETS; i++) {
+			__u32 delta = lat_new->lat_buckets[i] -
+				      lat_old->lat_buckets[i];
+
+			buckets[i] += delta;
+			total += delta;
+		}
+
+		if (lat_new->lat_max_us > max_us)
+			max_us = lat_new->lat_max_us;
+	}
+
+	if (errcount > 0)
+		fprintf(stdout, "Failed to get latency on %d nodes\n",
+			errcount);
+
+	if (total == 0)
+		return;
+
+	fprintf(stdout, "[RPC latency of %s]\n", name);
+	fprintf(stdout, "Count: %-10llu p50: %-8llu p99: %-8llu "
+		"p99.9: %-8llu Max: %u usec\n",
+		(unsigned long long)total,
+		(unsigned long long)lst_lat_percentile(buckets, total, 500,
+						       max_us),
+		(unsigned long long)lst_lat_percentile(buckets, total, 990,
+						       max_us),
+		(unsigned long long)lst_lat_percentile(buckets, total, 999,
+						       max_us),
+		max_us);
+}
+
 int
 jt_lst_stat(int argc, char **argv)
 {
@@ -1888,6 +2004,7 @@ jt_lst_stat(int argc, char **argv)
 	int		      rc;
 	int		      c;
 	int		      mbs     = 0; /* report as MB/s */
+	int		      lat     = 0; /* RPC latency percentiles */
 
 	static const struct option stat_opts[] = {
 		{ .name = "timeout", .has_arg = required_argument, .val = 't' },
@@ -1903,6 +2020,7 @@ jt_lst_stat(int argc, char **argv)
 		{ .name = "min",     .has_arg = no_argument,       .val = 'n' },
 		{ .name = "max",     .has_arg = no_argument,       .val = 'x' },
 		{ .name = "mbs",     .has_arg = no_argument,       .val = 'm' },
+		{ .name = "lat",     .has_arg = no_argument,       .val = 'L' },
 		{ .name = NULL } };
 
         if (session_key == 0) {
@@ -1912,7 +2030,7 @@ jt_lst_stat(int argc, char **argv)
         }
 
         while (1) {
-		c = getopt_long(argc, argv, "t:d:lcbarwgnxm", stat_opts,
+		c = getopt_long(argc, argv, "t:d:lcbarwgnxmL", stat_opts,
 				&optidx);
 
                 if (c == -1)
@@ -1970,6 +2088,9 @@ jt_lst_stat(int argc, char **argv)
 		case 'm':
 			mbs = 1;
 			break;
+		case 'L':
+			lat = 1;
+			break;
 
 		default:
 			lst_print_usage(argv[0]);
@@ -1999,7 +2120,7 @@ jt_lst_stat(int argc, char **argv)
 	INIT_LIST_HEAD(&head);
 
         while (optind < argc) {
-                rc = lst_stat_req_param_alloc(argv[optind++], &srp, 1);
+		rc = lst_stat_req_param_alloc(argv[optind++], &srp, 1, lat);
                 if (rc != 0)
                         goto out;
 
@@ -2018,7 +2139,7 @@ jt_lst_stat(int argc, char **argv)
 		list_for_each_entry(srp, &head, srp_link) {
                         rc = lst_stat_ioctl(srp->srp_name,
                                             srp->srp_count, srp->srp_ids,
-                                            timeout, &srp->srp_result[idx]);
+					    timeout, 0, &srp->srp_result[idx]);
                         if (rc == -1) {
                                 lst_print_error("stat", "Failed to stat %s: %s\n",
                                                 srp->srp_name, strerror(errno));
@@ -2029,6 +2150,29 @@ jt_lst_stat(int argc, char **argv)
 				       idx, lnet, bwrt, rdwr, type, mbs);
 
 			lst_reset_rpcent(&srp->srp_result[1 - idx]);
+
+			if (!lat)
+				continue;
+
+			rc = lst_stat_ioctl(srp->srp_name,
+					    srp->srp_count, srp->srp_ids,
+					    timeout, 1, &srp->srp_lat[idx]);
+			if (rc == -1) {
+				if (errno == EOPNOTSUPP)
+					fprintf(stderr,
+						"Session was created without "
+						"latency histograms\n");
+				else
+					lst_print_error("stat",
+							"Failed to stat %s: %s\n",
+							srp->srp_name,
+							strerror(errno));
+				goto out;
+			}
+
+			lst_print_lat(srp->srp_name, srp->srp_lat, idx);
+
+			lst_reset_rpcent(&srp->srp_lat[1 - idx]);
 		}
 
                 idx = 1 - idx;
@@ -2097,7 +2241,7 @@ jt_lst_show_error(int argc, char **argv)
 	INIT_LIST_HEAD(&head);
 
         while (optind < argc) {
-                rc = lst_stat_req_param_alloc(argv[optind++], &srp, 0);
+                rc = lst_stat_req_param_alloc(argv[optind++], &srp, 0, 0);
                 if (rc != 0)
                         goto out;
 
@@ -2105,8 +2249,8 @@ jt_lst_show_error(int argc, char **argv)
         }
 
 	list_for_each_entry(srp, &head, srp_link) {
-                rc = lst_stat_ioctl(srp->srp_name, srp->srp_count,
-                                    srp->srp_ids, 10, &srp->srp_result[0]);
+		rc = lst_stat_ioctl(srp->srp_name, srp->srp_count,
+				    srp->srp_ids, 10, 0, &srp->srp_result[0]);
 
                 if (rc == -1) {
                         lst_print_error(srp->srp_name, "Failed to show errors of %s: %s\n",
@@ -3242,7 +3386,7 @@ out:
 
 static command_t lst_cmdlist[] = {
 	{"new_session",		jt_lst_new_session,	NULL,
-         "Usage: lst new_session [--timeout TIME] [--force] [NAME]"	                },
+         "Usage: lst new_session [--timeout TIME] [--force] [--lat] [NAME]"	        },
 	{"end_session",		jt_lst_end_session,	NULL,
          "Usage: lst end_session"	                                                },
         {"show_session",        jt_lst_show_session,    NULL,
@@ -3259,7 +3403,7 @@ static command_t lst_cmdlist[] = {
           "Usage: lst list_group [--active] [--busy] [--down] [--unknown] GROUP ..."    },
 	{"stat",                jt_lst_stat,            NULL,
 	 "Usage: lst stat [--bw] [--rate] [--read] [--write] [--max] [--min] [--avg] "
-	 " [--mbs] [--timeout #] [--delay #] [--count #] GROUP [GROUP]"                 },
+	 " [--mbs] [--lat] [--timeout #] [--delay #] [--count #] GROUP [GROUP]"         },
         {"show_error",          jt_lst_show_error,      NULL,
          "Usage: lst show_error NAME | IDS ..."                                         },
         {"add_batch",           jt_lst_add_batch,       NULL,
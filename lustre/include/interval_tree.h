@@ -37,18 +37,15 @@
 #define _INTERVAL_H__
 
 #include <linux/errno.h>
+#include <linux/rbtree.h>
 #include <linux/string.h>
 #include <linux/types.h>
 
 struct interval_node {
-        struct interval_node   *in_left;
-        struct interval_node   *in_right;
-        struct interval_node   *in_parent;
-        unsigned                in_color:1,
-                                in_intree:1, /** set if the node is in tree */
-                                in_res1:30;
-        __u8                    in_res2[4];  /** tags, 8-bytes aligned */
-        __u64                   in_max_high;
+	struct rb_node		in_rb;
+	unsigned		in_intree:1, /** set if the node is in tree */
+				in_res1:31;
+	__u64			in_max_high;
         struct interval_node_extent {
                 __u64 start;
                 __u64 end;
@@ -108,6 +105,9 @@ typedef enum interval_iter (*interval_callback_t)(struct interval_node *node,
 struct interval_node *interval_insert(struct interval_node *node,
                                       struct interval_node **root);
 void interval_erase(struct interval_node *node, struct interval_node **root);
+/* Swap @new, covering the same extent, into the tree in place of @old. */
+void interval_replace(struct interval_node *old, struct interval_node *new,
+		      struct interval_node **root);
 
 /* Search the extents in the tree and call @func for each overlapped
  * extents. */
@@ -116,21 +116,29 @@ struct target_distribute_txn_data {
 	void			*tdtd_show_retrievers_cbdata;
 };
 
-struct tg_grants_data {
-	/* grants: all values in bytes */
-	/* grant lock to protect all grant counters */
-	spinlock_t		 tgd_grant_lock;
+/* per-CPT slice of the target grant counters, each export being accounted
+ * in the slice of its home CPT (see tgt_grant_cpt()) */
+struct tg_grants_pcpt {
 	/* total amount of dirty data reported by clients in incoming obdo */
-	u64			 tgd_tot_dirty;
+	u64			 tgp_tot_dirty;
 	/* sum of filesystem space granted to clients for async writes */
-	u64			 tgd_tot_granted;
+	u64			 tgp_tot_granted;
 	/* grant used by I/Os in progress (between prepare and commit) */
-	u64			 tgd_tot_pending;
+	u64			 tgp_tot_pending;
+};
+
+struct tg_grants_data {
+	/* grants: all values in bytes */
+	/* grant lock, private lock N protects grant counters of slice N and
+	 * of the exports homed there, exclusive lock protects all of them */
+	struct cfs_percpt_lock	*tgd_grant_lock;
+	/* per-CPT grant counters, see tgt_grant_totals() for the sum */
+	struct tg_grants_pcpt	**tgd_pcpt;
 	/* amount of available space in percentage that is never used for
 	 * grants, used on MDT to always keep space for metadata. */
 	u64			 tgd_reserved_pcnt;
 	/* number of clients using grants */
-	int			 tgd_tot_granted_clients;
+	atomic_t		 tgd_tot_granted_clients;
 	/* shall we grant space to clients not
 	 * supporting OBD_CONNECT_GRANT_PARAM? */
 	int			 tgd_grant_compat_disable;
@@ -506,6 +514,9 @@ static inline int exp_grant_param_supp(struct obd_export *exp)
 #define COMPAT_BSIZE_SHIFT 12
 
 void tgt_grant_sanity_check(struct obd_device *obd, const char *func);
+void tgt_grant_totals(struct tg_grants_data *tgd, u64 *dirty, u64 *granted,
+		      u64 *pending);
+void tgt_grant_fini(struct tg_grants_data *tgd);
 void tgt_grant_connect(const struct lu_env *env, struct obd_export *exp,
 		       struct obd_connect_data *data, bool new_conn);
 void tgt_grant_discard(struct obd_export *exp);
@@ -63,11 +63,17 @@ extern struct kset *ldlm_svc_kset;
 
 #define LDLM_DEFAULT_LRU_SIZE (100 * num_online_cpus())
 #define LDLM_DEFAULT_MAX_ALIVE		3900	/* 3900 seconds ~65 min */
+#define LDLM_DEFAULT_LRU_PROTECTED_PCT	50	/* max % of LRU kept protected */
+#define LDLM_LRU_PROTECT_REUSE		2	/* reuses to enter protected LRU */
+#define LDLM_LRU_PENDING_BATCH		32	/* released locks put in LRU at once */
 #define LDLM_CTIME_AGE_LIMIT (10)
 /* if client lock is unused for that time it can be cancelled if any other
  * client shows interest in that lock, e.g. glimpse is occured. */
 #define LDLM_DIRTY_AGE_LIMIT (10)
 #define LDLM_DEFAULT_PARALLEL_AST_LIMIT 1024
+/* locks per batched blocking AST, see OBD_CONNECT2_BATCH_AST */
+#define LDLM_DEFAULT_AST_BATCH	64
+#define LDLM_MAX_AST_BATCH	256
 
 /**
  * LDLM non-error return states
@@ -312,12 +318,13 @@ enum ldlm_appetite {
 };
 
 /**
- * Default values for the "max_nolock_size", "contention_time" and
- * "contended_locks" namespace tunables.
+ * Default values for the "max_nolock_size", "contention_time",
+ * "contended_locks" and "contended_clients" namespace tunables.
  */
 #define NS_DEFAULT_MAX_NOLOCK_BYTES 0
 #define NS_DEFAULT_CONTENTION_SECONDS 2
 #define NS_DEFAULT_CONTENDED_LOCKS 32
+#define NS_DEFAULT_CONTENDED_CLIENTS 4
 
 struct ldlm_ns_bucket {
 	/** back pointer to namespace */
@@ -328,15 +335,25 @@ struct ldlm_ns_bucket {
 	 * fact the network or overall system load is at fault
 	 */
 	struct adaptive_timeout     nsb_at_estimate;
-	/**
-	 * Which res in the bucket should we start with the reclaim.
-	 */
-	int			    nsb_reclaim_start;
 };
 
 enum {
 	/** LDLM namespace lock stats */
 	LDLM_NSS_LOCKS          = 0,
+	/** locks put into the client LRU */
+	LDLM_NSS_LRU_INSERTS,
+	/** locks used again while in the LRU probation list */
+	LDLM_NSS_LRU_HITS_PROBATION,
+	/** locks used again while in the LRU protected list */
+	LDLM_NSS_LRU_HITS_PROTECTED,
+	/** time from flock enqueue to grant, in microseconds */
+	LDLM_NSS_FLOCK_ENQUEUE_TIME,
+	/** flock deadlock detection runs */
+	LDLM_NSS_FLOCK_DEADLOCK_CHECKS,
+	/** flock deadlocks found */
+	LDLM_NSS_FLOCK_DEADLOCKS,
+	/** granted locks revoked by the server lock reclaim */
+	LDLM_NSS_RECLAIM_REVOKED,
 	LDLM_NSS_LAST
 };
 
@@ -350,6 +367,18 @@ enum ldlm_ns_type {
 	LDLM_NS_TYPE_MGT,		/**< MGT namespace */
 };
 
+/**
+ * Client locks released on one CPT, waiting to be put into the namespace
+ * LRU by the next ldlm_lru_pending_flush().
+ */
+struct ldlm_lru_pending {
+	spinlock_t		lp_lock;
+	/** Released locks, linked via l_lru */
+	struct list_head	lp_list;
+	/** Number of locks in lp_list */
+	int			lp_count;
+};
+
 /**
  * LDLM Namespace.
  *
@@ -417,11 +446,36 @@ struct ldlm_namespace {
 	 * us to release some locks due to e.g. memory pressure, we take locks
 	 * to release from the head of this list.
 	 * Locks are linked via l_lru field in \see struct ldlm_lock.
+	 *
+	 * The LRU is segmented: locks are put into this (probation) list
+	 * first and are moved to ns_protected_list by ldlm_prepare_lru_list()
+	 * if they were used again while in the LRU, so a scan touching many
+	 * locks once does not flush the locks which are really reused.
+	 * Locks in use are not in the LRU: addref removes a lock from it and
+	 * the last decref puts it on the ns_lru_pending list of its CPT, from
+	 * where it gets into the LRU in batches, into ns_protected_list if it
+	 * was reused LDLM_LRU_PROTECT_REUSE times while cached, see
+	 * ldlm_lock_add_to_lru().
 	 */
 	struct list_head	ns_unused_list;
-	/** Number of locks in the LRU list above */
+	/** Number of locks in both LRU lists */
 	int			ns_nr_unused;
 	struct list_head	*ns_last_pos;
+	/** LRU list of locks used again while in ns_unused_list */
+	struct list_head	ns_protected_list;
+	/** Number of locks in ns_protected_list */
+	int			ns_nr_protected;
+	/**
+	 * Maximum share of LRU locks kept in ns_protected_list, in percent.
+	 * 0 disables the protected list.
+	 */
+	unsigned int		ns_lru_protected_pct;
+	/**
+	 * Per-CPT lists of released locks not yet in the LRU, so that the
+	 * last decref and the reuse of a just released lock do not take
+	 * ns_lock. Locks there are not counted in ns_nr_unused.
+	 */
+	struct ldlm_lru_pending	**ns_lru_pending;
 
 	/**
 	 * Maximum number of locks permitted in the LRU. If 0, means locks
@@ -491,6 +545,13 @@ struct ldlm_namespace {
 	 */
 	unsigned		ns_contended_locks;
 
+	/**
+	 * If at least \a ns_contended_clients distinct clients had to wait
+	 * for extent locks on a resource recently, the resource is also
+	 * considered to be contended, 0 disables this check.
+	 */
+	unsigned		ns_contended_clients;
+
 	/**
 	 * The resources in this namespace remember contended state during
 	 * \a ns_contention_time, in seconds.
@@ -508,6 +569,12 @@ struct ldlm_namespace {
 	/** Limit of parallel AST RPC count. */
 	unsigned		ns_max_parallel_ast;
 
+	/**
+	 * Maximum number of locks sent to one client in a single blocking
+	 * AST RPC, 0 or 1 disables batching.
+	 */
+	unsigned		ns_max_ast_batch;
+
 	/**
 	 * Callback to check if a lock is good to be canceled by ELC or
 	 * during recovery.
@@ -524,9 +591,10 @@ struct ldlm_namespace {
 	unsigned		ns_stopping:1;
 
 	/**
-	 * Which bucket should we start with the lock reclaim.
+	 * Granted IBITS and EXTENT locks of this namespace are tracked by
+	 * the server lock reclaim, see ldlm_reclaim.c.
 	 */
-	int			ns_reclaim_start;
+	unsigned		ns_reclaimable:1;
 
 	struct kobject		ns_kobj; /* sysfs object */
 	struct completion	ns_kobj_unregister;
@@ -606,6 +674,8 @@ struct ldlm_glimpse_work {
 	void			*gl_interpret_data;
 };
 
+struct ldlm_bl_ast_batch;
+
 struct ldlm_cb_set_arg {
 	struct ptlrpc_request_set	*set;
 	int				 type; /* LDLM_{CP,BL,GL}_CALLBACK */
@@ -614,11 +684,16 @@ struct ldlm_cb_set_arg {
 	union ldlm_gl_desc		*gl_desc; /* glimpse AST descriptor */
 	ptlrpc_interpterer_t		 gl_interpret_reply;
 	void				*gl_interpret_data;
+	struct ldlm_bl_ast_batch	*bl_batch; /* blocking AST being built */
 };
 
 struct ldlm_cb_async_args {
 	struct ldlm_cb_set_arg	*ca_set_arg;
 	struct ldlm_lock	*ca_lock;
+	/* all locks of a batched blocking AST, ca_lock is the first one */
+	struct ldlm_lock	**ca_locks;
+	int			 ca_count;
+	int			 ca_size;
 };
 
 /** The ldlm_glimpse_work was slab allocated & must be freed accordingly.*/
@@ -645,6 +720,74 @@ struct ldlm_interval_tree {
 	struct interval_node	*lit_root; /* actual ldlm_interval */
 };
 
+/** Number of conflicting clients remembered by an extent resource */
+#define LDLM_CONTENTION_CLIENTS		8
+
+/**
+ * Recent conflict history of an extent resource, server only.
+ * Collected over windows of \a ns_contention_time seconds from enqueues
+ * that had to wait, and used to size granted extents to the observed
+ * access pattern and to decide whether the resource is contended.
+ * Protected by the resource lock.
+ */
+struct ldlm_extent_contention {
+	/** When the resource was last considered as contended */
+	time64_t		lec_time;
+	/** Start of the current sampling window */
+	time64_t		lec_window;
+	/** Conflicting enqueues in the current window */
+	__u32			lec_conflicts;
+	/** Distinct clients seen in the current window */
+	__u32			lec_nclients;
+	/** Average distance between successive requests of one client */
+	__u64			lec_stride;
+	/** Average length of the conflicting requests */
+	__u64			lec_req_len;
+	/** Clients seen in this window and start of their last request */
+	struct {
+		/** export handle cookie of the client */
+		__u64			 lecc_cookie;
+		__u64			 lecc_start;
+	} lec_clients[LDLM_CONTENTION_CLIENTS];
+};
+
+/**
+ * Extent locks index of a resource: interval trees of granted locks for
+ * all modes, \a lr_itree points to \a lei_itree, and contention history,
+ * allocated only for resources of server namespaces.
+ */
+struct ldlm_extent_index {
+	struct ldlm_interval_tree	 lei_itree[LCK_MODE_NUM];
+	struct ldlm_extent_contention	*lei_contention;
+};
+
+/** Order of the owner hash size of a flock resource index */
+#define LDLM_FLOCK_OWNER_HASH_BITS	6
+
+/**
+ * Index of the granted POSIX locks of a flock resource, server only.
+ * Must be accessed under the resource lock.
+ */
+struct ldlm_flock_index {
+	/** Interval trees of granted locks for all modes */
+	struct ldlm_interval_tree lfi_itree[LCK_MODE_NUM];
+	/** First granted lock of each owner, see l_flock_owner_hash */
+	struct hlist_head	lfi_owners[1 << LDLM_FLOCK_OWNER_HASH_BITS];
+};
+
+/** Number of inodebits tracked separately, the last slot is for any others */
+#define LDLM_IBITS_NUM		(MDS_INODELOCK_MAXSHIFT + 2)
+
+/**
+ * Granted IBITS locks summary of a server resource.
+ * Counts granted locks per lock mode and per inodebit, so that lock
+ * compatibility checks skip mode groups which cannot conflict with the
+ * request without walking them. Accessed under the resource lock.
+ */
+struct ldlm_ibits_queues {
+	__u32			liq_granted[LCK_MODE_NUM][LDLM_IBITS_NUM];
+};
+
 /** Whether to track references to exports by LDLM locks. */
 #define LUSTRE_TRACKS_LOCK_EXP_REFS (0)
 
@@ -661,8 +804,8 @@ struct ldlm_flock {
 	__u64 end;
 	__u64 owner;
 	__u64 blocking_owner;
-	struct obd_export *blocking_export;
-	atomic_t blocking_refs;
+	lnet_nid_t blocking_nid;
+	ktime_t enqueued;
 	__u32 pid;
 };
 
@@ -731,9 +874,34 @@ struct ldlm_lock {
 	struct ldlm_resource	*l_resource;
 	/**
 	 * List item for client side LRU list.
-	 * Protected by ns_lock in struct ldlm_namespace.
+	 * Protected by ns_lock in struct ldlm_namespace, or by lp_lock of
+	 * ns_lru_pending[l_lru_cpt] if \a l_lru_pending is set.
 	 */
 	struct list_head	l_lru;
+	/**
+	 * The lock is in ns_protected_list rather than in ns_unused_list.
+	 * Protected by ns_lock in struct ldlm_namespace.
+	 */
+	__u8			l_lru_protected;
+	/**
+	 * The lock was used again since it was put into or moved within the
+	 * LRU. Set under lr_lock, cleared under ns_lock.
+	 */
+	__u8			l_lru_hit;
+	/**
+	 * Number of times the lock was used again while cached since it was
+	 * last moved out of ns_protected_list, up to LDLM_LRU_PROTECT_REUSE,
+	 * at which the lock goes to the protected list.
+	 * Incremented under lr_lock, cleared under ns_lock.
+	 */
+	__u8			l_lru_reuse;
+	/**
+	 * \a l_lru is on ns_lru_pending[l_lru_cpt] rather than in the LRU.
+	 * Set under lr_lock and lp_lock, cleared under lp_lock.
+	 */
+	__u8			l_lru_pending;
+	/** CPT of the pending list the lock was released to */
+	__u16			l_lru_cpt;
 	/**
 	 * Linkage to resource's lock queues according to current lock state.
 	 * (could be granted or waiting)
@@ -741,19 +909,31 @@ struct ldlm_lock {
 	 */
 	struct list_head	l_res_link;
 	/**
-	 * Tree node for ldlm_extent.
+	 * Tree node for ldlm_extent. Points to l_interval, or to the node
+	 * of another granted lock with the same mode and extent when this
+	 * lock joined its policy group.
 	 */
 	struct ldlm_interval	*l_tree_node;
+	/**
+	 * Interval tree node embedded for LDLM_EXTENT and LDLM_FLOCK locks.
+	 */
+	struct ldlm_interval	l_interval;
 	/**
 	 * Per export hash of locks.
 	 * Protected by per-bucket exp->exp_lock_hash locks.
 	 */
 	struct hlist_node	l_exp_hash;
 	/**
-	 * Per export hash of flock locks.
-	 * Protected by per-bucket exp->exp_flock_hash locks.
+	 * Hash of blocked flock locks used for deadlock detection.
+	 * Protected by ldlm_flock_wfg_lock.
+	 */
+	struct hlist_node	l_flock_wait_hash;
+	/**
+	 * Links the first lock of every owner in the granted list of a
+	 * flock resource into ldlm_flock_index::lfi_owners.
+	 * Protected by lr_lock.
 	 */
-	struct hlist_node	l_exp_flock_hash;
+	struct hlist_node	l_flock_owner_hash;
 	/**
 	 * Requested mode.
 	 * Protected by lr_lock.
@@ -832,6 +1012,17 @@ struct ldlm_lock {
 	 */
 	ktime_t			l_last_used;
 
+	/**
+	 * Server side, linkage to the per-CPT lock reclaim list, which is
+	 * kept in the order the locks were granted. Protected by the lock
+	 * of that list.
+	 */
+	struct list_head	l_reclaim;
+	/** Memory charged to the lock by the lock reclaim, in bytes */
+	__u32			l_reclaim_cost;
+	/** CPT of the reclaim list \a l_reclaim is on */
+	__u32			l_reclaim_cpt;
+
 	/** Originally requested extent for the extent lock. */
 	struct ldlm_extent	l_req_extent;
 
@@ -999,23 +1190,23 @@ struct ldlm_resource {
 	/** Resource name */
 	struct ldlm_res_id	lr_name;
 
-	/**
-	 * Interval trees (only for extent locks) for all modes of this resource
-	 */
-	struct ldlm_interval_tree *lr_itree;
-
 	union {
 		/**
-		 * When the resource was considered as contended,
-		 * used only on server side.
-		 */
-		time64_t	lr_contention_time;
-		/**
-		 * Associated inode, used only on client side.
+		 * Interval trees (only for extent locks) for all modes of
+		 * this resource, embedded in struct ldlm_extent_index
 		 */
-		struct inode	*lr_lvb_inode;
+		struct ldlm_interval_tree *lr_itree;
+		/** Granted locks summary (only for IBITS locks on server) */
+		struct ldlm_ibits_queues *lr_ibits_queues;
+		/** Granted locks index (only for FLOCK locks on server) */
+		struct ldlm_flock_index *lr_flock_index;
 	};
 
+	/**
+	 * Associated inode, used only on client side.
+	 */
+	struct inode		*lr_lvb_inode;
+
 	/** Type of locks this resource can hold. Only one type per resource. */
 	enum ldlm_type		lr_type; /* LDLM_{PLAIN,EXTENT,FLOCK,IBITS} */
 
@@ -1032,6 +1223,9 @@ struct ldlm_resource {
 
 	/** List of references to this resource. For debugging. */
 	struct lu_ref		lr_reference;
+
+	/** Resources are freed after RCU grace period, see ldlm_resource_get */
+	struct rcu_head		lr_rcu;
 };
 
 static inline bool ldlm_has_layout(struct ldlm_lock *lock)
@@ -1305,6 +1499,7 @@ struct ldlm_prolong_args {
 void ldlm_lock_prolong_one(struct ldlm_lock *lock,
 			   struct ldlm_prolong_args *arg);
 void ldlm_resource_prolong(struct ldlm_prolong_args *arg);
+void ldlm_reclaim_touch(struct ldlm_lock *lock);
 
 struct ldlm_callback_suite {
         ldlm_completion_callback lcs_completion;
@@ -399,6 +399,16 @@
 #define ldlm_is_ndelay(_l)		 LDLM_TEST_FLAG((_l), 1ULL << 58)
 #define ldlm_set_ndelay(_l)		 LDLM_SET_FLAG((_l), 1ULL << 58)
 
+/**
+ * Client side: the lock was granted to a speculative (lockahead) request
+ * and no IO has used it yet. Locks still marked when they are cancelled
+ * are counted as unused lockahead locks.
+ */
+#define LDLM_FL_SPECULATIVE_UNUSED	 0x0800000000000000ULL /* bit  59 */
+#define ldlm_is_speculative_unused(_l)	 LDLM_TEST_FLAG((_l), 1ULL << 59)
+#define ldlm_set_speculative_unused(_l)	 LDLM_SET_FLAG((_l), 1ULL << 59)
+#define ldlm_clear_speculative_unused(_l) LDLM_CLEAR_FLAG((_l), 1ULL << 59)
+
 /** l_flags bits marked as "ast" bits */
 #define LDLM_FL_AST_MASK                (LDLM_FL_FLOCK_DEADLOCK		|\
 					 LDLM_FL_DISCARD_DATA)
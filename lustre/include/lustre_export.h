@@ -42,6 +42,7 @@
  * @{
  */
 
+#include <linux/rbtree.h>
 #include <linux/workqueue.h>
 
 #include <lprocfs_status.h>
@@ -124,6 +125,7 @@ struct filter_export_data {
 	spinlock_t		fed_lock;	/**< protects fed_mod_list */
 	__u64			fed_lastid_gen;
 	struct list_head	fed_mod_list; /* files being modified */
+	struct rb_root		fed_mod_tree; /* fed_mod_list by FID */
 	/* count of SOFT_SYNC RPCs, which will be reset after
 	 * ofd_soft_sync_limit number of RPCs, and trigger a sync. */
 	atomic_t		fed_soft_sync_count;
@@ -232,11 +234,6 @@ struct obd_export {
 	__u32			  exp_conn_cnt;
 	/** Hash list of all ldlm locks granted on this export */
 	struct cfs_hash		 *exp_lock_hash;
-	/**
-	 * Hash list for Posix lock deadlock detection, added with
-	 * ldlm_lock::l_exp_flock_hash.
-	 */
-	struct cfs_hash	       *exp_flock_hash;
 	struct list_head	exp_outstanding_replies;
 	struct list_head	exp_uncommitted_replies;
 	spinlock_t		exp_uncommitted_replies_lock;
@@ -246,6 +243,15 @@ struct obd_export {
 	time64_t		exp_last_request_time;
 	/** On replay all requests waiting for replay are linked here */
 	struct list_head	exp_req_replay_queue;
+	/** # of requests in obd_req_replay_queue, obd_recovery_task_lock */
+	int			exp_replay_queued;
+	/** scratch flag for target_replay_queue_blocked() */
+	int			exp_replay_scanned;
+	/**
+	 * a replay of this export was dropped, so the predecessor named by
+	 * its later replays may never arrive, obd_recovery_task_lock
+	 */
+	int			exp_replay_dropped;
 	/**
 	 * protects exp_flags, exp_outstanding_replies and the change
 	 * of exp_imp_reverse
@@ -455,6 +461,11 @@ static inline int exp_connect_lock_convert(struct obd_export *exp)
 	return !!(exp_connect_flags2(exp) & OBD_CONNECT2_LOCK_CONVERT);
 }
 
+static inline int exp_connect_batch_ast(struct obd_export *exp)
+{
+	return !!(exp_connect_flags2(exp) & OBD_CONNECT2_BATCH_AST);
+}
+
 extern struct obd_export *class_conn2export(struct lustre_handle *conn);
 extern struct obd_device *class_conn2obd(struct lustre_handle *conn);
 
@@ -245,6 +245,12 @@ struct obd_import {
         int                       imp_last_generation_checked;
         /** Last tranno we replayed */
         __u64                     imp_last_replay_transno;
+	/** Last transno sent for replay, ahead of imp_last_replay_transno
+	 * while several replays are in flight */
+	__u64			  imp_last_replay_sent;
+	/** Replays up to this transno may have reached the server before a
+	 * reconnect and are sent again with MSG_RESENT */
+	__u64			  imp_replay_resend_upto;
         /** Last transno committed on remote side */
         __u64                     imp_peer_committed_transno;
         /**
@@ -75,8 +75,13 @@
  * possible transfer size, PTLRPC_BULK_OPS_COUNT must be a power-of-two
  * value.  The client is free to limit the actual RPC size for any bulk
  * transfer via cl_max_pages_per_rpc to some non-power-of-two value.
- * NOTE: This is limited to 16 (=64GB RPCs) by IOOBJ_MAX_BRW_BITS. */
-#define PTLRPC_BULK_OPS_BITS	4
+ * NOTE: This is limited to 16 (=64GB RPCs) by IOOBJ_MAX_BRW_BITS.
+ *
+ * Raising this only raises the ceiling: the per-descriptor MD handle array
+ * is sized from the negotiated ocd_brw_size, servers keep the default
+ * DT_DEF_BRW_SIZE until the administrator raises obdfilter.*.brw_size, and
+ * caches sized per RPC use PTLRPC_DEF_BRW_PAGES rather than the maximum. */
+#define PTLRPC_BULK_OPS_BITS	6
 #if PTLRPC_BULK_OPS_BITS > 16
 #error "More than 65536 BRW RPCs not allowed by IOOBJ_MAX_BRW_BITS."
 #endif
@@ -101,6 +106,18 @@
 #define PTLRPC_MAX_BRW_SIZE	(1U << PTLRPC_MAX_BRW_BITS)
 #define PTLRPC_MAX_BRW_PAGES	(PTLRPC_MAX_BRW_SIZE >> PAGE_SHIFT)
 
+/**
+ * Default RPC size used to size client caches and pools, the 16MB maximum
+ * of 16 LNET_MTU transfers from before PTLRPC_BULK_OPS_BITS was raised.
+ * Readahead, the max_cached_mb floor and the sptlrpc encryption pool are
+ * based on this, and adapt to larger negotiated RPCs at runtime, so that
+ * the higher PTLRPC_MAX_BRW_PAGES ceiling does not inflate them for every
+ * client.
+ */
+#define PTLRPC_DEF_BRW_BITS	(LNET_MTU_BITS + 4)
+#define PTLRPC_DEF_BRW_SIZE	(1U << PTLRPC_DEF_BRW_BITS)
+#define PTLRPC_DEF_BRW_PAGES	(PTLRPC_DEF_BRW_SIZE >> PAGE_SHIFT)
+
 #define ONE_MB_BRW_SIZE		(1U << LNET_MTU_BITS)
 #define MD_MAX_BRW_SIZE		(1U << LNET_MTU_BITS)
 #define MD_MAX_BRW_PAGES	(MD_MAX_BRW_SIZE >> PAGE_SHIFT)
@@ -116,6 +133,9 @@
 #if (PTLRPC_MAX_BRW_SIZE != (PTLRPC_MAX_BRW_PAGES * PAGE_SIZE))
 # error "PTLRPC_MAX_BRW_SIZE isn't PTLRPC_MAX_BRW_PAGES * PAGE_SIZE"
 #endif
+#if (PTLRPC_DEF_BRW_SIZE > PTLRPC_MAX_BRW_SIZE)
+# error "PTLRPC_DEF_BRW_SIZE bigger than PTLRPC_MAX_BRW_SIZE"
+#endif
 #if (PTLRPC_MAX_BRW_SIZE > LNET_MTU * PTLRPC_BULK_OPS_COUNT)
 # error "PTLRPC_MAX_BRW_SIZE too big"
 #endif
@@ -465,10 +485,20 @@
 #define OSS_CR_NTHRS_BASE	8
 #define OSS_CR_NTHRS_MAX	64
 
+/**
+ * Maximum number of niobuf_remote in a single BRW request.
+ *
+ * This is deliberately independent of DT_MAX_BRW_PAGES so that allowing
+ * larger bulk transfers does not also inflate every OST request buffer.
+ * Large RPCs are normally made of a few contiguous niobufs, and the client
+ * stops adding fragmented extents to an RPC once this budget is used up.
+ */
+#define OST_IO_MAX_NIOBUFS	PTLRPC_DEF_BRW_PAGES
+
 /**
  * OST_IO_MAXREQSIZE ~=
  * 	lustre_msg + ptlrpc_body + obdo + obd_ioobj +
- * 	DT_MAX_BRW_PAGES * niobuf_remote
+ * 	OST_IO_MAX_NIOBUFS * niobuf_remote
  *
  * - single object with 16 pages is 512 bytes
  * - OST_IO_MAXREQSIZE must be at least 1 page of cookies plus some spillover
@@ -481,7 +511,7 @@
 			      sizeof(struct niobuf_remote))
 #define _OST_MAXREQSIZE_SUM (_OST_MAXREQSIZE_BASE + \
 			     sizeof(struct niobuf_remote) * \
-			     (DT_MAX_BRW_PAGES - 1))
+			     (OST_IO_MAX_NIOBUFS - 1))
 /**
  * FIEMAP request can be 4K+ for now
  */
@@ -1459,8 +1489,8 @@ struct ptlrpc_bulk_desc {
 	lnet_nid_t             bd_sender;       /* stash event::sender */
 	int			bd_md_count;	/* # valid entries in bd_mds */
 	int			bd_md_max_brw;	/* max entries in bd_mds */
-	/** array of associated MDs */
-	struct lnet_handle_md	bd_mds[PTLRPC_BULK_OPS_COUNT];
+	/** array of associated MDs, bd_md_max_brw entries */
+	struct lnet_handle_md	*bd_mds;
 
 	union {
 		struct {
@@ -1919,6 +1949,22 @@ struct ptlrpcd_ctl {
 	 * Error code if the thread failed to fully start.
 	 */
 	int				pc_error;
+	/**
+	 * Number of requests queued to this thread, updated under the
+	 * set_new_req_lock of pc_set.
+	 */
+	__u64				pc_queued;
+	/**
+	 * Number of requests this thread took from other threads of the
+	 * same CPT, and from threads bound to another CPT.
+	 */
+	__u64				pc_stolen;
+	__u64				pc_stolen_remote;
+	/**
+	 * Number of requests other threads took from this thread, updated
+	 * under the set_new_req_lock of pc_set.
+	 */
+	__u64				pc_lost;
 };
 
 /* Bits for pc_flags */
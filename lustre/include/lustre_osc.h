@@ -117,6 +117,8 @@ struct osc_device {
 		uint64_t	os_lockless_writes;    /* by bytes */
 		uint64_t	os_lockless_reads;     /* by bytes */
 		uint64_t	os_lockless_truncates; /* by times */
+		uint64_t	os_lockahead_granted;  /* by locks */
+		uint64_t	os_lockahead_unused;   /* by locks */
 	} od_stats;
 
 	/* configuration item(s) */
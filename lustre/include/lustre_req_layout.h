@@ -222,6 +222,7 @@ extern struct req_format RQF_LDLM_CANCEL;
 extern struct req_format RQF_LDLM_CALLBACK;
 extern struct req_format RQF_LDLM_CP_CALLBACK;
 extern struct req_format RQF_LDLM_BL_CALLBACK;
+extern struct req_format RQF_LDLM_BL_CALLBACK_BATCH;
 extern struct req_format RQF_LDLM_GL_CALLBACK;
 extern struct req_format RQF_LDLM_GL_CALLBACK_DESC;
 /* LOG req_format */
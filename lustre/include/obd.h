@@ -132,6 +132,8 @@ struct timeout_item {
 #define OBD_MAX_RIF_DEFAULT	8
 #define OBD_MAX_RIF_MAX		512
 #define OSC_MAX_RIF_MAX		256
+#define OSC_MIN_RIF_AUTO	2
+#define OSC_RIF_HIST_SIZE	16
 #define OSC_MAX_DIRTY_DEFAULT	2000	 /* Arbitrary large value */
 #define OSC_MAX_DIRTY_MB_MAX	2048     /* arbitrary, but < MAX_LONG bytes */
 #define OSC_DEFAULT_RESENDS	10
@@ -159,6 +161,15 @@ enum obd_cl_sem_lock_class {
 	OBD_CLI_SEM_MDCOSC,
 };
 
+/* One automatic change of max_rpcs_in_flight, see osc_rif_auto_update() */
+struct osc_rif_hist_entry {
+	time64_t	rhe_time;
+	__u32		rhe_window;
+	__u32		rhe_srtt;	/* smoothed BRW round-trip time, usec */
+	__u32		rhe_base;	/* shortest BRW round-trip time, usec */
+	__u32		rhe_congested;	/* server reported slow service */
+};
+
 struct mdc_rpc_lock;
 struct obd_import;
 struct client_obd {
@@ -260,6 +271,21 @@ struct client_obd {
 	__u32			cl_max_pages_per_rpc;
 	__u32			cl_max_rpcs_in_flight;
 	__u32			cl_short_io_bytes;
+	/* automatic tuning of cl_max_rpcs_in_flight from BRW latency,
+	 * also protected by cl_loi_list_lock */
+	unsigned int		cl_rif_auto:1,
+				cl_rif_auto_full:1,
+				cl_rif_auto_congested:1;
+	__u32			cl_rif_auto_max;
+	__u32			cl_rif_auto_acks;
+	__u32			cl_rif_auto_epoch;
+	__u64			cl_rif_auto_srtt;
+	__u64			cl_rif_auto_base;
+	__u64			cl_rif_auto_base_next;
+	/* smoothed server service time of BRWs, in 1/8 seconds */
+	__u32			cl_rif_auto_ssvc;
+	__u32			cl_rif_hist_idx;
+	struct osc_rif_hist_entry cl_rif_hist[OSC_RIF_HIST_SIZE];
 	struct obd_histogram	cl_read_rpc_hist;
 	struct obd_histogram	cl_write_rpc_hist;
 	struct obd_histogram	cl_read_page_hist;
@@ -463,8 +489,11 @@ struct niobuf_local {
 	void		*lnb_data;
 };
 
+/* per-thread niobuf_local array, grown on demand up to PTLRPC_MAX_BRW_PAGES
+ * so that large brw_size limits do not cost memory in every OST IO thread */
 struct tgt_thread_big_cache {
-	struct niobuf_local	local[PTLRPC_MAX_BRW_PAGES];
+	int			 tbc_max_pages;	/* # entries in \a local */
+	struct niobuf_local	*local;
 };
 
 #define LUSTRE_FLD_NAME         "fld"
@@ -582,6 +611,15 @@ struct obd_notify_upcall {
         void *onu_owner;
 };
 
+/* stages of target_recovery_thread(), timed for recovery_status */
+enum obd_recovery_phase {
+	OBD_RECOVERY_CONNECT = 0,	/* waiting for clients to reconnect */
+	OBD_RECOVERY_REQ_REPLAY,	/* replaying requests and updates */
+	OBD_RECOVERY_LOCK_REPLAY,	/* replaying locks */
+	OBD_RECOVERY_FINAL_PING,	/* processing final pings */
+	OBD_RECOVERY_PHASE_MAX,		/* recovery done */
+};
+
 struct target_recovery_data {
 	svc_handler_t		trd_recovery_handler;
 	pid_t			trd_processing_task;
@@ -678,6 +716,8 @@ struct obd_device {
 	__u64			obd_next_recovery_transno;
 	int			obd_replayed_requests;
 	int			obd_requests_queued_for_recovery;
+	/* # exports with requests in obd_req_replay_queue */
+	int			obd_replay_queued_exports;
 	wait_queue_head_t	obd_next_transno_waitq;
 	/* protected by obd_recovery_task_lock */
 	struct timer_list	obd_recovery_timer;
@@ -694,6 +734,10 @@ struct obd_device {
 	atomic_t			obd_req_replay_clients;
 	atomic_t			obd_lock_replay_clients;
 	struct target_recovery_data	obd_recovery_data;
+	/* recovery phase timing, sampled unlocked by lprocfs */
+	enum obd_recovery_phase		obd_recovery_phase;
+	ktime_t				obd_recovery_phase_start;
+	unsigned int		obd_recovery_phase_ms[OBD_RECOVERY_PHASE_MAX];
 
 	/* all lists are protected by obd_recovery_task_lock */
 	struct list_head		obd_req_replay_queue;
@@ -667,7 +667,9 @@ struct ptlrpc_body_v3 {
 	__u16 pb_tag;		/* multiple modifying RPCs virtual slot index */
 	__u16 pb_padding0;
 	__u32 pb_padding1;
-	__u64 pb_last_committed;/* rep: highest pb_transno committed to disk */
+	__u64 pb_last_committed;/* rep: highest pb_transno committed to disk
+				 * req: previous transno in a pipelined replay,
+				 * see OBD_CONNECT2_REPLAY_PIPELINE */
 	__u64 pb_transno;	/* server-assigned transno for modifying RPCs */
 	__u32 pb_flags;		/* req: MSG_* flags */
 	__u32 pb_op_flags;	/* req: MSG_CONNECT_* flags */
@@ -828,6 +830,8 @@ struct ptlrpc_body_v2 {
 #define OBD_CONNECT2_WBC_INTENTS	0x40ULL /* create/unlink/... intents for wbc, also operations under client-held parent locks */
 #define OBD_CONNECT2_LOCK_CONVERT	0x80ULL /* IBITS lock convert support */
 #define OBD_CONNECT2_ARCHIVE_ID_ARRAY	0x100ULL /* store HSM archive_id in array */
+#define OBD_CONNECT2_REPLAY_PIPELINE	0x200ULL /* several replays in flight */
+#define OBD_CONNECT2_BATCH_AST		0x400ULL /* many locks per BL AST */
 
 /* XXX README XXX:
  * Please DO NOT add flag values here before first ensuring that this same
@@ -880,7 +884,9 @@ struct ptlrpc_body_v2 {
 
 #define MDT_CONNECT_SUPPORTED2 (OBD_CONNECT2_FILE_SECCTX | OBD_CONNECT2_FLR | \
                                 OBD_CONNECT2_SUM_STATFS | \
-				OBD_CONNECT2_LOCK_CONVERT)
+				OBD_CONNECT2_LOCK_CONVERT | \
+				OBD_CONNECT2_REPLAY_PIPELINE | \
+				OBD_CONNECT2_BATCH_AST)
 
 #define OST_CONNECT_SUPPORTED  (OBD_CONNECT_SRVLOCK | OBD_CONNECT_GRANT | \
 				OBD_CONNECT_REQPORTAL | OBD_CONNECT_VERSION | \
@@ -901,7 +907,9 @@ struct ptlrpc_body_v2 {
 				OBD_CONNECT_GRANT_PARAM | \
 				OBD_CONNECT_SHORTIO | OBD_CONNECT_FLAGS2)
 
-#define OST_CONNECT_SUPPORTED2 OBD_CONNECT2_LOCKAHEAD
+#define OST_CONNECT_SUPPORTED2 (OBD_CONNECT2_LOCKAHEAD | \
+				OBD_CONNECT2_REPLAY_PIPELINE | \
+				OBD_CONNECT2_BATCH_AST)
 
 #define ECHO_CONNECT_SUPPORTED (OBD_CONNECT_FID)
 #define ECHO_CONNECT_SUPPORTED2 0
@@ -37,34 +37,45 @@
  * Author: Jay Xiong <jinshan.xiong@sun.com>
  */
 
+#include <linux/rbtree_augmented.h>
 #include <lustre_dlm.h>
 #include <interval_tree.h>
 
-enum {
-        INTERVAL_RED = 0,
-        INTERVAL_BLACK = 1
-};
+/*
+ * The tree is a kernel augmented rbtree ordered by (start, end), where the
+ * augmented value of every node, in_max_high, is the largest interval_high()
+ * found in its subtree. The rbtree code does the rebalancing, and calls back
+ * into the interval_augment operations below to keep in_max_high correct
+ * across rotations and erases.
+ *
+ * The API still passes the tree around as a pointer to its root node, so the
+ * rb_root needed by the rbtree primitives is rebuilt from (and written back
+ * to) the caller's root pointer around each update.
+ */
+static inline struct interval_node *rb2interval(struct rb_node *rb)
+{
+	return rb ? rb_entry(rb, struct interval_node, in_rb) : NULL;
+}
 
-static inline int node_is_left_child(struct interval_node *node)
+static inline struct interval_node *interval_left(struct interval_node *node)
 {
-        LASSERT(node->in_parent != NULL);
-        return node == node->in_parent->in_left;
+	return rb2interval(node->in_rb.rb_left);
 }
 
-static inline int node_is_right_child(struct interval_node *node)
+static inline struct interval_node *interval_right(struct interval_node *node)
 {
-        LASSERT(node->in_parent != NULL);
-        return node == node->in_parent->in_right;
+	return rb2interval(node->in_rb.rb_right);
 }
 
-static inline int node_is_red(struct interval_node *node)
+static inline struct interval_node *interval_parent(struct interval_node *node)
 {
-        return node->in_color == INTERVAL_RED;
+	return rb2interval(rb_parent(&node->in_rb));
 }
 
-static inline int node_is_black(struct interval_node *node)
+static inline int node_is_left_child(struct interval_node *node)
 {
-        return node->in_color == INTERVAL_BLACK;
+	LASSERT(interval_parent(node) != NULL);
+	return &node->in_rb == rb_parent(&node->in_rb)->rb_left;
 }
 
 static inline int extent_compare(struct interval_node_extent *e1,
@@ -120,6 +131,56 @@ static inline __u64 min_u64(__u64 x, __u64 y)
         return x < y ? x : y;
 }
 
+static __u64 interval_compute_max_high(struct interval_node *node)
+{
+	struct interval_node *child;
+	__u64 max_high = interval_high(node);
+
+	child = interval_left(node);
+	if (child)
+		max_high = max_u64(max_high, child->in_max_high);
+	child = interval_right(node);
+	if (child)
+		max_high = max_u64(max_high, child->in_max_high);
+
+	return max_high;
+}
+
+static void interval_augment_propagate(struct rb_node *rb,
+				       struct rb_node *stop)
+{
+	while (rb != stop) {
+		struct interval_node *node = rb2interval(rb);
+		__u64 max_high = interval_compute_max_high(node);
+
+		if (node->in_max_high == max_high)
+			break;
+		node->in_max_high = max_high;
+		rb = rb_parent(rb);
+	}
+}
+
+static void interval_augment_copy(struct rb_node *rb_old,
+				  struct rb_node *rb_new)
+{
+	rb2interval(rb_new)->in_max_high = rb2interval(rb_old)->in_max_high;
+}
+
+static void interval_augment_rotate(struct rb_node *rb_old,
+				    struct rb_node *rb_new)
+{
+	struct interval_node *old = rb2interval(rb_old);
+
+	rb2interval(rb_new)->in_max_high = old->in_max_high;
+	old->in_max_high = interval_compute_max_high(old);
+}
+
+static const struct rb_augment_callbacks interval_augment = {
+	.propagate	= interval_augment_propagate,
+	.copy		= interval_augment_copy,
+	.rotate		= interval_augment_rotate,
+};
+
 #define interval_for_each(node, root)                   \
 for (node = interval_first(root); node != NULL;         \
      node = interval_next(node))
@@ -130,462 +191,179 @@ for (node = interval_last(root); node != NULL;          \
 
 static struct interval_node *interval_first(struct interval_node *node)
 {
-        ENTRY;
-
-        if (!node)
-                RETURN(NULL);
-        while (node->in_left)
-                node = node->in_left;
-        RETURN(node);
+	if (!node)
+		return NULL;
+	while (node->in_rb.rb_left)
+		node = interval_left(node);
+	return node;
 }
 
 static struct interval_node *interval_last(struct interval_node *node)
 {
-        ENTRY;
-
-        if (!node)
-                RETURN(NULL);
-        while (node->in_right)
-                node = node->in_right;
-        RETURN(node);
+	if (!node)
+		return NULL;
+	while (node->in_rb.rb_right)
+		node = interval_right(node);
+	return node;
 }
 
-static struct interval_node *interval_next(struct interval_node *node)
+static inline struct interval_node *interval_next(struct interval_node *node)
 {
-        ENTRY;
-
-        if (!node)
-                RETURN(NULL);
-        if (node->in_right)
-                RETURN(interval_first(node->in_right));
-        while (node->in_parent && node_is_right_child(node))
-                node = node->in_parent;
-        RETURN(node->in_parent);
+	return rb2interval(rb_next(&node->in_rb));
 }
 
-static struct interval_node *interval_prev(struct interval_node *node)
+static inline struct interval_node *interval_prev(struct interval_node *node)
 {
-        ENTRY;
-
-        if (!node)
-                RETURN(NULL);
-
-        if (node->in_left)
-                RETURN(interval_last(node->in_left));
-
-        while (node->in_parent && node_is_left_child(node))
-                node = node->in_parent;
-
-        RETURN(node->in_parent);
+	return rb2interval(rb_prev(&node->in_rb));
 }
 
 enum interval_iter interval_iterate(struct interval_node *root,
-                                    interval_callback_t func,
-                                    void *data)
-{
-        struct interval_node *node;
-        enum interval_iter rc = INTERVAL_ITER_CONT;
-        ENTRY;
-        
-        interval_for_each(node, root) {
-                rc = func(node, data);
-                if (rc == INTERVAL_ITER_STOP)
-                        break;
-        }
+				    interval_callback_t func,
+				    void *data)
+{
+	struct interval_node *node;
+	enum interval_iter rc = INTERVAL_ITER_CONT;
+	ENTRY;
 
-        RETURN(rc);
+	interval_for_each(node, root) {
+		rc = func(node, data);
+		if (rc == INTERVAL_ITER_STOP)
+			break;
+	}
+
+	RETURN(rc);
 }
 EXPORT_SYMBOL(interval_iterate);
 
 enum interval_iter interval_iterate_reverse(struct interval_node *root,
-                                            interval_callback_t func,
-                                            void *data)
-{
-        struct interval_node *node;
-        enum interval_iter rc = INTERVAL_ITER_CONT;
-        ENTRY;
-        
-        interval_for_each_reverse(node, root) {
-                rc = func(node, data);
-                if (rc == INTERVAL_ITER_STOP)
-                        break;
-        }
+					    interval_callback_t func,
+					    void *data)
+{
+	struct interval_node *node;
+	enum interval_iter rc = INTERVAL_ITER_CONT;
+	ENTRY;
+
+	interval_for_each_reverse(node, root) {
+		rc = func(node, data);
+		if (rc == INTERVAL_ITER_STOP)
+			break;
+	}
 
-        RETURN(rc);
+	RETURN(rc);
 }
 EXPORT_SYMBOL(interval_iterate_reverse);
 
 /* try to find a node with same interval in the tree,
  * if found, return the pointer to the node, otherwise return NULL*/
 struct interval_node *interval_find(struct interval_node *root,
-                                    struct interval_node_extent *ex)
+				    struct interval_node_extent *ex)
 {
-        struct interval_node *walk = root;
-        int rc;
-        ENTRY;
+	struct interval_node *walk = root;
+	int rc;
+	ENTRY;
 
-        while (walk) {
-                rc = extent_compare(ex, &walk->in_extent);
-                if (rc == 0)
-                        break;
-                else if (rc < 0)
-                        walk = walk->in_left;
-                else
-                        walk = walk->in_right;
-        }
+	while (walk) {
+		rc = extent_compare(ex, &walk->in_extent);
+		if (rc == 0)
+			break;
+		else if (rc < 0)
+			walk = interval_left(walk);
+		else
+			walk = interval_right(walk);
+	}
 
-        RETURN(walk);
+	RETURN(walk);
 }
 EXPORT_SYMBOL(interval_find);
 
-static void __rotate_change_maxhigh(struct interval_node *node,
-                                    struct interval_node *rotate)
+static inline void interval_rb_root(struct rb_root *rbroot,
+				    struct interval_node *root)
 {
-        __u64 left_max, right_max;
-
-        rotate->in_max_high = node->in_max_high;
-        left_max = node->in_left ? node->in_left->in_max_high : 0;
-        right_max = node->in_right ? node->in_right->in_max_high : 0;
-        node->in_max_high  = max_u64(interval_high(node),
-                                     max_u64(left_max,right_max));
+	rbroot->rb_node = root ? &root->in_rb : NULL;
 }
 
-/* The left rotation "pivots" around the link from node to node->right, and
- * - node will be linked to node->right's left child, and
- * - node->right's left child will be linked to node's right child.  */
-static void __rotate_left(struct interval_node *node,
-                          struct interval_node **root)
-{
-        struct interval_node *right = node->in_right;
-        struct interval_node *parent = node->in_parent;
-
-        node->in_right = right->in_left;
-        if (node->in_right)
-                right->in_left->in_parent = node;
-
-        right->in_left = node;
-        right->in_parent = parent;
-        if (parent) {
-                if (node_is_left_child(node))
-                        parent->in_left = right;
-                else
-                        parent->in_right = right;
-        } else {
-                *root = right;
-        }
-        node->in_parent = right;
-
-        /* update max_high for node and right */
-        __rotate_change_maxhigh(node, right);
-}
-
-/* The right rotation "pivots" around the link from node to node->left, and
- * - node will be linked to node->left's right child, and
- * - node->left's right child will be linked to node's left child.  */
-static void __rotate_right(struct interval_node *node,
-                           struct interval_node **root)
-{
-        struct interval_node *left = node->in_left;
-        struct interval_node *parent = node->in_parent;
-
-        node->in_left = left->in_right;
-        if (node->in_left)
-                left->in_right->in_parent = node;
-        left->in_right = node;
-
-        left->in_parent = parent;
-        if (parent) {
-                if (node_is_right_child(node))
-                        parent->in_right = left;
-                else
-                        parent->in_left = left;
-        } else {
-                *root = left;
-        }
-        node->in_parent = left;
-
-        /* update max_high for node and left */
-        __rotate_change_maxhigh(node, left);
-}
-
-#define interval_swap(a, b) do {                        \
-        struct interval_node *c = a; a = b; b = c;      \
-} while (0)
-
 /*
- * Operations INSERT and DELETE, when run on a tree with n keys, 
- * take O(logN) time.Because they modify the tree, the result 
- * may violate the red-black properties.To restore these properties, 
- * we must change the colors of some of the nodes in the tree 
- * and also change the pointer structure.
+ * Insert @node into the tree. If a node with an identical extent is already
+ * in the tree, it is returned and @node is left untouched, otherwise NULL is
+ * returned.
  */
-static void interval_insert_color(struct interval_node *node,
-                                  struct interval_node **root)
-{
-        struct interval_node *parent, *gparent;
-        ENTRY;
-
-        while ((parent = node->in_parent) && node_is_red(parent)) {
-                gparent = parent->in_parent;
-                /* Parent is RED, so gparent must not be NULL */
-                if (node_is_left_child(parent)) {
-                        struct interval_node *uncle;
-                        uncle = gparent->in_right;
-                        if (uncle && node_is_red(uncle)) {
-                                uncle->in_color = INTERVAL_BLACK;
-                                parent->in_color = INTERVAL_BLACK;
-                                gparent->in_color = INTERVAL_RED;
-                                node = gparent;
-                                continue;
-                        }
-
-                        if (parent->in_right == node) {
-                                __rotate_left(parent, root);
-                                interval_swap(node, parent);
-                        }
-
-                        parent->in_color = INTERVAL_BLACK;
-                        gparent->in_color = INTERVAL_RED;
-                        __rotate_right(gparent, root);
-                } else {
-                        struct interval_node *uncle;
-                        uncle = gparent->in_left;
-                        if (uncle && node_is_red(uncle)) {
-                                uncle->in_color = INTERVAL_BLACK;
-                                parent->in_color = INTERVAL_BLACK;
-                                gparent->in_color = INTERVAL_RED;
-                                node = gparent;
-                                continue;
-                        }
-
-                        if (node_is_left_child(node)) {
-                                __rotate_right(parent, root);
-                                interval_swap(node, parent);
-                        }
-
-                        parent->in_color = INTERVAL_BLACK;
-                        gparent->in_color = INTERVAL_RED;
-                        __rotate_left(gparent, root);
-                }
-        }
-
-        (*root)->in_color = INTERVAL_BLACK;
-        EXIT;
-}
-
 struct interval_node *interval_insert(struct interval_node *node,
-                                      struct interval_node **root)
-                     
-{
-        struct interval_node **p, *parent = NULL;
-        ENTRY;
-
-        LASSERT(!interval_is_intree(node));
-        p = root;
-        while (*p) {
-                parent = *p;
-                if (node_equal(parent, node))
-                        RETURN(parent);
-
-                /* max_high field must be updated after each iteration */
-                if (parent->in_max_high < interval_high(node))
-                        parent->in_max_high = interval_high(node);
-
-                if (node_compare(node, parent) < 0)
-                        p = &parent->in_left;
-                else 
-                        p = &parent->in_right;
-        }
+				      struct interval_node **root)
+{
+	struct rb_root rbroot;
+	struct rb_node **p, *parent = NULL;
+	ENTRY;
 
-        /* link node into the tree */
-        node->in_parent = parent;
-        node->in_color = INTERVAL_RED;
-        node->in_left = node->in_right = NULL;
-        *p = node;
+	LASSERT(!interval_is_intree(node));
+	interval_rb_root(&rbroot, *root);
+	p = &rbroot.rb_node;
+	while (*p) {
+		struct interval_node *walk = rb2interval(*p);
+
+		if (node_equal(walk, node))
+			RETURN(walk);
+
+		/* max_high of the ancestors is updated on the way down, the
+		 * rotations done by rebalancing fix up the rest */
+		if (walk->in_max_high < interval_high(node))
+			walk->in_max_high = interval_high(node);
+
+		parent = *p;
+		if (node_compare(node, walk) < 0)
+			p = &parent->rb_left;
+		else
+			p = &parent->rb_right;
+	}
 
-        interval_insert_color(node, root);
-        node->in_intree = 1;
+	node->in_max_high = interval_high(node);
+	rb_link_node(&node->in_rb, parent, p);
+	rb_insert_augmented(&node->in_rb, &rbroot, &interval_augment);
+	*root = rb2interval(rbroot.rb_node);
+	node->in_intree = 1;
 
-        RETURN(NULL);
+	RETURN(NULL);
 }
 EXPORT_SYMBOL(interval_insert);
 
-static inline int node_is_black_or_0(struct interval_node *node)
-{
-        return !node || node_is_black(node);
-}
-
-static void interval_erase_color(struct interval_node *node,
-                                 struct interval_node *parent,
-                                 struct interval_node **root)
-{
-        struct interval_node *tmp;
-        ENTRY;
-
-        while (node_is_black_or_0(node) && node != *root) {
-                if (parent->in_left == node) {
-                        tmp = parent->in_right;
-                        if (node_is_red(tmp)) {
-                                tmp->in_color = INTERVAL_BLACK;
-                                parent->in_color = INTERVAL_RED;
-                                __rotate_left(parent, root);
-                                tmp = parent->in_right;
-                        }
-                        if (node_is_black_or_0(tmp->in_left) &&
-                            node_is_black_or_0(tmp->in_right)) {
-                                tmp->in_color = INTERVAL_RED;
-                                node = parent;
-                                parent = node->in_parent;
-                        } else {
-                                if (node_is_black_or_0(tmp->in_right)) {
-                                        struct interval_node *o_left;
-                                        if ((o_left = tmp->in_left))
-                                             o_left->in_color = INTERVAL_BLACK;
-                                        tmp->in_color = INTERVAL_RED;
-                                        __rotate_right(tmp, root);
-                                        tmp = parent->in_right;
-                                }
-                                tmp->in_color = parent->in_color;
-                                parent->in_color = INTERVAL_BLACK;
-                                if (tmp->in_right)
-                                    tmp->in_right->in_color = INTERVAL_BLACK;
-                                __rotate_left(parent, root);
-                                node = *root;
-                                break;
-                        }
-                } else {
-                        tmp = parent->in_left;
-                        if (node_is_red(tmp)) {
-                                tmp->in_color = INTERVAL_BLACK;
-                                parent->in_color = INTERVAL_RED;
-                                __rotate_right(parent, root);
-                                tmp = parent->in_left;
-                        }
-                        if (node_is_black_or_0(tmp->in_left) &&
-                            node_is_black_or_0(tmp->in_right)) {
-                                tmp->in_color = INTERVAL_RED;
-                                node = parent;
-                                parent = node->in_parent;
-                        } else {
-                                if (node_is_black_or_0(tmp->in_left)) {
-                                        struct interval_node *o_right;
-                                        if ((o_right = tmp->in_right))
-                                            o_right->in_color = INTERVAL_BLACK;
-                                        tmp->in_color = INTERVAL_RED;
-                                        __rotate_left(tmp, root);
-                                        tmp = parent->in_left;
-                                }
-                                tmp->in_color = parent->in_color;
-                                parent->in_color = INTERVAL_BLACK;
-                                if (tmp->in_left)
-                                        tmp->in_left->in_color = INTERVAL_BLACK;
-                                __rotate_right(parent, root);
-                                node = *root;
-                                break;
-                        }
-                }
-        }
-        if (node)
-                node->in_color = INTERVAL_BLACK;
-        EXIT;
-}
-
-/* 
- * if the @max_high value of @node is changed, this function traverse  a path 
- * from node  up to the root to update max_high for the whole tree.
- */
-static void update_maxhigh(struct interval_node *node,
-                           __u64  old_maxhigh)
+void interval_erase(struct interval_node *node,
+		    struct interval_node **root)
 {
-        __u64 left_max, right_max;
-        ENTRY;
-
-        while (node) {
-                left_max = node->in_left ? node->in_left->in_max_high : 0;
-                right_max = node->in_right ? node->in_right->in_max_high : 0;
-                node->in_max_high = max_u64(interval_high(node),
-                                            max_u64(left_max, right_max));
+	struct rb_root rbroot;
+	ENTRY;
 
-                if (node->in_max_high >= old_maxhigh)
-                        break;
-                node = node->in_parent;
-        }
-        EXIT;
+	LASSERT(interval_is_intree(node));
+	interval_rb_root(&rbroot, *root);
+	rb_erase_augmented(&node->in_rb, &rbroot, &interval_augment);
+	*root = rb2interval(rbroot.rb_node);
+	node->in_intree = 0;
+	EXIT;
 }
+EXPORT_SYMBOL(interval_erase);
 
-void interval_erase(struct interval_node *node,
-                    struct interval_node **root)
-{
-        struct interval_node *child, *parent;
-        int color;
-        ENTRY;
-
-        LASSERT(interval_is_intree(node));
-        node->in_intree = 0;
-        if (!node->in_left) {
-                child = node->in_right;
-        } else if (!node->in_right) {
-                child = node->in_left;
-        } else { /* Both left and right child are not NULL */
-                struct interval_node *old = node;
-
-                node = interval_next(node);
-                child = node->in_right;
-                parent = node->in_parent;
-                color = node->in_color;
-
-                if (child)
-                        child->in_parent = parent;
-                if (parent == old)
-                        parent->in_right = child;
-                else
-                        parent->in_left = child;
-
-                node->in_color = old->in_color;
-                node->in_right = old->in_right;
-                node->in_left = old->in_left;
-                node->in_parent = old->in_parent;
-
-                if (old->in_parent) {
-                        if (node_is_left_child(old))
-                                old->in_parent->in_left = node;
-                        else
-                                old->in_parent->in_right = node;
-                } else {
-                        *root = node;
-                }
-
-                old->in_left->in_parent = node;
-                if (old->in_right)
-                        old->in_right->in_parent = node;
-                update_maxhigh(child ? : parent, node->in_max_high);
-                update_maxhigh(node, old->in_max_high);
-                if (parent == old)
-                         parent = node;
-                goto color;
-        }
-        parent = node->in_parent;
-        color = node->in_color;
-
-        if (child)
-                child->in_parent = parent;
-        if (parent) {
-                if (node_is_left_child(node))
-                        parent->in_left = child;
-                else
-                        parent->in_right = child;
-        } else {
-                *root = child;
-        }
+/*
+ * Put @new in the place of @old in the tree without rebalancing. The two
+ * nodes must cover the same extent, so the ordering and the max_high of
+ * the subtree are unchanged.
+ */
+void interval_replace(struct interval_node *old, struct interval_node *new,
+		      struct interval_node **root)
+{
+	struct rb_root rbroot;
+	ENTRY;
 
-        update_maxhigh(child ? : parent, node->in_max_high);
+	LASSERT(interval_is_intree(old));
+	LASSERT(!interval_is_intree(new));
+	LASSERT(node_equal(old, new));
 
-color:
-        if (color == INTERVAL_BLACK)
-                interval_erase_color(child, parent, root);
-        EXIT;
+	interval_rb_root(&rbroot, *root);
+	new->in_max_high = old->in_max_high;
+	rb_replace_node(&old->in_rb, &new->in_rb, &rbroot);
+	*root = rb2interval(rbroot.rb_node);
+	old->in_intree = 0;
+	new->in_intree = 1;
+	EXIT;
 }
-EXPORT_SYMBOL(interval_erase);
+EXPORT_SYMBOL(interval_replace);
 
 static inline int interval_may_overlap(struct interval_node *node,
                                           struct interval_node_extent *ext)
@@ -630,8 +408,8 @@ enum interval_iter interval_search(struct interval_node *node,
 
 	while (node) {
 		if (ext->end < interval_low(node)) {
-			if (node->in_left) {
-				node = node->in_left;
+			if (node->in_rb.rb_left) {
+				node = interval_left(node);
 				continue;
 			}
 		} else if (interval_may_overlap(node, ext)) {
@@ -641,30 +419,30 @@ enum interval_iter interval_search(struct interval_node *node,
 					break;
 			}
 
-			if (node->in_left) {
-				node = node->in_left;
+			if (node->in_rb.rb_left) {
+				node = interval_left(node);
 				continue;
 			}
-			if (node->in_right) {
-				node = node->in_right;
+			if (node->in_rb.rb_right) {
+				node = interval_right(node);
 				continue;
 			}
 		}
 
-		parent = node->in_parent;
+		parent = interval_parent(node);
 		while (parent) {
 			if (node_is_left_child(node) &&
-			    parent->in_right) {
+			    parent->in_rb.rb_right) {
 				/* If we ever got the left, it means that the
 				 * parent met ext->end<interval_low(parent), or
 				 * may_overlap(parent). If the former is true,
 				 * we needn't go back. So stop early and check
 				 * may_overlap(parent) after this loop.  */
-				node = parent->in_right;
+				node = interval_right(parent);
 				break;
 			}
 			node = parent;
-			parent = parent->in_parent;
+			parent = interval_parent(parent);
 		}
 		if (parent == NULL || !interval_may_overlap(parent, ext))
 			break;
@@ -737,9 +515,9 @@ static inline __u64 interval_expand_high(struct interval_node *node, __u64 high)
                         
                 if (interval_low(node) > high) {
                         result = interval_low(node) - 1;
-                        node = node->in_left;
+                        node = interval_left(node);
                 } else {
-                        node = node->in_right;
+                        node = interval_right(node);
                 }
         }
 
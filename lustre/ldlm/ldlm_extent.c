@@ -70,6 +70,7 @@ static void ldlm_extent_internal_policy_fixup(struct ldlm_lock *req,
 					      struct ldlm_extent *new_ex,
 					      int conflicting)
 {
+	struct ldlm_extent_contention *lec;
 	enum ldlm_mode req_mode = req->l_req_mode;
 	__u64 req_start = req->l_req_extent.start;
 	__u64 req_end = req->l_req_extent.end;
@@ -81,6 +82,31 @@ static void ldlm_extent_internal_policy_fixup(struct ldlm_lock *req,
                                           new_ex->end);
         }
 
+	/* Several clients recently fought over this resource with requests
+	 * spaced wider than they are long, i.e. interleaved (strided) IO.
+	 * Growing the extent would only take it over the regions of the
+	 * other clients, so limit it to this client's share of the stride. */
+	lec = ldlm_res_contention(req->l_resource);
+	if (lec->lec_nclients > 1 && lec->lec_req_len != 0 &&
+	    lec->lec_stride > lec->lec_req_len && req_end != OBD_OBJECT_EOF) {
+		__u64 unit = div_u64(lec->lec_stride, lec->lec_nclients);
+		__u64 ustart;
+		__u64 uend;
+
+		if (unit < req_end - req_start + 1)
+			unit = req_end - req_start + 1;
+		ustart = div64_u64(req_start, unit) * unit;
+		uend = ustart + unit - 1;
+		if (uend < ustart)
+			uend = OBD_OBJECT_EOF;
+
+		new_ex->start = max(new_ex->start, ustart);
+		new_ex->end = min(new_ex->end, max(uend, req_end));
+		LDLM_DEBUG(req, "contended resource, stride %llu clients %u, "
+			   "extent limited to [%llu->%llu]", lec->lec_stride,
+			   lec->lec_nclients, new_ex->start, new_ex->end);
+	}
+
         if (new_ex->start == 0 && new_ex->end == OBD_OBJECT_EOF) {
                 EXIT;
                 return;
@@ -311,17 +337,85 @@ static void ldlm_extent_policy(struct ldlm_resource *res,
 static int ldlm_check_contention(struct ldlm_lock *lock, int contended_locks)
 {
 	struct ldlm_resource *res = lock->l_resource;
+	struct ldlm_namespace *ns = ldlm_res_to_ns(res);
+	struct ldlm_extent_contention *lec = ldlm_res_contention(res);
 	time64_t now = ktime_get_seconds();
 
 	if (OBD_FAIL_CHECK(OBD_FAIL_LDLM_SET_CONTENTION))
 		return 1;
 
-	CDEBUG(D_DLMTRACE, "contended locks = %d\n", contended_locks);
-	if (contended_locks > ldlm_res_to_ns(res)->ns_contended_locks)
-		res->lr_contention_time = now;
+	CDEBUG(D_DLMTRACE, "contended locks = %d, clients = %u\n",
+	       contended_locks, lec->lec_nclients);
+	if (contended_locks > ns->ns_contended_locks ||
+	    (ns->ns_contended_clients != 0 &&
+	     lec->lec_window + ns->ns_contention_time > now &&
+	     lec->lec_nclients >= ns->ns_contended_clients))
+		lec->lec_time = now;
+
+	return now < lec->lec_time + ns->ns_contention_time;
+}
+
+/**
+ * Add the blocked enqueue of \a req to the contention history of its
+ * resource.
+ *
+ * Counts the distinct clients waiting for locks on the resource during
+ * the current window, and keeps running averages of the requested extent
+ * length and of the distance between successive requests of each client,
+ * which the extent policy uses to size the locks it grants.
+ */
+static void ldlm_extent_contention_update(struct ldlm_lock *req)
+{
+	struct ldlm_resource *res = req->l_resource;
+	struct ldlm_namespace *ns = ldlm_res_to_ns(res);
+	struct ldlm_extent_contention *lec = ldlm_res_contention(res);
+	__u64 start = req->l_req_extent.start;
+	__u64 len = req->l_req_extent.end - start + 1;
+	time64_t now = ktime_get_seconds();
+	int i;
+
+	/* glimpses and whole file locks tell nothing about the IO pattern */
+	if (req->l_export == NULL || len == 0 ||
+	    req->l_req_extent.end == OBD_OBJECT_EOF)
+		return;
+
+	if (now >= lec->lec_window + ns->ns_contention_time) {
+		/* forget the pattern after a window without conflicts */
+		if (lec->lec_conflicts == 0) {
+			lec->lec_stride = 0;
+			lec->lec_req_len = 0;
+		}
+		lec->lec_window = now;
+		lec->lec_conflicts = 0;
+		lec->lec_nclients = 0;
+		memset(lec->lec_clients, 0, sizeof(lec->lec_clients));
+	}
+	lec->lec_conflicts++;
+	lec->lec_req_len = lec->lec_req_len == 0 ? len :
+			   (lec->lec_req_len * 3 + len) / 4;
+
+	for (i = 0; i < lec->lec_nclients; i++) {
+		if (lec->lec_clients[i].lecc_cookie !=
+		    req->l_export->exp_handle.h_cookie)
+			continue;
+
+		if (start > lec->lec_clients[i].lecc_start) {
+			__u64 stride = start - lec->lec_clients[i].lecc_start;
+
+			lec->lec_stride = lec->lec_stride == 0 ? stride :
+					  (lec->lec_stride * 3 + stride) / 4;
+		}
+		lec->lec_clients[i].lecc_start = start;
+		return;
+	}
 
-	return now < res->lr_contention_time +
-		     ldlm_res_to_ns(res)->ns_contention_time;
+	/* new client, once the table is full recycle the slots in turn */
+	if (lec->lec_nclients < LDLM_CONTENTION_CLIENTS)
+		i = lec->lec_nclients++;
+	else
+		i = lec->lec_conflicts % LDLM_CONTENTION_CLIENTS;
+	lec->lec_clients[i].lecc_cookie = req->l_export->exp_handle.h_cookie;
+	lec->lec_clients[i].lecc_start = start;
 }
 
 struct ldlm_extent_compat_args {
@@ -843,6 +937,8 @@ int ldlm_process_extent_lock(struct ldlm_lock *lock, __u64 *flags,
 		ldlm_resource_unlink_lock(lock);
 		ldlm_grant_lock(lock, grant_work);
 	} else {
+		if (intention == LDLM_PROCESS_ENQUEUE)
+			ldlm_extent_contention_update(lock);
 		/* Adding LDLM_FL_NO_TIMEOUT flag to granted lock to
 		 * force client to wait for the lock endlessly once
 		 * the lock is enqueued -bzzz */
@@ -964,37 +1060,13 @@ __u64 ldlm_extent_shift_kms(struct ldlm_lock *lock, __u64 old_kms)
 }
 EXPORT_SYMBOL(ldlm_extent_shift_kms);
 
-struct kmem_cache *ldlm_interval_slab;
-struct ldlm_interval *ldlm_interval_alloc(struct ldlm_lock *lock)
-{
-	struct ldlm_interval *node;
-	ENTRY;
-
-	LASSERT(lock->l_resource->lr_type == LDLM_EXTENT);
-	OBD_SLAB_ALLOC_PTR_GFP(node, ldlm_interval_slab, GFP_NOFS);
-	if (node == NULL)
-		RETURN(NULL);
-
-	INIT_LIST_HEAD(&node->li_group);
-	ldlm_interval_attach(node, lock);
-	RETURN(node);
-}
-
-void ldlm_interval_free(struct ldlm_interval *node)
-{
-        if (node) {
-		LASSERT(list_empty(&node->li_group));
-                LASSERT(!interval_is_intree(&node->li_node));
-                OBD_SLAB_FREE(node, ldlm_interval_slab, sizeof(*node));
-        }
-}
-
 /* interval tree, for LDLM_EXTENT. */
 void ldlm_interval_attach(struct ldlm_interval *n,
                           struct ldlm_lock *l)
 {
         LASSERT(l->l_tree_node == NULL);
-        LASSERT(l->l_resource->lr_type == LDLM_EXTENT);
+	LASSERT(l->l_resource->lr_type == LDLM_EXTENT ||
+		l->l_resource->lr_type == LDLM_FLOCK);
 
 	list_add_tail(&l->l_sl_policy, &n->li_group);
         l->l_tree_node = n;
@@ -1014,52 +1086,100 @@ struct ldlm_interval *ldlm_interval_detach(struct ldlm_lock *l)
 	return list_empty(&n->li_group) ? n : NULL;
 }
 
-static inline int ldlm_mode_to_index(enum ldlm_mode mode)
+/** Set up the interval node embedded in \a lock as its own policy group. */
+void ldlm_interval_init(struct ldlm_lock *lock)
+{
+	struct ldlm_interval *node = &lock->l_interval;
+
+	LASSERT(lock->l_resource->lr_type == LDLM_EXTENT ||
+		lock->l_resource->lr_type == LDLM_FLOCK);
+	LASSERT(!interval_is_intree(&node->li_node));
+
+	interval_init(&node->li_node);
+	INIT_LIST_HEAD(&node->li_group);
+	ldlm_interval_attach(node, lock);
+}
+
+/**
+ * The lock owning the tree node \a old is leaving its policy group, but
+ * other locks are still in it. Move the group and its place in the tree
+ * over to the node embedded in one of the remaining locks.
+ */
+static void ldlm_interval_migrate(struct ldlm_interval *old,
+				  struct ldlm_interval_tree *tree)
+{
+	struct ldlm_interval *node;
+	struct ldlm_lock *lck;
+
+	lck = list_entry(old->li_group.next, struct ldlm_lock, l_sl_policy);
+	node = &lck->l_interval;
+	LASSERT(list_empty(&node->li_group));
+
+	node->li_node.in_extent = old->li_node.in_extent;
+	interval_replace(&old->li_node, &node->li_node, &tree->lit_root);
+	list_replace_init(&old->li_group, &node->li_group);
+	list_for_each_entry(lck, &node->li_group, l_sl_policy)
+		lck->l_tree_node = node;
+}
+
+/**
+ * Insert granted \a lock covering [\a start, \a end] into \a tree, joining
+ * the policy group of a lock with the same extent if there is one.
+ */
+void ldlm_interval_tree_insert(struct ldlm_interval_tree *tree,
+			       struct ldlm_lock *lock, __u64 start, __u64 end)
+{
+	struct interval_node *found;
+	struct ldlm_interval *node = lock->l_tree_node;
+	int rc;
+
+	LASSERT(node != NULL);
+	LASSERT(!interval_is_intree(&node->li_node));
+	LASSERT(lock->l_granted_mode == tree->lit_mode);
+
+	rc = interval_set(&node->li_node, start, end);
+	LASSERT(!rc);
+
+	found = interval_insert(&node->li_node, &tree->lit_root);
+	if (found) { /* The policy group found. */
+		/* the embedded node stays unused while the lock is a member
+		 * of another lock's group */
+		ldlm_interval_detach(lock);
+		ldlm_interval_attach(to_ldlm_interval(found), lock);
+	}
+	tree->lit_size++;
+}
+
+/** Remove \a lock from \a tree, it must be in there. */
+void ldlm_interval_tree_erase(struct ldlm_interval_tree *tree,
+			      struct ldlm_lock *lock)
 {
-	int index;
-
-	LASSERT(mode != 0);
-	LASSERT(is_power_of_2(mode));
-	for (index = -1; mode != 0; index++, mode >>= 1)
-		/* do nothing */;
-	LASSERT(index < LCK_MODE_NUM);
-	return index;
+	struct ldlm_interval *node = lock->l_tree_node;
+
+	LASSERT(tree->lit_root != NULL); /* assure the tree is not null */
+
+	tree->lit_size--;
+	if (ldlm_interval_detach(lock))
+		interval_erase(&node->li_node, &tree->lit_root);
+	else if (node == &lock->l_interval)
+		ldlm_interval_migrate(node, tree);
 }
 
 /** Add newly granted lock into interval tree for the resource. */
 void ldlm_extent_add_lock(struct ldlm_resource *res,
                           struct ldlm_lock *lock)
 {
-        struct interval_node *found, **root;
-        struct ldlm_interval *node;
         struct ldlm_extent *extent;
-	int idx, rc;
+	int idx;
 
         LASSERT(lock->l_granted_mode == lock->l_req_mode);
 
-        node = lock->l_tree_node;
-        LASSERT(node != NULL);
-        LASSERT(!interval_is_intree(&node->li_node));
-
 	idx = ldlm_mode_to_index(lock->l_granted_mode);
 	LASSERT(lock->l_granted_mode == 1 << idx);
-	LASSERT(lock->l_granted_mode == res->lr_itree[idx].lit_mode);
 
-        /* node extent initialize */
         extent = &lock->l_policy_data.l_extent;
-
-	rc = interval_set(&node->li_node, extent->start, extent->end);
-	LASSERT(!rc);
-
-        root = &res->lr_itree[idx].lit_root;
-        found = interval_insert(&node->li_node, root);
-        if (found) { /* The policy group found. */
-                struct ldlm_interval *tmp = ldlm_interval_detach(lock);
-                LASSERT(tmp != NULL);
-                ldlm_interval_free(tmp);
-                ldlm_interval_attach(to_ldlm_interval(found), lock);
-        }
-        res->lr_itree[idx].lit_size++;
+	ldlm_interval_tree_insert(&res->lr_itree[idx], lock, extent->start,
+				  extent->end);
 
         /* even though we use interval tree to manage the extent lock, we also
          * add the locks into grant list, for debug purpose, .. */
@@ -1101,14 +1221,7 @@ void ldlm_extent_unlink_lock(struct ldlm_lock *lock)
 	LASSERT(lock->l_granted_mode == 1 << idx);
 	tree = &res->lr_itree[idx];
 
-	LASSERT(tree->lit_root != NULL); /* assure the tree is not null */
-
-	tree->lit_size--;
-	node = ldlm_interval_detach(lock);
-	if (node) {
-		interval_erase(&node->li_node, &tree->lit_root);
-		ldlm_interval_free(node);
-	}
+	ldlm_interval_tree_erase(tree, lock);
 }
 
 void ldlm_extent_policy_wire_to_local(const union ldlm_wire_policy_data *wpolicy,
@@ -52,6 +52,7 @@
 
 #define DEBUG_SUBSYSTEM S_LDLM
 
+#include <linux/hash.h>
 #include <linux/list.h>
 #include <lustre_dlm.h>
 #include <obd_support.h>
@@ -91,24 +92,200 @@ ldlm_flocks_overlap(struct ldlm_lock *lock, struct ldlm_lock *new)
                 lock->l_policy_data.l_flock.start));
 }
 
+/**
+ * Granted locks index of server flock resources.
+ *
+ * Granted locks are kept in per-mode interval trees so that conflicts are
+ * found without walking the whole granted list, and the first lock of each
+ * owner in the granted list is hashed so that the scan for merges and
+ * splits can start at the owner's locks directly.
+ */
+static inline struct hlist_head *
+ldlm_flock_owner_head(struct ldlm_resource *res, struct ldlm_lock *lock)
+{
+	__u64 key = lock->l_policy_data.l_flock.owner ^
+		    (unsigned long)lock->l_export;
+
+	return &res->lr_flock_index->lfi_owners[hash_64(key,
+					LDLM_FLOCK_OWNER_HASH_BITS)];
+}
+
+/* First granted lock of the owner of \a req, resource index only. */
+static struct ldlm_lock *
+ldlm_flock_owner_first(struct ldlm_resource *res, struct ldlm_lock *req)
+{
+	struct ldlm_lock *lock;
+
+	hlist_for_each_entry(lock, ldlm_flock_owner_head(res, req),
+			     l_flock_owner_hash)
+		if (ldlm_same_flock_owner(lock, req))
+			return lock;
+	return NULL;
+}
+
+static inline struct ldlm_interval_tree *
+ldlm_flock_itree(struct ldlm_resource *res, enum ldlm_mode mode)
+{
+	return &res->lr_flock_index->lfi_itree[ldlm_mode_to_index(mode)];
+}
+
+static inline bool ldlm_flock_in_itree(struct ldlm_lock *lock)
+{
+	return lock->l_tree_node != NULL &&
+	       interval_is_intree(&lock->l_tree_node->li_node);
+}
+
+/**
+ * Add granted flock \a lock into the granted list of \a res just before
+ * \a head, and into the granted locks index on the server.
+ */
+void ldlm_flock_add_lock(struct ldlm_resource *res, struct list_head *head,
+			 struct ldlm_lock *lock)
+{
+	struct ldlm_lock *first;
+
+	LASSERT(lock->l_granted_mode == lock->l_req_mode);
+
+	ldlm_resource_add_lock(res, head, lock);
+	if (res->lr_flock_index == NULL || list_empty(&lock->l_res_link))
+		return;
+
+	first = ldlm_flock_owner_first(res, lock);
+	if (first == NULL || head == &first->l_res_link) {
+		if (first != NULL)
+			hlist_del_init(&first->l_flock_owner_hash);
+		hlist_add_head(&lock->l_flock_owner_hash,
+			       ldlm_flock_owner_head(res, lock));
+	}
+
+	if (lock->l_tree_node == NULL)
+		ldlm_interval_init(lock);
+	ldlm_interval_tree_insert(ldlm_flock_itree(res, lock->l_granted_mode),
+				  lock, lock->l_policy_data.l_flock.start,
+				  lock->l_policy_data.l_flock.end);
+}
+
+/**
+ * Remove \a lock from the granted locks index, it has to be called before
+ * the lock is taken off the granted list.
+ */
+void ldlm_flock_unlink_lock(struct ldlm_lock *lock)
+{
+	struct ldlm_resource *res = lock->l_resource;
+	struct ldlm_lock *next;
+
+	if (res->lr_flock_index == NULL)
+		return;
+
+	if (!hlist_unhashed(&lock->l_flock_owner_hash)) {
+		hlist_del_init(&lock->l_flock_owner_hash);
+		/* pass the owner's first lock on to the next one, if any */
+		if (lock->l_res_link.next != &res->lr_granted) {
+			next = list_entry(lock->l_res_link.next,
+					  struct ldlm_lock, l_res_link);
+			if (ldlm_same_flock_owner(next, lock))
+				hlist_add_head(&next->l_flock_owner_hash,
+					       ldlm_flock_owner_head(res, next));
+		}
+	}
+
+	if (ldlm_flock_in_itree(lock))
+		ldlm_interval_tree_erase(ldlm_flock_itree(res,
+						lock->l_granted_mode), lock);
+}
+
+/* Change the range of a lock, moving it in the interval tree if granted. */
+static void ldlm_flock_range_set(struct ldlm_lock *lock, __u64 start,
+				 __u64 end)
+{
+	struct ldlm_resource *res = lock->l_resource;
+	struct ldlm_interval_tree *tree = NULL;
+
+	if (lock->l_policy_data.l_flock.start == start &&
+	    lock->l_policy_data.l_flock.end == end)
+		return;
+
+	if (res->lr_flock_index != NULL && ldlm_flock_in_itree(lock)) {
+		tree = ldlm_flock_itree(res, lock->l_granted_mode);
+		ldlm_interval_tree_erase(tree, lock);
+		ldlm_interval_init(lock);
+	}
+
+	lock->l_policy_data.l_flock.start = start;
+	lock->l_policy_data.l_flock.end = end;
+
+	if (tree != NULL)
+		ldlm_interval_tree_insert(tree, lock, start, end);
+}
+
+/**
+ * POSIX locks wait-for graph.
+ *
+ * Each blocked server-side flock request is hashed by its owner key: the
+ * namespace, the client NID and the lock owner. The request also records
+ * the owner key of the lock it waits for, which is the edge of the graph.
+ * As a process can't sleep on two locks at the same time, a new edge makes
+ * a cycle only if following the edges from the blocking owner leads back to
+ * the owner of the new request, so only that chain is checked when the
+ * edge is added.
+ */
+#define LDLM_FLOCK_WFG_HASH_BITS	10
+
+static struct hlist_head ldlm_flock_wfg[1 << LDLM_FLOCK_WFG_HASH_BITS];
+static DEFINE_SPINLOCK(ldlm_flock_wfg_lock);
+/* number of hashed requests, protected by ldlm_flock_wfg_lock */
+static unsigned int ldlm_flock_wfg_count;
+
+static inline lnet_nid_t ldlm_flock_nid(struct ldlm_lock *lock)
+{
+	return lock->l_export->exp_connection->c_peer.nid;
+}
+
+static inline struct hlist_head *
+ldlm_flock_wfg_head(struct ldlm_namespace *ns, lnet_nid_t nid, __u64 owner)
+{
+	return &ldlm_flock_wfg[hash_64(owner ^ nid ^ (unsigned long)ns,
+				       LDLM_FLOCK_WFG_HASH_BITS)];
+}
+
+/* Find a blocked request of the given owner, under ldlm_flock_wfg_lock. */
+static struct ldlm_lock *
+ldlm_flock_wfg_find(struct ldlm_namespace *ns, lnet_nid_t nid, __u64 owner)
+{
+	struct ldlm_lock *lock;
+
+	hlist_for_each_entry(lock, ldlm_flock_wfg_head(ns, nid, owner),
+			     l_flock_wait_hash)
+		if (lock->l_policy_data.l_flock.owner == owner &&
+		    ldlm_res_to_ns(lock->l_resource) == ns &&
+		    ldlm_flock_nid(lock) == nid)
+			return lock;
+	return NULL;
+}
+
 static inline void ldlm_flock_blocking_link(struct ldlm_lock *req,
 					    struct ldlm_lock *lock)
 {
+	struct ldlm_flock *flock = &req->l_policy_data.l_flock;
+
         /* For server only */
         if (req->l_export == NULL)
 		return;
 
-	LASSERT(hlist_unhashed(&req->l_exp_flock_hash));
-
-        req->l_policy_data.l_flock.blocking_owner =
-                lock->l_policy_data.l_flock.owner;
-        req->l_policy_data.l_flock.blocking_export =
-		lock->l_export;
-	atomic_set(&req->l_policy_data.l_flock.blocking_refs, 0);
-
-	cfs_hash_add(req->l_export->exp_flock_hash,
-		     &req->l_policy_data.l_flock.owner,
-		     &req->l_exp_flock_hash);
+	check_res_locked(req->l_resource);
+	LASSERT(hlist_unhashed(&req->l_flock_wait_hash));
+
+	flock->blocking_owner = lock->l_policy_data.l_flock.owner;
+	flock->blocking_nid = lock->l_export != NULL ?
+			      ldlm_flock_nid(lock) : LNET_NID_ANY;
+
+	LDLM_LOCK_GET(req);
+	spin_lock(&ldlm_flock_wfg_lock);
+	hlist_add_head(&req->l_flock_wait_hash,
+		       ldlm_flock_wfg_head(ldlm_res_to_ns(req->l_resource),
+					   ldlm_flock_nid(req), flock->owner));
+	ldlm_flock_wfg_count++;
+	spin_unlock(&ldlm_flock_wfg_lock);
 }
 
 static inline void ldlm_flock_blocking_unlink(struct ldlm_lock *req)
@@ -118,11 +295,17 @@ static inline void ldlm_flock_blocking_unlink(struct ldlm_lock *req)
                 return;
 
 	check_res_locked(req->l_resource);
-	if (req->l_export->exp_flock_hash != NULL &&
-	    !hlist_unhashed(&req->l_exp_flock_hash))
-		cfs_hash_del(req->l_export->exp_flock_hash,
-			     &req->l_policy_data.l_flock.owner,
-			     &req->l_exp_flock_hash);
+	if (hlist_unhashed(&req->l_flock_wait_hash))
+		return;
+
+	spin_lock(&ldlm_flock_wfg_lock);
+	hlist_del_init(&req->l_flock_wait_hash);
+	ldlm_flock_wfg_count--;
+	spin_unlock(&ldlm_flock_wfg_lock);
+
+	req->l_policy_data.l_flock.blocking_owner = 0;
+	req->l_policy_data.l_flock.blocking_nid = 0;
+	LDLM_LOCK_RELEASE(req);
 }
 
 static inline void
@@ -133,9 +316,9 @@ ldlm_flock_destroy(struct ldlm_lock *lock, enum ldlm_mode mode, __u64 flags)
 	LDLM_DEBUG(lock, "ldlm_flock_destroy(mode: %d, flags: %#llx)",
 		   mode, flags);
 
-	/* Safe to not lock here, since it should be empty anyway */
-	LASSERT(hlist_unhashed(&lock->l_exp_flock_hash));
+	LASSERT(hlist_unhashed(&lock->l_flock_wait_hash));
 
+	ldlm_flock_unlink_lock(lock);
 	list_del_init(&lock->l_res_link);
 	if (flags == LDLM_FL_WAIT_NOREPROC) {
 		/* client side - set a flag to prevent sending a CANCEL */
@@ -154,93 +337,55 @@ ldlm_flock_destroy(struct ldlm_lock *lock, enum ldlm_mode mode, __u64 flags)
  * POSIX locks deadlock detection code.
  *
  * Given a new lock \a req and an existing lock \a bl_lock it conflicts
- * with, we need to iterate through all blocked POSIX locks for this
- * export and see if there is a deadlock condition arising. (i.e. when
- * one client holds a lock on something and want a lock on something
- * else and at the same time another client has the opposite situation).
+ * with, follow the wait-for graph from the owner of \a bl_lock and see if
+ * it leads back to the owner of \a req. (i.e. when one client holds a lock
+ * on something and want a lock on something else and at the same time
+ * another client has the opposite situation).
  */
-
-struct ldlm_flock_lookup_cb_data {
-	__u64 *bl_owner;
-	struct ldlm_lock *lock;
-	struct obd_export *exp;
-};
-
-static int ldlm_flock_lookup_cb(struct cfs_hash *hs, struct cfs_hash_bd *bd,
-				struct hlist_node *hnode, void *data)
-{
-	struct ldlm_flock_lookup_cb_data *cb_data = data;
-	struct obd_export *exp = cfs_hash_object(hs, hnode);
-	struct ldlm_lock *lock;
-
-	lock = cfs_hash_lookup(exp->exp_flock_hash, cb_data->bl_owner);
-	if (lock == NULL)
-		return 0;
-
-	/* Stop on first found lock. Same process can't sleep twice */
-	cb_data->lock = lock;
-	cb_data->exp = class_export_get(exp);
-
-	return 1;
-}
-
 static int
 ldlm_flock_deadlock(struct ldlm_lock *req, struct ldlm_lock *bl_lock)
 {
-        struct obd_export *req_exp = req->l_export;
-        struct obd_export *bl_exp = bl_lock->l_export;
-        __u64 req_owner = req->l_policy_data.l_flock.owner;
-        __u64 bl_owner = bl_lock->l_policy_data.l_flock.owner;
+	struct ldlm_namespace *ns = ldlm_res_to_ns(req->l_resource);
+	__u64 req_owner = req->l_policy_data.l_flock.owner;
+	__u64 bl_owner = bl_lock->l_policy_data.l_flock.owner;
+	lnet_nid_t req_nid;
+	lnet_nid_t bl_nid;
+	unsigned int hops;
+	int deadlock = 0;
+
+	/* For server only */
+	if (req->l_export == NULL || bl_lock->l_export == NULL)
+		return 0;
 
-        /* For server only */
-        if (req_exp == NULL)
-                return 0;
-
-        class_export_get(bl_exp);
-	while (1) {
-		struct ldlm_flock_lookup_cb_data cb_data = {
-					.bl_owner = &bl_owner,
-					.lock = NULL,
-					.exp = NULL };
-		struct obd_export *bl_exp_new;
-		struct ldlm_lock *lock = NULL;
+	lprocfs_counter_incr(ns->ns_stats, LDLM_NSS_FLOCK_DEADLOCK_CHECKS);
+	req_nid = ldlm_flock_nid(req);
+	bl_nid = ldlm_flock_nid(bl_lock);
+
+	spin_lock(&ldlm_flock_wfg_lock);
+	/* a cycle which doesn't pass through @req can't make us loop forever,
+	 * the chain can't be longer than the number of blocked requests */
+	for (hops = 0; hops <= ldlm_flock_wfg_count; hops++) {
+		struct ldlm_lock *lock;
 		struct ldlm_flock *flock;
 
-		if (bl_exp->exp_flock_hash != NULL) {
-			cfs_hash_for_each_key(bl_exp->exp_obd->obd_nid_hash,
-				&bl_exp->exp_connection->c_peer.nid,
-				ldlm_flock_lookup_cb, &cb_data);
-			lock = cb_data.lock;
-		}
-		if (lock == NULL)
+		lock = ldlm_flock_wfg_find(ns, bl_nid, bl_owner);
+		if (lock == NULL || lock->l_export->exp_failed)
 			break;
 
-		class_export_put(bl_exp);
-		bl_exp = cb_data.exp;
-
-		LASSERT(req != lock);
 		flock = &lock->l_policy_data.l_flock;
-		LASSERT(flock->owner == bl_owner);
-                bl_owner = flock->blocking_owner;
-                bl_exp_new = class_export_get(flock->blocking_export);
-                class_export_put(bl_exp);
+		bl_owner = flock->blocking_owner;
+		bl_nid = flock->blocking_nid;
 
-		cfs_hash_put(bl_exp->exp_flock_hash, &lock->l_exp_flock_hash);
-                bl_exp = bl_exp_new;
-
-		if (bl_exp->exp_failed)
+		if (bl_owner == req_owner && bl_nid == req_nid) {
+			deadlock = 1;
 			break;
+		}
+	}
+	spin_unlock(&ldlm_flock_wfg_lock);
 
-		if (bl_owner == req_owner &&
-		    (bl_exp->exp_connection->c_peer.nid ==
-		     req_exp->exp_connection->c_peer.nid)) {
-                        class_export_put(bl_exp);
-                        return 1;
-                }
-        }
-        class_export_put(bl_exp);
-
-        return 0;
+	if (deadlock)
+		lprocfs_counter_incr(ns->ns_stats, LDLM_NSS_FLOCK_DEADLOCKS);
+	return deadlock;
 }
 
 static void ldlm_flock_cancel_on_deadlock(struct ldlm_lock *lock,
@@ -263,6 +408,108 @@ static void ldlm_flock_cancel_on_deadlock(struct ldlm_lock *lock,
 	}
 }
 
+struct ldlm_flock_conflict_args {
+	struct ldlm_lock	*fca_req;
+	/* the first conflicting lock, or the one making a deadlock */
+	struct ldlm_lock	*fca_lock;
+	/* check every conflicting lock for a deadlock */
+	bool			 fca_check_deadlock;
+	bool			 fca_deadlock;
+};
+
+/* Returns true if the search for conflicts should stop. */
+static bool ldlm_flock_conflict_check(struct ldlm_flock_conflict_args *args,
+				      struct ldlm_lock *lock)
+{
+	struct ldlm_lock *req = args->fca_req;
+
+	if (ldlm_same_flock_owner(lock, req))
+		return false;
+
+	/* locks are compatible, overlap doesn't matter */
+	if (lockmode_compat(lock->l_granted_mode, req->l_req_mode))
+		return false;
+
+	if (!ldlm_flocks_overlap(lock, req))
+		return false;
+
+	args->fca_lock = lock;
+	if (!args->fca_check_deadlock)
+		return true;
+
+	args->fca_deadlock = ldlm_flock_deadlock(req, lock);
+	return args->fca_deadlock;
+}
+
+static enum interval_iter ldlm_flock_conflict_cb(struct interval_node *n,
+						 void *data)
+{
+	struct ldlm_interval *node = to_ldlm_interval(n);
+	struct ldlm_lock *lock;
+
+	list_for_each_entry(lock, &node->li_group, l_sl_policy)
+		if (ldlm_flock_conflict_check(data, lock))
+			return INTERVAL_ITER_STOP;
+
+	return INTERVAL_ITER_CONT;
+}
+
+/**
+ * Look for granted locks conflicting with \a args->fca_req, in the interval
+ * trees of the incompatible modes when the resource is indexed.
+ */
+static void ldlm_flock_find_conflicts(struct ldlm_resource *res,
+				      struct ldlm_flock_conflict_args *args)
+{
+	struct ldlm_lock *req = args->fca_req;
+	struct ldlm_lock *lock;
+	int idx;
+
+	if (res->lr_flock_index != NULL) {
+		struct interval_node_extent ext = {
+			.start	= req->l_policy_data.l_flock.start,
+			.end	= req->l_policy_data.l_flock.end,
+		};
+
+		for (idx = 0; idx < LCK_MODE_NUM; idx++) {
+			struct ldlm_interval_tree *tree;
+
+			tree = &res->lr_flock_index->lfi_itree[idx];
+			if (tree->lit_root == NULL ||
+			    lockmode_compat(tree->lit_mode, req->l_req_mode))
+				continue;
+
+			if (interval_search(tree->lit_root, &ext,
+					    ldlm_flock_conflict_cb, args) ==
+			    INTERVAL_ITER_STOP)
+				return;
+		}
+		return;
+	}
+
+	list_for_each_entry(lock, &res->lr_granted, l_res_link)
+		if (ldlm_flock_conflict_check(args, lock))
+			return;
+}
+
+/* Position of the first lock of the owner of \a req in the granted list. */
+static struct list_head *ldlm_flock_ownlocks(struct ldlm_resource *res,
+					     struct ldlm_lock *req)
+{
+	struct ldlm_lock *lock;
+
+	if (res->lr_flock_index != NULL) {
+		lock = ldlm_flock_owner_first(res, req);
+		return lock != NULL ? &lock->l_res_link : NULL;
+	}
+
+	list_for_each_entry(lock, &res->lr_granted, l_res_link)
+		if (ldlm_same_flock_owner(lock, req))
+			return &lock->l_res_link;
+
+	return NULL;
+}
+
 /**
  * Process a granting attempt for flock lock.
  * Must be called under ns lock held.
@@ -286,6 +533,8 @@ ldlm_process_flock_lock(struct ldlm_lock *req, __u64 *flags,
 	enum ldlm_mode mode = req->l_req_mode;
 	int local = ns_is_client(ns);
 	int added = (mode == LCK_NL);
+	__u64 start;
+	__u64 end;
 	int overlaps = 0;
 	int splitted = 0;
 	const struct ldlm_callback_suite null_cbs = { NULL };
@@ -309,53 +558,35 @@ ldlm_process_flock_lock(struct ldlm_lock *req, __u64 *flags,
         } else {
                 /* Called on the server for lock cancels. */
                 req->l_blocking_ast = ldlm_flock_blocking_ast;
+		if (intention == LDLM_PROCESS_ENQUEUE)
+			req->l_policy_data.l_flock.enqueued = ktime_get();
         }
 
 reprocess:
-        if ((*flags == LDLM_FL_WAIT_NOREPROC) || (mode == LCK_NL)) {
-                /* This loop determines where this processes locks start
-                 * in the resource lr_granted list. */
-		list_for_each(tmp, &res->lr_granted) {
-			lock = list_entry(tmp, struct ldlm_lock,
-                                              l_res_link);
-                        if (ldlm_same_flock_owner(lock, req)) {
-                                ownlocks = tmp;
-                                break;
-                        }
-                }
-        } else {
-		int reprocess_failed = 0;
-                lockmode_verify(mode);
+	/* This determines where this processes locks start in the resource
+	 * lr_granted list. */
+	ownlocks = ldlm_flock_ownlocks(res, req);
 
-                /* This loop determines if there are existing locks
-                 * that conflict with the new lock request. */
-		list_for_each(tmp, &res->lr_granted) {
-			lock = list_entry(tmp, struct ldlm_lock,
-                                              l_res_link);
+	if ((*flags != LDLM_FL_WAIT_NOREPROC) && (mode != LCK_NL)) {
+		struct ldlm_flock_conflict_args args = {
+			.fca_req = req,
+			.fca_check_deadlock = intention != LDLM_PROCESS_ENQUEUE,
+		};
 
-                        if (ldlm_same_flock_owner(lock, req)) {
-                                if (!ownlocks)
-                                        ownlocks = tmp;
-                                continue;
-                        }
-
-                        /* locks are compatible, overlap doesn't matter */
-                        if (lockmode_compat(lock->l_granted_mode, mode))
-                                continue;
+                lockmode_verify(mode);
 
-                        if (!ldlm_flocks_overlap(lock, req))
-                                continue;
+                /* Determine if there are existing locks that conflict with
+                 * the new lock request. */
+		ldlm_flock_find_conflicts(res, &args);
+		lock = args.fca_lock;
 
-			if (intention != LDLM_PROCESS_ENQUEUE) {
-				reprocess_failed = 1;
-				if (ldlm_flock_deadlock(req, lock)) {
-					ldlm_flock_cancel_on_deadlock(req,
-							grant_work);
-					RETURN(LDLM_ITER_CONTINUE);
-				}
-				continue;
-			}
+		if (lock != NULL && intention != LDLM_PROCESS_ENQUEUE) {
+			if (args.fca_deadlock)
+				ldlm_flock_cancel_on_deadlock(req, grant_work);
+			RETURN(LDLM_ITER_CONTINUE);
+		}
 
+		if (lock != NULL) {
                         if (*flags & LDLM_FL_BLOCK_NOWAIT) {
                                 ldlm_flock_destroy(req, mode, *flags);
                                 *err = -EAGAIN;
@@ -390,8 +621,6 @@ reprocess:
                         *flags |= LDLM_FL_BLOCK_GRANTED;
                         RETURN(LDLM_ITER_STOP);
                 }
-		if (reprocess_failed)
-			RETURN(LDLM_ITER_CONTINUE);
         }
 
         if (*flags & LDLM_FL_TEST_LOCK) {
@@ -433,23 +662,13 @@ reprocess:
                             && (lock->l_policy_data.l_flock.start != 0))
                                 break;
 
-                        if (new->l_policy_data.l_flock.start <
-                            lock->l_policy_data.l_flock.start) {
-                                lock->l_policy_data.l_flock.start =
-                                        new->l_policy_data.l_flock.start;
-                        } else {
-                                new->l_policy_data.l_flock.start =
-                                        lock->l_policy_data.l_flock.start;
-                        }
-
-                        if (new->l_policy_data.l_flock.end >
-                            lock->l_policy_data.l_flock.end) {
-                                lock->l_policy_data.l_flock.end =
-                                        new->l_policy_data.l_flock.end;
-                        } else {
-                                new->l_policy_data.l_flock.end =
-                                        lock->l_policy_data.l_flock.end;
-                        }
+			/* both locks now cover the union of their ranges */
+			start = min(new->l_policy_data.l_flock.start,
+				    lock->l_policy_data.l_flock.start);
+			end = max(new->l_policy_data.l_flock.end,
+				  lock->l_policy_data.l_flock.end);
+			ldlm_flock_range_set(lock, start, end);
+			ldlm_flock_range_set(new, start, end);
 
                         if (added) {
                                 ldlm_flock_destroy(lock, mode, *flags);
@@ -474,8 +693,9 @@ reprocess:
                     lock->l_policy_data.l_flock.start) {
                         if (new->l_policy_data.l_flock.end <
                             lock->l_policy_data.l_flock.end) {
-                                lock->l_policy_data.l_flock.start =
-                                        new->l_policy_data.l_flock.end + 1;
+				ldlm_flock_range_set(lock,
+					new->l_policy_data.l_flock.end + 1,
+					lock->l_policy_data.l_flock.end);
                                 break;
                         }
                         ldlm_flock_destroy(lock, lock->l_req_mode, *flags);
@@ -483,8 +703,9 @@ reprocess:
                 }
                 if (new->l_policy_data.l_flock.end >=
                     lock->l_policy_data.l_flock.end) {
-                        lock->l_policy_data.l_flock.end =
-                                new->l_policy_data.l_flock.start - 1;
+			ldlm_flock_range_set(lock,
+					     lock->l_policy_data.l_flock.start,
+					     new->l_policy_data.l_flock.start - 1);
                         continue;
                 }
 
@@ -526,8 +747,8 @@ reprocess:
                         lock->l_policy_data.l_flock.start;
                 new2->l_policy_data.l_flock.end =
                         new->l_policy_data.l_flock.start - 1;
-                lock->l_policy_data.l_flock.start =
-                        new->l_policy_data.l_flock.end + 1;
+		ldlm_flock_range_set(lock, new->l_policy_data.l_flock.end + 1,
+				     lock->l_policy_data.l_flock.end);
                 new2->l_conn_export = lock->l_conn_export;
                 if (lock->l_export != NULL) {
                         new2->l_export = class_export_lock_get(lock->l_export, new2);
@@ -542,7 +763,7 @@ reprocess:
                                                          lock->l_granted_mode);
 
                 /* insert new2 at lock */
-                ldlm_resource_add_lock(res, ownlocks, new2);
+		ldlm_flock_add_lock(res, ownlocks, new2);
                 LDLM_LOCK_RELEASE(new2);
                 break;
         }
@@ -553,12 +774,16 @@ reprocess:
 
         /* At this point we're granting the lock request. */
         req->l_granted_mode = req->l_req_mode;
+	if (!local)
+		lprocfs_counter_add(ns->ns_stats, LDLM_NSS_FLOCK_ENQUEUE_TIME,
+				    ktime_us_delta(ktime_get(),
+					req->l_policy_data.l_flock.enqueued));
 
         /* Add req to the granted queue before calling ldlm_reprocess_all(). */
         if (!added) {
 		list_del_init(&req->l_res_link);
                 /* insert new lock before ownlocks in list. */
-                ldlm_resource_add_lock(res, ownlocks, req);
+		ldlm_flock_add_lock(res, ownlocks, req);
         }
 
         if (*flags != LDLM_FL_WAIT_NOREPROC) {
@@ -847,105 +1072,3 @@ void ldlm_flock_policy_local_to_wire(const union ldlm_policy_data *lpolicy,
 	wpolicy->l_flock.lfw_pid = lpolicy->l_flock.pid;
 	wpolicy->l_flock.lfw_owner = lpolicy->l_flock.owner;
 }
-
-/*
- * Export handle<->flock hash operations.
- */
-static unsigned
-ldlm_export_flock_hash(struct cfs_hash *hs, const void *key, unsigned mask)
-{
-	return cfs_hash_u64_hash(*(__u64 *)key, mask);
-}
-
-static void *
-ldlm_export_flock_key(struct hlist_node *hnode)
-{
-	struct ldlm_lock *lock;
-
-	lock = hlist_entry(hnode, struct ldlm_lock, l_exp_flock_hash);
-	return &lock->l_policy_data.l_flock.owner;
-}
-
-static int
-ldlm_export_flock_keycmp(const void *key, struct hlist_node *hnode)
-{
-	return !memcmp(ldlm_export_flock_key(hnode), key, sizeof(__u64));
-}
-
-static void *
-ldlm_export_flock_object(struct hlist_node *hnode)
-{
-	return hlist_entry(hnode, struct ldlm_lock, l_exp_flock_hash);
-}
-
-static void
-ldlm_export_flock_get(struct cfs_hash *hs, struct hlist_node *hnode)
-{
-	struct ldlm_lock *lock;
-	struct ldlm_flock *flock;
-
-	lock = hlist_entry(hnode, struct ldlm_lock, l_exp_flock_hash);
-	LDLM_LOCK_GET(lock);
-
-	flock = &lock->l_policy_data.l_flock;
-	LASSERT(flock->blocking_export != NULL);
-	class_export_get(flock->blocking_export);
-	atomic_inc(&flock->blocking_refs);
-}
-
-static void
-ldlm_export_flock_put(struct cfs_hash *hs, struct hlist_node *hnode)
-{
-	struct ldlm_lock *lock;
-	struct ldlm_flock *flock;
-
-	lock = hlist_entry(hnode, struct ldlm_lock, l_exp_flock_hash);
-
-	flock = &lock->l_policy_data.l_flock;
-	LASSERT(flock->blocking_export != NULL);
-	class_export_put(flock->blocking_export);
-	if (atomic_dec_and_test(&flock->blocking_refs)) {
-		flock->blocking_owner = 0;
-		flock->blocking_export = NULL;
-	}
-	LDLM_LOCK_RELEASE(lock);
-}
-
-static struct cfs_hash_ops ldlm_export_flock_ops = {
-	.hs_hash        = ldlm_export_flock_hash,
-	.hs_key         = ldlm_export_flock_key,
-	.hs_keycmp      = ldlm_export_flock_keycmp,
-	.hs_object      = ldlm_export_flock_object,
-	.hs_get         = ldlm_export_flock_get,
-	.hs_put         = ldlm_export_flock_put,
-	.hs_put_locked  = ldlm_export_flock_put,
-};
-
-int ldlm_init_flock_export(struct obd_export *exp)
-{
-	if( strcmp(exp->exp_obd->obd_type->typ_name, LUSTRE_MDT_NAME) != 0)
-		RETURN(0);
-
-	exp->exp_flock_hash =
-		cfs_hash_create(obd_uuid2str(&exp->exp_client_uuid),
-				HASH_EXP_LOCK_CUR_BITS,
-				HASH_EXP_LOCK_MAX_BITS,
-				HASH_EXP_LOCK_BKT_BITS, 0,
-				CFS_HASH_MIN_THETA, CFS_HASH_MAX_THETA,
-				&ldlm_export_flock_ops,
-				CFS_HASH_DEFAULT | CFS_HASH_NBLK_CHANGE);
-	if (!exp->exp_flock_hash)
-		RETURN(-ENOMEM);
-
-	RETURN(0);
-}
-
-void ldlm_destroy_flock_export(struct obd_export *exp)
-{
-	ENTRY;
-	if (exp->exp_flock_hash) {
-		cfs_hash_putref(exp->exp_flock_hash);
-		exp->exp_flock_hash = NULL;
-	}
-	EXIT;
-}
@@ -56,7 +56,127 @@
 
 #include "ldlm_internal.h"
 
+/**
+ * Account granted \a lock in the IBITS summary \a liq of its resource,
+ * \a delta is 1 when the lock is added to the granted list and -1 when it is
+ * removed from there.
+ */
+static void ldlm_inodebits_account(struct ldlm_ibits_queues *liq,
+				   struct ldlm_lock *lock, int delta)
+{
+	__u64 bits = lock->l_policy_data.l_inodebits.bits;
+	__u32 *granted;
+	int i;
+
+	granted = liq->liq_granted[ldlm_mode_to_index(lock->l_granted_mode)];
+	for (i = 0; i <= MDS_INODELOCK_MAXSHIFT; i++) {
+		if (bits & (1ULL << i)) {
+			LASSERT(delta > 0 || granted[i] > 0);
+			granted[i] += delta;
+		}
+	}
+	/* all unknown bits share the last counter */
+	if (bits & ~(__u64)MDS_INODELOCK_FULL) {
+		LASSERT(delta > 0 || granted[LDLM_IBITS_NUM - 1] > 0);
+		granted[LDLM_IBITS_NUM - 1] += delta;
+	}
+}
+
+/** Add granted IBITS \a lock to the summary of resource \a res. */
+void ldlm_inodebits_add_lock(struct ldlm_resource *res, struct ldlm_lock *lock)
+{
+	check_res_locked(res);
+
+	if (res->lr_ibits_queues == NULL)
+		return;
+
+	LASSERT(lock->l_granted_mode == lock->l_req_mode);
+	ldlm_inodebits_account(res->lr_ibits_queues, lock, 1);
+}
+
+/**
+ * Remove IBITS \a lock from the summary of its resource, if it was accounted
+ * there, i.e. it is in the granted list.
+ */
+void ldlm_inodebits_unlink_lock(struct ldlm_lock *lock)
+{
+	struct ldlm_resource *res = lock->l_resource;
+
+	check_res_locked(res);
+
+	if (res->lr_ibits_queues == NULL || list_empty(&lock->l_res_link) ||
+	    lock->l_granted_mode != lock->l_req_mode)
+		return;
+
+	ldlm_inodebits_account(res->lr_ibits_queues, lock, -1);
+}
+
 #ifdef HAVE_SERVER_SUPPORT
+/**
+ * Granted bits of all locks in mode with index \a idx.
+ */
+static __u64 ldlm_inodebits_granted_mask(struct ldlm_ibits_queues *liq,
+					 int idx)
+{
+	__u64 mask = 0;
+	int i;
+
+	for (i = 0; i <= MDS_INODELOCK_MAXSHIFT; i++)
+		if (liq->liq_granted[idx][i] != 0)
+			mask |= 1ULL << i;
+	if (liq->liq_granted[idx][LDLM_IBITS_NUM - 1] != 0)
+		mask |= ~(__u64)MDS_INODELOCK_FULL;
+
+	return mask;
+}
+
+/**
+ * Check the granted locks summary of the resource before walking the
+ * granted queue.
+ *
+ * Drops from the request try_bits all the bits held by granted locks in
+ * conflicting modes, and finds the modes which have locks with bits
+ * overlapping the request bits.
+ *
+ * \param[in] liq		granted locks summary
+ * \param[in] req		the lock being checked
+ * \param[out] conflict	modes which can conflict with \a req
+ *
+ * \retval 0 if the request has no bits left
+ * \retval 1 otherwise
+ */
+static int ldlm_inodebits_compat_granted(struct ldlm_ibits_queues *liq,
+					 struct ldlm_lock *req,
+					 enum ldlm_mode *conflict)
+{
+	__u64 req_bits = req->l_policy_data.l_inodebits.bits;
+	__u64 *try_bits = &req->l_policy_data.l_inodebits.try_bits;
+	enum ldlm_mode mode;
+	__u64 mask;
+	int idx;
+
+	*conflict = 0;
+	for (idx = 0; idx < LCK_MODE_NUM; idx++) {
+		mode = 1 << idx;
+		mask = ldlm_inodebits_granted_mask(liq, idx);
+		if (mask == 0)
+			continue;
+
+		/* see the same checks in ldlm_inodebits_compat_queue() */
+		if (mode == LCK_COS && !ldlm_is_cos_incompat(req) &&
+		    !ldlm_is_cos_enabled(req))
+			continue;
+		if (lockmode_compat(mode, req->l_req_mode))
+			continue;
+
+		*try_bits &= ~mask;
+		if (mask & req_bits)
+			*conflict |= mode;
+	}
+
+	return (req_bits | *try_bits) != 0;
+}
+
 /*
  * local lock will be canceled after use, and it should run blocking ast only
  * when it should trigger Commit-on-Sharing, otherwise if the blocking ast
@@ -112,10 +232,13 @@ static int
 ldlm_inodebits_compat_queue(struct list_head *queue, struct ldlm_lock *req,
 			    struct list_head *work_list)
 {
+	struct ldlm_resource *res = req->l_resource;
 	struct list_head *tmp;
 	struct ldlm_lock *lock;
 	__u64 req_bits = req->l_policy_data.l_inodebits.bits;
 	__u64 *try_bits = &req->l_policy_data.l_inodebits.try_bits;
+	/* modes of the granted locks which cannot conflict with @req */
+	__u32 skip_modes = 0;
 	int compat = 1;
 
 	ENTRY;
@@ -128,6 +251,22 @@ ldlm_inodebits_compat_queue(struct list_head *queue, struct ldlm_lock *req,
 	if ((req_bits | *try_bits) == 0)
 		RETURN(0);
 
+	/* The granted queue summary tells which mode groups may conflict,
+	 * the others are skipped without looking at their locks. */
+	if (queue == &res->lr_granted && res->lr_ibits_queues != NULL) {
+		enum ldlm_mode conflict;
+
+		if (!ldlm_inodebits_compat_granted(res->lr_ibits_queues, req,
+						   &conflict))
+			RETURN(0);
+		if (conflict == 0)
+			RETURN(1);
+		/* COS locks of the same client do not conflict */
+		if (!work_list && (conflict & ~LCK_COS) != 0)
+			RETURN(0);
+		skip_modes = ~conflict;
+	}
+
 	list_for_each(tmp, queue) {
 		struct list_head *mode_tail;
 
@@ -144,6 +283,12 @@ ldlm_inodebits_compat_queue(struct list_head *queue, struct ldlm_lock *req,
 		mode_tail = &list_entry(lock->l_sl_mode.prev, struct ldlm_lock,
 					l_sl_mode)->l_res_link;
 
+		if (lock->l_req_mode & skip_modes) {
+			/* jump to last lock in mode group */
+			tmp = mode_tail;
+			continue;
+		}
+
 		/* if request lock is not COS_INCOMPAT and COS is disabled,
 		 * they are compatible, IOW this request is from a local
 		 * transaction on a DNE system. */
@@ -118,11 +118,15 @@ int ldlm_cancel_lru_local(struct ldlm_namespace *ns,
 			  struct list_head *cancels, int count, int max,
 			  enum ldlm_cancel_flags cancel_flags,
 			  enum ldlm_lru_flags lru_flags);
+int ldlm_request_bufsize(int count, int type);
 extern unsigned int ldlm_enqueue_min;
 /* ldlm_resource.c */
 extern struct kmem_cache *ldlm_resource_slab;
 extern struct kmem_cache *ldlm_lock_slab;
 extern struct kmem_cache *ldlm_interval_tree_slab;
+extern struct kmem_cache *ldlm_inodebits_slab;
+extern struct kmem_cache *ldlm_flock_index_slab;
+extern struct kmem_cache *ldlm_extent_contention_slab;
 
 void ldlm_resource_insert_lock_after(struct ldlm_lock *original,
                                      struct ldlm_lock *new);
@@ -168,9 +172,17 @@ int ldlm_lock_remove_from_lru_check(struct ldlm_lock *lock, ktime_t last_use);
 #define ldlm_lock_remove_from_lru(lock) \
 		ldlm_lock_remove_from_lru_check(lock, ktime_set(0, 0))
 int ldlm_lock_remove_from_lru_nolock(struct ldlm_lock *lock);
-void ldlm_lock_add_to_lru_nolock(struct ldlm_lock *lock);
+void ldlm_lock_move_in_lru_nolock(struct ldlm_lock *lock, bool to_protected);
 void ldlm_lock_add_to_lru(struct ldlm_lock *lock);
+void ldlm_lru_pending_flush(struct ldlm_namespace *ns);
 void ldlm_lock_touch_in_lru(struct ldlm_lock *lock);
+
+/* Should the lock go to the protected LRU list rather than to probation */
+static inline bool ldlm_lock_lru_protect(struct ldlm_lock *lock)
+{
+	return ldlm_lock_to_ns(lock)->ns_lru_protected_pct > 0 &&
+	       lock->l_lru_reuse >= LDLM_LRU_PROTECT_REUSE;
+}
 void ldlm_lock_destroy_nolock(struct ldlm_lock *lock);
 
 int ldlm_export_cancel_blocked_locks(struct obd_export *exp);
@@ -185,6 +197,23 @@ int ldlm_bl_to_thread_list(struct ldlm_namespace *ns,
 			   struct list_head *cancels, int count,
 			   enum ldlm_cancel_flags cancel_flags);
 int ldlm_bl_thread_wakeup(void);
+#ifdef HAVE_SERVER_SUPPORT
+/**
+ * Blocking AST being collected for one export, see OBD_CONNECT2_BATCH_AST.
+ * All locks share the same lock descriptor and AST flags.
+ */
+struct ldlm_bl_ast_batch {
+	struct ptlrpc_request	*bab_req;
+	struct obd_export	*bab_exp;
+	struct ldlm_lock	**bab_locks;
+	int			 bab_count;
+	int			 bab_max;
+	__u64			 bab_flags;
+	struct ldlm_lock_desc	 bab_desc;
+};
+
+int ldlm_bl_ast_batch_flush(struct ldlm_cb_set_arg *arg);
+#endif
 
 void ldlm_handle_bl_callback(struct ldlm_namespace *ns,
                              struct ldlm_lock_desc *ld, struct ldlm_lock *lock);
@@ -207,13 +236,16 @@ int ldlm_process_extent_lock(struct ldlm_lock *lock, __u64 *flags,
 #endif
 void ldlm_extent_add_lock(struct ldlm_resource *res, struct ldlm_lock *lock);
 void ldlm_extent_unlink_lock(struct ldlm_lock *lock);
+void ldlm_inodebits_add_lock(struct ldlm_resource *res, struct ldlm_lock *lock);
+void ldlm_inodebits_unlink_lock(struct ldlm_lock *lock);
 
 /* ldlm_flock.c */
 int ldlm_process_flock_lock(struct ldlm_lock *req, __u64 *flags,
 			    enum ldlm_process_intention intention,
 			    enum ldlm_error *err, struct list_head *work_list);
-int ldlm_init_flock_export(struct obd_export *exp);
-void ldlm_destroy_flock_export(struct obd_export *exp);
+void ldlm_flock_add_lock(struct ldlm_resource *res, struct list_head *head,
+			 struct ldlm_lock *lock);
+void ldlm_flock_unlink_lock(struct ldlm_lock *lock);
 
 /* l_lock.c */
 void l_check_ns_lock(struct ldlm_namespace *ns);
@@ -230,11 +262,45 @@ struct ldlm_state {
 };
 
 /* interval tree, for LDLM_EXTENT. */
-extern struct kmem_cache *ldlm_interval_slab; /* slab cache for ldlm_interval */
 extern void ldlm_interval_attach(struct ldlm_interval *n, struct ldlm_lock *l);
 extern struct ldlm_interval *ldlm_interval_detach(struct ldlm_lock *l);
-extern struct ldlm_interval *ldlm_interval_alloc(struct ldlm_lock *lock);
-extern void ldlm_interval_free(struct ldlm_interval *node);
+extern void ldlm_interval_init(struct ldlm_lock *lock);
+void ldlm_interval_tree_insert(struct ldlm_interval_tree *tree,
+			       struct ldlm_lock *lock, __u64 start, __u64 end);
+void ldlm_interval_tree_erase(struct ldlm_interval_tree *tree,
+			      struct ldlm_lock *lock);
+
+static inline int ldlm_mode_to_index(enum ldlm_mode mode)
+{
+	int index;
+
+	LASSERT(mode != 0);
+	LASSERT(is_power_of_2(mode));
+	for (index = -1; mode != 0; index++, mode >>= 1)
+		/* do nothing */;
+	LASSERT(index < LCK_MODE_NUM);
+	return index;
+}
+
+static inline struct ldlm_extent_index *
+ldlm_res_extent_index(struct ldlm_resource *res)
+{
+	LASSERT(res->lr_type == LDLM_EXTENT);
+	return container_of(res->lr_itree, struct ldlm_extent_index,
+			    lei_itree[0]);
+}
+
+/* only extent resources of server namespaces have a contention history */
+static inline struct ldlm_extent_contention *
+ldlm_res_contention(struct ldlm_resource *res)
+{
+	struct ldlm_extent_contention *lec;
+
+	lec = ldlm_res_extent_index(res)->lei_contention;
+	LASSERT(lec != NULL);
+	return lec;
+}
+
 /* this function must be called with res lock held */
 static inline struct ldlm_extent *
 ldlm_interval_extent(struct ldlm_interval *node)
@@ -404,9 +470,12 @@ extern __u64 ldlm_lock_limit;
 extern __u64 ldlm_reclaim_threshold_mb;
 extern __u64 ldlm_lock_limit_mb;
 extern struct percpu_counter ldlm_granted_total;
+extern struct percpu_counter ldlm_granted_bytes;
+int ldlm_reclaim_stats_seq_show(struct seq_file *m, void *data);
 #endif
 int ldlm_reclaim_setup(void);
 void ldlm_reclaim_cleanup(void);
+void ldlm_reclaim_ns_init(struct ldlm_namespace *ns);
 void ldlm_reclaim_add(struct ldlm_lock *lock);
 void ldlm_reclaim_del(struct ldlm_lock *lock);
 bool ldlm_reclaim_full(void);
@@ -437,6 +437,8 @@ int client_obd_setup(struct obd_device *obddev, struct lustre_cfg *lcfg)
 			cli->cl_max_rpcs_in_flight = OBD_MAX_RIF_DEFAULT;
 	}
 
+	cli->cl_rif_auto_max = OSC_MAX_RIF_MAX;
+
 	spin_lock_init(&cli->cl_mod_rpcs_lock);
 	spin_lock_init(&cli->cl_mod_rpcs_hist.oh_lock);
 	cli->cl_max_mod_rpcs_in_flight = 0;
@@ -1594,6 +1596,40 @@ static void target_finish_recovery(struct lu_target *lut)
         EXIT;
 }
 
+/* obd_recovery_task_lock should be held */
+static void target_replay_queue_add(struct obd_device *obd,
+				    struct ptlrpc_request *req,
+				    struct list_head *pos)
+{
+	list_add(&req->rq_list, pos);
+	obd->obd_requests_queued_for_recovery++;
+	if (req->rq_export->exp_replay_queued++ == 0)
+		obd->obd_replay_queued_exports++;
+}
+
+/* obd_recovery_task_lock should be held */
+static void target_replay_queue_del(struct obd_device *obd,
+				    struct ptlrpc_request *req)
+{
+	list_del_init(&req->rq_list);
+	obd->obd_requests_queued_for_recovery--;
+	if (--req->rq_export->exp_replay_queued == 0)
+		obd->obd_replay_queued_exports--;
+}
+
+/* obd_recovery_task_lock should be held */
+static void target_replay_queue_splice(struct obd_device *obd,
+				       struct list_head *list)
+{
+	struct ptlrpc_request *req;
+
+	list_for_each_entry(req, &obd->obd_req_replay_queue, rq_list)
+		req->rq_export->exp_replay_queued = 0;
+	obd->obd_requests_queued_for_recovery = 0;
+	obd->obd_replay_queued_exports = 0;
+	list_splice_init(&obd->obd_req_replay_queue, list);
+}
+
 static void abort_req_replay_queue(struct obd_device *obd)
 {
 	struct ptlrpc_request *req, *n;
@@ -1601,7 +1637,7 @@ static void abort_req_replay_queue(struct obd_device *obd)
 
 	INIT_LIST_HEAD(&abort_list);
 	spin_lock(&obd->obd_recovery_task_lock);
-	list_splice_init(&obd->obd_req_replay_queue, &abort_list);
+	target_replay_queue_splice(obd, &abort_list);
 	spin_unlock(&obd->obd_recovery_task_lock);
 	list_for_each_entry_safe(req, n, &abort_list, rq_list) {
                 DEBUG_REQ(D_WARNING, req, "aborted:");
@@ -1661,7 +1697,7 @@ void target_cleanup_recovery(struct obd_device *obd)
 
 	spin_lock(&obd->obd_recovery_task_lock);
 	target_cancel_recovery_timer(obd);
-	list_splice_init(&obd->obd_req_replay_queue, &clean_list);
+	target_replay_queue_splice(obd, &clean_list);
 	spin_unlock(&obd->obd_recovery_task_lock);
 
 	list_for_each_entry_safe(req, n, &clean_list, rq_list) {
@@ -1863,12 +1899,56 @@ static inline int exp_finished_or_from_mdt(struct obd_export *exp)
 		exp_finished(exp);
 }
 
+/**
+ * Check whether some client is still sending the replay that precedes its
+ * lowest queued one.
+ *
+ * Clients that keep several replays in flight put the transno of their
+ * previous replay in pb_last_committed. If that transno has not been
+ * replayed yet, the request carrying it is still on the way and a missing
+ * transno must not be treated as a gap. This is not trusted for a client
+ * that had a replay dropped, the dropped one would block the queue until
+ * the recovery timer expires. obd_recovery_task_lock should be held.
+ */
+static bool target_replay_queue_blocked(struct obd_device *obd,
+					__u64 next_transno)
+{
+	struct ptlrpc_request *req;
+
+	list_for_each_entry(req, &obd->obd_req_replay_queue, rq_list)
+		req->rq_export->exp_replay_scanned = 0;
+
+	/* the queue is sorted, so the first request of each export seen
+	 * here is its lowest queued one */
+	list_for_each_entry(req, &obd->obd_req_replay_queue, rq_list) {
+		struct obd_export *exp = req->rq_export;
+		__u64 prev;
+
+		if (exp->exp_replay_scanned)
+			continue;
+		exp->exp_replay_scanned = 1;
+		if (exp->exp_replay_dropped)
+			continue;
+
+		prev = lustre_msg_get_last_committed(req->rq_reqmsg);
+		if (prev >= next_transno) {
+			CDEBUG(D_HA, "%s: %s still sending t%llu before "
+			       "t%llu\n", obd->obd_name,
+			       obd_export_nid2str(exp), prev,
+			       lustre_msg_get_transno(req->rq_reqmsg));
+			return true;
+		}
+	}
+
+	return false;
+}
+
 static int check_for_next_transno(struct lu_target *lut)
 {
 	struct ptlrpc_request *req = NULL;
 	struct obd_device *obd = lut->lut_obd;
 	struct target_distribute_txn_data *tdtd = lut->lut_tdtd;
-	int wake_up = 0, connected, completed, queue_len;
+	int wake_up = 0, connected, completed, queue_len, queued_exports;
 	__u64 req_transno = 0;
 	__u64 update_transno = 0;
 	__u64 next_transno = 0;
@@ -1887,12 +1967,13 @@ static int check_for_next_transno(struct lu_target *lut)
 	connected = atomic_read(&obd->obd_connected_clients);
 	completed = connected - atomic_read(&obd->obd_req_replay_clients);
 	queue_len = obd->obd_requests_queued_for_recovery;
+	queued_exports = obd->obd_replay_queued_exports;
 	next_transno = obd->obd_next_recovery_transno;
 
 	CDEBUG(D_HA, "max: %d, connected: %d, completed: %d, queue_len: %d, "
-	       "req_transno: %llu, next_transno: %llu\n",
+	       "queued_exports: %d, req_transno: %llu, next_transno: %llu\n",
 	       obd->obd_max_recoverable_clients, connected, completed,
-	       queue_len, req_transno, next_transno);
+	       queue_len, queued_exports, req_transno, next_transno);
 
 	if (obd->obd_abort_recovery) {
 		CDEBUG(D_HA, "waking for aborted recovery\n");
@@ -1912,8 +1993,11 @@ static int check_for_next_transno(struct lu_target *lut)
 		CDEBUG(D_HA, "waking for next (%lld)\n", next_transno);
 		wake_up = 1;
 	} else if (queue_len > 0 &&
-		   queue_len == atomic_read(&obd->obd_req_replay_clients)) {
-		/** handle gaps occured due to lost reply or VBR */
+		   queued_exports == atomic_read(&obd->obd_req_replay_clients) &&
+		   !target_replay_queue_blocked(obd, next_transno)) {
+		/** handle gaps occured due to lost reply or VBR, only once
+		 * every client has something queued: clients keeping several
+		 * replays in flight may have more than one request queued */
 		LASSERTF(req_transno >= next_transno,
 			 "req_transno: %llu, next_transno: %llu\n",
 			 req_transno, next_transno);
@@ -2303,6 +2387,10 @@ static void drop_duplicate_replay_req(struct lu_env *env,
 	obd->obd_replayed_requests++;
 }
 
+/*
+ * Replays are executed one at a time in transno order by the recovery
+ * thread, there is no parallel replay of requests on disjoint FIDs.
+ */
 static void replay_request_or_update(struct lu_env *env,
 				     struct lu_target *lut,
 				     struct target_recovery_data *trd,
@@ -2346,8 +2434,7 @@ static void replay_request_or_update(struct lu_env *env,
 			req = list_entry(obd->obd_req_replay_queue.next,
 					struct ptlrpc_request, rq_list);
 
-			list_del_init(&req->rq_list);
-			obd->obd_requests_queued_for_recovery--;
+			target_replay_queue_del(obd, req);
 			spin_unlock(&obd->obd_recovery_task_lock);
 
 			/* Let's check if the request has been redone by
@@ -2432,6 +2519,28 @@ abort:
 	} while (1);
 }
 
+/**
+ * Account the time spent in the current recovery phase and start \a next.
+ *
+ * The per-phase durations and replay rates are reported by
+ * lprocfs_recovery_status_seq_show().
+ */
+static void target_recovery_phase_next(struct obd_device *obd,
+				       enum obd_recovery_phase next)
+{
+	enum obd_recovery_phase cur = obd->obd_recovery_phase;
+	ktime_t now = ktime_get();
+
+	if (cur < OBD_RECOVERY_PHASE_MAX) {
+		obd->obd_recovery_phase_ms[cur] =
+			ktime_ms_delta(now, obd->obd_recovery_phase_start);
+		CDEBUG(D_HA, "%s: recovery phase %d done in %ums\n",
+		       obd->obd_name, cur, obd->obd_recovery_phase_ms[cur]);
+	}
+	obd->obd_recovery_phase_start = now;
+	obd->obd_recovery_phase = next;
+}
+
 static int target_recovery_thread(void *arg)
 {
         struct lu_target *lut = arg;
@@ -2472,6 +2581,11 @@ static int target_recovery_thread(void *arg)
 	       current_pid());
 	trd->trd_processing_task = current_pid();
 
+	memset(obd->obd_recovery_phase_ms, 0,
+	       sizeof(obd->obd_recovery_phase_ms));
+	obd->obd_recovery_phase_start = ktime_get();
+	obd->obd_recovery_phase = OBD_RECOVERY_CONNECT;
+
 	spin_lock(&obd->obd_dev_lock);
 	obd->obd_recovering = 1;
 	spin_unlock(&obd->obd_dev_lock);
@@ -2487,6 +2601,7 @@ static int target_recovery_thread(void *arg)
 	}
 
 	/* next stage: replay requests or update */
+	target_recovery_phase_next(obd, OBD_RECOVERY_REQ_REPLAY);
 	delta = jiffies;
 	CDEBUG(D_INFO, "1: request replay stage - %d clients from t%llu\n",
 	       atomic_read(&obd->obd_req_replay_clients),
@@ -2496,6 +2611,7 @@ static int target_recovery_thread(void *arg)
 	/**
 	 * The second stage: replay locks
 	 */
+	target_recovery_phase_next(obd, OBD_RECOVERY_LOCK_REPLAY);
 	CDEBUG(D_INFO, "2: lock replay stage - %d clients\n",
 	       atomic_read(&obd->obd_lock_replay_clients));
 	while ((req = target_next_replay_lock(lut))) {
@@ -2513,6 +2629,7 @@ static int target_recovery_thread(void *arg)
          * must have request in final queue
          */
 	CFS_FAIL_TIMEOUT(OBD_FAIL_TGT_REPLAY_RECONNECT, cfs_fail_val);
+	target_recovery_phase_next(obd, OBD_RECOVERY_FINAL_PING);
         CDEBUG(D_INFO, "3: final stage - process recovery completion pings\n");
         /** Update server last boot epoch */
         tgt_boot_epoch_update(lut);
@@ -2536,6 +2653,7 @@ static int target_recovery_thread(void *arg)
 		ptlrpc_update_export_timer(req->rq_export, 0);
 		target_request_copy_put(req);
 	}
+	target_recovery_phase_next(obd, OBD_RECOVERY_PHASE_MAX);
 
 	delta = jiffies_to_msecs(jiffies - delta) / MSEC_PER_SEC;
 	CDEBUG(D_INFO,"4: recovery completed in %lus - %d/%d reqs/locks\n",
@@ -2832,31 +2950,31 @@ int target_queue_recovery_request(struct ptlrpc_request *req,
                 RETURN(0);
         }
 
-	/* XXX O(n^2) */
+	/* Search from the tail: each client sends its replays in transno
+	 * order, so new requests usually belong at or near the end. */
 	spin_lock(&obd->obd_recovery_task_lock);
 	LASSERT(obd->obd_recovering);
-	list_for_each_entry(reqiter, &obd->obd_req_replay_queue, rq_list) {
-		if (lustre_msg_get_transno(reqiter->rq_reqmsg) > transno) {
-			list_add_tail(&req->rq_list, &reqiter->rq_list);
+	list_for_each_entry_reverse(reqiter, &obd->obd_req_replay_queue,
+				    rq_list) {
+		if (lustre_msg_get_transno(reqiter->rq_reqmsg) < transno) {
+			target_replay_queue_add(obd, req, &reqiter->rq_list);
 			inserted = 1;
-			goto added;
+			break;
 		}
 
-                if (unlikely(lustre_msg_get_transno(reqiter->rq_reqmsg) ==
-                             transno)) {
-                        DEBUG_REQ(D_ERROR, req, "dropping replay: transno "
-                                  "has been claimed by another client");
+		if (unlikely(lustre_msg_get_transno(reqiter->rq_reqmsg) ==
+			     transno)) {
+			DEBUG_REQ(D_ERROR, req, "dropping replay: transno "
+				  "has been claimed by another client");
+			req->rq_export->exp_replay_dropped = 1;
 			spin_unlock(&obd->obd_recovery_task_lock);
-                        target_exp_dequeue_req_replay(req);
-                        target_request_copy_put(req);
-                        RETURN(0);
-                }
-        }
-added:
-        if (!inserted)
-		list_add_tail(&req->rq_list, &obd->obd_req_replay_queue);
-
-        obd->obd_requests_queued_for_recovery++;
+			target_exp_dequeue_req_replay(req);
+			target_request_copy_put(req);
+			RETURN(0);
+		}
+	}
+	if (!inserted)
+		target_replay_queue_add(obd, req, &obd->obd_req_replay_queue);
 	spin_unlock(&obd->obd_recovery_task_lock);
 	wake_up(&obd->obd_next_transno_waitq);
 	RETURN(0);
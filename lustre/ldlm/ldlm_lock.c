@@ -215,7 +215,8 @@ void ldlm_lock_put(struct ldlm_lock *lock)
                 if (lock->l_lvb_data != NULL)
                         OBD_FREE_LARGE(lock->l_lvb_data, lock->l_lvb_len);
 
-                ldlm_interval_free(ldlm_interval_detach(lock));
+		ldlm_interval_detach(lock);
+		LASSERT(!interval_is_intree(&lock->l_interval.li_node));
                 lu_ref_fini(&lock->l_reference);
 		OBD_FREE_RCU(lock, sizeof(*lock), &lock->l_handle);
         }
@@ -226,11 +227,12 @@ EXPORT_SYMBOL(ldlm_lock_put);
 
 /**
  * Removes LDLM lock \a lock from LRU. Assumes LRU is already locked.
+ * A lock on a pending list is left there, see ldlm_lru_pending_del().
  */
 int ldlm_lock_remove_from_lru_nolock(struct ldlm_lock *lock)
 {
 	int rc = 0;
-	if (!list_empty(&lock->l_lru)) {
+	if (!list_empty(&lock->l_lru) && !lock->l_lru_pending) {
 		struct ldlm_namespace *ns = ldlm_lock_to_ns(lock);
 
 		LASSERT(lock->l_resource->lr_type != LDLM_FLOCK);
@@ -239,13 +241,45 @@ int ldlm_lock_remove_from_lru_nolock(struct ldlm_lock *lock)
 		list_del_init(&lock->l_lru);
 		LASSERT(ns->ns_nr_unused > 0);
 		ns->ns_nr_unused--;
+		if (lock->l_lru_protected) {
+			LASSERT(ns->ns_nr_protected > 0);
+			ns->ns_nr_protected--;
+			lock->l_lru_protected = 0;
+		}
+		rc = 1;
+	}
+	return rc;
+}
+
+/**
+ * Takes LDLM lock \a lock off the pending list it was released to.
+ * Must be called under the resource lock.
+ *
+ * \retval 1 the lock was on a pending list and removed.
+ * \retval 0 it was not, or has just been put into the LRU by a flush.
+ */
+static int ldlm_lru_pending_del(struct ldlm_lock *lock)
+{
+	struct ldlm_namespace *ns = ldlm_lock_to_ns(lock);
+	struct ldlm_lru_pending *lp = ns->ns_lru_pending[lock->l_lru_cpt];
+	int rc = 0;
+
+	spin_lock(&lp->lp_lock);
+	if (lock->l_lru_pending) {
+		list_del_init(&lock->l_lru);
+		lock->l_lru_pending = 0;
+		lp->lp_count--;
 		rc = 1;
 	}
+	spin_unlock(&lp->lp_lock);
+
 	return rc;
 }
 
 /**
- * Removes LDLM lock \a lock from LRU. Obtains the LRU lock first.
+ * Removes LDLM lock \a lock from LRU, or from the pending list it was
+ * released to. Obtains the LRU lock first. Must be called under the
+ * resource lock.
  *
  * If \a last_use is non-zero, it will remove the lock from LRU only if
  * it matches lock's l_last_used.
@@ -266,6 +300,14 @@ int ldlm_lock_remove_from_lru_check(struct ldlm_lock *lock, ktime_t last_use)
 		RETURN(0);
 	}
 
+	if (lock->l_lru_pending) {
+		/* released again since \a last_use was taken from the LRU */
+		if (ktime_compare(last_use, ktime_set(0, 0)))
+			RETURN(0);
+		if (ldlm_lru_pending_del(lock))
+			RETURN(1);
+	}
+
 	spin_lock(&ns->ns_lock);
 	if (!ktime_compare(last_use, ktime_set(0, 0)) ||
 	    !ktime_compare(last_use, lock->l_last_used))
@@ -276,43 +318,155 @@ int ldlm_lock_remove_from_lru_check(struct ldlm_lock *lock, ktime_t last_use)
 }
 
 /**
- * Adds LDLM lock \a lock to namespace LRU. Assumes LRU is already locked.
+ * Moves LDLM lock \a lock to the tail of the protected LRU list if
+ * \a to_protected is set, to the tail of the probation list otherwise.
+ * Assumes LRU is already locked.
  */
-void ldlm_lock_add_to_lru_nolock(struct ldlm_lock *lock)
+void ldlm_lock_move_in_lru_nolock(struct ldlm_lock *lock, bool to_protected)
 {
 	struct ldlm_namespace *ns = ldlm_lock_to_ns(lock);
 
-	lock->l_last_used = ktime_get();
+	LASSERT(!list_empty(&lock->l_lru));
+	if (ns->ns_last_pos == &lock->l_lru)
+		ns->ns_last_pos = lock->l_lru.prev;
+
+	if (lock->l_lru_protected != to_protected) {
+		if (to_protected)
+			ns->ns_nr_protected++;
+		else
+			ns->ns_nr_protected--;
+		lock->l_lru_protected = to_protected;
+	}
+	if (to_protected)
+		list_move_tail(&lock->l_lru, &ns->ns_protected_list);
+	else
+		list_move_tail(&lock->l_lru, &ns->ns_unused_list);
+}
+
+/**
+ * Puts LDLM lock \a lock at the tail of the namespace LRU without touching
+ * l_last_used. A lock reused often enough while cached goes to the
+ * protected list directly. Assumes LRU is already locked.
+ */
+static void ldlm_lock_lru_insert_nolock(struct ldlm_lock *lock)
+{
+	struct ldlm_namespace *ns = ldlm_lock_to_ns(lock);
+	bool to_protected = ldlm_lock_lru_protect(lock);
+
 	LASSERT(list_empty(&lock->l_lru));
 	LASSERT(lock->l_resource->lr_type != LDLM_FLOCK);
-	list_add_tail(&lock->l_lru, &ns->ns_unused_list);
+	lock->l_lru_hit = 0;
+	lock->l_lru_protected = to_protected;
+	if (to_protected) {
+		list_add_tail(&lock->l_lru, &ns->ns_protected_list);
+		ns->ns_nr_protected++;
+	} else {
+		list_add_tail(&lock->l_lru, &ns->ns_unused_list);
+	}
 	LASSERT(ns->ns_nr_unused >= 0);
 	ns->ns_nr_unused++;
+	lprocfs_counter_incr(ns->ns_stats, LDLM_NSS_LRU_INSERTS);
+}
+
+/**
+ * Puts the locks released to pending list \a lp into the LRU of \a ns,
+ * taking ns_lock once for all of them.
+ */
+static void ldlm_lru_pending_flush_one(struct ldlm_namespace *ns,
+				       struct ldlm_lru_pending *lp)
+{
+	struct ldlm_lock *lock;
+	struct ldlm_lock *next;
+
+	spin_lock(&lp->lp_lock);
+	spin_lock(&ns->ns_lock);
+	list_for_each_entry_safe(lock, next, &lp->lp_list, l_lru) {
+		list_del_init(&lock->l_lru);
+		lock->l_lru_pending = 0;
+		ldlm_lock_lru_insert_nolock(lock);
+	}
+	lp->lp_count = 0;
+	spin_unlock(&ns->ns_lock);
+	spin_unlock(&lp->lp_lock);
+}
+
+/**
+ * Puts all the released locks of namespace \a ns into its LRU, so that
+ * they are counted in ns_nr_unused and seen by the LRU scan.
+ */
+void ldlm_lru_pending_flush(struct ldlm_namespace *ns)
+{
+	struct ldlm_lru_pending *lp;
+	int i;
+
+	cfs_percpt_for_each(lp, i, ns->ns_lru_pending) {
+		/* racy check, a lock released meanwhile waits for the next */
+		if (lp->lp_count > 0)
+			ldlm_lru_pending_flush_one(ns, lp);
+	}
 }
 
 /**
- * Adds LDLM lock \a lock to namespace LRU. Obtains necessary LRU locks
- * first.
+ * Adds LDLM lock \a lock to namespace LRU. The lock is put on the pending
+ * list of the current CPT first, and LDLM_LRU_PENDING_BATCH locks released
+ * there are moved to the LRU at once, so the last decref does not take
+ * ns_lock, and a lock reused before the flush does not take it at all.
+ * Must be called under the resource lock.
  */
 void ldlm_lock_add_to_lru(struct ldlm_lock *lock)
 {
 	struct ldlm_namespace *ns = ldlm_lock_to_ns(lock);
+	struct ldlm_lru_pending *lp;
+	bool flush;
+	int cpt;
 
 	ENTRY;
-	spin_lock(&ns->ns_lock);
-	ldlm_lock_add_to_lru_nolock(lock);
-	spin_unlock(&ns->ns_lock);
+	LASSERT(list_empty(&lock->l_lru));
+	LASSERT(lock->l_resource->lr_type != LDLM_FLOCK);
+
+	cpt = cfs_cpt_current(cfs_cpt_tab, 1);
+	lp = ns->ns_lru_pending[cpt];
+	lock->l_last_used = ktime_get();
+
+	spin_lock(&lp->lp_lock);
+	lock->l_lru_cpt = cpt;
+	lock->l_lru_pending = 1;
+	list_add_tail(&lock->l_lru, &lp->lp_list);
+	flush = ++lp->lp_count >= LDLM_LRU_PENDING_BATCH;
+	spin_unlock(&lp->lp_lock);
+
+	if (flush)
+		ldlm_lru_pending_flush_one(ns, lp);
 	EXIT;
 }
 
 /**
- * Moves LDLM lock \a lock that is already in namespace LRU to the tail of
- * the LRU. Performs necessary LRU locking
+ * Marks LDLM lock \a lock as used again if it is in the namespace LRU or
+ * on a pending list, and counts the reuse towards the protected list.
+ * Must be called under the resource lock.
  */
-void ldlm_lock_touch_in_lru(struct ldlm_lock *lock)
+static void ldlm_lock_lru_hit(struct ldlm_lock *lock)
 {
 	struct ldlm_namespace *ns = ldlm_lock_to_ns(lock);
 
+	if (list_empty(&lock->l_lru))
+		return;
+
+	lock->l_lru_hit = 1;
+	if (lock->l_lru_reuse < LDLM_LRU_PROTECT_REUSE)
+		lock->l_lru_reuse++;
+	lprocfs_counter_incr(ns->ns_stats, lock->l_lru_protected ?
+					   LDLM_NSS_LRU_HITS_PROTECTED :
+					   LDLM_NSS_LRU_HITS_PROBATION);
+}
+
+/**
+ * Moves LDLM lock \a lock that is already in namespace LRU to the tail of
+ * the LRU. The move itself is done by the next LRU scan, this only marks
+ * the lock as used and does not take ns_lock.
+ */
+void ldlm_lock_touch_in_lru(struct ldlm_lock *lock)
+{
 	ENTRY;
 	if (ldlm_is_ns_srv(lock)) {
 		LASSERT(list_empty(&lock->l_lru));
@@ -320,12 +474,10 @@ void ldlm_lock_touch_in_lru(struct ldlm_lock *lock)
 		return;
 	}
 
-	spin_lock(&ns->ns_lock);
 	if (!list_empty(&lock->l_lru)) {
-		ldlm_lock_remove_from_lru_nolock(lock);
-		ldlm_lock_add_to_lru_nolock(lock);
+		lock->l_last_used = ktime_get();
+		ldlm_lock_lru_hit(lock);
 	}
-	spin_unlock(&ns->ns_lock);
 	EXIT;
 }
 
@@ -469,12 +621,14 @@ static struct ldlm_lock *ldlm_lock_new(struct ldlm_resource *resource)
 	INIT_LIST_HEAD(&lock->l_bl_ast);
 	INIT_LIST_HEAD(&lock->l_cp_ast);
 	INIT_LIST_HEAD(&lock->l_rk_ast);
+	INIT_LIST_HEAD(&lock->l_reclaim);
 	init_waitqueue_head(&lock->l_waitq);
 	lock->l_blocking_lock = NULL;
 	INIT_LIST_HEAD(&lock->l_sl_mode);
 	INIT_LIST_HEAD(&lock->l_sl_policy);
 	INIT_HLIST_NODE(&lock->l_exp_hash);
-	INIT_HLIST_NODE(&lock->l_exp_flock_hash);
+	INIT_HLIST_NODE(&lock->l_flock_wait_hash);
+	INIT_HLIST_NODE(&lock->l_flock_owner_hash);
 
         lprocfs_counter_incr(ldlm_res_to_ns(resource)->ns_stats,
                              LDLM_NSS_LOCKS);
@@ -726,13 +880,16 @@ EXPORT_SYMBOL(ldlm_lock_addref);
  * Helper function.
  * Add specified reader/writer reference to LDLM lock \a lock.
  * r/w reference type is determined by \a mode
- * Removes lock from LRU if it is there.
+ * Removes lock from LRU if it is there. The reuse of a cached lock is
+ * counted, so that the last decref puts a lock reused often enough into
+ * the protected LRU list.
  * Assumes the LDLM lock is already locked.
  */
 void ldlm_lock_addref_internal_nolock(struct ldlm_lock *lock,
 				      enum ldlm_mode mode)
 {
-        ldlm_lock_remove_from_lru(lock);
+	ldlm_lock_lru_hit(lock);
+	ldlm_lock_remove_from_lru(lock);
         if (mode & (LCK_NL | LCK_CR | LCK_PR)) {
                 lock->l_readers++;
                 lu_ref_add_atomic(&lock->l_reference, "reader", lock);
@@ -1066,6 +1223,9 @@ static void ldlm_granted_list_add_lock(struct ldlm_lock *lock,
 	if (&lock->l_sl_policy != prev->policy_link)
 		list_add(&lock->l_sl_policy, prev->policy_link);
 
+	if (res->lr_type == LDLM_IBITS)
+		ldlm_inodebits_add_lock(res, lock);
+
         EXIT;
 }
 
@@ -1121,7 +1281,7 @@ void ldlm_grant_lock(struct ldlm_lock *lock, struct list_head *work_list)
 		    ldlm_is_test_lock(lock) ||
 		    ldlm_is_flock_deadlock(lock))
 			RETURN_EXIT;
-		ldlm_resource_add_lock(res, &res->lr_granted, lock);
+		ldlm_flock_add_lock(res, &res->lr_granted, lock);
 	} else {
 		LBUG();
 	}
@@ -1666,10 +1826,9 @@ struct ldlm_lock *ldlm_lock_create(struct ldlm_namespace *ns,
 	}
 
 	lock->l_tree_node = NULL;
-	/* if this is the extent lock, allocate the interval tree node */
-	if (type == LDLM_EXTENT)
-		if (ldlm_interval_alloc(lock) == NULL)
-			GOTO(out, rc = -ENOMEM);
+	/* if this is the extent or flock lock, set up the interval tree node */
+	if (type == LDLM_EXTENT || type == LDLM_FLOCK)
+		ldlm_interval_init(lock);
 
 	if (lvb_len) {
 		lock->l_lvb_len = lvb_len;
@@ -1735,7 +1894,6 @@ enum ldlm_error ldlm_lock_enqueue(struct ldlm_namespace *ns,
 	struct ldlm_resource *res = lock->l_resource;
 	int local = ns_is_client(ldlm_res_to_ns(res));
 	enum ldlm_error rc = ELDLM_OK;
-	struct ldlm_interval *node = NULL;
 	ENTRY;
 
         /* policies are not executed on the client or during replay */
@@ -1784,13 +1942,6 @@ enum ldlm_error ldlm_lock_enqueue(struct ldlm_namespace *ns,
 		RETURN(ELDLM_OK);
 	}
 
-	/* For a replaying lock, it might be already in granted list. So
-	 * unlinking the lock will cause the interval node to be freed, we
-	 * have to allocate the interval node early otherwise we can't regrant
-	 * this lock in the future. - jay */
-	if (!local && (*flags & LDLM_FL_REPLAY) && res->lr_type == LDLM_EXTENT)
-		OBD_SLAB_ALLOC_PTR_GFP(node, ldlm_interval_slab, GFP_NOFS);
-
         lock_res_and_lock(lock);
         if (local && lock->l_req_mode == lock->l_granted_mode) {
                 /* The server returned a blocked lock, but it was granted
@@ -1800,17 +1951,13 @@ enum ldlm_error ldlm_lock_enqueue(struct ldlm_namespace *ns,
 		GOTO(out, rc = ELDLM_OK);
         }
 
-        ldlm_resource_unlink_lock(lock);
-        if (res->lr_type == LDLM_EXTENT && lock->l_tree_node == NULL) {
-                if (node == NULL) {
-                        ldlm_lock_destroy_nolock(lock);
-                        GOTO(out, rc = -ENOMEM);
-                }
-
-		INIT_LIST_HEAD(&node->li_group);
-                ldlm_interval_attach(node, lock);
-                node = NULL;
-        }
+	/* For a replaying lock, it might be already in granted list, and
+	 * unlinking it detaches the lock from the interval tree node. Set the
+	 * embedded node up again so that the lock can be regranted. */
+	ldlm_resource_unlink_lock(lock);
+	if ((res->lr_type == LDLM_EXTENT || res->lr_type == LDLM_FLOCK) &&
+	    lock->l_tree_node == NULL)
+		ldlm_interval_init(lock);
 
 	/* Some flags from the enqueue want to make it into the AST, via the
 	 * lock's l_flags. */
@@ -1863,10 +2010,8 @@ enum ldlm_error ldlm_lock_enqueue(struct ldlm_namespace *ns,
 #endif
 
 out:
-        unlock_res_and_lock(lock);
-        if (node)
-                OBD_SLAB_FREE(node, ldlm_interval_slab, sizeof(*node));
-        return rc;
+	unlock_res_and_lock(lock);
+	return rc;
 }
 
 #ifdef HAVE_SERVER_SUPPORT
@@ -2037,22 +2182,15 @@ void ldlm_discard_bl_list(struct list_head *bl_list)
 #endif
 
 /**
- * Process a call to blocking AST callback for a lock in ast_work list
+ * Call the blocking AST callback for \a lock, the first lock in ast_work list
  */
-static int
-ldlm_work_bl_ast_lock(struct ptlrpc_request_set *rqset, void *opaq)
+static int ldlm_work_bl_ast_one(struct ldlm_cb_set_arg *arg,
+				struct ldlm_lock *lock)
 {
-	struct ldlm_cb_set_arg *arg = opaq;
 	struct ldlm_lock_desc   d;
 	int                     rc;
-	struct ldlm_lock       *lock;
 	ENTRY;
 
-	if (list_empty(arg->list))
-		RETURN(-ENOENT);
-
-	lock = list_entry(arg->list->next, struct ldlm_lock, l_bl_ast);
-
 	/* nobody should touch l_bl_ast */
 	lock_res_and_lock(lock);
 	list_del_init(&lock->l_bl_ast);
@@ -2063,6 +2201,8 @@ ldlm_work_bl_ast_lock(struct ptlrpc_request_set *rqset, void *opaq)
 	lock->l_bl_ast_run++;
 	unlock_res_and_lock(lock);
 
+	/* zeroed, so that batched blocking ASTs can compare descriptors */
+	memset(&d, 0, sizeof(d));
 	ldlm_lock2desc(lock->l_blocking_lock, &d);
 	/* copy blocking lock ibits in cancel_bits as well,
 	 * new client may use them for lock convert and it is
@@ -2080,6 +2220,43 @@ ldlm_work_bl_ast_lock(struct ptlrpc_request_set *rqset, void *opaq)
 	RETURN(rc);
 }
 
+/**
+ * Process a call to blocking AST callback for a lock in ast_work list
+ *
+ * When blocking ASTs are batched, all following locks of the same export
+ * are processed as well, so that each call produces one RPC per client.
+ */
+static int
+ldlm_work_bl_ast_lock(struct ptlrpc_request_set *rqset, void *opaq)
+{
+	struct ldlm_cb_set_arg *arg = opaq;
+	struct ldlm_lock       *lock;
+	int                     rc;
+	ENTRY;
+
+	if (list_empty(arg->list))
+		RETURN(-ENOENT);
+
+	lock = list_entry(arg->list->next, struct ldlm_lock, l_bl_ast);
+	rc = ldlm_work_bl_ast_one(arg, lock);
+
+#ifdef HAVE_SERVER_SUPPORT
+	if (arg->bl_batch != NULL) {
+		struct ldlm_bl_ast_batch *batch = arg->bl_batch;
+
+		while (batch->bab_req != NULL && !list_empty(arg->list)) {
+			lock = list_entry(arg->list->next, struct ldlm_lock,
+					  l_bl_ast);
+			if (lock->l_export != batch->bab_exp)
+				break;
+			rc = ldlm_work_bl_ast_one(arg, lock);
+		}
+		ldlm_bl_ast_batch_flush(arg);
+	}
+#endif
+	RETURN(rc);
+}
+
 /**
  * Process a call to completion AST callback for a lock in ast_work list
  */
@@ -2192,11 +2369,60 @@ int ldlm_work_gl_ast_lock(struct ptlrpc_request_set *rqset, void *opaq)
 	RETURN(rc);
 }
 
+#ifdef HAVE_SERVER_SUPPORT
+#define LDLM_BL_AST_GROUP_BITS	6
+
+/**
+ * Reorder the blocking AST list so that the locks of each export are next to
+ * each other, which lets ldlm_work_bl_ast_lock() batch them. Locks are
+ * spread over hash chains by export first, so this is linear unless many
+ * exports hash to the same chain.
+ */
+static void ldlm_bl_ast_group(struct list_head *rpc_list)
+{
+	struct list_head *chains;
+	struct ldlm_lock *lock;
+	struct ldlm_lock *next;
+	int i;
+
+	/* without memory the locks are just batched less */
+	OBD_ALLOC(chains, sizeof(*chains) << LDLM_BL_AST_GROUP_BITS);
+	if (chains == NULL)
+		return;
+
+	for (i = 0; i < 1 << LDLM_BL_AST_GROUP_BITS; i++)
+		INIT_LIST_HEAD(&chains[i]);
+
+	list_for_each_entry_safe(lock, next, rpc_list, l_bl_ast)
+		list_move_tail(&lock->l_bl_ast,
+			       &chains[hash_ptr(lock->l_export,
+						LDLM_BL_AST_GROUP_BITS)]);
+
+	for (i = 0; i < 1 << LDLM_BL_AST_GROUP_BITS; i++) {
+		while (!list_empty(&chains[i])) {
+			struct obd_export *exp;
+
+			exp = list_entry(chains[i].next, struct ldlm_lock,
+					 l_bl_ast)->l_export;
+			list_for_each_entry_safe(lock, next, &chains[i],
+						 l_bl_ast) {
+				if (lock->l_export == exp)
+					list_move_tail(&lock->l_bl_ast,
+						       rpc_list);
+			}
+		}
+	}
+
+	OBD_FREE(chains, sizeof(*chains) << LDLM_BL_AST_GROUP_BITS);
+}
+#endif /* HAVE_SERVER_SUPPORT */
+
 /**
  * Process list of locks in need of ASTs being sent.
  *
  * Used on server to send multiple ASTs together instead of sending one by
- * one.
+ * one. Blocking ASTs for clients supporting OBD_CONNECT2_BATCH_AST are also
+ * coalesced into one RPC per client.
  */
 int ldlm_run_ast_work(struct ldlm_namespace *ns, struct list_head *rpc_list,
                       ldlm_desc_ast_t ast_type)
@@ -2236,6 +2462,19 @@ int ldlm_run_ast_work(struct ldlm_namespace *ns, struct list_head *rpc_list,
 			LBUG();
 	}
 
+#ifdef HAVE_SERVER_SUPPORT
+	if (ast_type == LDLM_WORK_BL_AST && ns_is_server(ns) &&
+	    ns->ns_max_ast_batch > 1 && !list_is_singular(rpc_list)) {
+		OBD_ALLOC_PTR(arg->bl_batch);
+		if (arg->bl_batch != NULL) {
+			arg->bl_batch->bab_max = min_t(unsigned int,
+						       ns->ns_max_ast_batch,
+						       LDLM_MAX_AST_BATCH);
+			ldlm_bl_ast_group(rpc_list);
+		}
+	}
+#endif
+
 	/* We create a ptlrpc request set with flow control extension.
 	 * This request set will use the work_ast_lock function to produce new
 	 * requests and will send a new request each time one completes in order
@@ -2251,6 +2490,12 @@ int ldlm_run_ast_work(struct ldlm_namespace *ns, struct list_head *rpc_list,
 	rc = atomic_read(&arg->restart) ? -ERESTART : 0;
 	GOTO(out, rc);
 out:
+#ifdef HAVE_SERVER_SUPPORT
+	if (arg->bl_batch != NULL) {
+		LASSERT(arg->bl_batch->bab_req == NULL);
+		OBD_FREE_PTR(arg->bl_batch);
+	}
+#endif
 	OBD_FREE_PTR(arg);
 	return rc;
 }
@@ -2382,6 +2627,9 @@ void ldlm_unlink_lock_skiplist(struct ldlm_lock *req)
             req->l_resource->lr_type != LDLM_IBITS)
                 return;
 
+	if (req->l_resource->lr_type == LDLM_IBITS)
+		ldlm_inodebits_unlink_lock(req);
+
 	list_del_init(&req->l_sl_policy);
 	list_del_init(&req->l_sl_mode);
 }
@@ -702,6 +702,58 @@ static int ldlm_handle_ast_error(struct ldlm_lock *lock,
 	return rc;
 }
 
+/**
+ * Process the reply to a batched blocking AST.
+ *
+ * The reply carries the handles of the locks the client did not find, these
+ * are handled as if the client replied -EINVAL for each of them.
+ */
+static int ldlm_cb_batch_interpret(struct ptlrpc_request *req,
+				   struct ldlm_cb_async_args *ca, int rc)
+{
+	struct ldlm_request *stale = NULL;
+	int restart = 0;
+	int i, j;
+
+	if (rc == 0 && req->rq_repmsg != NULL &&
+	    req_capsule_field_present(&req->rq_pill, &RMF_DLM_REQ,
+				      RCL_SERVER)) {
+		stale = req_capsule_server_get(&req->rq_pill, &RMF_DLM_REQ);
+		if (stale != NULL &&
+		    req_capsule_get_size(&req->rq_pill, &RMF_DLM_REQ,
+					 RCL_SERVER) <
+		    ldlm_request_bufsize(stale->lock_count, LDLM_BL_CALLBACK)) {
+			DEBUG_REQ(D_ERROR, req, "bad stale lock count %u",
+				  stale->lock_count);
+			stale = NULL;
+		}
+	}
+
+	for (i = 0; i < ca->ca_count; i++) {
+		struct ldlm_lock *lock = ca->ca_locks[i];
+		int lock_rc = rc;
+
+		for (j = 0; stale != NULL && j < stale->lock_count; j++) {
+			if (stale->lock_handle[j].cookie ==
+			    lock->l_remote_handle.cookie) {
+				lock_rc = -EINVAL;
+				break;
+			}
+		}
+		if (lock_rc != 0)
+			lock_rc = ldlm_handle_ast_error(lock, req, lock_rc,
+							"blocking");
+		if (lock_rc == -ERESTART)
+			restart = 1;
+
+		/* release extra reference taken in ldlm_bl_ast_batch_add() */
+		LDLM_LOCK_RELEASE(lock);
+	}
+	OBD_FREE(ca->ca_locks, ca->ca_size * sizeof(*ca->ca_locks));
+
+	return restart ? -ERESTART : 0;
+}
+
 static int ldlm_cb_interpret(const struct lu_env *env,
                              struct ptlrpc_request *req, void *data, int rc)
 {
@@ -712,6 +764,12 @@ static int ldlm_cb_interpret(const struct lu_env *env,
 
         LASSERT(lock != NULL);
 
+	if (ca->ca_locks != NULL) {
+		if (ldlm_cb_batch_interpret(req, ca, rc) == -ERESTART)
+			atomic_inc(&arg->restart);
+		RETURN(0);
+	}
+
 	switch (arg->type) {
 	case LDLM_GL_CALLBACK:
 		/* Update the LVB from disk if the AST failed
@@ -761,8 +819,17 @@ static void ldlm_update_resend(struct ptlrpc_request *req, void *data)
 {
 	struct ldlm_cb_async_args *ca = data;
 	struct ldlm_lock *lock = ca->ca_lock;
+	int i;
+
+	if (ca->ca_locks == NULL) {
+		ldlm_refresh_waiting_lock(lock, ldlm_bl_timeout(lock));
+		return;
+	}
 
-	ldlm_refresh_waiting_lock(lock, ldlm_bl_timeout(lock));
+	for (i = 0; i < ca->ca_count; i++) {
+		lock = ca->ca_locks[i];
+		ldlm_refresh_waiting_lock(lock, ldlm_bl_timeout(lock));
+	}
 }
 
 static inline int ldlm_ast_fini(struct ptlrpc_request *req,
@@ -818,12 +885,207 @@ static void ldlm_lock_reorder_req(struct ldlm_lock *lock)
 	EXIT;
 }
 
+/**
+ * Check if a blocking AST is still needed for \a lock.
+ *
+ * Must be called under the resource lock.
+ *
+ * \retval true	the lock was destroyed or is not granted yet, in which
+ *			case the blocking AST is sent with the completion AST
+ * \retval false	the blocking AST has to be sent
+ */
+static bool ldlm_bl_ast_skip(struct ldlm_lock *lock)
+{
+	if (ldlm_is_destroyed(lock))
+		/* What's the point? */
+		return true;
+
+	if (lock->l_granted_mode != lock->l_req_mode) {
+		/* this blocking AST will be communicated as part of the
+		 * completion AST instead */
+		ldlm_add_blocked_lock(lock);
+		ldlm_set_waited(lock);
+		LDLM_DEBUG(lock, "lock not granted, not sending blocking AST");
+		return true;
+	}
+
+	return false;
+}
+
+/**
+ * Start a new batched blocking AST for the export of \a lock.
+ *
+ * The request is allocated for the largest batch up front so that adding a
+ * lock, after which the lock waits for the client to cancel it, cannot fail.
+ */
+static int ldlm_bl_ast_batch_start(struct ldlm_bl_ast_batch *batch,
+				   struct ldlm_lock *lock,
+				   struct ldlm_lock_desc *desc)
+{
+	struct ptlrpc_request *req;
+	int rc;
+	ENTRY;
+
+	OBD_ALLOC(batch->bab_locks, batch->bab_max * sizeof(*batch->bab_locks));
+	if (batch->bab_locks == NULL)
+		RETURN(-ENOMEM);
+
+	req = ptlrpc_request_alloc(lock->l_export->exp_imp_reverse,
+				   &RQF_LDLM_BL_CALLBACK_BATCH);
+	if (req == NULL)
+		GOTO(out_free, rc = -ENOMEM);
+
+	req_capsule_set_size(&req->rq_pill, &RMF_DLM_REQ, RCL_CLIENT,
+			     ldlm_request_bufsize(batch->bab_max,
+						  LDLM_BL_CALLBACK));
+	rc = ptlrpc_request_pack(req, LUSTRE_DLM_VERSION, LDLM_BL_CALLBACK);
+	if (rc != 0) {
+		ptlrpc_request_free(req);
+		GOTO(out_free, rc);
+	}
+
+	batch->bab_req = req;
+	batch->bab_exp = lock->l_export;
+	batch->bab_flags = lock->l_flags & LDLM_FL_AST_MASK;
+	batch->bab_desc = *desc;
+	batch->bab_count = 0;
+
+	RETURN(0);
+out_free:
+	OBD_FREE(batch->bab_locks, batch->bab_max * sizeof(*batch->bab_locks));
+	batch->bab_locks = NULL;
+	return rc;
+}
+
+/**
+ * Send the blocking AST collected in \a arg->bl_batch, if any.
+ *
+ * Called when the batch is full, when the next lock needs a different
+ * export or descriptor, and by ldlm_work_bl_ast_lock() once it is done with
+ * an export.
+ */
+int ldlm_bl_ast_batch_flush(struct ldlm_cb_set_arg *arg)
+{
+	struct ldlm_bl_ast_batch *batch = arg->bl_batch;
+	struct ptlrpc_request *req = batch->bab_req;
+	struct obd_export *exp = batch->bab_exp;
+	struct ldlm_cb_async_args *ca;
+	struct ldlm_request *body;
+	int size;
+	int i;
+	ENTRY;
+
+	if (req == NULL)
+		RETURN(0);
+
+	batch->bab_req = NULL;
+	batch->bab_exp = NULL;
+
+	if (batch->bab_count == 0) {
+		/* all locks went away meanwhile */
+		ptlrpc_req_finished(req);
+		OBD_FREE(batch->bab_locks,
+			 batch->bab_max * sizeof(*batch->bab_locks));
+		batch->bab_locks = NULL;
+		RETURN(0);
+	}
+
+	body = req_capsule_client_get(&req->rq_pill, &RMF_DLM_REQ);
+	body->lock_desc = batch->bab_desc;
+	body->lock_flags = ldlm_flags_to_wire(batch->bab_flags);
+	body->lock_count = batch->bab_count;
+	for (i = 0; i < batch->bab_count; i++)
+		body->lock_handle[i] = batch->bab_locks[i]->l_remote_handle;
+
+	size = ldlm_request_bufsize(batch->bab_count, LDLM_BL_CALLBACK);
+	req_capsule_shrink(&req->rq_pill, &RMF_DLM_REQ, size, RCL_CLIENT);
+	req_capsule_set_size(&req->rq_pill, &RMF_DLM_REQ, RCL_SERVER, size);
+	ptlrpc_request_set_replen(req);
+
+	CLASSERT(sizeof(*ca) <= sizeof(req->rq_async_args));
+	ca = ptlrpc_req_async_args(req);
+	ca->ca_set_arg = arg;
+	ca->ca_lock = batch->bab_locks[0];
+	ca->ca_locks = batch->bab_locks;
+	ca->ca_count = batch->bab_count;
+	ca->ca_size = batch->bab_max;
+	batch->bab_locks = NULL;
+	batch->bab_count = 0;
+
+	req->rq_interpret_reply = ldlm_cb_interpret;
+	/* Do not resend after lock callback timeout */
+	req->rq_delay_limit = ldlm_bl_timeout(ca->ca_lock);
+	req->rq_resend_cb = ldlm_update_resend;
+	req->rq_send_state = LUSTRE_IMP_FULL;
+	/* ptlrpc_request_pack already set timeout */
+	if (AT_OFF)
+		req->rq_timeout = ldlm_get_rq_timeout();
+
+	if (exp->exp_nid_stats && exp->exp_nid_stats->nid_ldlm_stats)
+		lprocfs_counter_incr(exp->exp_nid_stats->nid_ldlm_stats,
+				     LDLM_BL_CALLBACK - LDLM_FIRST_OPC);
+
+	CDEBUG(D_DLMTRACE, "%s: blocking AST for %d locks to %s\n",
+	       exp->exp_obd->obd_name, ca->ca_count,
+	       obd_export_nid2str(exp));
+
+	ptlrpc_set_add_req(arg->set, req);
+
+	RETURN(0);
+}
+
+/**
+ * Add \a lock to the batched blocking AST of \a arg, starting a new one if
+ * the lock does not fit into the current batch.
+ */
+static int ldlm_bl_ast_batch_add(struct ldlm_lock *lock,
+				 struct ldlm_lock_desc *desc,
+				 struct ldlm_cb_set_arg *arg)
+{
+	struct ldlm_bl_ast_batch *batch = arg->bl_batch;
+	int rc = 0;
+	ENTRY;
+
+	if (batch->bab_req != NULL &&
+	    (batch->bab_exp != lock->l_export ||
+	     batch->bab_flags != (lock->l_flags & LDLM_FL_AST_MASK) ||
+	     memcmp(&batch->bab_desc, desc, sizeof(*desc)) != 0))
+		ldlm_bl_ast_batch_flush(arg);
+
+	if (batch->bab_req == NULL) {
+		rc = ldlm_bl_ast_batch_start(batch, lock, desc);
+		if (rc != 0)
+			RETURN(rc);
+	}
+
+	lock_res_and_lock(lock);
+	if (ldlm_bl_ast_skip(lock)) {
+		unlock_res_and_lock(lock);
+		RETURN(0);
+	}
+
+	LDLM_DEBUG(lock, "server adding lock to batched blocking AST");
+
+	ldlm_set_cbpending(lock);
+	LASSERT(lock->l_granted_mode == lock->l_req_mode);
+	ldlm_add_waiting_lock(lock, ldlm_bl_timeout(lock));
+	unlock_res_and_lock(lock);
+
+	LDLM_LOCK_GET(lock);
+	batch->bab_locks[batch->bab_count++] = lock;
+	if (batch->bab_count == batch->bab_max)
+		rc = ldlm_bl_ast_batch_flush(arg);
+
+	RETURN(rc);
+}
+
 /**
  * ->l_blocking_ast() method for server-side locks. This is invoked when newly
  * enqueued server lock conflicts with given one.
  *
  * Sends blocking AST RPC to the client owning that lock; arms timeout timer
- * to wait for client response.
+ * to wait for client response. If the client supports it, blocking ASTs for
+ * several of its locks are sent in one RPC, see ldlm_bl_ast_batch_add().
  */
 int ldlm_server_blocking_ast(struct ldlm_lock *lock,
                              struct ldlm_lock_desc *desc,
@@ -853,6 +1115,10 @@ int ldlm_server_blocking_ast(struct ldlm_lock *lock,
 
         ldlm_lock_reorder_req(lock);
 
+	if (arg->bl_batch != NULL && !ldlm_is_cancel_on_block(lock) &&
+	    exp_connect_batch_ast(lock->l_export))
+		RETURN(ldlm_bl_ast_batch_add(lock, desc, arg));
+
 	req = ptlrpc_request_alloc_pack(lock->l_export->exp_imp_reverse,
 					&RQF_LDLM_BL_CALLBACK,
 					LUSTRE_DLM_VERSION, LDLM_BL_CALLBACK);
@@ -867,25 +1133,12 @@ int ldlm_server_blocking_ast(struct ldlm_lock *lock,
 	req->rq_interpret_reply = ldlm_cb_interpret;
 
 	lock_res_and_lock(lock);
-	if (ldlm_is_destroyed(lock)) {
-		/* What's the point? */
+	if (ldlm_bl_ast_skip(lock)) {
 		unlock_res_and_lock(lock);
 		ptlrpc_req_finished(req);
 		RETURN(0);
 	}
 
-	if (lock->l_granted_mode != lock->l_req_mode) {
-		/* this blocking AST will be communicated as part of the
-		 * completion AST instead */
-		ldlm_add_blocked_lock(lock);
-		ldlm_set_waited(lock);
-		unlock_res_and_lock(lock);
-
-		ptlrpc_req_finished(req);
-		LDLM_DEBUG(lock, "lock not granted, not sending blocking AST");
-		RETURN(0);
-	}
-
 	if (ldlm_is_cancel_on_block(lock))
                 instant_cancel = 1;
 
@@ -2073,6 +2326,134 @@ static inline void ldlm_callback_errmsg(struct ptlrpc_request *req,
                 CWARN("Send reply failed, maybe cause bug 21636.\n");
 }
 
+/**
+ * Handle a blocking AST carrying several locks, see OBD_CONNECT2_BATCH_AST.
+ *
+ * Handles of the locks which are already gone are returned in the reply, so
+ * the server can cancel them without waiting. Unused locks are cancelled
+ * together by a blocking thread, which packs them into as few LDLM_CANCEL
+ * RPCs as possible. Locks still in use, or whose bits may be converted
+ * instead, take the same path as a single blocking AST, including handling
+ * it synchronously only after the reply is sent if no blocking thread could
+ * take it.
+ */
+static void ldlm_handle_bl_callback_batch(struct ptlrpc_request *req,
+					  struct ldlm_namespace *ns,
+					  struct ldlm_request *dlm_req)
+{
+	struct ldlm_lock_desc *ld = &dlm_req->lock_desc;
+	struct list_head cancels = LIST_HEAD_INIT(cancels);
+	struct ldlm_request *stale = NULL;
+	struct ldlm_lock *lock;
+	int count = dlm_req->lock_count;
+	int size = ldlm_request_bufsize(count, LDLM_BL_CALLBACK);
+	int nr_stale = 0;
+	int nr_cancel = 0;
+	int nr_sync = 0;
+	int rc;
+	int i;
+	ENTRY;
+
+	if (req_capsule_get_size(&req->rq_pill, &RMF_DLM_REQ,
+				 RCL_CLIENT) < size) {
+		rc = ldlm_callback_reply(req, -EPROTO);
+		ldlm_callback_errmsg(req, "Operate with short lock array", rc,
+				     NULL);
+		RETURN_EXIT;
+	}
+
+	req_capsule_extend(&req->rq_pill, &RQF_LDLM_BL_CALLBACK_BATCH);
+	req_capsule_set_size(&req->rq_pill, &RMF_DLM_REQ, RCL_SERVER, size);
+	/* without a reply buffer the stale locks just time out on the server */
+	if (req_capsule_server_pack(&req->rq_pill) == 0)
+		stale = req_capsule_server_get(&req->rq_pill, &RMF_DLM_REQ);
+
+	for (i = 0; i < count; i++) {
+		struct lustre_handle *lockh = &dlm_req->lock_handle[i];
+
+		lock = ldlm_handle2lock_long(lockh, 0);
+		if (lock == NULL) {
+			CDEBUG(D_DLMTRACE, "callback on lock %#llx - lock "
+			       "disappeared\n", lockh->cookie);
+			if (stale != NULL)
+				stale->lock_handle[nr_stale++] = *lockh;
+			continue;
+		}
+
+		lock_res_and_lock(lock);
+		lock->l_flags |= ldlm_flags_from_wire(dlm_req->lock_flags &
+						      LDLM_FL_AST_MASK);
+		if ((ldlm_is_canceling(lock) && ldlm_is_bl_done(lock)) ||
+		    ldlm_is_failed(lock)) {
+			LDLM_DEBUG(lock, "callback on lock %llx - lock disappeared",
+				   lockh->cookie);
+			unlock_res_and_lock(lock);
+			LDLM_LOCK_RELEASE(lock);
+			if (stale != NULL)
+				stale->lock_handle[nr_stale++] = *lockh;
+			continue;
+		}
+
+		ldlm_lock_remove_from_lru(lock);
+		ldlm_set_bl_ast(lock);
+
+		if (!lock->l_readers && !lock->l_writers &&
+		    !ldlm_is_canceling(lock) &&
+		    !(lock->l_resource->lr_type == LDLM_IBITS &&
+		      ld->l_policy_data.l_inodebits.cancel_bits != 0)) {
+			/* once CBPENDING is set, the lock can accumulate no
+			 * more readers/writers, see ldlm_prepare_lru_list() */
+			lock->l_flags |= LDLM_FL_CBPENDING | LDLM_FL_CANCELING;
+			LASSERT(list_empty(&lock->l_bl_ast));
+			list_add(&lock->l_bl_ast, &cancels);
+			unlock_res_and_lock(lock);
+			nr_cancel++;
+			continue;
+		}
+		unlock_res_and_lock(lock);
+
+		if (ldlm_bl_to_thread_lock(ns, ld, lock)) {
+			/* Handle it after the reply, as the single lock
+			 * blocking AST does. The handle array is reused, the
+			 * entries below \a i are already processed. */
+			dlm_req->lock_handle[nr_sync++] = *lockh;
+			LDLM_LOCK_RELEASE(lock);
+		}
+	}
+
+	if (stale != NULL) {
+		stale->lock_count = nr_stale;
+		req_capsule_shrink(&req->rq_pill, &RMF_DLM_REQ,
+				   ldlm_request_bufsize(nr_stale,
+							LDLM_BL_CALLBACK),
+				   RCL_SERVER);
+	}
+	rc = ldlm_callback_reply(req, 0);
+	if (req->rq_no_reply || rc)
+		ldlm_callback_errmsg(req, "Batched process", rc,
+				     &dlm_req->lock_handle[0]);
+
+	CDEBUG(D_DLMTRACE, "%s: blocking AST for %d locks, %d gone, %d unused, "
+	       "%d handled in place\n", ldlm_ns_name(ns), count, nr_stale,
+	       nr_cancel, nr_sync);
+
+	for (i = 0; i < nr_sync; i++) {
+		/* a lock cancelled meanwhile needs no blocking AST anymore */
+		lock = ldlm_handle2lock_long(&dlm_req->lock_handle[i], 0);
+		if (lock != NULL)
+			ldlm_handle_bl_callback(ns, ld, lock);
+	}
+
+	/* the cancelled locks keep the reference from ldlm_handle2lock() */
+	if (nr_cancel > 0 &&
+	    ldlm_bl_to_thread_list(ns, ld, &cancels, nr_cancel, LCF_ASYNC)) {
+		nr_cancel = ldlm_cli_cancel_list_local(&cancels, nr_cancel,
+						       LCF_BL_AST);
+		ldlm_cli_cancel_list(&cancels, nr_cancel, NULL, 0);
+	}
+	EXIT;
+}
+
 /* TODO: handle requests in a similar way as MDT: see mdt_handle_common() */
 static int ldlm_callback_handler(struct ptlrpc_request *req)
 {
@@ -2143,6 +2524,12 @@ static int ldlm_callback_handler(struct ptlrpc_request *req)
                 RETURN(0);
         }
 
+	if (lustre_msg_get_opc(req->rq_reqmsg) == LDLM_BL_CALLBACK &&
+	    dlm_req->lock_count > 1) {
+		ldlm_handle_bl_callback_batch(req, ns, dlm_req);
+		RETURN(0);
+	}
+
         /* Force a known safe race, send a cancel to the server for a lock
          * which the server has already started a blocking callback on. */
         if (OBD_FAIL_CHECK(OBD_FAIL_LDLM_CANCEL_BL_CB_RACE) &&
@@ -2800,7 +3187,6 @@ static struct cfs_hash_ops ldlm_export_lock_ops = {
 
 int ldlm_init_export(struct obd_export *exp)
 {
-	int rc;
         ENTRY;
 
         exp->exp_lock_hash =
@@ -2816,14 +3202,7 @@ int ldlm_init_export(struct obd_export *exp)
         if (!exp->exp_lock_hash)
                 RETURN(-ENOMEM);
 
-	rc = ldlm_init_flock_export(exp);
-	if (rc)
-		GOTO(err, rc);
-
         RETURN(0);
-err:
-	ldlm_destroy_export(exp);
-	RETURN(rc);
 }
 EXPORT_SYMBOL(ldlm_init_export);
 
@@ -2832,8 +3211,6 @@ void ldlm_destroy_export(struct obd_export *exp)
         ENTRY;
         cfs_hash_putref(exp->exp_lock_hash);
         exp->exp_lock_hash = NULL;
-
-	ldlm_destroy_flock_export(exp);
         EXIT;
 }
 EXPORT_SYMBOL(ldlm_destroy_export);
@@ -3133,24 +3510,36 @@ int ldlm_init(void)
 	if (ldlm_lock_slab == NULL)
 		goto out_resource;
 
-	ldlm_interval_slab = kmem_cache_create("interval_node",
-                                        sizeof(struct ldlm_interval),
-					0, SLAB_HWCACHE_ALIGN, NULL);
-	if (ldlm_interval_slab == NULL)
-		goto out_lock;
-
 	ldlm_interval_tree_slab = kmem_cache_create("interval_tree",
-			sizeof(struct ldlm_interval_tree) * LCK_MODE_NUM,
+			sizeof(struct ldlm_extent_index),
 			0, SLAB_HWCACHE_ALIGN, NULL);
 	if (ldlm_interval_tree_slab == NULL)
-		goto out_interval;
+		goto out_lock;
+
+	ldlm_inodebits_slab = kmem_cache_create("ldlm_ibits_queues",
+			sizeof(struct ldlm_ibits_queues),
+			0, SLAB_HWCACHE_ALIGN, NULL);
+	if (ldlm_inodebits_slab == NULL)
+		goto out_interval_tree;
+
+	ldlm_flock_index_slab = kmem_cache_create("ldlm_flock_index",
+			sizeof(struct ldlm_flock_index),
+			0, SLAB_HWCACHE_ALIGN, NULL);
+	if (ldlm_flock_index_slab == NULL)
+		goto out_inodebits;
+
+	ldlm_extent_contention_slab = kmem_cache_create("ldlm_ext_contention",
+			sizeof(struct ldlm_extent_contention),
+			0, SLAB_HWCACHE_ALIGN, NULL);
+	if (ldlm_extent_contention_slab == NULL)
+		goto out_flock_index;
 
 #ifdef HAVE_SERVER_SUPPORT
 	ldlm_glimpse_work_kmem = kmem_cache_create("ldlm_glimpse_work_kmem",
 					sizeof(struct ldlm_glimpse_work),
 					0, 0, NULL);
 	if (ldlm_glimpse_work_kmem == NULL)
-		goto out_interval_tree;
+		goto out_contention;
 #endif
 
 #if LUSTRE_TRACKS_LOCK_EXP_REFS
@@ -3158,11 +3547,15 @@ int ldlm_init(void)
 #endif
 	return 0;
 #ifdef HAVE_SERVER_SUPPORT
+out_contention:
+	kmem_cache_destroy(ldlm_extent_contention_slab);
+#endif
+out_flock_index:
+	kmem_cache_destroy(ldlm_flock_index_slab);
+out_inodebits:
+	kmem_cache_destroy(ldlm_inodebits_slab);
 out_interval_tree:
 	kmem_cache_destroy(ldlm_interval_tree_slab);
-#endif
-out_interval:
-	kmem_cache_destroy(ldlm_interval_slab);
 out_lock:
 	kmem_cache_destroy(ldlm_lock_slab);
 out_resource:
@@ -3175,14 +3568,18 @@ void ldlm_exit(void)
 {
 	if (ldlm_refcount)
 		CERROR("ldlm_refcount is %d in ldlm_exit!\n", ldlm_refcount);
+	/* wait for resources freed by ldlm_resource_putref() via RCU */
+	rcu_barrier();
 	kmem_cache_destroy(ldlm_resource_slab);
 	/* ldlm_lock_put() use RCU to call ldlm_lock_free, so need call
 	 * synchronize_rcu() to wait a grace period elapsed, so that
 	 * ldlm_lock_free() get a chance to be called. */
 	synchronize_rcu();
 	kmem_cache_destroy(ldlm_lock_slab);
-	kmem_cache_destroy(ldlm_interval_slab);
 	kmem_cache_destroy(ldlm_interval_tree_slab);
+	kmem_cache_destroy(ldlm_inodebits_slab);
+	kmem_cache_destroy(ldlm_flock_index_slab);
+	kmem_cache_destroy(ldlm_extent_contention_slab);
 #ifdef HAVE_SERVER_SUPPORT
 	kmem_cache_destroy(ldlm_glimpse_work_kmem);
 #endif
@@ -38,21 +38,31 @@
  * ldlm_reclaim_threshold & ldlm_lock_limit are used for reclaiming
  * granted locks and rejecting incoming enqueue requests defensively.
  *
- * ldlm_reclaim_threshold: When the amount of granted locks reaching this
- * threshold, server start to revoke locks gradually.
+ * ldlm_reclaim_threshold: When the memory used by granted locks reaching
+ * this threshold, server start to revoke locks gradually.
  *
- * ldlm_lock_limit: When the amount of granted locks reaching this
+ * ldlm_lock_limit: When the memory used by granted locks reaching this
  * threshold, server will return -EINPROGRESS to any incoming enqueue
- * request until the lock count is shrunk below the threshold again.
+ * request until the lock memory is shrunk below the threshold again.
  *
  * ldlm_reclaim_threshold & ldlm_lock_limit is set to 20% & 30% of the
  * total memory by default. It is tunable via proc entry, when it's set
  * to 0, the feature is disabled.
+ *
+ * Each reclaimable lock is charged with its own size plus its LVB, the
+ * first granted lock on a resource is charged with the resource and its
+ * per-type lock index as well, since that memory is only freed when the
+ * last lock goes away.
+ *
+ * Granted locks are kept on per-CPT lists in the order they were granted,
+ * so the reclaim takes the coldest locks from the list heads and never
+ * has to walk the resource hashes: the cost of a reclaim run is bound by
+ * the number of locks it revokes.
  */
 
 #ifdef HAVE_SERVER_SUPPORT
 
-/* Lock count is stored in ldlm_reclaim_threshold & ldlm_lock_limit */
+/* Memory used by the granted locks, in bytes */
 __u64 ldlm_reclaim_threshold;
 __u64 ldlm_lock_limit;
 
@@ -62,19 +72,41 @@ __u64 ldlm_reclaim_threshold_mb;
 __u64 ldlm_lock_limit_mb;
 
 struct percpu_counter		ldlm_granted_total;
+struct percpu_counter		ldlm_granted_bytes;
 static atomic_t			ldlm_nr_reclaimer;
 static s64			ldlm_last_reclaim_age_ns;
 static ktime_t			ldlm_last_reclaim_time;
 
+/* Granted reclaimable locks of one CPT, oldest first */
+struct ldlm_reclaim_list {
+	spinlock_t		lrl_lock;
+	struct list_head	lrl_locks;
+};
+
+static struct ldlm_reclaim_list	**ldlm_reclaim_lists;
+/* CPT to start the next reclaim run with, protected by ldlm_nr_reclaimer */
+static unsigned int		  ldlm_reclaim_cursor;
+
+/* Reclaim statistics, updated by the only running reclaimer */
+static struct ldlm_reclaim_stats {
+	__u64			lrs_runs;
+	__u64			lrs_locks;
+	__u64			lrs_bytes;
+	__u64			lrs_last_usec;
+	__u64			lrs_max_usec;
+	__u64			lrs_sum_usec;
+} ldlm_reclaim_stats;
+
 struct ldlm_reclaim_cb_data {
+	struct ldlm_namespace	*rcd_ns;
 	struct list_head	 rcd_rpc_list;
+	/* locks on rcd_rpc_list, all from rcd_ns */
 	int			 rcd_added;
+	/* locks still to be revoked by this run */
 	int			 rcd_total;
-	int			 rcd_cursor;
-	int			 rcd_start;
-	bool			 rcd_skip;
+	__u64			 rcd_bytes;
+	__u64			 rcd_bytes_total;
 	s64			 rcd_age_ns;
-	struct cfs_hash_bd	*rcd_prev_bd;
 };
 
 static inline bool ldlm_lock_reclaimable(struct ldlm_lock *lock)
@@ -85,7 +117,7 @@ static inline bool ldlm_lock_reclaimable(struct ldlm_lock *lock)
 	 * explicitly controlled by application, PLAIN lock
 	 * is used by quota global lock and config lock.
 	 */
-	if (ns->ns_client == LDLM_NAMESPACE_SERVER &&
+	if (ns->ns_reclaimable &&
 	    (lock->l_resource->lr_type == LDLM_IBITS ||
 	     lock->l_resource->lr_type == LDLM_EXTENT))
 		return true;
@@ -93,132 +125,152 @@ static inline bool ldlm_lock_reclaimable(struct ldlm_lock *lock)
 }
 
 /**
- * Callback function for revoking locks from certain resource.
- *
- * \param [in] hs	ns_rs_hash
- * \param [in] bd	current bucket of ns_rsh_hash
- * \param [in] hnode	hnode of the resource
- * \param [in] arg	opaque data
- *
- * \retval 0		continue the scan
- * \retval 1		stop the iteration
+ * Only the locks of the MDT and OST namespaces are reclaimed, the other
+ * server namespaces (MGS, quota) hold a few long lived locks only.
  */
-static int ldlm_reclaim_lock_cb(struct cfs_hash *hs, struct cfs_hash_bd *bd,
-				struct hlist_node *hnode, void *arg)
-
+void ldlm_reclaim_ns_init(struct ldlm_namespace *ns)
 {
-	struct ldlm_resource		*res;
-	struct ldlm_reclaim_cb_data	*data;
-	struct ldlm_lock		*lock;
-	struct ldlm_ns_bucket		*nsb;
-	int				 rc = 0;
-
-	data = (struct ldlm_reclaim_cb_data *)arg;
-
-	LASSERTF(data->rcd_added < data->rcd_total, "added:%d >= total:%d\n",
-		 data->rcd_added, data->rcd_total);
-
-	nsb = cfs_hash_bd_extra_get(hs, bd);
-	res = cfs_hash_object(hs, hnode);
-
-	if (data->rcd_prev_bd != bd) {
-		if (data->rcd_prev_bd != NULL)
-			ldlm_res_to_ns(res)->ns_reclaim_start++;
-		data->rcd_prev_bd = bd;
-		data->rcd_cursor = 0;
-		data->rcd_start = nsb->nsb_reclaim_start %
-				  cfs_hash_bd_count_get(bd);
-	}
+	int idx, type;
 
-	if (data->rcd_skip && data->rcd_cursor < data->rcd_start) {
-		data->rcd_cursor++;
-		return 0;
+	ns->ns_reclaimable = 0;
+	if (ns->ns_client != LDLM_NAMESPACE_SERVER)
+		return;
+
+	if (ns->ns_obd) {
+		type = server_name2index(ns->ns_obd->obd_name, &idx, NULL);
+		if (type != LDD_F_SV_TYPE_MDT && type != LDD_F_SV_TYPE_OST)
+			return;
 	}
+	ns->ns_reclaimable = 1;
+}
 
-	nsb->nsb_reclaim_start++;
+/**
+ * Memory pinned by a granted lock, see the comment on top of this file.
+ * Called under the resource lock, after the lock is put on lr_granted.
+ */
+static __u32 ldlm_reclaim_lock_cost(struct ldlm_lock *lock)
+{
+	struct ldlm_resource *res = lock->l_resource;
+	__u32 cost = sizeof(*lock) + lock->l_lvb_len;
+
+	if (!list_is_singular(&res->lr_granted))
+		return cost;
+
+	cost += sizeof(*res) + res->lr_lvb_len;
+	if (res->lr_type == LDLM_EXTENT)
+		cost += sizeof(struct ldlm_extent_index) +
+			sizeof(struct ldlm_extent_contention);
+	else
+		cost += sizeof(*res->lr_ibits_queues);
+	return cost;
+}
 
-	lock_res(res);
-	list_for_each_entry(lock, &res->lr_granted, l_res_link) {
-		if (!ldlm_lock_reclaimable(lock))
-			continue;
+/**
+ * Send the revoke ASTs collected in \a data and account them on the
+ * namespace they belong to.
+ */
+static void ldlm_reclaim_flush(struct ldlm_reclaim_cb_data *data)
+{
+	struct ldlm_namespace *ns = data->rcd_ns;
 
-		if (!OBD_FAIL_CHECK(OBD_FAIL_LDLM_WATERMARK_LOW) &&
-		    ktime_before(ktime_get(),
-				 ktime_add_ns(lock->l_last_used,
-					      data->rcd_age_ns)))
-			continue;
-
-		if (!ldlm_is_ast_sent(lock)) {
-			ldlm_set_ast_sent(lock);
-			LASSERT(list_empty(&lock->l_rk_ast));
-			list_add(&lock->l_rk_ast, &data->rcd_rpc_list);
-			LDLM_LOCK_GET(lock);
-			if (++data->rcd_added == data->rcd_total) {
-				rc = 1; /* stop the iteration */
-				break;
-			}
-		}
-	}
-	unlock_res(res);
+	if (ns == NULL)
+		return;
 
-	return rc;
+	if (data->rcd_added != 0) {
+		CDEBUG(D_DLMTRACE, "NS(%s): %d locks to be reclaimed\n",
+		       ldlm_ns_name(ns), data->rcd_added);
+		lprocfs_counter_add(ns->ns_stats, LDLM_NSS_RECLAIM_REVOKED,
+				    data->rcd_added);
+		ldlm_run_ast_work(ns, &data->rcd_rpc_list,
+				  LDLM_WORK_REVOKE_AST);
+		data->rcd_added = 0;
+	}
+	data->rcd_ns = NULL;
 }
 
 /**
- * Revoke locks from the resources of a namespace in a roundrobin
- * manner.
- *
- * \param[in] ns	namespace to do the lock revoke on
- * \param[in] count	count of lock to be revoked
- * \param[in] age	only revoke locks older than the 'age'
- * \param[in] skip	scan from the first lock on resource if the
- *			'skip' is false, otherwise, continue scan
- *			from the last scanned position
- * \param[out] count	count of lock still to be revoked
+ * Revoke a lock taken off the reclaim list. The reference held on the
+ * lock is either passed to the revoke AST work list or dropped here.
  */
-static void ldlm_reclaim_res(struct ldlm_namespace *ns, int *count,
-			     s64 age_ns, bool skip)
+static void ldlm_reclaim_lock(struct ldlm_reclaim_cb_data *data,
+			      struct ldlm_lock *lock, __u32 cost)
 {
-	struct ldlm_reclaim_cb_data	data;
-	int				idx, type, start;
-	ENTRY;
-
-	LASSERT(*count != 0);
+	struct ldlm_namespace *ns = ldlm_lock_to_ns(lock);
 
-	if (ns->ns_obd) {
-		type = server_name2index(ns->ns_obd->obd_name, &idx, NULL);
-		if (type != LDD_F_SV_TYPE_MDT && type != LDD_F_SV_TYPE_OST) {
-			EXIT;
-			return;
-		}
+	if (ns != data->rcd_ns) {
+		ldlm_reclaim_flush(data);
+		data->rcd_ns = ns;
 	}
 
-	if (atomic_read(&ns->ns_bref) == 0) {
-		EXIT;
+	lock_res_and_lock(lock);
+	if (lock->l_granted_mode != lock->l_req_mode ||
+	    ldlm_is_ast_sent(lock) || ldlm_is_destroyed(lock) ||
+	    ns->ns_stopping) {
+		unlock_res_and_lock(lock);
+		LDLM_LOCK_RELEASE(lock);
 		return;
 	}
 
-	INIT_LIST_HEAD(&data.rcd_rpc_list);
-	data.rcd_added = 0;
-	data.rcd_total = *count;
-	data.rcd_age_ns = age_ns;
-	data.rcd_skip = skip;
-	data.rcd_prev_bd = NULL;
-	start = ns->ns_reclaim_start % CFS_HASH_NBKT(ns->ns_rs_hash);
+	ldlm_set_ast_sent(lock);
+	LASSERT(list_empty(&lock->l_rk_ast));
+	list_add_tail(&lock->l_rk_ast, &data->rcd_rpc_list);
+	unlock_res_and_lock(lock);
+
+	data->rcd_added++;
+	data->rcd_total--;
+	data->rcd_bytes += cost;
+}
 
-	cfs_hash_for_each_nolock(ns->ns_rs_hash, ldlm_reclaim_lock_cb, &data,
-				 start);
+#define LDLM_RECLAIM_SCAN_BATCH	16
 
-	CDEBUG(D_DLMTRACE, "NS(%s): %d locks to be reclaimed, found %d/%d "
-	       "locks.\n", ldlm_ns_name(ns), *count, data.rcd_added,
-	       data.rcd_total);
+/**
+ * Take the coldest locks off the reclaim list of one CPT and revoke them.
+ *
+ * Server locks are put at the list tail with l_last_used set when they are
+ * granted, and moved back to the tail by ldlm_reclaim_touch() whenever IO
+ * refreshes l_last_used, so the list is ordered by age and the scan stops
+ * at the first lock younger than the reclaim age.
+ * The list lock nests inside the resource lock, so the victims are only
+ * collected under it and revoked after it is dropped.
+ *
+ * \param[in] lrl	reclaim list to scan
+ * \param[in] data	reclaim state
+ *
+ * \retval		number of locks taken off the list
+ */
+static int ldlm_reclaim_list_scan(struct ldlm_reclaim_list *lrl,
+				  struct ldlm_reclaim_cb_data *data)
+{
+	struct ldlm_lock	*victims[LDLM_RECLAIM_SCAN_BATCH];
+	__u32			 costs[LDLM_RECLAIM_SCAN_BATCH];
+	struct ldlm_lock	*lock;
+	ktime_t			 now = ktime_get();
+	int			 nr = 0;
+	int			 i;
+
+	spin_lock(&lrl->lrl_lock);
+	while (nr < LDLM_RECLAIM_SCAN_BATCH && nr < data->rcd_total &&
+	       !list_empty(&lrl->lrl_locks)) {
+		lock = list_first_entry(&lrl->lrl_locks, struct ldlm_lock,
+					l_reclaim);
+
+		/* all the following locks are younger still */
+		if (!OBD_FAIL_CHECK(OBD_FAIL_LDLM_WATERMARK_LOW) &&
+		    ktime_before(now, ktime_add_ns(lock->l_last_used,
+						   data->rcd_age_ns)))
+			break;
+
+		/* still charged in ldlm_granted_bytes until it is freed */
+		list_del_init(&lock->l_reclaim);
+		costs[nr] = lock->l_reclaim_cost;
+		victims[nr++] = LDLM_LOCK_GET(lock);
+	}
+	spin_unlock(&lrl->lrl_lock);
 
-	LASSERTF(*count >= data.rcd_added, "count:%d, added:%d\n", *count,
-		 data.rcd_added);
+	for (i = 0; i < nr; i++)
+		ldlm_reclaim_lock(data, victims[i], costs[i]);
 
-	ldlm_run_ast_work(ns, &data.rcd_rpc_list, LDLM_WORK_REVOKE_AST);
-	*count -= data.rcd_added;
-	EXIT;
+	return nr;
 }
 
 #define LDLM_RECLAIM_BATCH	512
@@ -240,19 +292,35 @@ static inline s64 ldlm_reclaim_age(void)
 	return age_ns;
 }
 
+static void ldlm_reclaim_stats_update(struct ldlm_reclaim_cb_data *data,
+				      ktime_t start)
+{
+	struct ldlm_reclaim_stats *lrs = &ldlm_reclaim_stats;
+	__u64 usec = ktime_us_delta(ktime_get(), start);
+
+	lrs->lrs_runs++;
+	lrs->lrs_locks += LDLM_RECLAIM_BATCH - data->rcd_total;
+	lrs->lrs_bytes += data->rcd_bytes;
+	lrs->lrs_last_usec = usec;
+	lrs->lrs_sum_usec += usec;
+	if (usec > lrs->lrs_max_usec)
+		lrs->lrs_max_usec = usec;
+}
+
 /**
- * Revoke certain amount of locks from all the server namespaces
- * in a roundrobin manner. Lock age is used to avoid reclaim on
- * the non-aged locks.
+ * Revoke the coldest granted locks of all the server namespaces, until
+ * LDLM_RECLAIM_BATCH locks or memory worth as many bare locks is
+ * reclaimed. The CPT lists are scanned in a roundrobin manner, lock age
+ * is used to avoid reclaim on the non-aged locks.
  */
 static void ldlm_reclaim_ns(void)
 {
-	struct ldlm_namespace	*ns;
-	int			 count = LDLM_RECLAIM_BATCH;
-	int			 ns_nr, nr_processed;
-	enum ldlm_side		 ns_cli = LDLM_NAMESPACE_SERVER;
-	s64 age_ns;
-	bool			 skip = true;
+	struct ldlm_reclaim_cb_data	 data;
+	struct ldlm_reclaim_list	*lrl;
+	ktime_t				 start = ktime_get();
+	int				 nr_cpts;
+	int				 nr_idle;
+	int				 cpt;
 	ENTRY;
 
 	if (!atomic_add_unless(&ldlm_nr_reclaimer, 1, 1)) {
@@ -260,62 +328,115 @@ static void ldlm_reclaim_ns(void)
 		return;
 	}
 
-	age_ns = ldlm_reclaim_age();
+	INIT_LIST_HEAD(&data.rcd_rpc_list);
+	data.rcd_ns = NULL;
+	data.rcd_added = 0;
+	data.rcd_total = LDLM_RECLAIM_BATCH;
+	data.rcd_bytes = 0;
+	data.rcd_bytes_total = LDLM_RECLAIM_BATCH * sizeof(struct ldlm_lock);
+	data.rcd_age_ns = ldlm_reclaim_age();
+
+	nr_cpts = cfs_percpt_number(ldlm_reclaim_lists);
 again:
-	nr_processed = 0;
-	ns_nr = ldlm_namespace_nr_read(ns_cli);
-	while (count > 0 && nr_processed < ns_nr) {
-		mutex_lock(ldlm_namespace_lock(ns_cli));
-
-		if (list_empty(ldlm_namespace_list(ns_cli))) {
-			mutex_unlock(ldlm_namespace_lock(ns_cli));
-			goto out;
-		}
-
-		ns = ldlm_namespace_first_locked(ns_cli);
-		ldlm_namespace_move_to_active_locked(ns, ns_cli);
-		mutex_unlock(ldlm_namespace_lock(ns_cli));
-
-		ldlm_reclaim_res(ns, &count, age_ns, skip);
-		ldlm_namespace_put(ns);
-		nr_processed++;
+	/* stop after a full round on the CPT lists without any victim */
+	nr_idle = 0;
+	while (nr_idle < nr_cpts && data.rcd_total > 0 &&
+	       data.rcd_bytes < data.rcd_bytes_total) {
+		cpt = ldlm_reclaim_cursor++ % nr_cpts;
+		lrl = ldlm_reclaim_lists[cpt];
+
+		if (ldlm_reclaim_list_scan(lrl, &data) == 0)
+			nr_idle++;
+		else
+			nr_idle = 0;
 	}
+	ldlm_reclaim_flush(&data);
 
-	if (count > 0 && age_ns > LDLM_RECLAIM_AGE_MIN) {
-		age_ns >>= 1;
-		if (age_ns < (LDLM_RECLAIM_AGE_MIN * 2))
-			age_ns = LDLM_RECLAIM_AGE_MIN;
-		skip = false;
+	if (data.rcd_total > 0 && data.rcd_bytes < data.rcd_bytes_total &&
+	    data.rcd_age_ns > LDLM_RECLAIM_AGE_MIN) {
+		data.rcd_age_ns >>= 1;
+		if (data.rcd_age_ns < (LDLM_RECLAIM_AGE_MIN * 2))
+			data.rcd_age_ns = LDLM_RECLAIM_AGE_MIN;
 		goto again;
 	}
 
-	ldlm_last_reclaim_age_ns = age_ns;
+	ldlm_reclaim_stats_update(&data, start);
+	ldlm_last_reclaim_age_ns = data.rcd_age_ns;
 	ldlm_last_reclaim_time = ktime_get();
-out:
+
 	atomic_add_unless(&ldlm_nr_reclaimer, -1, 0);
 	EXIT;
 }
 
+/**
+ * Charge a newly granted lock and put it at the tail of the reclaim list
+ * of the current CPT. Called under the resource lock.
+ */
 void ldlm_reclaim_add(struct ldlm_lock *lock)
 {
+	struct ldlm_reclaim_list *lrl;
+
 	if (!ldlm_lock_reclaimable(lock))
 		return;
-	percpu_counter_add(&ldlm_granted_total, 1);
+
 	lock->l_last_used = ktime_get();
+	lock->l_reclaim_cost = ldlm_reclaim_lock_cost(lock);
+	lock->l_reclaim_cpt = cfs_cpt_current(cfs_cpt_tab, 1);
+	lrl = ldlm_reclaim_lists[lock->l_reclaim_cpt];
+
+	spin_lock(&lrl->lrl_lock);
+	list_add_tail(&lock->l_reclaim, &lrl->lrl_locks);
+	spin_unlock(&lrl->lrl_lock);
+
+	percpu_counter_add(&ldlm_granted_total, 1);
+	percpu_counter_add(&ldlm_granted_bytes, lock->l_reclaim_cost);
+}
+
+/**
+ * Refresh l_last_used of a granted lock used by IO and move it to the tail
+ * of its reclaim list, so the list stays ordered by age.
+ */
+void ldlm_reclaim_touch(struct ldlm_lock *lock)
+{
+	struct ldlm_reclaim_list *lrl;
+
+	if (!ldlm_lock_reclaimable(lock))
+		return;
+
+	lrl = ldlm_reclaim_lists[lock->l_reclaim_cpt];
+	spin_lock(&lrl->lrl_lock);
+	/* not on the list if it is not granted yet or is being reclaimed */
+	if (!list_empty(&lock->l_reclaim)) {
+		lock->l_last_used = ktime_get();
+		list_move_tail(&lock->l_reclaim, &lrl->lrl_locks);
+	}
+	spin_unlock(&lrl->lrl_lock);
 }
+EXPORT_SYMBOL(ldlm_reclaim_touch);
 
 void ldlm_reclaim_del(struct ldlm_lock *lock)
 {
+	struct ldlm_reclaim_list *lrl;
+
 	if (!ldlm_lock_reclaimable(lock))
 		return;
+
+	lrl = ldlm_reclaim_lists[lock->l_reclaim_cpt];
+	spin_lock(&lrl->lrl_lock);
+	list_del_init(&lock->l_reclaim);
+	spin_unlock(&lrl->lrl_lock);
+
 	percpu_counter_sub(&ldlm_granted_total, 1);
+	percpu_counter_sub(&ldlm_granted_bytes, lock->l_reclaim_cost);
 }
 
 /**
- * Check on the total granted locks: return true if it reaches the
- * high watermark (ldlm_lock_limit), otherwise return false; It also
- * triggers lock reclaim if the low watermark (ldlm_reclaim_threshold)
- * is reached.
+ * Check on the memory used by the granted locks: return true if it
+ * reaches the high watermark (ldlm_lock_limit), otherwise return false;
+ * It also triggers lock reclaim if the low watermark
+ * (ldlm_reclaim_threshold) is reached.
+ *
+ * The fail_loc watermarks in cfs_fail_val are lock counts.
  *
  * \retval true		high watermark reached.
  * \retval false	high watermark not reached.
@@ -325,36 +446,58 @@ bool ldlm_reclaim_full(void)
 	__u64 high = ldlm_lock_limit;
 	__u64 low = ldlm_reclaim_threshold;
 
-	if (low != 0 && OBD_FAIL_CHECK(OBD_FAIL_LDLM_WATERMARK_LOW))
-		low = cfs_fail_val;
-
-	if (low != 0 &&
-	    percpu_counter_sum_positive(&ldlm_granted_total) > low)
+	if (low != 0 && OBD_FAIL_CHECK(OBD_FAIL_LDLM_WATERMARK_LOW)) {
+		if (percpu_counter_sum_positive(&ldlm_granted_total) >
+		    cfs_fail_val)
+			ldlm_reclaim_ns();
+	} else if (low != 0 &&
+		   percpu_counter_sum_positive(&ldlm_granted_bytes) > low) {
 		ldlm_reclaim_ns();
+	}
 
 	if (high != 0 && OBD_FAIL_CHECK(OBD_FAIL_LDLM_WATERMARK_HIGH))
-		high = cfs_fail_val;
+		return percpu_counter_sum_positive(&ldlm_granted_total) >
+		       cfs_fail_val;
 
 	if (high != 0 &&
-	    percpu_counter_sum_positive(&ldlm_granted_total) > high)
+	    percpu_counter_sum_positive(&ldlm_granted_bytes) > high)
 		return true;
 
 	return false;
 }
 
-static inline __u64 ldlm_ratio2locknr(int ratio)
+int ldlm_reclaim_stats_seq_show(struct seq_file *m, void *data)
 {
-	__u64 locknr;
+	struct ldlm_reclaim_stats *lrs = &ldlm_reclaim_stats;
+	__u64 avg = lrs->lrs_sum_usec;
+
+	if (lrs->lrs_runs != 0)
+		do_div(avg, lrs->lrs_runs);
+
+	seq_printf(m, "runs: %llu\n"
+		   "locks: %llu\n"
+		   "bytes: %llu\n"
+		   "last_usec: %llu\n"
+		   "max_usec: %llu\n"
+		   "avg_usec: %llu\n",
+		   lrs->lrs_runs, lrs->lrs_locks, lrs->lrs_bytes,
+		   lrs->lrs_last_usec, lrs->lrs_max_usec, avg);
+	return 0;
+}
 
-	locknr = ((__u64)NUM_CACHEPAGES << PAGE_SHIFT) * ratio;
-	do_div(locknr, 100 * sizeof(struct ldlm_lock));
+static inline __u64 ldlm_ratio2bytes(int ratio)
+{
+	__u64 bytes;
+
+	bytes = ((__u64)NUM_CACHEPAGES << PAGE_SHIFT) * ratio;
+	do_div(bytes, 100);
 
-	return locknr;
+	return bytes;
 }
 
-static inline __u64 ldlm_locknr2mb(__u64 locknr)
+static inline __u64 ldlm_bytes2mb(__u64 bytes)
 {
-	return (locknr * sizeof(struct ldlm_lock) + 512 * 1024) >> 20;
+	return (bytes + 512 * 1024) >> 20;
 }
 
 #define LDLM_WM_RATIO_LOW_DEFAULT	20
@@ -362,30 +505,72 @@ static inline __u64 ldlm_locknr2mb(__u64 locknr)
 
 int ldlm_reclaim_setup(void)
 {
+	struct ldlm_reclaim_list *lrl;
+	int rc;
+	int i;
+
 	atomic_set(&ldlm_nr_reclaimer, 0);
+	ldlm_reclaim_cursor = 0;
+	memset(&ldlm_reclaim_stats, 0, sizeof(ldlm_reclaim_stats));
 
-	ldlm_reclaim_threshold = ldlm_ratio2locknr(LDLM_WM_RATIO_LOW_DEFAULT);
-	ldlm_reclaim_threshold_mb = ldlm_locknr2mb(ldlm_reclaim_threshold);
-	ldlm_lock_limit = ldlm_ratio2locknr(LDLM_WM_RATIO_HIGH_DEFAULT);
-	ldlm_lock_limit_mb = ldlm_locknr2mb(ldlm_lock_limit);
+	ldlm_reclaim_threshold = ldlm_ratio2bytes(LDLM_WM_RATIO_LOW_DEFAULT);
+	ldlm_reclaim_threshold_mb = ldlm_bytes2mb(ldlm_reclaim_threshold);
+	ldlm_lock_limit = ldlm_ratio2bytes(LDLM_WM_RATIO_HIGH_DEFAULT);
+	ldlm_lock_limit_mb = ldlm_bytes2mb(ldlm_lock_limit);
 
 	ldlm_last_reclaim_age_ns = LDLM_RECLAIM_AGE_MAX;
 	ldlm_last_reclaim_time = ktime_get();
 
+	ldlm_reclaim_lists = cfs_percpt_alloc(cfs_cpt_tab, sizeof(*lrl));
+	if (ldlm_reclaim_lists == NULL)
+		return -ENOMEM;
+
+	cfs_percpt_for_each(lrl, i, ldlm_reclaim_lists) {
+		spin_lock_init(&lrl->lrl_lock);
+		INIT_LIST_HEAD(&lrl->lrl_locks);
+	}
+
 #ifdef HAVE_PERCPU_COUNTER_INIT_GFP_FLAG
-	return percpu_counter_init(&ldlm_granted_total, 0, GFP_KERNEL);
+	rc = percpu_counter_init(&ldlm_granted_total, 0, GFP_KERNEL);
 #else
-	return percpu_counter_init(&ldlm_granted_total, 0);
+	rc = percpu_counter_init(&ldlm_granted_total, 0);
 #endif
+	if (rc)
+		goto out_lists;
+
+#ifdef HAVE_PERCPU_COUNTER_INIT_GFP_FLAG
+	rc = percpu_counter_init(&ldlm_granted_bytes, 0, GFP_KERNEL);
+#else
+	rc = percpu_counter_init(&ldlm_granted_bytes, 0);
+#endif
+	if (rc)
+		goto out_total;
+
+	return 0;
+
+out_total:
+	percpu_counter_destroy(&ldlm_granted_total);
+out_lists:
+	cfs_percpt_free(ldlm_reclaim_lists);
+	ldlm_reclaim_lists = NULL;
+	return rc;
 }
 
 void ldlm_reclaim_cleanup(void)
 {
+	percpu_counter_destroy(&ldlm_granted_bytes);
 	percpu_counter_destroy(&ldlm_granted_total);
+	cfs_percpt_free(ldlm_reclaim_lists);
+	ldlm_reclaim_lists = NULL;
 }
 
 #else /* HAVE_SERVER_SUPPORT */
 
+void ldlm_reclaim_ns_init(struct ldlm_namespace *ns)
+{
+	ns->ns_reclaimable = 0;
+}
+
 bool ldlm_reclaim_full(void)
 {
 	return false;
@@ -395,6 +580,11 @@ void ldlm_reclaim_add(struct ldlm_lock *lock)
 {
 }
 
+void ldlm_reclaim_touch(struct ldlm_lock *lock)
+{
+}
+EXPORT_SYMBOL(ldlm_reclaim_touch);
+
 void ldlm_reclaim_del(struct ldlm_lock *lock)
 {
 }
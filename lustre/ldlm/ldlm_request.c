@@ -1103,8 +1103,6 @@ static int lock_convert_interpret(const struct lu_env *env,
 		 * finish with convert otherwise.
 		 */
 		if (!ldlm_is_bl_ast(lock)) {
-			struct ldlm_namespace *ns = ldlm_lock_to_ns(lock);
-
 			/* Drop cancel_bits since there are no more converts
 			 * and put lock into LRU if it is still not used and
 			 * is not there yet.
@@ -1112,11 +1110,9 @@ static int lock_convert_interpret(const struct lu_env *env,
 			lock->l_policy_data.l_inodebits.cancel_bits = 0;
 			if (!lock->l_readers && !lock->l_writers &&
 			    !ldlm_is_canceling(lock)) {
-				spin_lock(&ns->ns_lock);
 				/* there is check for list_empty() inside */
-				ldlm_lock_remove_from_lru_nolock(lock);
-				ldlm_lock_add_to_lru_nolock(lock);
-				spin_unlock(&ns->ns_lock);
+				ldlm_lock_remove_from_lru(lock);
+				ldlm_lock_add_to_lru(lock);
 			}
 		}
 	}
@@ -1816,6 +1812,89 @@ ldlm_cancel_lru_policy(struct ldlm_namespace *ns, enum ldlm_lru_flags lru_flags)
 	return ldlm_cancel_default_policy;
 }
 
+/**
+ * Keep the protected LRU list within ns_lru_protected_pct of all LRU locks:
+ * its oldest locks go back to the tail of the probation list.
+ * Assumes LRU is already locked.
+ */
+static void ldlm_lru_balance_nolock(struct ldlm_namespace *ns)
+{
+	struct ldlm_lock *lock;
+
+	while (ns->ns_nr_protected > 0 &&
+	       ns->ns_nr_protected * 100ULL >
+	       (__u64)ns->ns_nr_unused * ns->ns_lru_protected_pct) {
+		lock = list_entry(ns->ns_protected_list.next,
+				  struct ldlm_lock, l_lru);
+		/* it has to be reused again to get back */
+		lock->l_lru_hit = 0;
+		lock->l_lru_reuse = 0;
+		ldlm_lock_move_in_lru_nolock(lock, false);
+	}
+}
+
+/**
+ * Find the next LRU lock to pass to the LRU policy, looking at the probation
+ * list first unless \a protected_only is set.
+ *
+ * Locks touched since they were put into the LRU or since the previous scan
+ * get another chance instead: they are moved to the tail of the protected
+ * list if they were reused LDLM_LRU_PROTECT_REUSE times, to the tail of the
+ * list they are on otherwise (probation if the protected list is off). Not
+ * more than \a rotate locks are moved this way, to bound the scan if all the
+ * locks are touched. Locks in use are never in the LRU, addref removes them.
+ * Assumes LRU is already locked.
+ */
+static struct ldlm_lock *ldlm_lru_next_nolock(struct ldlm_namespace *ns,
+					      bool no_wait,
+					      bool protected_only,
+					      int *rotate)
+{
+	struct list_head *head = &ns->ns_unused_list;
+	struct list_head *item, *next;
+	struct ldlm_lock *lock;
+
+	ldlm_lru_balance_nolock(ns);
+
+	item = no_wait ? ns->ns_last_pos : head;
+	if (protected_only) {
+		head = &ns->ns_protected_list;
+		item = head;
+	}
+again:
+	for (item = item->next, next = item->next; item != head;
+	     item = next, next = item->next) {
+		lock = list_entry(item, struct ldlm_lock, l_lru);
+
+		/* No locks which got blocking requests. */
+		LASSERT(!ldlm_is_bl_ast(lock));
+
+		if (ldlm_is_canceling(lock) || ldlm_is_converting(lock)) {
+			/* Somebody is already doing CANCEL. No need for this
+			 * lock in LRU, do not traverse it again. */
+			ldlm_lock_remove_from_lru_nolock(lock);
+			continue;
+		}
+
+		if (!lock->l_lru_hit || *rotate <= 0)
+			return lock;
+
+		(*rotate)--;
+		lock->l_lru_hit = 0;
+		ldlm_lock_move_in_lru_nolock(lock,
+					     lock->l_lru_protected ||
+					     ldlm_lock_lru_protect(lock));
+	}
+
+	if (head == &ns->ns_unused_list) {
+		head = &ns->ns_protected_list;
+		item = head;
+		goto again;
+	}
+
+	return NULL;
+}
+
 /**
  * - Free space in LRU for \a count new locks,
  *   redundant unused locks are canceled locally;
@@ -1852,6 +1931,9 @@ ldlm_cancel_lru_policy(struct ldlm_namespace *ns, enum ldlm_lru_flags lru_flags)
  * flags & LDLM_CANCEL_CLEANUP - when cancelling read locks, do not check for
  * 				other read locks covering the same pages, just
  * 				discard those pages.
+ *
+ * Locks in the probation LRU list are looked at before the protected ones,
+ * see ldlm_lru_next_nolock().
  */
 static int ldlm_prepare_lru_list(struct ldlm_namespace *ns,
 				 struct list_head *cancels, int count, int max,
@@ -1860,9 +1942,14 @@ static int ldlm_prepare_lru_list(struct ldlm_namespace *ns,
 	ldlm_cancel_lru_policy_t pf;
 	int added = 0;
 	int no_wait = lru_flags & LDLM_LRU_FLAG_NO_WAIT;
+	bool protected_only = false;
+	int rotate;
 
 	ENTRY;
 
+	ldlm_lru_pending_flush(ns);
+	rotate = ns->ns_nr_unused;
+
 	if (!ns_connect_lru_resize(ns))
 		count += ns->ns_nr_unused - ns->ns_max_unused;
 
@@ -1870,36 +1957,22 @@ static int ldlm_prepare_lru_list(struct ldlm_namespace *ns,
 	LASSERT(pf != NULL);
 
 	/* For any flags, stop scanning if @max is reached. */
-	while (!list_empty(&ns->ns_unused_list) && (max == 0 || added < max)) {
+	while (max == 0 || added < max) {
 		struct ldlm_lock *lock;
-		struct list_head *item, *next;
 		enum ldlm_policy_res result;
 		ktime_t last_use = ktime_set(0, 0);
+		bool was_protected;
 
 		spin_lock(&ns->ns_lock);
-		item = no_wait ? ns->ns_last_pos : &ns->ns_unused_list;
-		for (item = item->next, next = item->next;
-		     item != &ns->ns_unused_list;
-		     item = next, next = item->next) {
-			lock = list_entry(item, struct ldlm_lock, l_lru);
-
-			/* No locks which got blocking requests. */
-			LASSERT(!ldlm_is_bl_ast(lock));
-
-			if (!ldlm_is_canceling(lock) &&
-			    !ldlm_is_converting(lock))
-				break;
-
-			/* Somebody is already doing CANCEL. No need for this
-			 * lock in LRU, do not traverse it again. */
-			ldlm_lock_remove_from_lru_nolock(lock);
-		}
-		if (item == &ns->ns_unused_list) {
+		lock = ldlm_lru_next_nolock(ns, no_wait, protected_only,
+					    &rotate);
+		if (lock == NULL) {
 			spin_unlock(&ns->ns_lock);
 			break;
 		}
 
 		last_use = lock->l_last_used;
+		was_protected = lock->l_lru_protected;
 
 		LDLM_LOCK_GET(lock);
 		spin_unlock(&ns->ns_lock);
@@ -1922,6 +1995,11 @@ static int ldlm_prepare_lru_list(struct ldlm_namespace *ns,
 		if (result == LDLM_POLICY_KEEP_LOCK) {
 			lu_ref_del(&lock->l_reference, __func__, current);
 			LDLM_LOCK_RELEASE(lock);
+			/* The protected list may still have older locks. */
+			if (!was_protected && !protected_only) {
+				protected_only = true;
+				continue;
+			}
 			break;
 		}
 
@@ -1929,6 +2007,12 @@ static int ldlm_prepare_lru_list(struct ldlm_namespace *ns,
 			lu_ref_del(&lock->l_reference, __func__, current);
 			if (no_wait) {
 				spin_lock(&ns->ns_lock);
+				/* ns_last_pos only walks the probation list,
+				 * move the skipped lock there to pass it. */
+				if (!list_empty(&lock->l_lru) &&
+				    lock->l_lru_protected)
+					ldlm_lock_move_in_lru_nolock(lock,
+								     false);
 				if (!list_empty(&lock->l_lru) &&
 				    lock->l_lru.prev == ns->ns_last_pos)
 					ns->ns_last_pos = &lock->l_lru;
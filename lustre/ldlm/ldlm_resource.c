@@ -43,6 +43,9 @@
 
 struct kmem_cache *ldlm_resource_slab, *ldlm_lock_slab;
 struct kmem_cache *ldlm_interval_tree_slab;
+struct kmem_cache *ldlm_inodebits_slab;
+struct kmem_cache *ldlm_flock_index_slab;
+struct kmem_cache *ldlm_extent_contention_slab;
 
 int ldlm_srv_namespace_nr = 0;
 int ldlm_cli_namespace_nr = 0;
@@ -137,11 +140,7 @@ static ssize_t seq_watermark_write(struct file *file,
 		}
 
 		*data = watermark;
-		if (watermark != 0) {
-			watermark <<= 20;
-			do_div(watermark, sizeof(struct ldlm_lock));
-		}
-		ldlm_reclaim_threshold = watermark;
+		ldlm_reclaim_threshold = watermark << 20;
 	} else {
 		if (ldlm_reclaim_threshold_mb != 0 &&
 		    watermark < ldlm_reclaim_threshold_mb) {
@@ -151,11 +150,7 @@ static ssize_t seq_watermark_write(struct file *file,
 		}
 
 		*data = watermark;
-		if (watermark != 0) {
-			watermark <<= 20;
-			do_div(watermark, sizeof(struct ldlm_lock));
-		}
-		ldlm_lock_limit = watermark;
+		ldlm_lock_limit = watermark << 20;
 	}
 
 	return count;
@@ -195,6 +190,8 @@ static const struct file_operations ldlm_granted_fops = {
 	.release = seq_release,
 };
 
+LDEBUGFS_SEQ_FOPS_RO(ldlm_reclaim_stats);
+
 #endif /* HAVE_SERVER_SUPPORT */
 
 static struct lprocfs_vars ldlm_debugfs_list[] = {
@@ -214,6 +211,11 @@ static struct lprocfs_vars ldlm_debugfs_list[] = {
 	{ .name =	"lock_granted_count",
 	  .fops =	&ldlm_granted_fops,
 	  .data =	&ldlm_granted_total },
+	{ .name =	"lock_granted_bytes",
+	  .fops =	&ldlm_granted_fops,
+	  .data =	&ldlm_granted_bytes },
+	{ .name =	"lock_reclaim_stats",
+	  .fops =	&ldlm_reclaim_stats_fops },
 #endif
 	{ NULL }
 };
@@ -350,6 +352,9 @@ static ssize_t lru_size_store(struct kobject *kobj, struct attribute *attr,
 	int lru_resize;
 	int err;
 
+	/* count the locks released but not in the LRU yet */
+	ldlm_lru_pending_flush(ns);
+
 	if (strncmp(buffer, "clear", 5) == 0) {
                 CDEBUG(D_DLMTRACE,
                        "dropping all unused locks from namespace %s\n",
@@ -420,6 +425,85 @@ static ssize_t lru_size_store(struct kobject *kobj, struct attribute *attr,
 }
 LUSTRE_RW_ATTR(lru_size);
 
+static ssize_t lru_probation_count_show(struct kobject *kobj,
+					struct attribute *attr, char *buf)
+{
+	struct ldlm_namespace *ns = container_of(kobj, struct ldlm_namespace,
+						 ns_kobj);
+
+	return sprintf(buf, "%d\n", ns->ns_nr_unused - ns->ns_nr_protected);
+}
+LUSTRE_RO_ATTR(lru_probation_count);
+
+static ssize_t lru_protected_count_show(struct kobject *kobj,
+					struct attribute *attr, char *buf)
+{
+	struct ldlm_namespace *ns = container_of(kobj, struct ldlm_namespace,
+						 ns_kobj);
+
+	return sprintf(buf, "%d\n", ns->ns_nr_protected);
+}
+LUSTRE_RO_ATTR(lru_protected_count);
+
+static ssize_t lru_protected_pct_show(struct kobject *kobj,
+				      struct attribute *attr, char *buf)
+{
+	struct ldlm_namespace *ns = container_of(kobj, struct ldlm_namespace,
+						 ns_kobj);
+
+	return sprintf(buf, "%u\n", ns->ns_lru_protected_pct);
+}
+
+static ssize_t lru_protected_pct_store(struct kobject *kobj,
+				       struct attribute *attr,
+				       const char *buffer, size_t count)
+{
+	struct ldlm_namespace *ns = container_of(kobj, struct ldlm_namespace,
+						 ns_kobj);
+	unsigned long tmp;
+	int err;
+
+	err = kstrtoul(buffer, 10, &tmp);
+	if (err != 0)
+		return -EINVAL;
+
+	if (tmp > 100)
+		return -ERANGE;
+
+	/* the protected list is trimmed by the next LRU scan */
+	ns->ns_lru_protected_pct = tmp;
+
+	return count;
+}
+LUSTRE_RW_ATTR(lru_protected_pct);
+
+/* Percentage of LRU lock uses which found the lock still cached. */
+static ssize_t lru_hit_rate_show(struct kobject *kobj, struct attribute *attr,
+				 char *buf)
+{
+	struct ldlm_namespace *ns = container_of(kobj, struct ldlm_namespace,
+						 ns_kobj);
+	__u64 inserts;
+	__u64 hits;
+
+	inserts = lprocfs_stats_collector(ns->ns_stats, LDLM_NSS_LRU_INSERTS,
+					  LPROCFS_FIELDS_FLAGS_SUM);
+	hits = lprocfs_stats_collector(ns->ns_stats,
+				       LDLM_NSS_LRU_HITS_PROBATION,
+				       LPROCFS_FIELDS_FLAGS_SUM) +
+	       lprocfs_stats_collector(ns->ns_stats,
+				       LDLM_NSS_LRU_HITS_PROTECTED,
+				       LPROCFS_FIELDS_FLAGS_SUM);
+	inserts += hits;
+	if (inserts == 0)
+		return sprintf(buf, "0\n");
+
+	hits *= 100;
+	do_div(hits, inserts);
+	return sprintf(buf, "%llu\n", hits);
+}
+LUSTRE_RO_ATTR(lru_hit_rate);
+
 static ssize_t lru_max_age_show(struct kobject *kobj, struct attribute *attr,
 				char *buf)
 {
@@ -635,6 +719,37 @@ static ssize_t contended_locks_store(struct kobject *kobj,
 }
 LUSTRE_RW_ATTR(contended_locks);
 
+static ssize_t contended_clients_show(struct kobject *kobj,
+				      struct attribute *attr, char *buf)
+{
+	struct ldlm_namespace *ns = container_of(kobj, struct ldlm_namespace,
+						 ns_kobj);
+
+	return sprintf(buf, "%u\n", ns->ns_contended_clients);
+}
+
+static ssize_t contended_clients_store(struct kobject *kobj,
+				       struct attribute *attr,
+				       const char *buffer, size_t count)
+{
+	struct ldlm_namespace *ns = container_of(kobj, struct ldlm_namespace,
+						 ns_kobj);
+	unsigned long tmp;
+	int err;
+
+	err = kstrtoul(buffer, 10, &tmp);
+	if (err != 0)
+		return -EINVAL;
+
+	if (tmp > LDLM_CONTENTION_CLIENTS)
+		return -ERANGE;
+
+	ns->ns_contended_clients = tmp;
+
+	return count;
+}
+LUSTRE_RW_ATTR(contended_clients);
+
 static ssize_t max_parallel_ast_show(struct kobject *kobj,
 				     struct attribute *attr, char *buf)
 {
@@ -663,6 +778,37 @@ static ssize_t max_parallel_ast_store(struct kobject *kobj,
 }
 LUSTRE_RW_ATTR(max_parallel_ast);
 
+static ssize_t max_ast_batch_show(struct kobject *kobj,
+				  struct attribute *attr, char *buf)
+{
+	struct ldlm_namespace *ns = container_of(kobj, struct ldlm_namespace,
+						 ns_kobj);
+
+	return sprintf(buf, "%u\n", ns->ns_max_ast_batch);
+}
+
+static ssize_t max_ast_batch_store(struct kobject *kobj,
+				   struct attribute *attr,
+				   const char *buffer, size_t count)
+{
+	struct ldlm_namespace *ns = container_of(kobj, struct ldlm_namespace,
+						 ns_kobj);
+	unsigned long tmp;
+	int err;
+
+	err = kstrtoul(buffer, 10, &tmp);
+	if (err != 0)
+		return -EINVAL;
+
+	if (tmp > LDLM_MAX_AST_BATCH)
+		return -ERANGE;
+
+	ns->ns_max_ast_batch = tmp;
+
+	return count;
+}
+LUSTRE_RW_ATTR(max_ast_batch);
+
 #endif /* HAVE_SERVER_SUPPORT */
 
 /* These are for namespaces in /sys/fs/lustre/ldlm/namespaces/ */
@@ -671,6 +817,10 @@ static struct attribute *ldlm_ns_attrs[] = {
 	&lustre_attr_lock_count.attr,
 	&lustre_attr_lock_unused_count.attr,
 	&lustre_attr_lru_size.attr,
+	&lustre_attr_lru_probation_count.attr,
+	&lustre_attr_lru_protected_count.attr,
+	&lustre_attr_lru_protected_pct.attr,
+	&lustre_attr_lru_hit_rate.attr,
 	&lustre_attr_lru_max_age.attr,
 	&lustre_attr_early_lock_cancel.attr,
 	&lustre_attr_dirty_age_limit.attr,
@@ -680,7 +830,9 @@ static struct attribute *ldlm_ns_attrs[] = {
 	&lustre_attr_max_nolock_bytes.attr,
 	&lustre_attr_contention_seconds.attr,
 	&lustre_attr_contended_locks.attr,
+	&lustre_attr_contended_clients.attr,
 	&lustre_attr_max_parallel_ast.attr,
+	&lustre_attr_max_ast_batch.attr,
 #endif
 	NULL,
 };
@@ -733,6 +885,20 @@ int ldlm_namespace_sysfs_register(struct ldlm_namespace *ns)
 
 	lprocfs_counter_init(ns->ns_stats, LDLM_NSS_LOCKS,
 			     LPROCFS_CNTR_AVGMINMAX, "locks", "locks");
+	lprocfs_counter_init(ns->ns_stats, LDLM_NSS_LRU_INSERTS, 0,
+			     "lru_inserts", "locks");
+	lprocfs_counter_init(ns->ns_stats, LDLM_NSS_LRU_HITS_PROBATION, 0,
+			     "lru_hits_probation", "locks");
+	lprocfs_counter_init(ns->ns_stats, LDLM_NSS_LRU_HITS_PROTECTED, 0,
+			     "lru_hits_protected", "locks");
+	lprocfs_counter_init(ns->ns_stats, LDLM_NSS_FLOCK_ENQUEUE_TIME,
+			     LPROCFS_CNTR_AVGMINMAX, "flock_enqueue", "usecs");
+	lprocfs_counter_init(ns->ns_stats, LDLM_NSS_FLOCK_DEADLOCK_CHECKS, 0,
+			     "flock_deadlock_checks", "checks");
+	lprocfs_counter_init(ns->ns_stats, LDLM_NSS_FLOCK_DEADLOCKS, 0,
+			     "flock_deadlocks", "deadlocks");
+	lprocfs_counter_init(ns->ns_stats, LDLM_NSS_RECLAIM_REVOKED, 0,
+			     "reclaim_revoked", "locks");
 
 	return err;
 }
@@ -751,7 +917,7 @@ static int ldlm_namespace_debugfs_register(struct ldlm_namespace *ns)
 		ns->ns_debugfs_entry = ns_entry;
 	}
 
-	return 0;
+	return ldebugfs_register_stats(ns_entry, "stats", ns->ns_stats);
 }
 #undef MAX_STRING_SIZE
 
@@ -920,6 +1086,7 @@ struct ldlm_namespace *ldlm_namespace_new(struct obd_device *obd, char *name,
 	struct ldlm_namespace *ns = NULL;
 	struct ldlm_ns_bucket *nsb;
 	struct ldlm_ns_hash_def *nsd;
+	struct ldlm_lru_pending *lp;
 	struct cfs_hash_bd bd;
 	int idx;
 	int rc;
@@ -965,7 +1132,6 @@ struct ldlm_namespace *ldlm_namespace_new(struct obd_device *obd, char *name,
                 nsb = cfs_hash_bd_extra_get(ns->ns_rs_hash, &bd);
                 at_init(&nsb->nsb_at_estimate, ldlm_enqueue_min, 0);
                 nsb->nsb_namespace = ns;
-		nsb->nsb_reclaim_start = 0;
         }
 
 	ns->ns_obd = obd;
@@ -977,6 +1143,7 @@ struct ldlm_namespace *ldlm_namespace_new(struct obd_device *obd, char *name,
 
 	INIT_LIST_HEAD(&ns->ns_list_chain);
 	INIT_LIST_HEAD(&ns->ns_unused_list);
+	INIT_LIST_HEAD(&ns->ns_protected_list);
 	spin_lock_init(&ns->ns_lock);
 	atomic_set(&ns->ns_bref, 0);
 	init_waitqueue_head(&ns->ns_waitq);
@@ -984,8 +1151,10 @@ struct ldlm_namespace *ldlm_namespace_new(struct obd_device *obd, char *name,
 	ns->ns_max_nolock_size    = NS_DEFAULT_MAX_NOLOCK_BYTES;
 	ns->ns_contention_time    = NS_DEFAULT_CONTENTION_SECONDS;
 	ns->ns_contended_locks    = NS_DEFAULT_CONTENDED_LOCKS;
+	ns->ns_contended_clients  = NS_DEFAULT_CONTENDED_CLIENTS;
 
         ns->ns_max_parallel_ast   = LDLM_DEFAULT_PARALLEL_AST_LIMIT;
+	ns->ns_max_ast_batch      = LDLM_DEFAULT_AST_BATCH;
         ns->ns_nr_unused          = 0;
         ns->ns_max_unused         = LDLM_DEFAULT_LRU_SIZE;
 	ns->ns_max_age            = ktime_set(LDLM_DEFAULT_MAX_ALIVE, 0);
@@ -995,13 +1164,24 @@ struct ldlm_namespace *ldlm_namespace_new(struct obd_device *obd, char *name,
         ns->ns_orig_connect_flags = 0;
         ns->ns_connect_flags      = 0;
         ns->ns_stopping           = 0;
-	ns->ns_reclaim_start	  = 0;
 	ns->ns_last_pos		  = &ns->ns_unused_list;
+	ns->ns_nr_protected	  = 0;
+	ns->ns_lru_protected_pct  = LDLM_DEFAULT_LRU_PROTECTED_PCT;
+	ldlm_reclaim_ns_init(ns);
+
+	ns->ns_lru_pending = cfs_percpt_alloc(cfs_cpt_tab, sizeof(*lp));
+	if (ns->ns_lru_pending == NULL)
+		GOTO(out_hash, NULL);
+	cfs_percpt_for_each(lp, idx, ns->ns_lru_pending) {
+		spin_lock_init(&lp->lp_lock);
+		INIT_LIST_HEAD(&lp->lp_list);
+		lp->lp_count = 0;
+	}
 
 	rc = ldlm_namespace_sysfs_register(ns);
 	if (rc) {
 		CERROR("Can't initialize ns sysfs, rc %d\n", rc);
-		GOTO(out_hash, rc);
+		GOTO(out_pending, rc);
 	}
 
 	rc = ldlm_namespace_debugfs_register(ns);
@@ -1024,6 +1204,8 @@ out_proc:
 out_sysfs:
 	ldlm_namespace_sysfs_unregister(ns);
 	ldlm_namespace_cleanup(ns, 0);
+out_pending:
+	cfs_percpt_free(ns->ns_lru_pending);
 out_hash:
 	kfree(ns->ns_name);
 	cfs_hash_putref(ns->ns_rs_hash);
@@ -1275,6 +1457,9 @@ EXPORT_SYMBOL(ldlm_namespace_free_prior);
  */
 void ldlm_namespace_free_post(struct ldlm_namespace *ns)
 {
+	struct ldlm_lru_pending *lp;
+	int i;
+
         ENTRY;
         if (!ns) {
                 EXIT;
@@ -1292,6 +1477,10 @@ void ldlm_namespace_free_post(struct ldlm_namespace *ns)
 	ldlm_namespace_sysfs_unregister(ns);
 	cfs_hash_putref(ns->ns_rs_hash);
 	kfree(ns->ns_name);
+	/* all the locks are gone, destroy took them off the pending lists */
+	cfs_percpt_for_each(lp, i, ns->ns_lru_pending)
+		LASSERT(list_empty(&lp->lp_list));
+	cfs_percpt_free(ns->ns_lru_pending);
 	/* Namespace \a ns should be not on list at this time, otherwise
 	 * this will cause issues related to using freed \a ns in poold
 	 * thread.
@@ -1401,7 +1590,8 @@ struct ldlm_namespace *ldlm_namespace_first_locked(enum ldlm_side client)
 }
 
 /** Create and initialize new resource. */
-static struct ldlm_resource *ldlm_resource_new(enum ldlm_type ldlm_type)
+static struct ldlm_resource *ldlm_resource_new(struct ldlm_namespace *ns,
+					       enum ldlm_type ldlm_type)
 {
 	struct ldlm_resource *res;
 	int idx;
@@ -1411,18 +1601,43 @@ static struct ldlm_resource *ldlm_resource_new(enum ldlm_type ldlm_type)
 		return NULL;
 
 	if (ldlm_type == LDLM_EXTENT) {
-		OBD_SLAB_ALLOC(res->lr_itree, ldlm_interval_tree_slab,
-			       sizeof(*res->lr_itree) * LCK_MODE_NUM);
-		if (res->lr_itree == NULL) {
+		struct ldlm_extent_index *lei;
+
+		OBD_SLAB_ALLOC_PTR_GFP(lei, ldlm_interval_tree_slab, GFP_NOFS);
+		if (lei == NULL) {
 			OBD_SLAB_FREE_PTR(res, ldlm_resource_slab);
 			return NULL;
 		}
+		if (ns_is_server(ns)) {
+			OBD_SLAB_ALLOC_PTR_GFP(lei->lei_contention,
+					       ldlm_extent_contention_slab,
+					       GFP_NOFS);
+			if (lei->lei_contention == NULL) {
+				OBD_SLAB_FREE_PTR(lei, ldlm_interval_tree_slab);
+				OBD_SLAB_FREE_PTR(res, ldlm_resource_slab);
+				return NULL;
+			}
+		}
+		res->lr_itree = lei->lei_itree;
 		/* Initialize interval trees for each lock mode. */
-		for (idx = 0; idx < LCK_MODE_NUM; idx++) {
-			res->lr_itree[idx].lit_size = 0;
+		for (idx = 0; idx < LCK_MODE_NUM; idx++)
 			res->lr_itree[idx].lit_mode = 1 << idx;
-			res->lr_itree[idx].lit_root = NULL;
+	} else if (ldlm_type == LDLM_IBITS && ns_is_server(ns)) {
+		OBD_SLAB_ALLOC_PTR_GFP(res->lr_ibits_queues,
+				       ldlm_inodebits_slab, GFP_NOFS);
+		if (res->lr_ibits_queues == NULL) {
+			OBD_SLAB_FREE_PTR(res, ldlm_resource_slab);
+			return NULL;
 		}
+	} else if (ldlm_type == LDLM_FLOCK && ns_is_server(ns)) {
+		OBD_SLAB_ALLOC_PTR_GFP(res->lr_flock_index,
+				       ldlm_flock_index_slab, GFP_NOFS);
+		if (res->lr_flock_index == NULL) {
+			OBD_SLAB_FREE_PTR(res, ldlm_resource_slab);
+			return NULL;
+		}
+		for (idx = 0; idx < LCK_MODE_NUM; idx++)
+			res->lr_flock_index->lfi_itree[idx].lit_mode = 1 << idx;
 	}
 
 	INIT_LIST_HEAD(&res->lr_granted);
@@ -1440,6 +1655,69 @@ static struct ldlm_resource *ldlm_resource_new(enum ldlm_type ldlm_type)
 	return res;
 }
 
+static void ldlm_resource_free(struct ldlm_resource *res)
+{
+	if (res->lr_type == LDLM_EXTENT) {
+		if (res->lr_itree != NULL) {
+			struct ldlm_extent_index *lei;
+
+			lei = ldlm_res_extent_index(res);
+			if (lei->lei_contention != NULL)
+				OBD_SLAB_FREE_PTR(lei->lei_contention,
+						  ldlm_extent_contention_slab);
+			OBD_SLAB_FREE_PTR(lei, ldlm_interval_tree_slab);
+		}
+	} else if (res->lr_type == LDLM_IBITS) {
+		if (res->lr_ibits_queues != NULL)
+			OBD_SLAB_FREE_PTR(res->lr_ibits_queues,
+					  ldlm_inodebits_slab);
+	} else if (res->lr_type == LDLM_FLOCK) {
+		if (res->lr_flock_index != NULL)
+			OBD_SLAB_FREE_PTR(res->lr_flock_index,
+					  ldlm_flock_index_slab);
+	}
+	OBD_SLAB_FREE(res, ldlm_resource_slab, sizeof *res);
+}
+
+static void ldlm_resource_free_rcu(struct rcu_head *head)
+{
+	ldlm_resource_free(container_of(head, struct ldlm_resource, lr_rcu));
+}
+
+/**
+ * Lockless lookup of the resource with given name.
+ *
+ * Resource hash of a namespace is never rehashed and resources are freed
+ * after an RCU grace period once removed from the hash, so the hash chain
+ * may be walked without the bucket lock. A resource whose last reference
+ * is being dropped is skipped.
+ *
+ * \retval referenced resource or NULL if not found, a miss may be false and
+ *	   has to be checked again under the bucket lock
+ */
+static struct ldlm_resource *
+ldlm_resource_lookup_rcu(struct ldlm_namespace *ns,
+			 const struct ldlm_res_id *name)
+{
+	struct ldlm_resource *res;
+	struct cfs_hash_bd bd;
+
+	cfs_hash_bd_get(ns->ns_rs_hash, (void *)name, &bd);
+
+	rcu_read_lock();
+	hlist_for_each_entry_rcu(res, cfs_hash_bd_hhead(ns->ns_rs_hash, &bd),
+				 lr_hash) {
+		if (!ldlm_res_eq(name, &res->lr_name))
+			continue;
+		if (!atomic_inc_not_zero(&res->lr_refcount))
+			res = NULL;
+		break;
+	}
+	rcu_read_unlock();
+
+	return res;
+}
+
 /**
  * Return a reference to resource with given name, creating it if necessary.
  * Args: namespace with ns_lock unlocked
@@ -1462,6 +1740,10 @@ ldlm_resource_get(struct ldlm_namespace *ns, struct ldlm_resource *parent,
         LASSERT(ns->ns_rs_hash != NULL);
         LASSERT(name->name[0] != 0);
 
+	res = ldlm_resource_lookup_rcu(ns, name);
+	if (res != NULL)
+		return res;
+
         cfs_hash_bd_get_and_lock(ns->ns_rs_hash, (void *)name, &bd, 0);
         hnode = cfs_hash_bd_lookup_locked(ns->ns_rs_hash, &bd, (void *)name);
         if (hnode != NULL) {
@@ -1477,7 +1759,7 @@ ldlm_resource_get(struct ldlm_namespace *ns, struct ldlm_resource *parent,
 
 	LASSERTF(type >= LDLM_MIN_TYPE && type < LDLM_MAX_TYPE,
 		 "type: %d\n", type);
-	res = ldlm_resource_new(type);
+	res = ldlm_resource_new(ns, type);
 	if (res == NULL)
 		return ERR_PTR(-ENOMEM);
 
@@ -1494,10 +1776,7 @@ ldlm_resource_get(struct ldlm_namespace *ns, struct ldlm_resource *parent,
 		cfs_hash_bd_unlock(ns->ns_rs_hash, &bd, 1);
 		/* Clean lu_ref for failed resource. */
 		lu_ref_fini(&res->lr_reference);
-		if (res->lr_itree != NULL)
-			OBD_SLAB_FREE(res->lr_itree, ldlm_interval_tree_slab,
-				      sizeof(*res->lr_itree) * LCK_MODE_NUM);
-		OBD_SLAB_FREE(res, ldlm_resource_slab, sizeof *res);
+		ldlm_resource_free(res);
 found:
 		res = hlist_entry(hnode, struct ldlm_resource, lr_hash);
 		return res;
@@ -1573,10 +1852,8 @@ int ldlm_resource_putref(struct ldlm_resource *res)
 		cfs_hash_bd_unlock(ns->ns_rs_hash, &bd, 1);
 		if (ns->ns_lvbo && ns->ns_lvbo->lvbo_free)
 			ns->ns_lvbo->lvbo_free(res);
-		if (res->lr_itree != NULL)
-			OBD_SLAB_FREE(res->lr_itree, ldlm_interval_tree_slab,
-				      sizeof(*res->lr_itree) * LCK_MODE_NUM);
-		OBD_SLAB_FREE(res, ldlm_resource_slab, sizeof *res);
+		/* lockless lookups may still look at it */
+		call_rcu(&res->lr_rcu, ldlm_resource_free_rcu);
 		return 1;
 	}
 	return 0;
@@ -1638,6 +1915,8 @@ void ldlm_resource_unlink_lock(struct ldlm_lock *lock)
                 ldlm_unlink_lock_skiplist(lock);
         else if (type == LDLM_EXTENT)
                 ldlm_extent_unlink_lock(lock);
+	else if (type == LDLM_FLOCK)
+		ldlm_flock_unlink_lock(lock);
 	list_del_init(&lock->l_res_link);
 }
 EXPORT_SYMBOL(ldlm_resource_unlink_lock);
@@ -1743,5 +2022,14 @@ void ldlm_resource_dump(int level, struct ldlm_resource *res)
 		list_for_each_entry(lock, &res->lr_waiting, l_res_link)
 			LDLM_DEBUG_LIMIT(level, lock, "###");
 	}
+
+	if (res->lr_type == LDLM_EXTENT && ns_is_server(ldlm_res_to_ns(res))) {
+		struct ldlm_extent_contention *lec = ldlm_res_contention(res);
+
+		CDEBUG(level, "Contention: window %lld conflicts %u clients %u "
+		       "stride %llu req_len %llu contended %lld\n",
+		       lec->lec_window, lec->lec_conflicts, lec->lec_nclients,
+		       lec->lec_stride, lec->lec_req_len, lec->lec_time);
+	}
 }
 EXPORT_SYMBOL(ldlm_resource_dump);
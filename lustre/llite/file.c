@@ -619,6 +619,7 @@ static int ll_local_open(struct file *file, struct lookup_intent *it,
 
 	LUSTRE_FPRIVATE(file) = fd;
 	ll_readahead_init(inode, &fd->fd_ras);
+	ll_write_stride_init(&fd->fd_wss);
 	fd->fd_omode = it->it_flags & (FMODE_READ | FMODE_WRITE | FMODE_EXEC);
 
 	/* ll_cl_context initialize */
@@ -1340,6 +1341,11 @@ static void ll_io_init(struct cl_io *io, struct file *file, enum cl_io_type iot)
 	io->ci_lock_no_expand = fd->ll_lock_no_expand;
 
 	if (iot == CIT_WRITE) {
+		/* the locks of the next strides are requested ahead, so do
+		 * not let the lock of this one grow over them */
+		if (ll_i2sbi(inode)->ll_lockahead_depth > 0 &&
+		    ll_write_stride_mode(&fd->fd_wss))
+			io->ci_lock_no_expand = 1;
 		io->u.ci_rw.rw_append = !!(file->f_flags & O_APPEND);
 		io->u.ci_rw.rw_sync   = !!(file->f_flags & O_SYNC ||
 					   file->f_flags & O_DIRECT ||
@@ -1439,6 +1445,52 @@ static int ll_file_io_ptask(struct cfs_ptask *ptask)
 	RETURN(pt->cip_result > 0 ? 0 : rc);
 }
 
+/**
+ * Request write locks ahead for the next strides of a strided writer.
+ *
+ * Called after each successful write through a file descriptor. Once the
+ * write stride detector sees the pattern of interleaved writers of a shared
+ * file, asynchronous lockahead requests are sent for the next
+ * ll_lockahead_depth strides, so that the writes find their locks already
+ * granted instead of taking away the locks of the other writers.
+ *
+ * \param[in] file	file written
+ * \param[in] pos	offset of the write
+ * \param[in] count	bytes written
+ */
+static void ll_write_lockahead(struct file *file, loff_t pos, size_t count)
+{
+	struct ll_sb_info *sbi = ll_i2sbi(file_inode(file));
+	struct ll_file_data *fd = LUSTRE_FPRIVATE(file);
+	struct llapi_lu_ladvise ladvise = {
+		.lla_advice		= LU_LADVISE_LOCKAHEAD,
+		.lla_lockahead_mode	= MODE_WRITE_USER,
+		.lla_peradvice_flags	= LF_ASYNC,
+	};
+	loff_t start;
+	loff_t stride;
+	int nr;
+	int rc;
+
+	nr = ll_write_stride_update(&fd->fd_wss, pos, count,
+				    sbi->ll_lockahead_depth, &start, &stride);
+	for (; nr > 0; nr--, start += stride) {
+		ladvise.lla_start = start;
+		ladvise.lla_end = start + count - 1;
+		rc = ll_file_lock_ahead(file, &ladvise);
+		if (rc < 0) {
+			CDEBUG(D_VFSTRACE, "%s: lockahead [%llu, %llu] failed: "
+			       "rc = %d\n", file_dentry(file)->d_name.name,
+			       ladvise.lla_start, ladvise.lla_end, rc);
+			break;
+		}
+		CDEBUG(D_VFSTRACE, "%s: lockahead [%llu, %llu] requested\n",
+		       file_dentry(file)->d_name.name, ladvise.lla_start,
+		       ladvise.lla_end);
+		ll_stats_ops_tally(sbi, LPROC_LL_LOCKAHEAD_AUTO, 1);
+	}
+}
+
 static ssize_t
 ll_file_io_generic(const struct lu_env *env, struct vvp_io_args *args,
 		   struct file *file, enum cl_io_type iot,
@@ -1586,6 +1638,13 @@ out:
 			ll_stats_ops_tally(ll_i2sbi(inode),
 					   LPROC_LL_WRITE_BYTES, result);
 			fd->fd_write_failed = false;
+			if (args->via_io_subtype == IO_NORMAL &&
+			    !(file->f_flags & O_APPEND) &&
+			    !(fd->fd_flags & LL_FILE_GROUP_LOCKED) &&
+			    !ll_file_nolock(file))
+				/* *ppos is already past the write here */
+				ll_write_lockahead(file, *ppos - result,
+						   result);
 		} else if (result == 0 && rc == 0) {
 			rc = io->ci_result;
 			if (rc < 0)
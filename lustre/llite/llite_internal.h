@@ -537,6 +537,10 @@ struct ll_sb_info {
 						  * count */
 	atomic_t		  ll_agl_total;  /* AGL thread started count */
 
+	/* strides of a strided writer to request write locks ahead for,
+	 * 0 disables automatic lockahead */
+	unsigned int		  ll_lockahead_depth;
+
 	dev_t			  ll_sdev_orig; /* save s_dev before assign for
 						 * clustred nfs */
 	/* root squash */
@@ -571,7 +575,7 @@ struct ll_readahead_state {
          * XXX nikita: window is also reset (by ras_update()) when Lustre
          * believes that memory pressure evicts read-ahead pages. In that
          * case, it probably doesn't make sense to expand window to
-         * PTLRPC_MAX_BRW_PAGES on the third access.
+         * ras_rpc_size on the third access.
          */
         unsigned long   ras_consecutive_pages;
         /*
@@ -584,8 +588,8 @@ struct ll_readahead_state {
          * Parameters of current read-ahead window. Handled by
          * ras_update(). On the initial access to the file or after a seek,
          * window is reset to 0. After 3 consecutive accesses, window is
-         * expanded to PTLRPC_MAX_BRW_PAGES. Afterwards, window is enlarged by
-         * PTLRPC_MAX_BRW_PAGES chunks up to ->ra_max_pages.
+         * expanded to ras_rpc_size. Afterwards, window is enlarged by
+         * ras_rpc_size chunks up to ->ra_max_pages.
          */
         unsigned long   ras_window_start, ras_window_len;
 	/*
@@ -635,10 +639,32 @@ struct ll_readahead_state {
         unsigned long   ras_consecutive_stride_requests;
 };
 
+/*
+ * per file-descriptor write pattern, used to detect strided writes to a
+ * shared file and to request their locks ahead, see ll_write_stride_update().
+ * Same model as the read-ahead stride detector above:
+ *
+ *    offset      |-stride_bytes-|-stride_gap-|
+ *    ws_stride_length = stride_bytes + stride_gap;
+ */
+struct ll_write_stride_state {
+	spinlock_t	ws_lock;
+	/* byte range [start, end) of the last write */
+	loff_t		ws_last_start;
+	loff_t		ws_last_end;
+	loff_t		ws_stride_length;
+	/* number of consecutive writes in the stride pattern, stride mode
+	 * is only enabled after 2 of them */
+	unsigned long	ws_consecutive_strides;
+	/* first stride which locks were not requested ahead for yet */
+	loff_t		ws_ahead_next;
+};
+
 extern struct kmem_cache *ll_file_data_slab;
 struct lustre_handle;
 struct ll_file_data {
 	struct ll_readahead_state fd_ras;
+	struct ll_write_stride_state fd_wss;
 	struct ll_grouplock fd_grouplock;
 	__u64 lfd_pos;
 	__u32 fd_flags;
@@ -767,6 +793,7 @@ enum {
 	LPROC_LL_LISTXATTR,
 	LPROC_LL_REMOVEXATTR,
 	LPROC_LL_INODE_PERM,
+	LPROC_LL_LOCKAHEAD_AUTO,
 	LPROC_LL_FILE_OPCODES
 };
 
@@ -816,6 +843,11 @@ int ll_readpage(struct file *file, struct page *page);
 int ll_io_read_page(const struct lu_env *env, struct cl_io *io,
 			   struct cl_page *page, struct file *file);
 void ll_readahead_init(struct inode *inode, struct ll_readahead_state *ras);
+void ll_write_stride_init(struct ll_write_stride_state *wss);
+bool ll_write_stride_mode(struct ll_write_stride_state *wss);
+int ll_write_stride_update(struct ll_write_stride_state *wss, loff_t pos,
+			   size_t count, unsigned int depth,
+			   loff_t *ahead_start, loff_t *ahead_stride);
 int vvp_io_write_commit(const struct lu_env *env, struct cl_io *io);
 
 enum lcc_type;
@@ -1179,6 +1211,10 @@ enum ras_update_flags {
 void ll_ra_count_put(struct ll_sb_info *sbi, unsigned long len);
 void ll_ra_stats_inc(struct inode *inode, enum ra_stat which);
 
+/* rw.c, automatic lockahead for strided writers */
+#define LL_LOCKAHEAD_DEPTH_DEF	4
+#define LL_LOCKAHEAD_DEPTH_MAX	64
+
 /* statahead.c */
 
 #define LL_SA_RPC_MIN           2
@@ -510,8 +510,9 @@ ll_max_cached_mb_seq_write(struct file *file, const char __user *buffer,
 		       totalram_pages >> (20 - PAGE_SHIFT));
 		RETURN(-ERANGE);
 	}
-	/* Allow enough cache so clients can make well-formed RPCs */
-	pages_number = max_t(long, pages_number, PTLRPC_MAX_BRW_PAGES);
+	/* Allow enough cache so clients can make well-formed RPCs of the
+	 * default size, larger brw_size needs a correspondingly larger cache */
+	pages_number = max_t(long, pages_number, PTLRPC_DEF_BRW_PAGES);
 
 	spin_lock(&sbi->ll_lock);
 	diff = pages_number - cache->ccc_lru_max;
@@ -734,6 +735,40 @@ static ssize_t statahead_running_max_store(struct kobject *kobj,
 }
 LUSTRE_RW_ATTR(statahead_running_max);
 
+static ssize_t lockahead_depth_show(struct kobject *kobj,
+				    struct attribute *attr, char *buf)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+
+	return snprintf(buf, 16, "%u\n", sbi->ll_lockahead_depth);
+}
+
+static ssize_t lockahead_depth_store(struct kobject *kobj,
+				     struct attribute *attr,
+				     const char *buffer, size_t count)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+	unsigned long val;
+	int rc;
+
+	rc = kstrtoul(buffer, 0, &val);
+	if (rc)
+		return rc;
+
+	if (val > LL_LOCKAHEAD_DEPTH_MAX) {
+		CERROR("Bad lockahead_depth value %lu. Valid values are in "
+		       "the range [0, %d]\n", val, LL_LOCKAHEAD_DEPTH_MAX);
+		return -ERANGE;
+	}
+
+	sbi->ll_lockahead_depth = val;
+
+	return count;
+}
+LUSTRE_RW_ATTR(lockahead_depth);
+
 static int ll_statahead_max_seq_show(struct seq_file *m, void *v)
 {
 	struct super_block *sb = m->private;
@@ -1235,6 +1270,7 @@ static struct attribute *llite_attrs[] = {
 	&lustre_attr_fstype.attr,
 	&lustre_attr_uuid.attr,
 	&lustre_attr_statahead_running_max.attr,
+	&lustre_attr_lockahead_depth.attr,
 	NULL,
 };
 
@@ -1299,6 +1335,7 @@ static const struct llite_file_opcode {
         { LPROC_LL_LISTXATTR,      LPROCFS_TYPE_REGS, "listxattr" },
         { LPROC_LL_REMOVEXATTR,    LPROCFS_TYPE_REGS, "removexattr" },
         { LPROC_LL_INODE_PERM,     LPROCFS_TYPE_REGS, "inode_permission" },
+	{ LPROC_LL_LOCKAHEAD_AUTO, LPROCFS_TYPE_REGS, "lockahead_auto" },
 };
 
 void ll_stats_ops_tally(struct ll_sb_info *sbi, int op, int count)
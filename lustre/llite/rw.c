@@ -92,7 +92,7 @@ static unsigned long ll_ra_count_get(struct ll_sb_info *sbi,
          * performance a lot. */
 	ret = min(ra->ra_max_pages - atomic_read(&ra->ra_cur_pages),
 		  pages);
-        if (ret < 0 || ret < min_t(long, PTLRPC_MAX_BRW_PAGES, pages))
+	if (ret < 0 || ret < min_t(long, PTLRPC_DEF_BRW_PAGES, pages))
                 GOTO(out, ret = 0);
 
 	if (atomic_add_return(ret, &ra->ra_cur_pages) > ra->ra_max_pages) {
@@ -367,9 +367,10 @@ ll_read_ahead_pages(const struct lu_env *env, struct cl_io *io,
 				LASSERTF(ra.cra_end >= page_idx,
 					 "object: %p, indcies %lu / %lu\n",
 					 io->ci_obj, ra.cra_end, page_idx);
-				/* update read ahead RPC size.
+				/* update read ahead RPC size, it can also grow
+				 * if a bigger brw_size was negotiated.
 				 * NB: it's racy but doesn't matter */
-				if (ras->ras_rpc_size > ra.cra_rpc_size &&
+				if (ras->ras_rpc_size != ra.cra_rpc_size &&
 				    ra.cra_rpc_size > 0)
 					ras->ras_rpc_size = ra.cra_rpc_size;
 				/* trim it to align with optimal RPC size */
@@ -597,11 +598,99 @@ static void ras_stride_reset(struct ll_readahead_state *ras)
 void ll_readahead_init(struct inode *inode, struct ll_readahead_state *ras)
 {
 	spin_lock_init(&ras->ras_lock);
-	ras->ras_rpc_size = PTLRPC_MAX_BRW_PAGES;
+	ras->ras_rpc_size = PTLRPC_DEF_BRW_PAGES;
 	ras_reset(inode, ras, 0);
 	ras->ras_requests = 0;
 }
 
+void ll_write_stride_init(struct ll_write_stride_state *wss)
+{
+	spin_lock_init(&wss->ws_lock);
+	wss->ws_last_start = 0;
+	wss->ws_last_end = 0;
+	wss->ws_stride_length = 0;
+	wss->ws_consecutive_strides = 0;
+	wss->ws_ahead_next = 0;
+}
+
+static inline int ws_stride_mode(struct ll_write_stride_state *wss)
+{
+	return wss->ws_consecutive_strides > 1;
+}
+
+bool ll_write_stride_mode(struct ll_write_stride_state *wss)
+{
+	bool stride;
+
+	spin_lock(&wss->ws_lock);
+	stride = ws_stride_mode(wss);
+	spin_unlock(&wss->ws_lock);
+
+	return stride;
+}
+
+/**
+ * Update the write stride detector of a file descriptor with a write of
+ * \a count bytes at \a pos.
+ *
+ * Like ras_update_stride_detector() does for reads, writes of the same size
+ * separated by the same gap are taken as a stride pattern, which is what
+ * interleaved writers of a shared file produce. Once the pattern is
+ * established, finds the strides among the next \a depth ones which locks
+ * were not requested ahead for yet.
+ *
+ * \param[in] wss		write stride state of the file descriptor
+ * \param[in] pos		offset of the write
+ * \param[in] count		bytes written
+ * \param[in] depth		number of strides to lock ahead
+ * \param[out] ahead_start	offset of the first stride to lock ahead
+ * \param[out] ahead_stride	distance between the strides to lock ahead
+ *
+ * \retval number of strides to lock ahead, each \a count bytes long
+ */
+int ll_write_stride_update(struct ll_write_stride_state *wss, loff_t pos,
+			   size_t count, unsigned int depth,
+			   loff_t *ahead_start, loff_t *ahead_stride)
+{
+	loff_t stride;
+	loff_t start;
+	loff_t limit;
+	int nr = 0;
+
+	spin_lock(&wss->ws_lock);
+	stride = pos - wss->ws_last_start;
+	if (count != 0 && count == wss->ws_last_end - wss->ws_last_start &&
+	    pos > wss->ws_last_end) {
+		if (stride == wss->ws_stride_length) {
+			wss->ws_consecutive_strides++;
+		} else {
+			wss->ws_stride_length = stride;
+			wss->ws_consecutive_strides = 1;
+			wss->ws_ahead_next = 0;
+		}
+	} else {
+		wss->ws_stride_length = 0;
+		wss->ws_consecutive_strides = 0;
+		wss->ws_ahead_next = 0;
+	}
+	wss->ws_last_start = pos;
+	wss->ws_last_end = pos + count;
+
+	if (ws_stride_mode(wss) && depth > 0) {
+		start = max(pos + stride, wss->ws_ahead_next);
+		limit = pos + stride * depth;
+		*ahead_start = start;
+		*ahead_stride = stride;
+		for (; start <= limit; start += stride)
+			nr++;
+		if (nr > 0)
+			wss->ws_ahead_next = start;
+	}
+	spin_unlock(&wss->ws_lock);
+
+	return nr;
+}
+
 /*
  * Check whether the read request is in the stride window.
  * If it is in the stride window, return 1, otherwise return 0.
@@ -1224,7 +1313,7 @@ int ll_readpage(struct file *file, struct page *vmpage)
 			 * the case, we can't do fast IO because we will need
 			 * a cl_io to issue the RPC. */
 			if (ras->ras_window_start + ras->ras_window_len <
-			    ras->ras_next_readahead + PTLRPC_MAX_BRW_PAGES) {
+			    ras->ras_next_readahead + ras->ras_rpc_size) {
 				/* export the page and skip io stack */
 				vpg->vpg_ra_used = 1;
 				cl_page_export(env, page, 1);
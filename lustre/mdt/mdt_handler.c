@@ -421,6 +421,9 @@ static int mdt_statfs(struct tgt_session_info *tsi)
 	struct obd_statfs *osfs;
 	struct mdt_body *reqbody = NULL;
 	struct mdt_statfs_cache *msf;
+	u64 tot_dirty;
+	u64 tot_granted;
+	u64 tot_pending;
 	int rc;
 
 	ENTRY;
@@ -475,15 +478,15 @@ static int mdt_statfs(struct tgt_session_info *tsi)
 	/* at least try to account for cached pages.  its still racy and
 	 * might be under-reporting if clients haven't announced their
 	 * caches with brw recently */
+	tgt_grant_totals(tgd, &tot_dirty, &tot_granted, &tot_pending);
 	CDEBUG(D_SUPER | D_CACHE, "blocks cached %llu granted %llu"
 	       " pending %llu free %llu avail %llu\n",
-	       tgd->tgd_tot_dirty, tgd->tgd_tot_granted,
-	       tgd->tgd_tot_pending,
+	       tot_dirty, tot_granted, tot_pending,
 	       osfs->os_bfree << tgd->tgd_blockbits,
 	       osfs->os_bavail << tgd->tgd_blockbits);
 
 	osfs->os_bavail -= min_t(u64, osfs->os_bavail,
-				 ((tgd->tgd_tot_dirty + tgd->tgd_tot_pending +
+				 ((tot_dirty + tot_pending +
 				   osfs->os_bsize - 1) >> tgd->tgd_blockbits));
 
 	tgt_grant_sanity_check(mdt->mdt_lu_dev.ld_obd, __func__);
@@ -4953,6 +4956,7 @@ static void mdt_fini(const struct lu_env *env, struct mdt_device *m)
 	mdt_fs_cleanup(env, m);
 
 	tgt_fini(env, &m->mdt_lut);
+	tgt_grant_fini(&m->mdt_lut.lut_tgd);
 
 	mdt_hsm_cdt_fini(m);
 
@@ -5233,6 +5237,7 @@ err_fs_cleanup:
 	mdt_fs_cleanup(env, m);
 err_tgt:
 	tgt_fini(env, &m->mdt_lut);
+	tgt_grant_fini(&m->mdt_lut.lut_tgd);
 err_free_ns:
 	ldlm_namespace_free(m->mdt_namespace, NULL, 0);
 	obd->obd_namespace = m->mdt_namespace = NULL;
@@ -5983,7 +5988,8 @@ static int mdt_destroy_export(struct obd_export *exp)
 	 */
 	tgt_grant_discard(exp);
 	if (exp_connect_flags(exp) & OBD_CONNECT_GRANT)
-		exp->exp_obd->u.obt.obt_lut->lut_tgd.tgd_tot_granted_clients--;
+		atomic_dec(&exp->exp_obd->u.obt.obt_lut->
+			   lut_tgd.tgd_tot_granted_clients);
 
 	if (!(exp->exp_flags & OBD_OPT_FORCE))
 		tgt_grant_sanity_check(exp->exp_obd, __func__);
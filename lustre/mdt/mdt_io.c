@@ -100,7 +100,7 @@ static void mdt_prolong_dom_lock(struct tgt_session_info *tsi,
 		if (lock != NULL) {
 			LASSERT(lock->l_export == data->lpa_export);
 			ldlm_lock_prolong_one(lock, data);
-			lock->l_last_used = ktime_get();
+			ldlm_reclaim_touch(lock);
 			LDLM_LOCK_PUT(lock);
 			RETURN_EXIT;
 		}
@@ -461,8 +461,8 @@ int mdt_obd_preprw(const struct lu_env *env, int cmd, struct obd_export *exp,
 	char *jobid;
 	int rc = 0;
 
-	/* The default value PTLRPC_MAX_BRW_PAGES is set in tgt_brw_write()
-	 * but for MDT it is different, correct it here. */
+	/* The default value from the per-thread cache is set in
+	 * tgt_brw_write() but for MDT it is different, correct it here. */
 	if (*nr_local > MD_MAX_BRW_PAGES)
 		*nr_local = MD_MAX_BRW_PAGES;
 
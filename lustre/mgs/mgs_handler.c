@@ -1417,6 +1417,7 @@ err_llog:
 	}
 err_tgt:
 	tgt_fini(env, &mgs->mgs_lut);
+	tgt_grant_fini(&mgs->mgs_lut.lut_tgd);
 err_fs:
 	/* No extra cleanup needed for llog_init_commit_thread() */
 	mgs_fs_cleanup(env, mgs);
@@ -1588,6 +1589,7 @@ static struct lu_device *mgs_device_fini(const struct lu_env *env,
 
 	tgt_fini(env, &mgs->mgs_lut);
 	lproc_mgs_cleanup(mgs);
+	tgt_grant_fini(&mgs->mgs_lut.lut_tgd);
 
 	ctxt = llog_get_context(mgs->mgs_obd, LLOG_CONFIG_ORIG_CTXT);
 	if (ctxt) {
@@ -809,6 +809,8 @@ static const char *obd_connect_names[] = {
 	"wbc",		/* 0x40 */
 	"lock_convert",  /* 0x80 */
 	"archive_id_array",	/* 0x100 */
+	"replay_pipeline",	/* 0x200 */
+	"batch_ast",	/* 0x400 */
 	NULL
 };
 
@@ -630,6 +630,55 @@ int lprocfs_hash_seq_show(struct seq_file *m, void *data)
 }
 EXPORT_SYMBOL(lprocfs_hash_seq_show);
 
+static const char *obd_recovery_phase_names[OBD_RECOVERY_PHASE_MAX] = {
+	[OBD_RECOVERY_CONNECT]		= "connect",
+	[OBD_RECOVERY_REQ_REPLAY]	= "request_replay",
+	[OBD_RECOVERY_LOCK_REPLAY]	= "lock_replay",
+	[OBD_RECOVERY_FINAL_PING]	= "final_ping",
+};
+
+static unsigned int obd_recovery_phase_ms(struct obd_device *obd,
+					  enum obd_recovery_phase phase)
+{
+	/* the phase in progress has no duration recorded yet */
+	if (phase == obd->obd_recovery_phase)
+		return ktime_ms_delta(ktime_get(),
+				      obd->obd_recovery_phase_start);
+	return obd->obd_recovery_phase_ms[phase];
+}
+
+static void lprocfs_recovery_phases_seq_show(struct seq_file *m,
+					     struct obd_device *obd)
+{
+	enum obd_recovery_phase phase;
+	unsigned int ms;
+
+	/* the recovery thread never ran */
+	if (ktime_to_ns(obd->obd_recovery_phase_start) == 0)
+		return;
+
+	for (phase = 0; phase < OBD_RECOVERY_PHASE_MAX; phase++) {
+		if (phase > obd->obd_recovery_phase)
+			break;
+		seq_printf(m, "phase_%s_ms: %u\n",
+			   obd_recovery_phase_names[phase],
+			   obd_recovery_phase_ms(obd, phase));
+	}
+
+	if (obd->obd_recovery_phase > OBD_RECOVERY_REQ_REPLAY) {
+		ms = obd_recovery_phase_ms(obd, OBD_RECOVERY_REQ_REPLAY);
+		seq_printf(m, "replay_rate: %llu reqs/s\n",
+			   (u64)obd->obd_replayed_requests * MSEC_PER_SEC /
+			   max(ms, 1U));
+	}
+	if (obd->obd_recovery_phase > OBD_RECOVERY_LOCK_REPLAY) {
+		ms = obd_recovery_phase_ms(obd, OBD_RECOVERY_LOCK_REPLAY);
+		seq_printf(m, "lock_replay_rate: %llu locks/s\n",
+			   (u64)obd->obd_replayed_locks * MSEC_PER_SEC /
+			   max(ms, 1U));
+	}
+}
+
 int lprocfs_recovery_status_seq_show(struct seq_file *m, void *data)
 {
 	struct obd_device *obd = m->private;
@@ -665,6 +714,7 @@ int lprocfs_recovery_status_seq_show(struct seq_file *m, void *data)
 			   "ENABLED" : "DISABLED");
 		seq_printf(m, "IR: %s\n", obd->obd_no_ir ?
 			   "DISABLED" : "ENABLED");
+		lprocfs_recovery_phases_seq_show(m, obd);
 		goto out;
 	}
 
@@ -727,6 +777,7 @@ int lprocfs_recovery_status_seq_show(struct seq_file *m, void *data)
 		   obd->obd_requests_queued_for_recovery);
 	seq_printf(m, "next_transno: %lld\n",
 		   obd->obd_next_recovery_transno);
+	lprocfs_recovery_phases_seq_show(m, obd);
 out:
 	return 0;
 }
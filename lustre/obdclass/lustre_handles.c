@@ -41,16 +41,20 @@
 #include <lustre_lib.h>
 
 
-static __u64 handle_base;
+static atomic64_t handle_base;
 #define HANDLE_INCR 7
-static DEFINE_SPINLOCK(handle_base_lock);
 
 static struct handle_bucket {
 	spinlock_t lock;
 	struct list_head head;
 } *handle_hash;
 
-#define HANDLE_HASH_SIZE (1 << 16)
+/* The hash is sized once at init from the amount of memory, so it never
+ * needs to be resized while lookups run locklessly under RCU. */
+#define HANDLE_HASH_MIN_BITS	16
+#define HANDLE_HASH_MAX_BITS	20
+static unsigned int handle_hash_bits = HANDLE_HASH_MIN_BITS;
+#define HANDLE_HASH_SIZE (1U << handle_hash_bits)
 #define HANDLE_HASH_MASK (HANDLE_HASH_SIZE - 1)
 
 /*
@@ -61,6 +65,7 @@ void class_handle_hash(struct portals_handle *h,
 		       struct portals_handle_ops *ops)
 {
 	struct handle_bucket *bucket;
+	__u64 cookie;
 
 	ENTRY;
 
@@ -71,20 +76,17 @@ void class_handle_hash(struct portals_handle *h,
 	 * This is fast, but simplistic cookie generation algorithm, it will
 	 * need a re-do at some point in the future for security.
 	 */
-	spin_lock(&handle_base_lock);
-	handle_base += HANDLE_INCR;
-
-	if (unlikely(handle_base == 0)) {
+	cookie = atomic64_add_return(HANDLE_INCR, &handle_base);
+	if (unlikely(cookie == 0)) {
 		/*
 		 * Cookie of zero is "dangerous", because in many places it's
 		 * assumed that 0 means "unassigned" handle, not bound to any
 		 * object.
 		 */
 		CWARN("The universe has been exhausted: cookie wrap-around.\n");
-		handle_base += HANDLE_INCR;
+		cookie = atomic64_add_return(HANDLE_INCR, &handle_base);
 	}
-	h->h_cookie = handle_base;
-	spin_unlock(&handle_base_lock);
+	h->h_cookie = cookie;
 
 	h->h_ops = ops;
 	spin_lock_init(&h->h_lock);
@@ -203,10 +205,16 @@ int class_handle_init(void)
 {
 	struct handle_bucket *bucket;
 	struct timespec64 ts;
+	__u64 base;
 	int seed[2];
 
 	LASSERT(handle_hash == NULL);
 
+	/* one bucket per 64KB of memory, i.e. roughly per 150 locks */
+	handle_hash_bits = clamp_t(unsigned int,
+				   ilog2(totalram_pages >> (16 - PAGE_SHIFT)),
+				   HANDLE_HASH_MIN_BITS, HANDLE_HASH_MAX_BITS);
+
 	OBD_ALLOC_LARGE(handle_hash, sizeof(*bucket) * HANDLE_HASH_SIZE);
 	if (handle_hash == NULL)
 		return -ENOMEM;
@@ -222,8 +230,9 @@ int class_handle_init(void)
 	ktime_get_ts64(&ts);
 	cfs_srand(ts.tv_sec ^ seed[0], ts.tv_nsec ^ seed[1]);
 
-	cfs_get_random_bytes(&handle_base, sizeof(handle_base));
-	LASSERT(handle_base != 0ULL);
+	cfs_get_random_bytes(&base, sizeof(base));
+	LASSERT(base != 0ULL);
+	atomic64_set(&handle_base, base);
 
 	return 0;
 }
@@ -833,6 +833,7 @@ static void echo_srv_fini(const struct lu_env *env,
 
 	lprocfs_obd_cleanup(obd);
 	lprocfs_free_obd_stats(obd);
+	tgt_grant_fini(&esd->esd_lut.lut_tgd);
 
 	leaked = atomic_read(&obd->u.echo.eo_prep);
 	if (leaked != 0)
@@ -932,4 +932,24 @@ void ofd_stats_counter_init(struct lprocfs_stats *stats)
 			     0, "quotactl", "reqs");
 }
 
+/**
+ * Initialize OFD FMD statistics counters
+ *
+ * The FMD hit rate is fmd_hit / fmd_lookup, fmd_count samples the number
+ * of FMDs held by the export at each lookup.
+ *
+ * param[in] stats	statistics counters
+ */
+void ofd_fmd_stats_counter_init(struct lprocfs_stats *stats)
+{
+	LASSERT(stats && stats->ls_num >= LPROC_OFD_FMD_LAST);
+
+	lprocfs_counter_init(stats, LPROC_OFD_FMD_LOOKUP,
+			     0, "fmd_lookup", "reqs");
+	lprocfs_counter_init(stats, LPROC_OFD_FMD_HIT,
+			     0, "fmd_hit", "reqs");
+	lprocfs_counter_init(stats, LPROC_OFD_FMD_COUNT,
+			     LPROCFS_CNTR_AVGMINMAX, "fmd_count", "entries");
+}
+
 #endif /* CONFIG_PROC_FS */
@@ -758,10 +758,24 @@ static int ofd_procfs_init(struct ofd_device *ofd)
 				    ofd_stats_counter_init);
 	if (rc)
 		GOTO(obd_cleanup, rc);
+
+	ofd->ofd_fmd_stats = lprocfs_alloc_stats(LPROC_OFD_FMD_LAST, 0);
+	if (ofd->ofd_fmd_stats == NULL)
+		GOTO(obd_cleanup, rc = -ENOMEM);
+	ofd_fmd_stats_counter_init(ofd->ofd_fmd_stats);
+
+	rc = lprocfs_register_stats(obd->obd_proc_entry, "fmd_stats",
+				    ofd->ofd_fmd_stats);
+	if (rc) {
+		CERROR("%s: add proc entry 'fmd_stats' failed: %d.\n",
+		       obd->obd_name, rc);
+		GOTO(obd_cleanup, rc);
+	}
 	RETURN(0);
 obd_cleanup:
 	lprocfs_obd_cleanup(obd);
 	lprocfs_free_obd_stats(obd);
+	lprocfs_free_stats(&ofd->ofd_fmd_stats);
 
 	return rc;
 }
@@ -818,6 +832,7 @@ static void ofd_procfs_fini(struct ofd_device *ofd)
 	lprocfs_free_per_client_stats(obd);
 	lprocfs_obd_cleanup(obd);
 	lprocfs_free_obd_stats(obd);
+	lprocfs_free_stats(&ofd->ofd_fmd_stats);
 	lprocfs_job_stats_fini(obd);
 }
 
@@ -2096,7 +2111,7 @@ out:
 
 static int ofd_ladvise_prefetch(const struct lu_env *env,
 				struct ofd_object *fo,
-				struct niobuf_local *lnb,
+				struct niobuf_local *lnb, int max_pages,
 				__u64 start, __u64 end, enum dt_bufs_type dbt)
 {
 	struct ofd_thread_info *info = ofd_info(env);
@@ -2127,8 +2142,7 @@ static int ofd_ladvise_prefetch(const struct lu_env *env,
 	end_index = (end - 1) >> PAGE_SHIFT;
 	pages = end_index - start_index + 1;
 	while (pages > 0) {
-		nr_local = pages <= PTLRPC_MAX_BRW_PAGES ? pages :
-			PTLRPC_MAX_BRW_PAGES;
+		nr_local = pages <= max_pages ? pages : max_pages;
 		rnb.rnb_offset = start_index << PAGE_SHIFT;
 		rnb.rnb_len = nr_local << PAGE_SHIFT;
 		rc = dt_bufs_get(env, ofd_object_child(fo), &rnb, lnb, dbt);
@@ -2259,6 +2273,7 @@ static int ofd_ladvise_hdl(struct tgt_session_info *tsi)
 
 			req->rq_status = ofd_ladvise_prefetch(env, fo,
 							      tbc->local,
+							      tbc->tbc_max_pages,
 							      start, end, dbt);
 			tgt_extent_unlock(&lockh, LCK_PR);
 			break;
@@ -2417,7 +2432,7 @@ static void ofd_prolong_extent_locks(struct tgt_session_info *tsi,
 				/* The lock was destroyed probably lets try
 				 * resource tree. */
 			} else {
-				lock->l_last_used = ktime_get();
+				ldlm_reclaim_touch(lock);
 				LDLM_LOCK_PUT(lock);
 			}
 		}
@@ -3045,6 +3060,7 @@ err_fini_stack:
 	ofd_stack_fini(env, m, &m->ofd_osd->dd_lu_dev);
 err_fini_proc:
 	ofd_procfs_fini(m);
+	tgt_grant_fini(&m->ofd_lut.lut_tgd);
 	return rc;
 }
 
@@ -3089,6 +3105,8 @@ static void ofd_fini(const struct lu_env *env, struct ofd_device *m)
 
 	ofd_stack_fini(env, m, &m->ofd_dt_dev.dd_lu_dev);
 	ofd_procfs_fini(m);
+	/* tot_dirty, tot_granted and tot_pending read the grant counters */
+	tgt_grant_fini(&m->ofd_lut.lut_tgd);
 	LASSERT(atomic_read(&d->ld_ref) == 0);
 	server_put_mount(obd->obd_name, true);
 	EXIT;
@@ -38,7 +38,8 @@
  *
  * FMD is organized as per-client list and identified by FID of object. Each
  * FMD stores FID of object and the highest received XID of modification
- * request for this object.
+ * request for this object. The list is kept in LRU order for expiry, and
+ * FMDs are also indexed by FID in a per-client rbtree for lookup.
  *
  * FMD can expire if there are no updates for a long time to keep the list
  * reasonably small.
@@ -52,6 +53,70 @@
 
 static struct kmem_cache *ll_fmd_cachep;
 
+/**
+ * Look up FMD by FID in the export FMD tree.
+ *
+ * Must be called with fed_lock held.
+ *
+ * \param[in] fed	filter export data
+ * \param[in] fid	FID of FMD to find
+ *
+ * \retval		struct ofd_mod_data found by FID
+ * \retval		NULL if FMD is not found
+ */
+static struct ofd_mod_data *ofd_fmd_tree_find(struct filter_export_data *fed,
+					      const struct lu_fid *fid)
+{
+	struct rb_node *node = fed->fed_mod_tree.rb_node;
+	struct ofd_mod_data *fmd;
+	int rc;
+
+	while (node != NULL) {
+		fmd = rb_entry(node, struct ofd_mod_data, fmd_node);
+		rc = lu_fid_cmp(fid, &fmd->fmd_fid);
+		if (rc < 0)
+			node = node->rb_left;
+		else if (rc > 0)
+			node = node->rb_right;
+		else
+			return fmd;
+	}
+
+	return NULL;
+}
+
+/**
+ * Insert FMD into the export FMD tree.
+ *
+ * Must be called with fed_lock held, and no FMD with the same FID must be
+ * in the tree already.
+ *
+ * \param[in] fed	filter export data
+ * \param[in] fmd	FMD to insert
+ */
+static void ofd_fmd_tree_insert(struct filter_export_data *fed,
+				struct ofd_mod_data *fmd)
+{
+	struct rb_node **node = &fed->fed_mod_tree.rb_node;
+	struct rb_node *parent = NULL;
+	struct ofd_mod_data *tmp;
+	int rc;
+
+	while (*node != NULL) {
+		parent = *node;
+		tmp = rb_entry(parent, struct ofd_mod_data, fmd_node);
+		rc = lu_fid_cmp(&fmd->fmd_fid, &tmp->fmd_fid);
+		LASSERT(rc != 0);
+		if (rc < 0)
+			node = &parent->rb_left;
+		else
+			node = &parent->rb_right;
+	}
+
+	rb_link_node(&fmd->fmd_node, parent, node);
+	rb_insert_color(&fmd->fmd_node, &fed->fed_mod_tree);
+}
+
 /**
  * Drop FMD reference and free it if reference drops to zero.
  *
@@ -69,12 +134,33 @@ static inline void ofd_fmd_put_nolock(struct obd_export *exp,
 	if (--fmd->fmd_refcount == 0) {
 		/* XXX when we have persistent reservations and the handle
 		 * is stored herein we need to drop it here. */
+		LASSERT(RB_EMPTY_NODE(&fmd->fmd_node));
 		fed->fed_mod_count--;
 		list_del(&fmd->fmd_list);
 		OBD_SLAB_FREE(fmd, ll_fmd_cachep, sizeof(*fmd));
 	}
 }
 
+/**
+ * Remove FMD from the export FMD list and tree.
+ *
+ * The list reference is dropped, so FMD is freed once the last caller
+ * reference is put. Must be called with fed_lock held.
+ *
+ * \param[in] exp	OBD export
+ * \param[in] fmd	FMD to remove
+ */
+static void ofd_fmd_unlink_nolock(struct obd_export *exp,
+				  struct ofd_mod_data *fmd)
+{
+	struct filter_export_data *fed = &exp->exp_filter_data;
+
+	list_del_init(&fmd->fmd_list);
+	rb_erase(&fmd->fmd_node, &fed->fed_mod_tree);
+	RB_CLEAR_NODE(&fmd->fmd_node);
+	ofd_fmd_put_nolock(exp, fmd); /* list reference */
+}
+
 /**
  * Wrapper to drop FMD reference with fed_lock held.
  *
@@ -124,8 +210,7 @@ static void ofd_fmd_expire_nolock(struct obd_export *exp,
 		    fed->fed_mod_count < ofd->ofd_fmd_max_num)
 			break;
 
-		list_del_init(&fmd->fmd_list);
-		ofd_fmd_put_nolock(exp, fmd); /* list reference */
+		ofd_fmd_unlink_nolock(exp, fmd);
 	}
 }
 
@@ -148,7 +233,8 @@ void ofd_fmd_expire(struct obd_export *exp)
 /**
  * Find FMD by specified FID.
  *
- * Function finds FMD entry by FID in the filter_export_data::fed_fmd_list.
+ * Function finds FMD entry by FID in the filter_export_data::fed_mod_tree
+ * and moves it to the tail of filter_export_data::fed_mod_list.
  *
  * Caller must hold filter_export_data::fed_lock and take FMD reference.
  *
@@ -162,20 +248,25 @@ static struct ofd_mod_data *ofd_fmd_find_nolock(struct obd_export *exp,
 						const struct lu_fid *fid)
 {
 	struct filter_export_data *fed = &exp->exp_filter_data;
-	struct ofd_mod_data *found = NULL, *fmd;
+	struct ofd_mod_data *found;
 	struct ofd_device *ofd = ofd_exp(exp);
 	time64_t now = ktime_get_seconds();
 
 	assert_spin_locked(&fed->fed_lock);
 
-	list_for_each_entry_reverse(fmd, &fed->fed_mod_list, fmd_list) {
-		if (lu_fid_eq(&fmd->fmd_fid, fid)) {
-			found = fmd;
-			list_del(&fmd->fmd_list);
-			list_add_tail(&fmd->fmd_list, &fed->fed_mod_list);
-			fmd->fmd_expire = now + ofd->ofd_fmd_max_age;
-			break;
-		}
+	found = ofd_fmd_tree_find(fed, fid);
+	if (found != NULL) {
+		list_move_tail(&found->fmd_list, &fed->fed_mod_list);
+		found->fmd_expire = now + ofd->ofd_fmd_max_age;
+	}
+
+	if (ofd->ofd_fmd_stats != NULL) {
+		lprocfs_counter_incr(ofd->ofd_fmd_stats, LPROC_OFD_FMD_LOOKUP);
+		if (found != NULL)
+			lprocfs_counter_incr(ofd->ofd_fmd_stats,
+					     LPROC_OFD_FMD_HIT);
+		lprocfs_counter_add(ofd->ofd_fmd_stats, LPROC_OFD_FMD_COUNT,
+				    fed->fed_mod_count);
 	}
 
 	ofd_fmd_expire_nolock(exp, found);
@@ -239,6 +330,7 @@ struct ofd_mod_data *ofd_fmd_get(struct obd_export *exp, const struct lu_fid *fi
 			list_add_tail(&fmd_new->fmd_list,
 				      &fed->fed_mod_list);
 			fmd_new->fmd_fid = *fid;
+			ofd_fmd_tree_insert(fed, fmd_new);
 			fmd_new->fmd_refcount++;   /* list reference */
 			found = fmd_new;
 			fed->fed_mod_count++;
@@ -279,10 +371,8 @@ void ofd_fmd_drop(struct obd_export *exp, const struct lu_fid *fid)
 
 	spin_lock(&fed->fed_lock);
 	found = ofd_fmd_find_nolock(exp, fid);
-	if (found) {
-		list_del_init(&found->fmd_list);
-		ofd_fmd_put_nolock(exp, found);
-	}
+	if (found)
+		ofd_fmd_unlink_nolock(exp, found);
 	spin_unlock(&fed->fed_lock);
 }
 #endif
@@ -301,12 +391,11 @@ void ofd_fmd_cleanup(struct obd_export *exp)
 
 	spin_lock(&fed->fed_lock);
 	list_for_each_entry_safe(fmd, tmp, &fed->fed_mod_list, fmd_list) {
-		list_del_init(&fmd->fmd_list);
 		if (fmd->fmd_refcount > 1) {
 			CDEBUG(D_INFO, "fmd %p still referenced (refcount = %d)\n",
 			       fmd, fmd->fmd_refcount);
 		}
-		ofd_fmd_put_nolock(exp, fmd);
+		ofd_fmd_unlink_nolock(exp, fmd);
 	}
 	spin_unlock(&fed->fed_lock);
 }
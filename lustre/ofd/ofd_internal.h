@@ -54,6 +54,7 @@
 /* per-client-per-object persistent state (LRU) */
 struct ofd_mod_data {
 	struct list_head fmd_list;	  /* linked to fed_mod_list */
+	struct rb_node	 fmd_node;	  /* linked to fed_mod_tree */
 	struct lu_fid	 fmd_fid;	  /* FID being written to */
 	__u64		 fmd_mactime_xid; /* xid highest {m,a,c}time setattr */
 	time64_t	 fmd_expire;	  /* time when the fmd should expire */
@@ -63,6 +64,14 @@ struct ofd_mod_data {
 #define OFD_FMD_MAX_NUM_DEFAULT 128
 #define OFD_FMD_MAX_AGE_DEFAULT (obd_timeout + 10)
 
+/* FMD lookup stats */
+enum {
+	LPROC_OFD_FMD_LOOKUP = 0,
+	LPROC_OFD_FMD_HIT,
+	LPROC_OFD_FMD_COUNT,
+	LPROC_OFD_FMD_LAST,
+};
+
 #define OFD_SOFT_SYNC_LIMIT_DEFAULT 16
 
 /* request stats */
@@ -138,6 +147,7 @@ struct ofd_device {
 	/* ofd mod data: ofd_device wide values */
 	int			 ofd_fmd_max_num; /* per ofd ofd_mod_data */
 	time64_t		 ofd_fmd_max_age; /* time to fmd expiry */
+	struct lprocfs_stats	*ofd_fmd_stats;	  /* FMD lookups and hits */
 
 	spinlock_t		 ofd_flags_lock;
 	unsigned long		 ofd_raid_degraded:1,
@@ -353,8 +363,10 @@ int ofd_txn_stop_cb(const struct lu_env *env, struct thandle *txn,
 #ifdef CONFIG_PROC_FS
 extern struct lprocfs_vars lprocfs_ofd_obd_vars[];
 void ofd_stats_counter_init(struct lprocfs_stats *stats);
+void ofd_fmd_stats_counter_init(struct lprocfs_stats *stats);
 #else
 static inline void ofd_stats_counter_init(struct lprocfs_stats *stats) {}
+static inline void ofd_fmd_stats_counter_init(struct lprocfs_stats *stats) {}
 #endif
 
 /* ofd_objects.c */
@@ -547,6 +547,7 @@ static int ofd_init_export(struct obd_export *exp)
 
 	spin_lock_init(&exp->exp_filter_data.fed_lock);
 	INIT_LIST_HEAD(&exp->exp_filter_data.fed_mod_list);
+	exp->exp_filter_data.fed_mod_tree = RB_ROOT;
 	atomic_set(&exp->exp_filter_data.fed_soft_sync_count, 0);
 	spin_lock(&exp->exp_lock);
 	exp->exp_connecting = 1;
@@ -605,12 +606,13 @@ static int ofd_destroy_export(struct obd_export *exp)
 	ofd_fmd_cleanup(exp);
 
 	if (exp_connect_flags(exp) & OBD_CONNECT_GRANT)
-		ofd->ofd_lut.lut_tgd.tgd_tot_granted_clients--;
+		atomic_dec(&ofd->ofd_lut.lut_tgd.tgd_tot_granted_clients);
 
 	if (!(exp->exp_flags & OBD_OPT_FORCE))
 		tgt_grant_sanity_check(exp->exp_obd, __func__);
 
 	LASSERT(list_empty(&exp->exp_filter_data.fed_mod_list));
+	LASSERT(RB_EMPTY_ROOT(&exp->exp_filter_data.fed_mod_tree));
 	return 0;
 }
 
@@ -798,6 +800,9 @@ int ofd_statfs(const struct lu_env *env,  struct obd_export *exp,
         struct obd_device	*obd = class_exp2obd(exp);
 	struct ofd_device	*ofd = ofd_exp(exp);
 	struct tg_grants_data	*tgd = &ofd->ofd_lut.lut_tgd;
+	u64			 tot_dirty;
+	u64			 tot_granted;
+	u64			 tot_pending;
 	int			 rc;
 
 	ENTRY;
@@ -810,15 +815,15 @@ int ofd_statfs(const struct lu_env *env,  struct obd_export *exp,
 	 * might be under-reporting if clients haven't announced their
 	 * caches with brw recently */
 
+	tgt_grant_totals(tgd, &tot_dirty, &tot_granted, &tot_pending);
 	CDEBUG(D_SUPER | D_CACHE, "blocks cached %llu granted %llu"
 	       " pending %llu free %llu avail %llu\n",
-	       tgd->tgd_tot_dirty, tgd->tgd_tot_granted,
-	       tgd->tgd_tot_pending,
+	       tot_dirty, tot_granted, tot_pending,
 	       osfs->os_bfree << tgd->tgd_blockbits,
 	       osfs->os_bavail << tgd->tgd_blockbits);
 
 	osfs->os_bavail -= min_t(u64, osfs->os_bavail,
-				 ((tgd->tgd_tot_dirty + tgd->tgd_tot_pending +
+				 ((tot_dirty + tot_pending +
 				   osfs->os_bsize - 1) >> tgd->tgd_blockbits));
 
 	/* The QoS code on the MDS does not care about space reserved for
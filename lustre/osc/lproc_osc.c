@@ -100,7 +100,6 @@ static ssize_t max_rpcs_in_flight_store(struct kobject *kobj,
 	struct obd_device *dev = container_of(kobj, struct obd_device,
 					      obd_kset.kobj);
 	struct client_obd *cli = &dev->u.cli;
-	int adding, added, req_count;
 	unsigned int val;
 	int rc;
 
@@ -113,19 +112,7 @@ static ssize_t max_rpcs_in_flight_store(struct kobject *kobj,
 
 	LPROCFS_CLIMP_CHECK(dev);
 
-	adding = (int)val - cli->cl_max_rpcs_in_flight;
-	req_count = atomic_read(&osc_pool_req_count);
-	if (adding > 0 && req_count < osc_reqpool_maxreqcount) {
-		/*
-		 * There might be some race which will cause over-limit
-		 * allocation, but it is fine.
-		 */
-		if (req_count + adding > osc_reqpool_maxreqcount)
-			adding = osc_reqpool_maxreqcount - req_count;
-
-		added = osc_rq_pool->prp_populate(osc_rq_pool, adding);
-		atomic_add(added, &osc_pool_req_count);
-	}
+	osc_rq_pool_grow((int)val - cli->cl_max_rpcs_in_flight);
 
 	spin_lock(&cli->cl_loi_list_lock);
 	cli->cl_max_rpcs_in_flight = val;
@@ -137,6 +124,90 @@ static ssize_t max_rpcs_in_flight_store(struct kobject *kobj,
 }
 LUSTRE_RW_ATTR(max_rpcs_in_flight);
 
+static ssize_t max_rpcs_in_flight_auto_show(struct kobject *kobj,
+					    struct attribute *attr,
+					    char *buf)
+{
+	struct obd_device *dev = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+	struct client_obd *cli = &dev->u.cli;
+
+	return sprintf(buf, "%u\n", cli->cl_rif_auto);
+}
+
+static ssize_t max_rpcs_in_flight_auto_store(struct kobject *kobj,
+					     struct attribute *attr,
+					     const char *buffer,
+					     size_t count)
+{
+	struct obd_device *dev = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+	struct client_obd *cli = &dev->u.cli;
+	bool val;
+	int rc;
+
+	rc = kstrtobool(buffer, &val);
+	if (rc)
+		return rc;
+
+	spin_lock(&cli->cl_loi_list_lock);
+	if (val && !cli->cl_rif_auto) {
+		/* start learning the path latency from scratch */
+		cli->cl_rif_auto_acks = 0;
+		cli->cl_rif_auto_epoch = 0;
+		cli->cl_rif_auto_srtt = 0;
+		cli->cl_rif_auto_base = 0;
+		cli->cl_rif_auto_base_next = 0;
+		cli->cl_rif_auto_ssvc = 0;
+		cli->cl_rif_auto_full = 0;
+		cli->cl_rif_auto_congested = 0;
+	}
+	cli->cl_rif_auto = val;
+	spin_unlock(&cli->cl_loi_list_lock);
+
+	return count;
+}
+LUSTRE_RW_ATTR(max_rpcs_in_flight_auto);
+
+static ssize_t max_rpcs_in_flight_auto_max_show(struct kobject *kobj,
+						struct attribute *attr,
+						char *buf)
+{
+	struct obd_device *dev = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+	struct client_obd *cli = &dev->u.cli;
+
+	return sprintf(buf, "%u\n", cli->cl_rif_auto_max);
+}
+
+static ssize_t max_rpcs_in_flight_auto_max_store(struct kobject *kobj,
+						 struct attribute *attr,
+						 const char *buffer,
+						 size_t count)
+{
+	struct obd_device *dev = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+	struct client_obd *cli = &dev->u.cli;
+	unsigned int val;
+	int rc;
+
+	rc = kstrtouint(buffer, 0, &val);
+	if (rc)
+		return rc;
+
+	if (val < OSC_MIN_RIF_AUTO || val > OSC_MAX_RIF_MAX)
+		return -ERANGE;
+
+	spin_lock(&cli->cl_loi_list_lock);
+	cli->cl_rif_auto_max = val;
+	if (cli->cl_rif_auto && cli->cl_max_rpcs_in_flight > val)
+		cli->cl_max_rpcs_in_flight = val;
+	spin_unlock(&cli->cl_loi_list_lock);
+
+	return count;
+}
+LUSTRE_RW_ATTR(max_rpcs_in_flight_auto_max);
+
 static ssize_t max_dirty_mb_show(struct kobject *kobj,
 				 struct attribute *attr,
 				 char *buf)
@@ -608,6 +679,38 @@ static int osc_unstable_stats_seq_show(struct seq_file *m, void *v)
 }
 LPROC_SEQ_FOPS_RO(osc_unstable_stats);
 
+static int osc_rif_auto_history_seq_show(struct seq_file *m, void *v)
+{
+	struct obd_device *dev = m->private;
+	struct client_obd *cli = &dev->u.cli;
+	struct osc_rif_hist_entry *rhe;
+	__u32 i;
+
+	spin_lock(&cli->cl_loi_list_lock);
+	seq_printf(m, "enabled:           %u\n"
+		   "max_rpcs_in_flight: %u\n"
+		   "srtt_us:           %llu\n"
+		   "base_rtt_us:       %llu\n"
+		   "changes:           %u\n",
+		   cli->cl_rif_auto, cli->cl_max_rpcs_in_flight,
+		   cli->cl_rif_auto_srtt, cli->cl_rif_auto_base,
+		   cli->cl_rif_hist_idx);
+	seq_printf(m, "%-12s %8s %10s %10s %9s\n",
+		   "time", "window", "srtt_us", "base_us", "congested");
+	i = cli->cl_rif_hist_idx > OSC_RIF_HIST_SIZE ?
+	    cli->cl_rif_hist_idx - OSC_RIF_HIST_SIZE : 0;
+	for (; i < cli->cl_rif_hist_idx; i++) {
+		rhe = &cli->cl_rif_hist[i % OSC_RIF_HIST_SIZE];
+		seq_printf(m, "%-12lld %8u %10u %10u %9u\n",
+			   (s64)rhe->rhe_time, rhe->rhe_window,
+			   rhe->rhe_srtt, rhe->rhe_base, rhe->rhe_congested);
+	}
+	spin_unlock(&cli->cl_loi_list_lock);
+
+	return 0;
+}
+LPROC_SEQ_FOPS_RO(osc_rif_auto_history);
+
 static ssize_t idle_timeout_show(struct kobject *kobj, struct attribute *attr,
 				 char *buf)
 {
@@ -766,6 +869,8 @@ struct lprocfs_vars lprocfs_osc_obd_vars[] = {
 	  .fops	=	&osc_pinger_recov_fops		},
 	{ .name	=	"unstable_stats",
 	  .fops	=	&osc_unstable_stats_fops	},
+	{ .name	=	"rpcs_in_flight_auto_history",
+	  .fops	=	&osc_rif_auto_history_fops	},
 	{ NULL }
 };
 
@@ -904,6 +1009,10 @@ static int osc_stats_seq_show(struct seq_file *seq, void *v)
 		   stats->os_lockless_reads);
 	seq_printf(seq, "lockless_truncate\t\t%llu\n",
 		   stats->os_lockless_truncates);
+	seq_printf(seq, "lockahead_granted\t\t%llu\n",
+		   stats->os_lockahead_granted);
+	seq_printf(seq, "lockahead_unused\t\t%llu\n",
+		   stats->os_lockahead_unused);
 	return 0;
 }
 
@@ -947,6 +1056,8 @@ static struct attribute *osc_attrs[] = {
 	&lustre_attr_lockless_truncate.attr,
 	&lustre_attr_max_dirty_mb.attr,
 	&lustre_attr_max_rpcs_in_flight.attr,
+	&lustre_attr_max_rpcs_in_flight_auto.attr,
+	&lustre_attr_max_rpcs_in_flight_auto_max.attr,
 	&lustre_attr_short_io_bytes.attr,
 	&lustre_attr_resend_count.attr,
 	&lustre_attr_conn_uuid.attr,
@@ -1900,6 +1900,7 @@ struct extent_rpc_data {
 	unsigned int		erd_max_pages;
 	unsigned int		erd_max_chunks;
 	unsigned int		erd_max_extents;
+	unsigned int		erd_max_niobufs;
 };
 
 static inline unsigned osc_extent_chunks(const struct osc_extent *ext)
@@ -1910,9 +1911,22 @@ static inline unsigned osc_extent_chunks(const struct osc_extent *ext)
 	return (ext->oe_end >> ppc_bits) - (ext->oe_start >> ppc_bits) + 1;
 }
 
+/**
+ * Upper bound of niobuf_remote needed to describe the pages of \a ext.
+ * A fully populated extent is a single contiguous niobuf, otherwise assume
+ * the worst case of one niobuf per page.
+ */
+static inline unsigned int osc_extent_niobufs(const struct osc_extent *ext)
+{
+	if (ext->oe_nr_pages == ext->oe_end - ext->oe_start + 1)
+		return 1;
+	return ext->oe_nr_pages;
+}
+
 /**
  * Try to add extent to one RPC. We need to think about the following things:
  * - # of pages must not be over max_pages_per_rpc
+ * - # of niobufs must fit in the server request buffer (OST_IO_MAX_NIOBUFS)
  * - extent must be compatible with previous ones
  */
 static int try_to_add_extent_for_io(struct client_obd *cli,
@@ -1921,6 +1935,7 @@ static int try_to_add_extent_for_io(struct client_obd *cli,
 {
 	struct osc_extent *tmp;
 	unsigned int chunk_count;
+	unsigned int nio_count;
 	struct osc_async_page *oap = list_first_entry(&ext->oe_pages,
 						      struct osc_async_page,
 						      oap_pending_item);
@@ -1951,6 +1966,10 @@ static int try_to_add_extent_for_io(struct client_obd *cli,
 	if (data->erd_page_count + ext->oe_nr_pages > data->erd_max_pages)
 		RETURN(0);
 
+	nio_count = osc_extent_niobufs(ext);
+	if (data->erd_page_count != 0 && nio_count > data->erd_max_niobufs)
+		RETURN(0);
+
 	list_for_each_entry(tmp, data->erd_rpc_list, oe_link) {
 		struct osc_async_page *oap2;
 		oap2 = list_first_entry(&tmp->oe_pages, struct osc_async_page,
@@ -1980,6 +1999,7 @@ static int try_to_add_extent_for_io(struct client_obd *cli,
 
 	data->erd_max_extents--;
 	data->erd_max_chunks -= chunk_count;
+	data->erd_max_niobufs -= min(nio_count, data->erd_max_niobufs);
 	data->erd_page_count += ext->oe_nr_pages;
 	list_move_tail(&ext->oe_link, data->erd_rpc_list);
 	ext->oe_owner = current;
@@ -2002,9 +2022,11 @@ static inline unsigned osc_max_write_chunks(const struct client_obd *cli)
 	 *
 	 * This piece of code is to make sure that OSC won't send write RPCs
 	 * with too many chunks. The maximum chunk size that an RPC can cover
-	 * is set to PTLRPC_MAX_BRW_SIZE, which is defined to 16MB. Ideally
-	 * OST should tell the client what the biggest transaction size is,
-	 * but it's good enough for now.
+	 * is set to PTLRPC_MAX_BRW_SIZE, which is defined to 64MB, the same
+	 * as DMU_MAX_ACCESS. It cannot be less than the largest RPC, or an
+	 * RPC of max_pages_per_rpc fully dirty chunks could not be built.
+	 * Ideally OST should tell the client what the biggest transaction
+	 * size is, but it's good enough for now.
 	 *
 	 * This limitation doesn't apply to ldiskfs, which allows as many
 	 * chunks in one RPC as we want. However, it won't have any benefits
@@ -2040,6 +2062,7 @@ static unsigned int get_write_extents(struct osc_object *obj,
 		.erd_max_pages	= cli->cl_max_pages_per_rpc,
 		.erd_max_chunks	= osc_max_write_chunks(cli),
 		.erd_max_extents = 256,
+		.erd_max_niobufs = OST_IO_MAX_NIOBUFS,
 	};
 
 	LASSERT(osc_object_is_locked(obj));
@@ -2182,6 +2205,7 @@ __must_hold(osc)
 		.erd_max_pages	= cli->cl_max_pages_per_rpc,
 		.erd_max_chunks	= UINT_MAX,
 		.erd_max_extents = UINT_MAX,
+		.erd_max_niobufs = OST_IO_MAX_NIOBUFS,
 	};
 	int rc = 0;
 	ENTRY;
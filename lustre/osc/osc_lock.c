@@ -344,6 +344,16 @@ static int osc_lock_upcall_speculative(void *cookie,
 	/* there is no osc_lock associated with speculative locks */
 	osc_lock_lvb_update(env, osc, dlmlock, NULL);
 
+	/* glimpse (AGL) locks cover the whole object, the others are
+	 * lockahead locks waiting for the IO they were requested for */
+	if (dlmlock->l_policy_data.l_extent.start != 0 ||
+	    dlmlock->l_policy_data.l_extent.end != OBD_OBJECT_EOF) {
+		struct lu_device *ld = osc2cl(osc)->co_lu.lo_dev;
+
+		ldlm_set_speculative_unused(dlmlock);
+		lu2osc_dev(ld)->od_stats.os_lockahead_granted++;
+	}
+
 	unlock_res_and_lock(dlmlock);
 	LDLM_LOCK_PUT(dlmlock);
 
@@ -419,6 +429,13 @@ static int osc_dlm_blocking_ast0(const struct lu_env *env,
 		cl_object_get(obj);
 	}
 
+	/* speculative locks have no l_ast_data, see osc_lock_enqueue() */
+	if (ldlm_is_speculative_unused(dlmlock)) {
+		ldlm_clear_speculative_unused(dlmlock);
+		obd2osc_dev(ldlm_lock_to_ns(dlmlock)->ns_obd)->
+			od_stats.os_lockahead_unused++;
+	}
+
 	unlock_res_and_lock(dlmlock);
 
 	/* if l_ast_data is NULL, the dlmlock was enqueued by AGL or
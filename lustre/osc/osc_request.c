@@ -986,6 +986,9 @@ void osc_init_grant(struct client_obd *cli, struct obd_connect_data *ocd)
 		cli->cl_chunkbits = PAGE_SHIFT;
 		cli->cl_max_extent_pages = DT_MAX_BRW_PAGES;
 	}
+	/* a single sparse extent must still fit into one BRW request */
+	if (cli->cl_max_extent_pages > OST_IO_MAX_NIOBUFS)
+		cli->cl_max_extent_pages = OST_IO_MAX_NIOBUFS;
 	spin_unlock(&cli->cl_loi_list_lock);
 
 	CDEBUG(D_CACHE, "%s, setting cl_avail_grant: %ld cl_lost_grant: %ld."
@@ -2011,6 +2014,118 @@ static void osc_release_ppga(struct brw_page **ppga, size_t count)
         OBD_FREE(ppga, sizeof(*ppga) * count);
 }
 
+/**
+ * Add \a adding requests to the shared OSC request pool, so that a larger
+ * max_rpcs_in_flight window can also be used under memory pressure.
+ *
+ * The total number of requests is limited to osc_reqpool_maxreqcount.
+ * There might be some race which will cause over-limit allocation, but it
+ * is fine. This can sleep, so it must not be called under a spinlock.
+ *
+ * \param[in] adding	number of requests to add
+ */
+void osc_rq_pool_grow(int adding)
+{
+	int req_count;
+	int added;
+
+	req_count = atomic_read(&osc_pool_req_count);
+	if (adding <= 0 || req_count >= osc_reqpool_maxreqcount)
+		return;
+
+	if (req_count + adding > osc_reqpool_maxreqcount)
+		adding = osc_reqpool_maxreqcount - req_count;
+
+	added = osc_rq_pool->prp_populate(osc_rq_pool, adding);
+	atomic_add(added, &osc_pool_req_count);
+}
+
+/**
+ * Adjust max_rpcs_in_flight from the latency of completed BRW RPCs, in
+ * the way of TCP Vegas. The shortest round-trip time seen recently is
+ * taken as the latency of an idle path, and a smoothed RTT well above
+ * it means that RPCs are queueing up on the way or on the server. The
+ * server also reports in pb_service_time how long our RPC waited and was
+ * processed there, and a service time more than twice its smoothed value
+ * means the OST request queue is building up. pb_timeout cannot be used
+ * for this, the server folds the service time into its AT estimate before
+ * it is sent, so the estimate is never below the service time.
+ *
+ * Once per window of completed RPCs, the window is halved if either
+ * signal showed congestion, and grows by one if all RPC slots were in
+ * use, so the number of RPCs in flight follows the bandwidth-delay
+ * product of the path without overloading the OST.
+ *
+ * \param[in] cli	client obd
+ * \param[in] rtt	round-trip time of a full-sized BRW, in usec
+ * \param[in] svc	service time reported by the server, in seconds
+ *
+ * \retval		number of RPC slots the window grew by, the caller
+ *			tops up the request pool with it once the
+ *			cl_loi_list_lock is released
+ */
+static int osc_rif_auto_update(struct client_obd *cli, __u64 rtt,
+			       __u32 svc)
+{
+	struct osc_rif_hist_entry *rhe;
+	__u32 win = cli->cl_max_rpcs_in_flight;
+	__u64 srtt = cli->cl_rif_auto_srtt;
+	__u32 ssvc = cli->cl_rif_auto_ssvc;
+	int grown = 0;
+
+	assert_spin_locked(&cli->cl_loi_list_lock);
+
+	/* compare with the previous samples before this one is added,
+	 * pb_service_time has a resolution of one second */
+	if (svc > 1 && svc * 8 > 2 * ssvc)
+		cli->cl_rif_auto_congested = 1;
+	cli->cl_rif_auto_ssvc = ssvc - (ssvc >> 3) + svc;
+
+	srtt = srtt == 0 ? rtt : srtt - (srtt >> 3) + (rtt >> 3);
+	cli->cl_rif_auto_srtt = srtt;
+	if (cli->cl_rif_auto_base == 0 || rtt < cli->cl_rif_auto_base)
+		cli->cl_rif_auto_base = rtt;
+	if (cli->cl_rif_auto_base_next == 0 ||
+	    rtt < cli->cl_rif_auto_base_next)
+		cli->cl_rif_auto_base_next = rtt;
+	if (cli->cl_r_in_flight + cli->cl_w_in_flight >= win)
+		cli->cl_rif_auto_full = 1;
+
+	if (++cli->cl_rif_auto_acks < win)
+		return 0;
+
+	if (cli->cl_rif_auto_congested || srtt > 2 * cli->cl_rif_auto_base)
+		win = max_t(__u32, win / 2, OSC_MIN_RIF_AUTO);
+	else if (cli->cl_rif_auto_full && win < cli->cl_rif_auto_max)
+		win++;
+
+	/* Let the base latency follow route and server changes. */
+	if (++cli->cl_rif_auto_epoch % 32 == 0) {
+		cli->cl_rif_auto_base = cli->cl_rif_auto_base_next;
+		cli->cl_rif_auto_base_next = 0;
+	}
+
+	if (win != cli->cl_max_rpcs_in_flight) {
+		rhe = &cli->cl_rif_hist[cli->cl_rif_hist_idx++ %
+					OSC_RIF_HIST_SIZE];
+		rhe->rhe_time = ktime_get_real_seconds();
+		rhe->rhe_window = win;
+		rhe->rhe_srtt = min_t(__u64, srtt, UINT_MAX);
+		rhe->rhe_base = min_t(__u64, cli->cl_rif_auto_base, UINT_MAX);
+		rhe->rhe_congested = cli->cl_rif_auto_congested;
+
+		if (win > cli->cl_max_rpcs_in_flight)
+			grown = win - cli->cl_max_rpcs_in_flight;
+		cli->cl_max_rpcs_in_flight = win;
+		client_adjust_max_dirty(cli);
+	}
+	cli->cl_rif_auto_acks = 0;
+	cli->cl_rif_auto_full = 0;
+	cli->cl_rif_auto_congested = 0;
+
+	return grown;
+}
+
 static int brw_interpret(const struct lu_env *env,
                          struct ptlrpc_request *req, void *data, int rc)
 {
@@ -2019,6 +2134,9 @@ static int brw_interpret(const struct lu_env *env,
 	struct osc_extent *tmp;
 	struct client_obd *cli = aa->aa_cli;
 	unsigned long		transferred = 0;
+	__u64			rtt = 0;
+	__u32			svc = 0;
+	int			rif_grown = 0;
         ENTRY;
 
         rc = osc_brw_fini_request(req, rc);
@@ -2116,10 +2234,19 @@ static int brw_interpret(const struct lu_env *env,
 		       aa->aa_requested_nob :
 		       req->rq_bulk->bd_nob_transferred);
 
+	/* Only full-sized RPCs tell about the latency of the path. */
+	if (cli->cl_rif_auto && rc == 0 && req->rq_repmsg != NULL &&
+	    aa->aa_page_count >= cli->cl_max_pages_per_rpc / 2) {
+		rtt = ktime_us_delta(ktime_get_real(), req->rq_sent_ns);
+		svc = lustre_msg_get_service_time(req->rq_repmsg);
+	}
+
 	osc_release_ppga(aa->aa_ppga, aa->aa_page_count);
 	ptlrpc_lprocfs_brw(req, transferred);
 
 	spin_lock(&cli->cl_loi_list_lock);
+	if (cli->cl_rif_auto && rtt > 0)
+		rif_grown = osc_rif_auto_update(cli, rtt, svc);
 	/* We need to decrement before osc_ap_completion->osc_wake_cache_waiters
 	 * is called so we know whether to go to sync BRWs or wait for more
 	 * RPCs to complete */
@@ -2130,6 +2257,9 @@ static int brw_interpret(const struct lu_env *env,
 	osc_wake_cache_waiters(cli);
 	spin_unlock(&cli->cl_loi_list_lock);
 
+	/* as max_rpcs_in_flight_store() does for a manual change */
+	osc_rq_pool_grow(rif_grown);
+
 	osc_io_unplug(env, cli, NULL);
 	RETURN(rc);
 }
@@ -2357,8 +2487,11 @@ static int osc_set_lock_data(struct ldlm_lock *lock, void *data)
 
 	if (lock->l_ast_data == NULL)
 		lock->l_ast_data = data;
-	if (lock->l_ast_data == data)
+	if (lock->l_ast_data == data) {
+		/* a lockahead lock is finally used for IO */
+		ldlm_clear_speculative_unused(lock);
 		set = 1;
+	}
 
 	unlock_res_and_lock(lock);
 
@@ -1802,7 +1802,7 @@ static dnode_t *osd_mkreg(const struct lu_env *env, struct osd_object *obj,
 	if ((fid_is_idif(fid) || fid_is_norm(fid) || fid_is_echo(fid))) {
 		/* The minimum block size must be at least page size otherwise
 		 * it will break the assumption in tgt_thread_big_cache where
-		 * the array size is PTLRPC_MAX_BRW_PAGES. It will also affect
+		 * the array is sized in pages of the request. It also affects
 		 * RDMA due to subpage transfer size */
 		rc = -dmu_object_set_blocksize(osd->od_os, dn->dn_object,
 					       PAGE_SIZE, 0, oh->ot_tx);
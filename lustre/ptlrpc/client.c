@@ -153,11 +153,22 @@ struct ptlrpc_bulk_desc *ptlrpc_new_bulk(unsigned nfrags, unsigned max_brw,
 	LASSERT(max_brw > 0);
 	desc->bd_md_max_brw = min(max_brw, PTLRPC_BULK_OPS_COUNT);
 	/* PTLRPC_BULK_OPS_COUNT is the compile-time transfer limit for this
-	 * node. Negotiated ocd_brw_size will always be <= this number. */
-	for (i = 0; i < PTLRPC_BULK_OPS_COUNT; i++)
+	 * node. Negotiated ocd_brw_size will always be <= this number, so only
+	 * allocate the MD handles this descriptor can actually use. */
+	OBD_ALLOC(desc->bd_mds, desc->bd_md_max_brw * sizeof(*desc->bd_mds));
+	if (desc->bd_mds == NULL)
+		goto out_vec;
+	for (i = 0; i < desc->bd_md_max_brw; i++)
 		LNetInvalidateMDHandle(&desc->bd_mds[i]);
 
 	return desc;
+out_vec:
+	if (type & PTLRPC_BULK_BUF_KIOV)
+		OBD_FREE_LARGE(GET_KIOV(desc),
+			       nfrags * sizeof(*GET_KIOV(desc)));
+	else
+		OBD_FREE_LARGE(GET_KVEC(desc),
+			       nfrags * sizeof(*GET_KVEC(desc)));
 out:
 	OBD_FREE_PTR(desc);
 	return NULL;
@@ -280,6 +291,7 @@ void ptlrpc_free_bulk(struct ptlrpc_bulk_desc *desc)
 	else
 		OBD_FREE_LARGE(GET_KVEC(desc),
 			desc->bd_max_iov * sizeof(*GET_KVEC(desc)));
+	OBD_FREE(desc->bd_mds, desc->bd_md_max_brw * sizeof(*desc->bd_mds));
 	OBD_FREE_PTR(desc);
 	EXIT;
 }
@@ -1123,6 +1135,7 @@ void ptlrpc_set_add_new_req(struct ptlrpcd_ctl *pc,
 	req->rq_queued_time = ktime_get_seconds();
 	list_add_tail(&req->rq_set_chain, &set->set_new_requests);
 	count = atomic_inc_return(&set->set_new_count);
+	pc->pc_queued++;
 	spin_unlock(&set->set_new_req_lock);
 
 	/* Only need to call wakeup once for the first entry. */
@@ -1134,6 +1147,9 @@ void ptlrpc_set_add_new_req(struct ptlrpcd_ctl *pc,
 		 *      no other better choice. It maybe fixed in future. */
 		for (i = 0; i < pc->pc_npartners; i++)
 			wake_up(&pc->pc_partners[i]->pc_set->set_waitq);
+	} else {
+		/* A backlog is building, let an idle thread steal from it. */
+		ptlrpcd_kick_idle(pc, count, 1);
 	}
 }
 
@@ -2973,8 +2989,13 @@ static int ptlrpc_replay_interpret(const struct lu_env *env,
                          lustre_msg_get_transno(req->rq_repmsg));
         }
 
+	/* with several replays in flight the replies may be interpreted
+	 * by different ptlrpcd threads, never move backward */
 	spin_lock(&imp->imp_lock);
-	imp->imp_last_replay_transno = lustre_msg_get_transno(req->rq_reqmsg);
+	if (lustre_msg_get_transno(req->rq_reqmsg) >
+	    imp->imp_last_replay_transno)
+		imp->imp_last_replay_transno =
+			lustre_msg_get_transno(req->rq_reqmsg);
 	spin_unlock(&imp->imp_lock);
         LASSERT(imp->imp_last_replay_transno);
 
@@ -1220,6 +1220,8 @@ static int ptlrpc_connect_interpret(const struct lu_env *env,
                 imp->imp_remote_handle =
                                 *lustre_msg_get_handle(request->rq_repmsg);
                 imp->imp_last_replay_transno = 0;
+		imp->imp_last_replay_sent = 0;
+		imp->imp_replay_resend_upto = 0;
 		imp->imp_replay_cursor = &imp->imp_committed_list;
                 IMPORT_SET_STATE(imp, LUSTRE_IMP_REPLAY);
         } else {
@@ -1494,12 +1496,25 @@ int ptlrpc_import_recovery_state_machine(struct obd_import *imp)
 		CDEBUG(D_HA, "replay requested by %s\n",
 		       obd2cli_tgt(imp->imp_obd));
 		rc = ptlrpc_replay_next(imp, &inflight);
-		if (inflight == 0 &&
-		    atomic_read(&imp->imp_replay_inflight) == 0) {
-			IMPORT_SET_STATE(imp, LUSTRE_IMP_REPLAY_LOCKS);
-			rc = ldlm_replay_locks(imp);
-			if (rc)
-				GOTO(out, rc);
+		if (inflight == 0) {
+			bool replay_locks = false;
+
+			/* several replay replies can get here at once, only
+			 * one of them may start lock replay */
+			spin_lock(&imp->imp_lock);
+			if (imp->imp_state == LUSTRE_IMP_REPLAY &&
+			    atomic_read(&imp->imp_replay_inflight) == 0) {
+				IMPORT_SET_STATE_NOLOCK(imp,
+						LUSTRE_IMP_REPLAY_LOCKS);
+				replay_locks = true;
+			}
+			spin_unlock(&imp->imp_lock);
+
+			if (replay_locks) {
+				rc = ldlm_replay_locks(imp);
+				if (rc)
+					GOTO(out, rc);
+			}
 		}
 		rc = 0;
 	}
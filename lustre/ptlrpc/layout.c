@@ -792,6 +792,7 @@ static struct req_format *req_formats[] = {
 	&RQF_LDLM_CALLBACK,
 	&RQF_LDLM_CP_CALLBACK,
 	&RQF_LDLM_BL_CALLBACK,
+	&RQF_LDLM_BL_CALLBACK_BATCH,
 	&RQF_LDLM_GL_CALLBACK,
 	&RQF_LDLM_GL_CALLBACK_DESC,
 	&RQF_LDLM_INTENT,
@@ -1497,6 +1498,12 @@ struct req_format RQF_LDLM_BL_CALLBACK =
         DEFINE_REQ_FMT0("LDLM_BL_CALLBACK", ldlm_enqueue_client, empty);
 EXPORT_SYMBOL(RQF_LDLM_BL_CALLBACK);
 
+/* the reply lists the handles of locks the client no longer has */
+struct req_format RQF_LDLM_BL_CALLBACK_BATCH =
+	DEFINE_REQ_FMT0("LDLM_BL_CALLBACK_BATCH", ldlm_enqueue_client,
+			ldlm_enqueue_client);
+EXPORT_SYMBOL(RQF_LDLM_BL_CALLBACK_BATCH);
+
 struct req_format RQF_LDLM_GL_CALLBACK =
         DEFINE_REQ_FMT0("LDLM_GL_CALLBACK", ldlm_enqueue_client,
                         ldlm_gl_callback_server);
@@ -137,6 +137,19 @@ module_param(ptlrpcd_cpts, charp, 0644);
 MODULE_PARM_DESC(ptlrpcd_cpts,
 		 "CPU partitions ptlrpcd threads should run in");
 
+/*
+ * ptlrpcd_steal_remote_min: An idle ptlrpcd thread first takes work
+ * from its partners, then from any busy thread of its own CPT. Only
+ * if there is none will it take work from threads bound to the CPTs
+ * nearest to its own, and only from those that have at least this
+ * many requests queued, so that a request is normally handled on the
+ * CPT that submitted it. A value of 0 disables stealing across CPTs.
+ */
+static int ptlrpcd_steal_remote_min = 8;
+module_param(ptlrpcd_steal_remote_min, int, 0644);
+MODULE_PARM_DESC(ptlrpcd_steal_remote_min,
+		 "Min queue length for stealing ptlrpcd work across CPTs");
+
 /* ptlrpcds_cpt_idx maps cpt numbers to an index in the ptlrpcds array. */
 static int		*ptlrpcds_cpt_idx;
 
@@ -144,6 +157,13 @@ static int		*ptlrpcds_cpt_idx;
 static int		ptlrpcds_num;
 static struct ptlrpcd	**ptlrpcds;
 
+/*
+ * Set once all ptlrpcd threads have been started, and cleared before
+ * they are stopped. Threads only look outside of their partner group
+ * while it is set.
+ */
+static bool		ptlrpcds_started;
+
 /*
  * In addition to the regular thread pool above, there is a single
  * global recovery thread. Recovery isn't critical for performance,
@@ -165,22 +185,60 @@ void ptlrpcd_wake(struct ptlrpc_request *req)
 }
 EXPORT_SYMBOL(ptlrpcd_wake);
 
+static inline struct ptlrpcd *ptlrpcd_of_cpt(int cpt)
+{
+	if (ptlrpcds_cpt_idx == NULL)
+		return ptlrpcds[cpt];
+	return ptlrpcds[ptlrpcds_cpt_idx[cpt]];
+}
+
+/**
+ * Return the number of requests queued to or being processed by \a pc.
+ */
+static inline int ptlrpcd_load(struct ptlrpcd_ctl *pc)
+{
+	struct ptlrpc_request_set *set = pc->pc_set;
+
+	if (set == NULL)
+		return INT_MAX;
+
+	return atomic_read(&set->set_new_count) +
+	       atomic_read(&set->set_remaining);
+}
+
+/**
+ * Return the smallest NUMA distance from \a pd to the ptlrpcd threads
+ * of any other CPT.
+ */
+static unsigned int ptlrpcd_nearest(struct ptlrpcd *pd)
+{
+	unsigned int	best = UINT_MAX;
+	unsigned int	dist;
+	int		i;
+
+	for (i = 0; i < ptlrpcds_num; i++) {
+		if (ptlrpcds[i] == pd)
+			continue;
+		dist = cfs_cpt_distance(cfs_cpt_table, pd->pd_cpt,
+					ptlrpcds[i]->pd_cpt);
+		if (dist < best)
+			best = dist;
+	}
+	return best;
+}
+
 static struct ptlrpcd_ctl *
 ptlrpcd_select_pc(struct ptlrpc_request *req)
 {
-	struct ptlrpcd	*pd;
-	int		cpt;
-	int		idx;
+	struct ptlrpcd		*pd;
+	struct ptlrpcd_ctl	*pc;
+	struct ptlrpcd_ctl	*alt;
+	int			idx;
 
 	if (req != NULL && req->rq_send_state != LUSTRE_IMP_FULL)
 		return &ptlrpcd_rcv;
 
-	cpt = cfs_cpt_current(cfs_cpt_table, 1);
-	if (ptlrpcds_cpt_idx == NULL)
-		idx = cpt;
-	else
-		idx = ptlrpcds_cpt_idx[cpt];
-	pd = ptlrpcds[idx];
+	pd = ptlrpcd_of_cpt(cfs_cpt_current(cfs_cpt_table, 1));
 
 	/* We do not care whether it is strict load balance. */
 	idx = pd->pd_cursor;
@@ -188,7 +246,73 @@ ptlrpcd_select_pc(struct ptlrpc_request *req)
 		idx = 0;
 	pd->pd_cursor = idx;
 
-	return &pd->pd_threads[idx];
+	/*
+	 * Of the next two threads in turn, pick the one with less work,
+	 * so that a thread busy with slow RPCs does not keep getting its
+	 * full share of the new ones.
+	 */
+	pc = &pd->pd_threads[idx];
+	if (++idx == pd->pd_nthreads)
+		idx = 0;
+	alt = &pd->pd_threads[idx];
+	if (ptlrpcd_load(alt) < ptlrpcd_load(pc))
+		pc = alt;
+
+	return pc;
+}
+
+/**
+ * Wake up one idle ptlrpcd thread of \a pd other than \a skip.
+ * Return true if one was found.
+ */
+static bool ptlrpcd_wake_idle(struct ptlrpcd *pd, struct ptlrpcd_ctl *skip)
+{
+	struct ptlrpcd_ctl	*pc;
+	int			i;
+
+	for (i = 0; i < pd->pd_nthreads; i++) {
+		pc = &pd->pd_threads[i];
+		if (pc == skip || ptlrpcd_load(pc) != 0)
+			continue;
+
+		wake_up(&pc->pc_set->set_waitq);
+		return true;
+	}
+	return false;
+}
+
+/**
+ * Called when \a added requests brought the queue of \a pc to \a count.
+ * Once a backlog builds up, wake an idle thread of the same CPT to take
+ * part of it, and if it grows past ptlrpcd_steal_remote_min, an idle
+ * thread of one of the nearest CPTs as well.
+ */
+void ptlrpcd_kick_idle(struct ptlrpcd_ctl *pc, int count, int added)
+{
+	struct ptlrpcd	*pd;
+	unsigned int	best;
+	int		thresh = ptlrpcd_steal_remote_min;
+	int		i;
+
+	if (!ptlrpcds_started || test_bit(LIOD_RECOVERY, &pc->pc_flags))
+		return;
+
+	pd = ptlrpcd_of_cpt(pc->pc_cpt);
+	if (count >= 2 && count - added < 2 && ptlrpcd_wake_idle(pd, pc))
+		return;
+
+	if (thresh <= 0 || count < thresh || count - added >= thresh)
+		return;
+
+	best = ptlrpcd_nearest(pd);
+	for (i = 0; i < ptlrpcds_num; i++) {
+		if (ptlrpcds[i] == pd ||
+		    cfs_cpt_distance(cfs_cpt_table, pd->pd_cpt,
+				     ptlrpcds[i]->pd_cpt) != best)
+			continue;
+		if (ptlrpcd_wake_idle(ptlrpcds[i], NULL))
+			return;
+	}
 }
 
 /**
@@ -220,6 +344,7 @@ void ptlrpcd_add_rqset(struct ptlrpc_request_set *set)
 	i = atomic_read(&set->set_remaining);
 	count = atomic_add_return(i, &new->set_new_count);
 	atomic_set(&set->set_remaining, 0);
+	pc->pc_queued += i;
 	spin_unlock(&new->set_new_req_lock);
 	if (count == i) {
 		wake_up(&new->set_waitq);
@@ -229,36 +354,11 @@ void ptlrpcd_add_rqset(struct ptlrpc_request_set *set)
 		 *      no other better choice. It maybe fixed in future. */
 		for (i = 0; i < pc->pc_npartners; i++)
 			wake_up(&pc->pc_partners[i]->pc_set->set_waitq);
+	} else {
+		ptlrpcd_kick_idle(pc, count, i);
 	}
 }
 
-/**
- * Return transferred RPCs count.
- */
-static int ptlrpcd_steal_rqset(struct ptlrpc_request_set *des,
-                               struct ptlrpc_request_set *src)
-{
-	struct list_head *tmp, *pos;
-	struct ptlrpc_request *req;
-	int rc = 0;
-
-	spin_lock(&src->set_new_req_lock);
-	if (likely(!list_empty(&src->set_new_requests))) {
-		list_for_each_safe(pos, tmp, &src->set_new_requests) {
-			req = list_entry(pos, struct ptlrpc_request,
-					 rq_set_chain);
-			req->rq_set = des;
-		}
-		list_splice_init(&src->set_new_requests,
-				 &des->set_requests);
-		rc = atomic_read(&src->set_new_count);
-		atomic_add(rc, &des->set_remaining);
-		atomic_set(&src->set_new_count, 0);
-	}
-	spin_unlock(&src->set_new_req_lock);
-	return rc;
-}
-
 /**
  * Requests that are added to the ptlrpcd queue are sent via
  * ptlrpcd_check->ptlrpc_check_set().
@@ -307,6 +407,114 @@ static inline void ptlrpc_reqset_get(struct ptlrpc_request_set *set)
 	atomic_inc(&set->set_refcount);
 }
 
+/**
+ * Move new requests queued to \a victim into the set of \a pc, if
+ * \a victim has at least \a thresh of them queued. Either all of them
+ * are taken, or only the older half if \a half is set.
+ *
+ * Return transferred RPCs count.
+ */
+static int ptlrpcd_steal_rqset(struct ptlrpcd_ctl *pc,
+			       struct ptlrpcd_ctl *victim, int thresh,
+			       bool half)
+{
+	struct list_head *tmp, *pos;
+	struct ptlrpc_request_set *des = pc->pc_set;
+	struct ptlrpc_request_set *src;
+	struct ptlrpc_request *req;
+	int count;
+	int rc = 0;
+
+	if (victim == pc)
+		return 0;
+
+	spin_lock(&victim->pc_lock);
+	src = victim->pc_set;
+	if (src == NULL) {
+		spin_unlock(&victim->pc_lock);
+		return 0;
+	}
+
+	ptlrpc_reqset_get(src);
+	spin_unlock(&victim->pc_lock);
+
+	if (atomic_read(&src->set_new_count) < max(thresh, 1))
+		goto out;
+
+	spin_lock(&src->set_new_req_lock);
+	count = atomic_read(&src->set_new_count);
+	if (likely(count >= max(thresh, 1))) {
+		if (half)
+			count = (count + 1) / 2;
+		list_for_each_safe(pos, tmp, &src->set_new_requests) {
+			if (rc == count)
+				break;
+			req = list_entry(pos, struct ptlrpc_request,
+					 rq_set_chain);
+			req->rq_set = des;
+			list_move_tail(&req->rq_set_chain, &des->set_requests);
+			rc++;
+		}
+		atomic_add(rc, &des->set_remaining);
+		atomic_sub(rc, &src->set_new_count);
+		victim->pc_lost += rc;
+	}
+	spin_unlock(&src->set_new_req_lock);
+
+	if (rc > 0)
+		CDEBUG(D_RPCTRACE, "transfer %d async RPCs [%s->%s]\n",
+		       rc, victim->pc_name, pc->pc_name);
+out:
+	ptlrpc_reqset_put(src);
+	return rc;
+}
+
+/**
+ * Take work for the idle thread \a pc from outside its partner group:
+ * first half the backlog of a busy thread in the same CPT, and failing
+ * that, of a thread bound to one of the nearest CPTs if its backlog
+ * exceeds ptlrpcd_steal_remote_min.
+ *
+ * Return transferred RPCs count.
+ */
+static int ptlrpcd_steal_wide(struct ptlrpcd_ctl *pc)
+{
+	struct ptlrpcd	*pd = ptlrpcd_of_cpt(pc->pc_cpt);
+	struct ptlrpcd	*rpd;
+	unsigned int	best;
+	int		thresh = ptlrpcd_steal_remote_min;
+	int		rc = 0;
+	int		i;
+	int		j;
+
+	for (i = 1; i < pd->pd_nthreads && rc == 0; i++) {
+		j = (pc->pc_index + i) % pd->pd_nthreads;
+		rc = ptlrpcd_steal_rqset(pc, &pd->pd_threads[j], 2, true);
+	}
+	if (rc > 0) {
+		pc->pc_stolen += rc;
+		return rc;
+	}
+
+	if (thresh <= 0 || ptlrpcds_num < 2)
+		return 0;
+
+	best = ptlrpcd_nearest(pd);
+	for (i = 0; i < ptlrpcds_num && rc == 0; i++) {
+		rpd = ptlrpcds[i];
+		if (rpd == pd ||
+		    cfs_cpt_distance(cfs_cpt_table, pd->pd_cpt,
+				     rpd->pd_cpt) != best)
+			continue;
+
+		for (j = 0; j < rpd->pd_nthreads && rc == 0; j++)
+			rc = ptlrpcd_steal_rqset(pc, &rpd->pd_threads[j],
+						 thresh, true);
+	}
+	pc->pc_stolen_remote += rc;
+	return rc;
+}
+
 /**
  * Check if there is more work to do on ptlrpcd set.
  * Returns 1 if yes.
@@ -380,7 +588,6 @@ static int ptlrpcd_check(struct lu_env *env, struct ptlrpcd_ctl *pc)
                  * work from our partner threads. */
                 if (rc == 0 && pc->pc_npartners > 0) {
                         struct ptlrpcd_ctl *partner;
-                        struct ptlrpc_request_set *ps;
                         int first = pc->pc_cursor;
 
                         do {
@@ -390,27 +597,15 @@ static int ptlrpcd_check(struct lu_env *env, struct ptlrpcd_ctl *pc)
                                 if (partner == NULL)
                                         continue;
 
-				spin_lock(&partner->pc_lock);
-				ps = partner->pc_set;
-				if (ps == NULL) {
-					spin_unlock(&partner->pc_lock);
-					continue;
-				}
-
-				ptlrpc_reqset_get(ps);
-				spin_unlock(&partner->pc_lock);
-
-				if (atomic_read(&ps->set_new_count)) {
-					rc = ptlrpcd_steal_rqset(set, ps);
-					if (rc > 0)
-						CDEBUG(D_RPCTRACE, "transfer %d"
-						       " async RPCs [%d->%d]\n",
-						       rc, partner->pc_index,
-						       pc->pc_index);
-				}
-				ptlrpc_reqset_put(ps);
+				rc = ptlrpcd_steal_rqset(pc, partner, 1, false);
 			} while (rc == 0 && pc->pc_cursor != first);
+			pc->pc_stolen += rc;
 		}
+
+		/* Then from busy threads of this and nearby CPTs. */
+		if (rc == 0 && ptlrpcds_started &&
+		    !test_bit(LIOD_RECOVERY, &pc->pc_flags))
+			rc = ptlrpcd_steal_wide(pc);
 	}
 
 	RETURN(rc || test_bit(LIOD_STOP, &pc->pc_flags));
@@ -527,6 +722,10 @@ static void ptlrpcd_ctl_init(struct ptlrpcd_ctl *pc, int index, int cpt)
 
 	pc->pc_index = index;
 	pc->pc_cpt = cpt;
+	pc->pc_queued = 0;
+	pc->pc_stolen = 0;
+	pc->pc_stolen_remote = 0;
+	pc->pc_lost = 0;
 	init_completion(&pc->pc_starting);
 	init_completion(&pc->pc_finishing);
 	spin_lock_init(&pc->pc_lock);
@@ -691,14 +890,27 @@ static void ptlrpcd_fini(void)
 	int	ncpts;
 	ENTRY;
 
+	ptlrpcds_started = false;
 	if (ptlrpcds != NULL) {
+		/*
+		 * Threads may steal from any other CPT, so stop all of
+		 * them before freeing anything.
+		 */
 		for (i = 0; i < ptlrpcds_num; i++) {
 			if (ptlrpcds[i] == NULL)
 				break;
 			for (j = 0; j < ptlrpcds[i]->pd_nthreads; j++)
 				ptlrpcd_stop(&ptlrpcds[i]->pd_threads[j], 0);
+		}
+		for (i = 0; i < ptlrpcds_num; i++) {
+			if (ptlrpcds[i] == NULL)
+				break;
 			for (j = 0; j < ptlrpcds[i]->pd_nthreads; j++)
 				ptlrpcd_free(&ptlrpcds[i]->pd_threads[j]);
+		}
+		for (i = 0; i < ptlrpcds_num; i++) {
+			if (ptlrpcds[i] == NULL)
+				break;
 			OBD_FREE(ptlrpcds[i], ptlrpcds[i]->pd_size);
 			ptlrpcds[i] = NULL;
 		}
@@ -931,6 +1143,7 @@ static int ptlrpcd_init(void)
 				GOTO(out, rc);
 		}
 	}
+	ptlrpcds_started = true;
 out:
 	if (rc != 0)
 		ptlrpcd_fini();
@@ -962,4 +1175,68 @@ void ptlrpcd_decref(void)
 	mutex_unlock(&ptlrpcd_mutex);
 }
 EXPORT_SYMBOL(ptlrpcd_decref);
+
+static int ptlrpcd_stats_seq_show(struct seq_file *m, void *v)
+{
+	struct ptlrpcd_ctl	*pc;
+	struct ptlrpc_request_set *set;
+	int			i;
+	int			j;
+
+	mutex_lock(&ptlrpcd_mutex);
+	if (ptlrpcds == NULL)
+		goto out;
+
+	seq_printf(m, "%-16s %4s %12s %12s %12s %12s %8s %8s\n",
+		   "thread", "cpt", "queued", "stolen", "stolen_remote",
+		   "lost", "new", "active");
+	for (i = 0; i < ptlrpcds_num; i++) {
+		if (ptlrpcds[i] == NULL)
+			break;
+		for (j = 0; j < ptlrpcds[i]->pd_nthreads; j++) {
+			int nnew = 0;
+			int nactive = 0;
+
+			pc = &ptlrpcds[i]->pd_threads[j];
+			spin_lock(&pc->pc_lock);
+			set = pc->pc_set;
+			if (set != NULL) {
+				nnew = atomic_read(&set->set_new_count);
+				nactive = atomic_read(&set->set_remaining);
+			}
+			spin_unlock(&pc->pc_lock);
+
+			seq_printf(m, "%-16s %4d %12llu %12llu %12llu %12llu "
+				   "%8d %8d\n", pc->pc_name, pc->pc_cpt,
+				   pc->pc_queued, pc->pc_stolen,
+				   pc->pc_stolen_remote, pc->pc_lost,
+				   nnew, nactive);
+		}
+	}
+out:
+	mutex_unlock(&ptlrpcd_mutex);
+	return 0;
+}
+LDEBUGFS_SEQ_FOPS_RO(ptlrpcd_stats);
+
+static struct dentry *ptlrpcd_debugfs_entry;
+
+int ptlrpcd_debugfs_init(void)
+{
+	struct dentry *entry;
+
+	entry = ldebugfs_add_simple(debugfs_lustre_root, "ptlrpcd_stats",
+				    NULL, &ptlrpcd_stats_fops);
+	if (IS_ERR_OR_NULL(entry))
+		return entry ? PTR_ERR(entry) : -ENOMEM;
+
+	ptlrpcd_debugfs_entry = entry;
+	return 0;
+}
+
+void ptlrpcd_debugfs_fini(void)
+{
+	if (!IS_ERR_OR_NULL(ptlrpcd_debugfs_entry))
+		ldebugfs_remove(&ptlrpcd_debugfs_entry);
+}
 /** @} ptlrpcd */
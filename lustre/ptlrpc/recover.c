@@ -61,50 +61,58 @@ void ptlrpc_initiate_recovery(struct obd_import *imp)
         EXIT;
 }
 
-/**
- * Identify what request from replay list needs to be replayed next
- * (based on what we have already replayed) and send it to server.
+/*
+ * Maximum number of replay RPCs an import keeps in flight during recovery.
+ * The server still executes replays in transno order, but having the next
+ * few requests of each client already queued there avoids one round-trip
+ * per replayed transaction. Only used when the server advertises
+ * OBD_CONNECT2_REPLAY_PIPELINE, and never for MDT-MDT imports whose
+ * update replays depend on each other.
  */
-int ptlrpc_replay_next(struct obd_import *imp, int *inflight)
+static unsigned int replay_max_inflight = 4;
+module_param(replay_max_inflight, uint, 0644);
+MODULE_PARM_DESC(replay_max_inflight,
+		 "Max replay RPCs in flight per import during recovery");
+
+static unsigned int ptlrpc_replay_window(struct obd_import *imp)
 {
-        int rc = 0;
-	struct list_head *tmp, *pos;
-        struct ptlrpc_request *req = NULL;
-        __u64 last_transno;
-        ENTRY;
+	struct obd_connect_data *ocd = &imp->imp_connect_data;
 
-        *inflight = 0;
+	if (replay_max_inflight <= 1 ||
+	    imp->imp_connect_flags_orig & OBD_CONNECT_MDS_MDS ||
+	    !(ocd->ocd_connect_flags & OBD_CONNECT_FLAGS2) ||
+	    !(ocd->ocd_connect_flags2 & OBD_CONNECT2_REPLAY_PIPELINE))
+		return 1;
 
-        /* It might have committed some after we last spoke, so make sure we
-         * get rid of them now.
-         */
-	spin_lock(&imp->imp_lock);
-	imp->imp_last_transno_checked = 0;
-	ptlrpc_free_committed(imp);
-	last_transno = imp->imp_last_replay_transno;
+	return replay_max_inflight;
+}
 
-	CDEBUG(D_HA, "import %p from %s committed %llu last %llu\n",
-	       imp, obd2cli_tgt(imp->imp_obd),
-	       imp->imp_peer_committed_transno, last_transno);
+/**
+ * Find the next request to replay after \a last_transno, starting from
+ * the committed open requests and then the regular replay list.
+ *
+ * Called with imp_lock held.
+ */
+static struct ptlrpc_request *
+ptlrpc_replay_find_next(struct obd_import *imp, __u64 last_transno)
+{
+	struct ptlrpc_request *req = NULL;
 
 	/* Replay all the committed open requests on committed_list first */
 	if (!list_empty(&imp->imp_committed_list)) {
-		tmp = imp->imp_committed_list.prev;
-		req = list_entry(tmp, struct ptlrpc_request,
-				     rq_replay_list);
+		req = list_entry(imp->imp_committed_list.prev,
+				 struct ptlrpc_request, rq_replay_list);
 
 		/* The last request on committed_list hasn't been replayed */
 		if (req->rq_transno > last_transno) {
-			if (!imp->imp_resend_replay ||
-			    imp->imp_replay_cursor == &imp->imp_committed_list)
-				imp->imp_replay_cursor =
-					imp->imp_replay_cursor->next;
+			/* the cursor points to the last request sent */
+			imp->imp_replay_cursor = imp->imp_replay_cursor->next;
 
 			while (imp->imp_replay_cursor !=
 			       &imp->imp_committed_list) {
 				req = list_entry(imp->imp_replay_cursor,
-						     struct ptlrpc_request,
-						     rq_replay_list);
+						 struct ptlrpc_request,
+						 rq_replay_list);
 				if (req->rq_transno > last_transno)
 					break;
 
@@ -123,40 +131,97 @@ int ptlrpc_replay_next(struct obd_import *imp, int *inflight)
 	/* All the requests in committed list have been replayed, let's replay
 	 * the imp_replay_list */
 	if (req == NULL) {
-		list_for_each_safe(tmp, pos, &imp->imp_replay_list) {
-			req = list_entry(tmp, struct ptlrpc_request,
-					     rq_replay_list);
+		struct ptlrpc_request *tmp;
 
-			if (req->rq_transno > last_transno)
+		list_for_each_entry(tmp, &imp->imp_replay_list,
+				    rq_replay_list) {
+			if (tmp->rq_transno > last_transno) {
+				req = tmp;
 				break;
-			req = NULL;
+			}
 		}
 	}
 
-	/* If need to resend the last sent transno (because a reconnect
-	 * has occurred), then stop on the matching req and send it again.
-	 * If, however, the last sent transno has been committed then we
-	 * continue replay from the next request. */
-	if (req != NULL && imp->imp_resend_replay)
-		lustre_msg_add_flags(req->rq_reqmsg, MSG_RESENT);
-
-	/* ptlrpc_prepare_replay() may fail to add the reqeust into unreplied
-	 * list if the request hasn't been added to replay list then. Another
-	 * exception is that resend replay could have been removed from the
-	 * unreplied list. */
-	if (req != NULL && list_empty(&req->rq_unreplied_list)) {
-		DEBUG_REQ(D_HA, req, "resend_replay: %d, last_transno: %llu\n",
-			  imp->imp_resend_replay, last_transno);
-		ptlrpc_add_unreplied(req);
-		imp->imp_known_replied_xid = ptlrpc_known_replied_xid(imp);
-	}
+	return req;
+}
 
-	imp->imp_resend_replay = 0;
-	spin_unlock(&imp->imp_lock);
+/**
+ * Identify what requests from replay list need to be replayed next
+ * (based on what we have already replayed and sent) and send them to
+ * the server, keeping up to ptlrpc_replay_window() of them in flight.
+ */
+int ptlrpc_replay_next(struct obd_import *imp, int *inflight)
+{
+	struct ptlrpc_request *req;
+	unsigned int window = ptlrpc_replay_window(imp);
+	__u64 last_transno;
+	int rc = 0;
+	ENTRY;
 
-	if (req != NULL) {
-		LASSERT(!list_empty(&req->rq_unreplied_list));
+	*inflight = 0;
+
+	/* It might have committed some after we last spoke, so make sure we
+	 * get rid of them now.
+	 */
+	spin_lock(&imp->imp_lock);
+	imp->imp_last_transno_checked = 0;
+	ptlrpc_free_committed(imp);
 
+	CDEBUG(D_HA, "import %p from %s committed %llu last %llu sent %llu "
+	       "inflight %d/%u\n", imp, obd2cli_tgt(imp->imp_obd),
+	       imp->imp_peer_committed_transno, imp->imp_last_replay_transno,
+	       imp->imp_last_replay_sent,
+	       atomic_read(&imp->imp_replay_inflight), window);
+
+	/* If need to resend the requests sent before a reconnect, restart
+	 * from the last replied transno and mark everything up to the last
+	 * sent one as resent. If, however, those have been committed then we
+	 * continue replay from the next request. Replays still in flight on
+	 * the previous connection must finish before they can be resent. */
+	if (imp->imp_resend_replay &&
+	    atomic_read(&imp->imp_replay_inflight) > 0) {
+		spin_unlock(&imp->imp_lock);
+		RETURN(0);
+	}
+	if (imp->imp_resend_replay) {
+		imp->imp_replay_resend_upto = imp->imp_last_replay_sent;
+		imp->imp_last_replay_sent = imp->imp_last_replay_transno;
+		imp->imp_replay_cursor = &imp->imp_committed_list;
+		imp->imp_resend_replay = 0;
+	}
+	if (imp->imp_last_replay_sent < imp->imp_last_replay_transno)
+		imp->imp_last_replay_sent = imp->imp_last_replay_transno;
+
+	while (atomic_read(&imp->imp_replay_inflight) < window) {
+		last_transno = imp->imp_last_replay_sent;
+		req = ptlrpc_replay_find_next(imp, last_transno);
+		if (req == NULL)
+			break;
+
+		if (req->rq_transno <= imp->imp_replay_resend_upto)
+			lustre_msg_add_flags(req->rq_reqmsg, MSG_RESENT);
+		/* let the server know which of our replays must arrive
+		 * before this one, so that a later replay overtaking an
+		 * earlier one is not mistaken for a transno gap */
+		lustre_msg_set_last_committed(req->rq_reqmsg,
+					      window > 1 ? last_transno : 0);
+
+		/* ptlrpc_prepare_replay() may fail to add the reqeust into
+		 * unreplied list if the request hasn't been added to replay
+		 * list then. Another exception is that resend replay could
+		 * have been removed from the unreplied list. */
+		if (list_empty(&req->rq_unreplied_list)) {
+			DEBUG_REQ(D_HA, req, "resend_replay: %llu, "
+				  "last_transno: %llu\n",
+				  imp->imp_replay_resend_upto, last_transno);
+			ptlrpc_add_unreplied(req);
+			imp->imp_known_replied_xid =
+				ptlrpc_known_replied_xid(imp);
+		}
+		imp->imp_last_replay_sent = req->rq_transno;
+		spin_unlock(&imp->imp_lock);
+
+		LASSERT(!list_empty(&req->rq_unreplied_list));
 		rc = ptlrpc_replay_req(req);
 		if (rc) {
 			CERROR("recovery replay error %d for req "
@@ -164,7 +229,13 @@ int ptlrpc_replay_next(struct obd_import *imp, int *inflight)
 			RETURN(rc);
 		}
 		*inflight = 1;
+
+		spin_lock(&imp->imp_lock);
+		if (imp->imp_state != LUSTRE_IMP_REPLAY)
+			break;
 	}
+	spin_unlock(&imp->imp_lock);
+
 	RETURN(rc);
 }
 
@@ -224,7 +224,7 @@ static void enc_pools_release_free_pages(long npages)
 }
 
 /*
- * we try to keep at least PTLRPC_MAX_BRW_PAGES pages in the pool.
+ * we try to keep at least PTLRPC_DEF_BRW_PAGES pages in the pool.
  */
 static unsigned long enc_pools_shrink_count(struct shrinker *s,
 					    struct shrink_control *sc)
@@ -241,23 +241,23 @@ static unsigned long enc_pools_shrink_count(struct shrinker *s,
 	}
 
 	LASSERT(page_pools.epp_idle_idx <= IDLE_IDX_MAX);
-	return (page_pools.epp_free_pages <= PTLRPC_MAX_BRW_PAGES) ? 0 :
-		(page_pools.epp_free_pages - PTLRPC_MAX_BRW_PAGES) *
+	return (page_pools.epp_free_pages <= PTLRPC_DEF_BRW_PAGES) ? 0 :
+		(page_pools.epp_free_pages - PTLRPC_DEF_BRW_PAGES) *
 		(IDLE_IDX_MAX - page_pools.epp_idle_idx) / IDLE_IDX_MAX;
 }
 
 /*
- * we try to keep at least PTLRPC_MAX_BRW_PAGES pages in the pool.
+ * we try to keep at least PTLRPC_DEF_BRW_PAGES pages in the pool.
  */
 static unsigned long enc_pools_shrink_scan(struct shrinker *s,
 					   struct shrink_control *sc)
 {
 	spin_lock(&page_pools.epp_lock);
-	if (page_pools.epp_free_pages <= PTLRPC_MAX_BRW_PAGES)
+	if (page_pools.epp_free_pages <= PTLRPC_DEF_BRW_PAGES)
 		sc->nr_to_scan = 0;
 	else
 		sc->nr_to_scan = min_t(unsigned long, sc->nr_to_scan,
-			      page_pools.epp_free_pages - PTLRPC_MAX_BRW_PAGES);
+			      page_pools.epp_free_pages - PTLRPC_DEF_BRW_PAGES);
 	if (sc->nr_to_scan > 0) {
 		enc_pools_release_free_pages(sc->nr_to_scan);
 		CDEBUG(D_SEC, "released %ld pages, %ld left\n",
@@ -430,8 +430,8 @@ static int enc_pools_add_pages(int npages)
 	int             npools, alloced = 0;
 	int             i, j, rc = -ENOMEM;
 
-	if (npages < PTLRPC_MAX_BRW_PAGES)
-		npages = PTLRPC_MAX_BRW_PAGES;
+	if (npages < PTLRPC_DEF_BRW_PAGES)
+		npages = PTLRPC_DEF_BRW_PAGES;
 
 	mutex_lock(&add_pages_mutex);
 
@@ -734,8 +734,8 @@ int sptlrpc_enc_pool_add_user(void)
 	spin_unlock(&page_pools.epp_lock);
 
 	if (need_grow) {
-		enc_pools_add_pages(PTLRPC_MAX_BRW_PAGES +
-				    PTLRPC_MAX_BRW_PAGES);
+		enc_pools_add_pages(PTLRPC_DEF_BRW_PAGES +
+				    PTLRPC_DEF_BRW_PAGES);
 
 		spin_lock(&page_pools.epp_lock);
 		page_pools.epp_growing = 0;
@@ -1334,6 +1334,10 @@ void lustre_assert_wire_constants(void)
 		 OBD_CONNECT2_LOCK_CONVERT);
 	LASSERTF(OBD_CONNECT2_ARCHIVE_ID_ARRAY == 0x100ULL, "found 0x%.16llxULL\n",
 		 OBD_CONNECT2_ARCHIVE_ID_ARRAY);
+	LASSERTF(OBD_CONNECT2_REPLAY_PIPELINE == 0x200ULL, "found 0x%.16llxULL\n",
+		 OBD_CONNECT2_REPLAY_PIPELINE);
+	LASSERTF(OBD_CONNECT2_BATCH_AST == 0x400ULL, "found 0x%.16llxULL\n",
+		 OBD_CONNECT2_BATCH_AST);
 	LASSERTF(OBD_CKSUM_CRC32 == 0x00000001UL, "found 0x%.8xUL\n",
 		(unsigned)OBD_CKSUM_CRC32);
 	LASSERTF(OBD_CKSUM_ADLER == 0x00000002UL, "found 0x%.8xUL\n",
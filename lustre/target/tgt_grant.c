@@ -63,6 +63,9 @@
  * This file handles the core logic for:
  * - grant allocation strategy
  * - maintaining per-client as well as global grant space accounting
+ * - splitting global accounting into per-CPT slices so that concurrent bulk
+ *   writes from clients homed on different CPTs do not serialize, all slices
+ *   being locked together only when free space runs low
  * - processing grant information packed in incoming requests
  * - allocating server-side grant space for synchronous write RPCs which did not
  *   consume grant on the client side (OBD_BRW_FROM_GRANT flag not set). If not
@@ -73,6 +76,7 @@
 
 #define DEBUG_SUBSYSTEM S_FILTER
 
+#include <linux/hash.h>
 #include <obd.h>
 #include <obd_class.h>
 
@@ -81,6 +85,55 @@
 /* Clients typically hold 2x their max_rpcs_in_flight of grant space */
 #define TGT_GRANT_SHRINK_LIMIT(exp)	(2ULL * 8 * exp_max_brw_size(exp))
 
+/* Below this amount of ungranted space, per-CPT shares of it get too small
+ * to be handed out independently and grant is accounted under the exclusive
+ * grant lock */
+#define TGT_GRANT_GLOBAL_LIMIT(tgd, chunk)				\
+	((u64)cfs_percpt_number((tgd)->tgd_pcpt) * 32 * (chunk))
+
+/* Home CPT of an export for grant accounting. Grant counters of an export
+ * are only updated under the private grant lock of this CPT and are summed
+ * in the matching tgd_pcpt slice. Handle cookies are allocated in a fixed
+ * stride from a common base, so they are hashed to spread exports evenly
+ * over the CPTs */
+static inline int tgt_grant_cpt(struct tg_grants_data *tgd,
+				struct obd_export *exp)
+{
+	return hash_64(exp->exp_handle.h_cookie, 32) %
+	       cfs_percpt_number(tgd->tgd_pcpt);
+}
+
+static inline struct tg_grants_pcpt *tgt_grant_pcpt(struct tg_grants_data *tgd,
+						    struct obd_export *exp)
+{
+	return tgd->tgd_pcpt[tgt_grant_cpt(tgd, exp)];
+}
+
+/* Take the grant lock of \a exp home CPT, or all grant locks if \a global */
+static inline void tgt_grant_lock(struct tg_grants_data *tgd,
+				  struct obd_export *exp, bool global)
+{
+	cfs_percpt_lock(tgd->tgd_grant_lock,
+			global ? CFS_PERCPT_LOCK_EX : tgt_grant_cpt(tgd, exp));
+}
+
+/* Companion of tgt_grant_lock() */
+static inline void tgt_grant_unlock(struct tg_grants_data *tgd,
+				    struct obd_export *exp, bool global)
+{
+	cfs_percpt_unlock(tgd->tgd_grant_lock,
+			  global ? CFS_PERCPT_LOCK_EX : tgt_grant_cpt(tgd, exp));
+}
+
+/* The exclusive lock holds all private locks, so this also works then */
+static inline void tgt_grant_assert_locked(struct tg_grants_data *tgd,
+					   struct obd_export *exp)
+{
+	int cpt = tgt_grant_cpt(tgd, exp);
+
+	assert_spin_locked(tgd->tgd_grant_lock->pcl_locks[cpt]);
+}
+
 /* Helpers to inflate/deflate grants for clients that do not support the grant
  * parameters */
 static inline u64 tgt_grant_inflate(struct tg_grants_data *tgd, u64 val)
@@ -132,6 +185,65 @@ static inline u64 tgt_grant_chunk(struct obd_export *exp,
 	return chunk;
 }
 
+/**
+ * Fold per-CPT grant counters of a target.
+ *
+ * Unless the caller holds the exclusive grant lock, slices are read without
+ * locking and the result is a racy estimate. This is good enough for statfs
+ * and for space checks as long as free space is not running low.
+ *
+ * \param[in] tgd	grant data of the target
+ * \param[out] dirty	total dirty data reported by clients, can be NULL
+ * \param[out] granted	total space granted to clients, can be NULL
+ * \param[out] pending	total grant used by I/Os in progress, can be NULL
+ */
+void tgt_grant_totals(struct tg_grants_data *tgd, u64 *dirty, u64 *granted,
+		      u64 *pending)
+{
+	struct tg_grants_pcpt *tgp;
+	u64 tot_dirty = 0;
+	u64 tot_granted = 0;
+	u64 tot_pending = 0;
+	int i;
+
+	if (tgd->tgd_pcpt != NULL) {
+		cfs_percpt_for_each(tgp, i, tgd->tgd_pcpt) {
+			tot_dirty += tgp->tgp_tot_dirty;
+			tot_granted += tgp->tgp_tot_granted;
+			tot_pending += tgp->tgp_tot_pending;
+		}
+	}
+
+	if (dirty != NULL)
+		*dirty = tot_dirty;
+	if (granted != NULL)
+		*granted = tot_granted;
+	if (pending != NULL)
+		*pending = tot_pending;
+}
+EXPORT_SYMBOL(tgt_grant_totals);
+
+/**
+ * Release per-CPT grant accounting set up by tgt_init().
+ *
+ * This is not done by tgt_fini(), the target calls it once its procfs
+ * entries which read the grant totals are removed. Safe to call twice.
+ *
+ * \param[in] tgd	grant data of the target
+ */
+void tgt_grant_fini(struct tg_grants_data *tgd)
+{
+	if (tgd->tgd_pcpt != NULL) {
+		cfs_percpt_free(tgd->tgd_pcpt);
+		tgd->tgd_pcpt = NULL;
+	}
+	if (tgd->tgd_grant_lock != NULL) {
+		cfs_percpt_lock_free(tgd->tgd_grant_lock);
+		tgd->tgd_grant_lock = NULL;
+	}
+}
+EXPORT_SYMBOL(tgt_grant_fini);
+
 static int tgt_check_export_grants(struct obd_export *exp, u64 *dirty,
 				   u64 *pending, u64 *granted, u64 maxsize)
 {
@@ -171,6 +283,7 @@ static int tgt_check_export_grants(struct obd_export *exp, u64 *dirty,
  * found, a CERROR is printed with the function name \func that was passed as
  * argument. LBUG is only called in case of serious counter corruption (i.e.
  * value larger than the device size).
+ * All per-CPT grant locks are taken so that the folded counters are exact.
  * Those sanity checks can be pretty expensive and are disabled if the OBD
  * device has more than 100 connected exports.
  *
@@ -204,7 +317,7 @@ void tgt_grant_sanity_check(struct obd_device *obd, const char *func)
 	maxsize = tgd->tgd_osfs.os_blocks << tgd->tgd_blockbits;
 
 	spin_lock(&obd->obd_dev_lock);
-	spin_lock(&tgd->tgd_grant_lock);
+	cfs_percpt_lock(tgd->tgd_grant_lock, CFS_PERCPT_LOCK_EX);
 	exp = obd->obd_self_export;
 	ted = &exp->exp_target_data;
 	CDEBUG(D_CACHE, "%s: processing self export: %ld %ld "
@@ -219,7 +332,8 @@ void tgt_grant_sanity_check(struct obd_device *obd, const char *func)
 						&tot_granted, maxsize);
 		if (error < 0) {
 			spin_unlock(&obd->obd_dev_lock);
-			spin_unlock(&tgd->tgd_grant_lock);
+			cfs_percpt_unlock(tgd->tgd_grant_lock,
+					  CFS_PERCPT_LOCK_EX);
 			LBUG();
 		}
 	}
@@ -232,16 +346,15 @@ void tgt_grant_sanity_check(struct obd_device *obd, const char *func)
 						&tot_granted, maxsize);
 		if (error < 0) {
 			spin_unlock(&obd->obd_dev_lock);
-			spin_unlock(&tgd->tgd_grant_lock);
+			cfs_percpt_unlock(tgd->tgd_grant_lock,
+					  CFS_PERCPT_LOCK_EX);
 			LBUG();
 		}
 	}
 
-	fo_tot_granted = tgd->tgd_tot_granted;
-	fo_tot_pending = tgd->tgd_tot_pending;
-	fo_tot_dirty = tgd->tgd_tot_dirty;
+	tgt_grant_totals(tgd, &fo_tot_dirty, &fo_tot_granted, &fo_tot_pending);
 	spin_unlock(&obd->obd_dev_lock);
-	spin_unlock(&tgd->tgd_grant_lock);
+	cfs_percpt_unlock(tgd->tgd_grant_lock, CFS_PERCPT_LOCK_EX);
 
 	if (tot_granted != fo_tot_granted)
 		CERROR("%s: tot_granted %llu != fo_tot_granted %llu\n",
@@ -289,6 +402,7 @@ int tgt_statfs_internal(const struct lu_env *env, struct lu_target *lut,
 	spin_lock(&tgd->tgd_osfs_lock);
 	if (tgd->tgd_osfs_age < max_age || max_age == 0) {
 		u64 unstable;
+		u64 pending;
 
 		/* statfs data are too old, get up-to-date one.
 		 * we must be cautious here since multiple threads might be
@@ -315,7 +429,9 @@ int tgt_statfs_internal(const struct lu_env *env, struct lu_target *lut,
 
 		osfs->os_namelen = min_t(__u32, osfs->os_namelen, NAME_MAX);
 
-		spin_lock(&tgd->tgd_grant_lock);
+		/* a lazy fold is enough, that is an estimate anyway */
+		tgt_grant_totals(tgd, NULL, NULL, &pending);
+
 		spin_lock(&tgd->tgd_osfs_lock);
 		/* calculate how much space was written while we released the
 		 * tgd_osfs_lock */
@@ -339,8 +455,7 @@ int tgt_statfs_internal(const struct lu_env *env, struct lu_target *lut,
 		}
 		/* similarly, there is some uncertainty on write requests
 		 * between prepare & commit */
-		tgd->tgd_osfs_unstable += tgd->tgd_tot_pending;
-		spin_unlock(&tgd->tgd_grant_lock);
+		tgd->tgd_osfs_unstable += pending;
 
 		/* finally udpate cached statfs data */
 		tgd->tgd_osfs = *osfs;
@@ -420,7 +535,8 @@ static void tgt_grant_statfs(const struct lu_env *env, struct obd_export *exp,
  * This is done by accessing cached statfs data previously populated by
  * tgt_grant_statfs(), from which we withdraw the space already granted to
  * clients and the reserved space.
- * Caller must hold tgd_grant_lock spinlock.
+ * Caller must hold the grant lock of \a exp. Granted space is folded from all
+ * CPTs, which is exact only if the caller holds the exclusive grant lock.
  *
  * \param[in] exp	export associated with the device for which the amount
  *			of available space is requested
@@ -432,13 +548,15 @@ static u64 tgt_grant_space_left(struct obd_export *exp)
 	struct lu_target	*lut = obd->u.obt.obt_lut;
 	struct tg_grants_data	*tgd = &lut->lut_tgd;
 	u64			 tot_granted;
+	u64			 tot_pending;
+	u64			 tot_dirty;
 	u64			 left;
 	u64			 avail;
 	u64			 unstable;
 	u64			 reserved;
 
 	ENTRY;
-	assert_spin_locked(&tgd->tgd_grant_lock);
+	tgt_grant_assert_locked(tgd, exp);
 
 	spin_lock(&tgd->tgd_osfs_lock);
 	/* get available space from cached statfs data */
@@ -446,12 +564,13 @@ static u64 tgt_grant_space_left(struct obd_export *exp)
 	unstable = tgd->tgd_osfs_unstable; /* those might be accounted twice */
 	spin_unlock(&tgd->tgd_osfs_lock);
 
+	tgt_grant_totals(tgd, &tot_dirty, &tot_granted, &tot_pending);
 	reserved = left * tgd->tgd_reserved_pcnt / 100;
-	tot_granted = tgd->tgd_tot_granted + reserved;
+	tot_granted += reserved;
 
 	if (left < tot_granted) {
 		int mask = (left + unstable <
-			    tot_granted - tgd->tgd_tot_pending) ?
+			    tot_granted - tot_pending) ?
 			    D_ERROR : D_CACHE;
 
 		CDEBUG_LIMIT(mask, "%s: cli %s/%p left %llu < tot_grant "
@@ -459,8 +578,7 @@ static u64 tgt_grant_space_left(struct obd_export *exp)
 			     "dirty %llu\n",
 			     obd->obd_name, exp->exp_client_uuid.uuid, exp,
 			     left, tot_granted, unstable,
-			     tgd->tgd_tot_pending,
-			     tgd->tgd_tot_dirty);
+			     tot_pending, tot_dirty);
 		RETURN(0);
 	}
 
@@ -474,7 +592,7 @@ static u64 tgt_grant_space_left(struct obd_export *exp)
 	CDEBUG(D_CACHE, "%s: cli %s/%p avail %llu left %llu unstable "
 	       "%llu tot_grant %llu pending %llu\n", obd->obd_name,
 	       exp->exp_client_uuid.uuid, exp, avail, left, unstable,
-	       tot_granted, tgd->tgd_tot_pending);
+	       tot_granted, tot_pending);
 
 	RETURN(left);
 }
@@ -487,23 +605,26 @@ static u64 tgt_grant_space_left(struct obd_export *exp)
  * inflate all grant counters passed in the request if the client does not
  * support the grant parameters.
  * We will later calculate the client's new grant and return it.
- * Caller must hold tgd_grant_lock spinlock.
+ * Caller must hold the grant lock of \a exp.
  *
  * \param[in] env	LU environment supplying osfs storage
  * \param[in] exp	export for which we received the request
  * \param[in,out] oa	incoming obdo sent by the client
+ * \param[in] chunk	grant chunk of the export
+ * \param[in] global	whether the exclusive grant lock is held
  */
 static void tgt_grant_incoming(const struct lu_env *env, struct obd_export *exp,
-			       struct obdo *oa, long chunk)
+			       struct obdo *oa, long chunk, bool global)
 {
 	struct tg_export_data	*ted = &exp->exp_target_data;
 	struct obd_device	*obd = exp->exp_obd;
 	struct tg_grants_data	*tgd = &obd->u.obt.obt_lut->lut_tgd;
+	struct tg_grants_pcpt	*tgp = tgt_grant_pcpt(tgd, exp);
 	long			 dirty;
 	long			 dropped;
 	ENTRY;
 
-	assert_spin_locked(&tgd->tgd_grant_lock);
+	tgt_grant_assert_locked(tgd, exp);
 
 	if ((oa->o_valid & (OBD_MD_FLBLOCKS|OBD_MD_FLGRANT)) !=
 					(OBD_MD_FLBLOCKS|OBD_MD_FLGRANT)) {
@@ -539,7 +660,7 @@ static void tgt_grant_incoming(const struct lu_env *env, struct obd_export *exp,
 	 * on ted_dirty however, but we must check sanity to not assert. */
 	if (dirty > ted->ted_grant + 4 * chunk)
 		dirty = ted->ted_grant + 4 * chunk;
-	tgd->tgd_tot_dirty += dirty - ted->ted_dirty;
+	tgp->tgp_tot_dirty += dirty - ted->ted_dirty;
 	if (ted->ted_grant < dropped) {
 		CDEBUG(D_CACHE,
 		       "%s: cli %s/%p reports %lu dropped > grant %lu\n",
@@ -547,13 +668,13 @@ static void tgt_grant_incoming(const struct lu_env *env, struct obd_export *exp,
 		       ted->ted_grant);
 		dropped = 0;
 	}
-	if (tgd->tgd_tot_granted < dropped) {
+	if (tgp->tgp_tot_granted < dropped) {
 		CERROR("%s: cli %s/%p reports %lu dropped > tot_grant %llu\n",
 		       obd->obd_name, exp->exp_client_uuid.uuid, exp,
-		       dropped, tgd->tgd_tot_granted);
+		       dropped, tgp->tgp_tot_granted);
 		dropped = 0;
 	}
-	tgd->tgd_tot_granted -= dropped;
+	tgp->tgp_tot_granted -= dropped;
 	ted->ted_grant -= dropped;
 	ted->ted_dirty = dirty;
 
@@ -561,7 +682,7 @@ static void tgt_grant_incoming(const struct lu_env *env, struct obd_export *exp,
 		CERROR("%s: cli %s/%p dirty %ld pend %ld grant %ld\n",
 		       obd->obd_name, exp->exp_client_uuid.uuid, exp,
 		       ted->ted_dirty, ted->ted_pending, ted->ted_grant);
-		spin_unlock(&tgd->tgd_grant_lock);
+		tgt_grant_unlock(tgd, exp, global);
 		LBUG();
 	}
 	EXIT;
@@ -574,7 +695,7 @@ static void tgt_grant_incoming(const struct lu_env *env, struct obd_export *exp,
  * shrinking). This function proceeds with the shrink request when there is
  * less ungranted space remaining than the amount all of the connected clients
  * would consume if they used their full grant.
- * Caller must hold tgd_grant_lock spinlock.
+ * Caller must hold the grant lock of \a exp.
  *
  * \param[in] exp		export releasing grant space
  * \param[in,out] oa		incoming obdo sent by the client
@@ -587,22 +708,23 @@ static void tgt_grant_shrink(struct obd_export *exp, struct obdo *oa,
 	struct tg_export_data	*ted = &exp->exp_target_data;
 	struct obd_device	*obd = exp->exp_obd;
 	struct tg_grants_data	*tgd = &obd->u.obt.obt_lut->lut_tgd;
+	struct tg_grants_pcpt	*tgp = tgt_grant_pcpt(tgd, exp);
 	long			 grant_shrink;
 
-	assert_spin_locked(&tgd->tgd_grant_lock);
+	tgt_grant_assert_locked(tgd, exp);
 	LASSERT(exp);
-	if (left_space >= tgd->tgd_tot_granted_clients *
+	if (left_space >= atomic_read(&tgd->tgd_tot_granted_clients) *
 			  TGT_GRANT_SHRINK_LIMIT(exp))
 		return;
 
 	grant_shrink = oa->o_grant;
 
 	ted->ted_grant -= grant_shrink;
-	tgd->tgd_tot_granted -= grant_shrink;
+	tgp->tgp_tot_granted -= grant_shrink;
 
-	CDEBUG(D_CACHE, "%s: cli %s/%p shrink %ld ted_grant %ld total %llu\n",
+	CDEBUG(D_CACHE, "%s: cli %s/%p shrink %ld ted_grant %ld cpt total %llu\n",
 	       obd->obd_name, exp->exp_client_uuid.uuid, exp, grant_shrink,
-	       ted->ted_grant, tgd->tgd_tot_granted);
+	       ted->ted_grant, tgp->tgp_tot_granted);
 
 	/* client has just released some grant, don't grant any space back */
 	oa->o_grant = 0;
@@ -678,7 +800,7 @@ static inline u64 tgt_grant_rnb_size(struct obd_export *exp,
  * The OBD_BRW_GRANTED flag will be set in the rnb_flags of each network
  * buffer which has been granted enough space to proceed. Buffers without
  * this flag will fail to be written with -ENOSPC (see tgt_preprw_write().
- * Caller must hold tgd_grant_lock spinlock.
+ * Caller must hold the grant lock of \a exp.
  *
  * \param[in] env	LU environment passed by the caller
  * \param[in] exp	export identifying the client which sent the RPC
@@ -688,15 +810,17 @@ static inline u64 tgt_grant_rnb_size(struct obd_export *exp,
  * \param[in] niocount	the number of network buffers in the list
  * \param[in] left	the remaining free space with space already granted
  *			taken out
+ * \param[in] global	whether the exclusive grant lock is held
  */
 static void tgt_grant_check(const struct lu_env *env, struct obd_export *exp,
 			    struct obdo *oa, struct niobuf_remote *rnb,
-			    int niocount, u64 *left)
+			    int niocount, u64 *left, bool global)
 {
 	struct tg_export_data	*ted = &exp->exp_target_data;
 	struct obd_device	*obd = exp->exp_obd;
 	struct lu_target	*lut = obd->u.obt.obt_lut;
 	struct tg_grants_data	*tgd = &lut->lut_tgd;
+	struct tg_grants_pcpt	*tgp = tgt_grant_pcpt(tgd, exp);
 	unsigned long		 ungranted = 0;
 	unsigned long		 granted = 0;
 	int			 i;
@@ -704,7 +828,7 @@ static void tgt_grant_check(const struct lu_env *env, struct obd_export *exp,
 
 	ENTRY;
 
-	assert_spin_locked(&tgd->tgd_grant_lock);
+	tgt_grant_assert_locked(tgd, exp);
 
 	if (obd->obd_recovering) {
 		/* Replaying write. Grant info have been processed already so no
@@ -823,8 +947,8 @@ static void tgt_grant_check(const struct lu_env *env, struct obd_export *exp,
 	 * happens in tgt_grant_commit() after the writes are done. */
 	ted->ted_grant -= granted;
 	ted->ted_pending += oa->o_grant_used;
-	tgd->tgd_tot_granted += ungranted;
-	tgd->tgd_tot_pending += oa->o_grant_used;
+	tgp->tgp_tot_granted += ungranted;
+	tgp->tgp_tot_pending += oa->o_grant_used;
 
 	CDEBUG(D_CACHE,
 	       "%s: cli %s/%p granted: %lu ungranted: %lu grant: %lu dirty: %lu"
@@ -842,14 +966,14 @@ static void tgt_grant_check(const struct lu_env *env, struct obd_export *exp,
 		       granted, ted->ted_dirty);
 		granted = ted->ted_dirty;
 	}
-	tgd->tgd_tot_dirty -= granted;
+	tgp->tgp_tot_dirty -= granted;
 	ted->ted_dirty -= granted;
 
 	if (ted->ted_dirty < 0 || ted->ted_grant < 0 || ted->ted_pending < 0) {
 		CERROR("%s: cli %s/%p dirty %ld pend %ld grant %ld\n",
 		       obd->obd_name, exp->exp_client_uuid.uuid, exp,
 		       ted->ted_dirty, ted->ted_pending, ted->ted_grant);
-		spin_unlock(&tgd->tgd_grant_lock);
+		tgt_grant_unlock(tgd, exp, global);
 		LBUG();
 	}
 	EXIT;
@@ -860,7 +984,7 @@ static void tgt_grant_check(const struct lu_env *env, struct obd_export *exp,
  *
  * Calculate how much grant space to return to client, based on how much space
  * is currently free and how much of that is already granted.
- * Caller must hold tgd_grant_lock spinlock.
+ * Caller must hold the grant lock of \a exp.
  *
  * \param[in] exp		export of the client which sent the request
  * \param[in] curgrant		current grant claimed by the client
@@ -872,15 +996,17 @@ static void tgt_grant_check(const struct lu_env *env, struct obd_export *exp,
  *				and limit how much space is granted back to the
  *				client. Otherwise, the server should try hard to
  *				satisfy the client request.
+ * \param[in] global		whether the exclusive grant lock is held
  *
  * \retval			amount of grant space allocated
  */
 static long tgt_grant_alloc(struct obd_export *exp, u64 curgrant,
 			    u64 want, u64 left, long chunk,
-			    bool conservative)
+			    bool conservative, bool global)
 {
 	struct obd_device	*obd = exp->exp_obd;
 	struct tg_grants_data	*tgd = &obd->u.obt.obt_lut->lut_tgd;
+	struct tg_grants_pcpt	*tgp = tgt_grant_pcpt(tgd, exp);
 	struct tg_export_data	*ted = &exp->exp_target_data;
 	u64			 grant;
 
@@ -916,6 +1042,11 @@ static long tgt_grant_alloc(struct obd_export *exp, u64 curgrant,
 	if (obd->obd_recovering)
 		conservative = false;
 
+	if (!global)
+		/* exports homed on other CPTs can be granted the same space
+		 * concurrently, only hand out the share of this CPT */
+		left /= cfs_percpt_number(tgd->tgd_pcpt);
+
 	if (conservative)
 		/* don't grant more than 1/8th of the remaining free space in
 		 * one chunk */
@@ -940,14 +1071,14 @@ static long tgt_grant_alloc(struct obd_export *exp, u64 curgrant,
 	if (ted->ted_grant + grant > want + chunk)
 		grant = want + chunk - ted->ted_grant;
 
-	tgd->tgd_tot_granted += grant;
+	tgp->tgp_tot_granted += grant;
 	ted->ted_grant += grant;
 
 	if (ted->ted_grant < 0) {
 		CERROR("%s: cli %s/%p grant %ld want %llu current %llu\n",
 		       obd->obd_name, exp->exp_client_uuid.uuid, exp,
 		       ted->ted_grant, want, curgrant);
-		spin_unlock(&tgd->tgd_grant_lock);
+		tgt_grant_unlock(tgd, exp, global);
 		LBUG();
 	}
 
@@ -956,9 +1087,9 @@ static long tgt_grant_alloc(struct obd_export *exp, u64 curgrant,
 	       " granting: %llu\n", obd->obd_name, exp->exp_client_uuid.uuid,
 	       exp, want, curgrant, grant);
 	CDEBUG(D_CACHE,
-	       "%s: cli %s/%p tot cached:%llu granted:%llu"
+	       "%s: cli %s/%p cpt cached:%llu granted:%llu"
 	       " num_exports: %d\n", obd->obd_name, exp->exp_client_uuid.uuid,
-	       exp, tgd->tgd_tot_dirty, tgd->tgd_tot_granted,
+	       exp, tgp->tgp_tot_dirty, tgp->tgp_tot_granted,
 	       obd->obd_num_exports);
 
 	RETURN(grant);
@@ -990,6 +1121,7 @@ void tgt_grant_connect(const struct lu_env *env, struct obd_export *exp,
 	long			 chunk;
 	int			 from_cache;
 	int			 force = 0; /* can use cached data */
+	bool			 global = false;
 
 	/* don't grant space to client with read-only access */
 	if (OCD_HAS_FLAG(data, RDONLY) ||
@@ -1008,8 +1140,8 @@ void tgt_grant_connect(const struct lu_env *env, struct obd_export *exp,
 	chunk = tgt_grant_chunk(exp, lut, data);
 refresh:
 	tgt_grant_statfs(env, exp, force, &from_cache);
-
-	spin_lock(&tgd->tgd_grant_lock);
+relock:
+	tgt_grant_lock(tgd, exp, global);
 
 	/* Grab free space from cached info and take out space already granted
 	 * to clients as well as reserved space */
@@ -1017,13 +1149,21 @@ refresh:
 
 	/* get fresh statfs data if we are short in ungranted space */
 	if (from_cache && left < 32 * chunk) {
-		spin_unlock(&tgd->tgd_grant_lock);
+		tgt_grant_unlock(tgd, exp, global);
 		CDEBUG(D_CACHE, "fs has no space left and statfs too old\n");
 		force = 1;
 		goto refresh;
 	}
 
-	tgt_grant_alloc(exp, (u64)ted->ted_grant, want, left, chunk, new_conn);
+	/* space is getting short, account grant across all CPTs at once */
+	if (!global && left < TGT_GRANT_GLOBAL_LIMIT(tgd, chunk)) {
+		tgt_grant_unlock(tgd, exp, global);
+		global = true;
+		goto relock;
+	}
+
+	tgt_grant_alloc(exp, (u64)ted->ted_grant, want, left, chunk, new_conn,
+			global);
 
 	/* return to client its current grant */
 	if (OCD_HAS_FLAG(data, GRANT_PARAM))
@@ -1033,13 +1173,13 @@ refresh:
 		data->ocd_grant = tgt_grant_deflate(tgd, (u64)ted->ted_grant);
 
 	/* reset dirty accounting */
-	tgd->tgd_tot_dirty -= ted->ted_dirty;
+	tgt_grant_pcpt(tgd, exp)->tgp_tot_dirty -= ted->ted_dirty;
 	ted->ted_dirty = 0;
 
 	if (new_conn && OCD_HAS_FLAG(data, GRANT))
-		tgd->tgd_tot_granted_clients++;
+		atomic_inc(&tgd->tgd_tot_granted_clients);
 
-	spin_unlock(&tgd->tgd_grant_lock);
+	tgt_grant_unlock(tgd, exp, global);
 
 	CDEBUG(D_CACHE, "%s: cli %s/%p ocd_grant: %d want: %llu left: %llu\n",
 	       exp->exp_obd->obd_name, exp->exp_client_uuid.uuid,
@@ -1063,28 +1203,29 @@ void tgt_grant_discard(struct obd_export *exp)
 {
 	struct obd_device	*obd = exp->exp_obd;
 	struct tg_grants_data	*tgd = &obd->u.obt.obt_lut->lut_tgd;
+	struct tg_grants_pcpt	*tgp = tgt_grant_pcpt(tgd, exp);
 	struct tg_export_data	*ted = &exp->exp_target_data;
 
-	spin_lock(&tgd->tgd_grant_lock);
-	LASSERTF(tgd->tgd_tot_granted >= ted->ted_grant,
+	tgt_grant_lock(tgd, exp, false);
+	LASSERTF(tgp->tgp_tot_granted >= ted->ted_grant,
 		 "%s: tot_granted %llu cli %s/%p ted_grant %ld\n",
-		 obd->obd_name, tgd->tgd_tot_granted,
+		 obd->obd_name, tgp->tgp_tot_granted,
 		 exp->exp_client_uuid.uuid, exp, ted->ted_grant);
-	tgd->tgd_tot_granted -= ted->ted_grant;
+	tgp->tgp_tot_granted -= ted->ted_grant;
 	ted->ted_grant = 0;
-	LASSERTF(tgd->tgd_tot_pending >= ted->ted_pending,
+	LASSERTF(tgp->tgp_tot_pending >= ted->ted_pending,
 		 "%s: tot_pending %llu cli %s/%p ted_pending %ld\n",
-		 obd->obd_name, tgd->tgd_tot_pending,
+		 obd->obd_name, tgp->tgp_tot_pending,
 		 exp->exp_client_uuid.uuid, exp, ted->ted_pending);
-	/* tgd_tot_pending is handled in tgt_grant_commit as bulk
+	/* tgp_tot_pending is handled in tgt_grant_commit as bulk
 	 * commmits */
-	LASSERTF(tgd->tgd_tot_dirty >= ted->ted_dirty,
+	LASSERTF(tgp->tgp_tot_dirty >= ted->ted_dirty,
 		 "%s: tot_dirty %llu cli %s/%p ted_dirty %ld\n",
-		 obd->obd_name, tgd->tgd_tot_dirty,
+		 obd->obd_name, tgp->tgp_tot_dirty,
 		 exp->exp_client_uuid.uuid, exp, ted->ted_dirty);
-	tgd->tgd_tot_dirty -= ted->ted_dirty;
+	tgp->tgp_tot_dirty -= ted->ted_dirty;
 	ted->ted_dirty = 0;
-	spin_unlock(&tgd->tgd_grant_lock);
+	tgt_grant_unlock(tgd, exp, false);
 }
 EXPORT_SYMBOL(tgt_grant_discard);
 
@@ -1127,8 +1268,9 @@ void tgt_grant_prepare_read(const struct lu_env *env,
 		 * statfs information. */
 		tgt_grant_statfs(env, exp, 1, NULL);
 
-		/* protect all grant counters */
-		spin_lock(&tgd->tgd_grant_lock);
+		/* protect grant counters of this export, shrinking only
+		 * releases space so a lazy fold of the others is fine */
+		tgt_grant_lock(tgd, exp, false);
 
 		/* Grab free space from cached statfs data and take out space
 		 * already granted to clients as well as reserved space */
@@ -1141,13 +1283,14 @@ void tgt_grant_prepare_read(const struct lu_env *env,
 		 * since we don't grant space back on reads, no point
 		 * in running statfs, so just skip it and process
 		 * incoming grant data directly. */
-		spin_lock(&tgd->tgd_grant_lock);
+		tgt_grant_lock(tgd, exp, false);
 		do_shrink = 0;
 	}
 
 	/* extract incoming grant information provided by the client and
 	 * inflate grant counters if required */
-	tgt_grant_incoming(env, exp, oa, tgt_grant_chunk(exp, lut, NULL));
+	tgt_grant_incoming(env, exp, oa, tgt_grant_chunk(exp, lut, NULL),
+			   false);
 
 	/* unlike writes, we don't return grants back on reads unless a grant
 	 * shrink request was packed and we decided to turn it down. */
@@ -1158,7 +1301,7 @@ void tgt_grant_prepare_read(const struct lu_env *env,
 
 	if (!exp_grant_param_supp(exp))
 		oa->o_grant = tgt_grant_deflate(tgd, oa->o_grant);
-	spin_unlock(&tgd->tgd_grant_lock);
+	tgt_grant_unlock(tgd, exp, false);
 	EXIT;
 }
 EXPORT_SYMBOL(tgt_grant_prepare_read);
@@ -1177,6 +1320,9 @@ EXPORT_SYMBOL(tgt_grant_prepare_read);
  * the backend storage. This function works in pair with tgt_grant_commit()
  * which must be invoked once all buffers have been written to disk in order
  * to release space from the pending grant counter.
+ * Only the grant lock of the export home CPT is taken as long as there is
+ * plenty of ungranted space, all grant locks are taken once it runs low so
+ * that ENOSPC decisions are made against exact totals.
  *
  * \param[in] env	LU environment provided by the caller
  * \param[in] exp	export of the client which sent the request
@@ -1195,14 +1341,15 @@ void tgt_grant_prepare_write(const struct lu_env *env,
 	int			 from_cache;
 	int			 force = 0; /* can use cached data intially */
 	long			 chunk = tgt_grant_chunk(exp, lut, NULL);
+	bool			 global = false;
 
 	ENTRY;
 
 refresh:
 	/* get statfs information from OSD layer */
 	tgt_grant_statfs(env, exp, force, &from_cache);
-
-	spin_lock(&tgd->tgd_grant_lock); /* protect all grant counters */
+relock:
+	tgt_grant_lock(tgd, exp, global); /* protect grant counters */
 
 	/* Grab free space from cached statfs data and take out space already
 	 * granted to clients as well as reserved space */
@@ -1210,13 +1357,21 @@ refresh:
 
 	/* Get fresh statfs data if we are short in ungranted space */
 	if (from_cache && left < 32 * chunk) {
-		spin_unlock(&tgd->tgd_grant_lock);
+		tgt_grant_unlock(tgd, exp, global);
 		CDEBUG(D_CACHE, "%s: fs has no space left and statfs too old\n",
 		       obd->obd_name);
 		force = 1;
 		goto refresh;
 	}
 
+	/* Space is getting short, the lazy fold done above is not accurate
+	 * enough any more. Take all grant locks to account it exactly */
+	if (!global && left < TGT_GRANT_GLOBAL_LIMIT(tgd, chunk)) {
+		tgt_grant_unlock(tgd, exp, global);
+		global = true;
+		goto relock;
+	}
+
 	/* When close to free space exhaustion, trigger a sync to force
 	 * writeback cache to consume required space immediately and release as
 	 * much space as possible. */
@@ -1234,7 +1389,7 @@ refresh:
 		if (!from_grant) {
 			/* at least one network buffer requires acquiring grant
 			 * space on the server */
-			spin_unlock(&tgd->tgd_grant_lock);
+			tgt_grant_unlock(tgd, exp, global);
 			/* discard errors, at least we tried ... */
 			dt_sync(env, lut->lut_bottom);
 			force = 2;
@@ -1244,13 +1399,15 @@ refresh:
 
 	/* extract incoming grant information provided by the client,
 	 * and inflate grant counters if required */
-	tgt_grant_incoming(env, exp, oa, chunk);
+	tgt_grant_incoming(env, exp, oa, chunk, global);
 
-	/* check limit */
-	tgt_grant_check(env, exp, oa, rnb, niocount, &left);
+	/* check limit. Without the exclusive lock, sync writes homed on other
+	 * CPTs may consume the same space concurrently, but that is at most
+	 * one RPC per CPT and well below TGT_GRANT_GLOBAL_LIMIT() */
+	tgt_grant_check(env, exp, oa, rnb, niocount, &left, global);
 
 	if (!(oa->o_valid & OBD_MD_FLGRANT)) {
-		spin_unlock(&tgd->tgd_grant_lock);
+		tgt_grant_unlock(tgd, exp, global);
 		RETURN_EXIT;
 	}
 
@@ -1262,11 +1419,11 @@ refresh:
 	else
 		/* grant more space back to the client if possible */
 		oa->o_grant = tgt_grant_alloc(exp, oa->o_grant, oa->o_undirty,
-					      left, chunk, true);
+					      left, chunk, true, global);
 
 	if (!exp_grant_param_supp(exp))
 		oa->o_grant = tgt_grant_deflate(tgd, oa->o_grant);
-	spin_unlock(&tgd->tgd_grant_lock);
+	tgt_grant_unlock(tgd, exp, global);
 	EXIT;
 }
 EXPORT_SYMBOL(tgt_grant_prepare_write);
@@ -1293,6 +1450,7 @@ long tgt_grant_create(const struct lu_env *env, struct obd_export *exp, s64 *nr)
 {
 	struct lu_target	*lut = exp->exp_obd->u.obt.obt_lut;
 	struct tg_grants_data	*tgd = &lut->lut_tgd;
+	struct tg_grants_pcpt	*tgp;
 	struct tg_export_data	*ted = &exp->exp_target_data;
 	u64			 left = 0;
 	unsigned long		 wanted;
@@ -1307,14 +1465,16 @@ long tgt_grant_create(const struct lu_env *env, struct obd_export *exp, s64 *nr)
 	/* Update statfs data if required */
 	tgt_grant_statfs(env, exp, 1, NULL);
 
-	/* protect all grant counters */
-	spin_lock(&tgd->tgd_grant_lock);
+	/* protect all grant counters, precreation is rare enough and space
+	 * taken out of the ungranted pool has to be accounted exactly */
+	tgt_grant_lock(tgd, exp, true);
+	tgp = tgt_grant_pcpt(tgd, exp);
 
 	/* fail precreate request if there is not enough blocks available for
 	 * writing */
 	if (tgd->tgd_osfs.os_bavail - (ted->ted_grant >> tgd->tgd_blockbits) <
 	    (tgd->tgd_osfs.os_blocks >> 10)) {
-		spin_unlock(&tgd->tgd_grant_lock);
+		tgt_grant_unlock(tgd, exp, true);
 		CDEBUG(D_RPCTRACE, "%s: not enough space for create %llu\n",
 		       exp->exp_obd->obd_name,
 		       tgd->tgd_osfs.os_bavail * tgd->tgd_osfs.os_blocks);
@@ -1336,7 +1496,7 @@ long tgt_grant_create(const struct lu_env *env, struct obd_export *exp, s64 *nr)
 		if (*nr == 0) {
 			/* we really have no space any more for precreation,
 			 * fail the precreate request with ENOSPC */
-			spin_unlock(&tgd->tgd_grant_lock);
+			tgt_grant_unlock(tgd, exp, true);
 			RETURN(-ENOSPC);
 		}
 		/* compute space needed for the new number of creations */
@@ -1349,13 +1509,13 @@ long tgt_grant_create(const struct lu_env *env, struct obd_export *exp, s64 *nr)
 		ted->ted_grant -= wanted;
 	} else {
 		/* we need to take some space from the ungranted pool */
-		tgd->tgd_tot_granted += wanted - ted->ted_grant;
+		tgp->tgp_tot_granted += wanted - ted->ted_grant;
 		left -= wanted - ted->ted_grant;
 		ted->ted_grant = 0;
 	}
 	granted = wanted;
 	ted->ted_pending += granted;
-	tgd->tgd_tot_pending += granted;
+	tgp->tgp_tot_pending += granted;
 
 	/* grant more space for precreate purpose if possible. */
 	wanted = OST_MAX_PRECREATE * lut->lut_dt_conf.ddp_inodespace / 2;
@@ -1367,9 +1527,9 @@ long tgt_grant_create(const struct lu_env *env, struct obd_export *exp, s64 *nr)
 		chunk = tgt_grant_chunk(exp, lut, NULL);
 		wanted -= ted->ted_grant;
 		tgt_grant_alloc(exp, ted->ted_grant, wanted, left, chunk,
-				false);
+				false, true);
 	}
-	spin_unlock(&tgd->tgd_grant_lock);
+	tgt_grant_unlock(tgd, exp, true);
 	RETURN(granted);
 }
 EXPORT_SYMBOL(tgt_grant_create);
@@ -1387,6 +1547,7 @@ void tgt_grant_commit(struct obd_export *exp, unsigned long pending,
 		      int rc)
 {
 	struct tg_grants_data *tgd = &exp->exp_obd->u.obt.obt_lut->lut_tgd;
+	struct tg_grants_pcpt *tgp = tgt_grant_pcpt(tgd, exp);
 
 	ENTRY;
 
@@ -1395,7 +1556,7 @@ void tgt_grant_commit(struct obd_export *exp, unsigned long pending,
 	if (pending == 0)
 		RETURN_EXIT;
 
-	spin_lock(&tgd->tgd_grant_lock);
+	tgt_grant_lock(tgd, exp, false);
 	/* Don't update statfs data for errors raised before commit (e.g.
 	 * bulk transfer failed, ...) since we know those writes have not been
 	 * processed. For other errors hit during commit, we cannot really tell
@@ -1419,29 +1580,29 @@ void tgt_grant_commit(struct obd_export *exp, unsigned long pending,
 		CERROR("%s: cli %s/%p ted_pending(%lu) < grant_used(%lu)\n",
 		       exp->exp_obd->obd_name, exp->exp_client_uuid.uuid, exp,
 		       exp->exp_target_data.ted_pending, pending);
-		spin_unlock(&tgd->tgd_grant_lock);
+		tgt_grant_unlock(tgd, exp, false);
 		LBUG();
 	}
 	exp->exp_target_data.ted_pending -= pending;
 
-	if (tgd->tgd_tot_granted < pending) {
+	if (tgp->tgp_tot_granted < pending) {
 		CERROR("%s: cli %s/%p tot_granted(%llu) < grant_used(%lu)\n",
 		       exp->exp_obd->obd_name, exp->exp_client_uuid.uuid, exp,
-		       tgd->tgd_tot_granted, pending);
-		spin_unlock(&tgd->tgd_grant_lock);
+		       tgp->tgp_tot_granted, pending);
+		tgt_grant_unlock(tgd, exp, false);
 		LBUG();
 	}
-	tgd->tgd_tot_granted -= pending;
+	tgp->tgp_tot_granted -= pending;
 
-	if (tgd->tgd_tot_pending < pending) {
+	if (tgp->tgp_tot_pending < pending) {
 		CERROR("%s: cli %s/%p tot_pending(%llu) < grant_used(%lu)\n",
 		       exp->exp_obd->obd_name, exp->exp_client_uuid.uuid, exp,
-		       tgd->tgd_tot_pending, pending);
-		spin_unlock(&tgd->tgd_grant_lock);
+		       tgp->tgp_tot_pending, pending);
+		tgt_grant_unlock(tgd, exp, false);
 		LBUG();
 	}
-	tgd->tgd_tot_pending -= pending;
-	spin_unlock(&tgd->tgd_grant_lock);
+	tgp->tgp_tot_pending -= pending;
+	tgt_grant_unlock(tgd, exp, false);
 	EXIT;
 }
 EXPORT_SYMBOL(tgt_grant_commit);
@@ -1532,10 +1693,12 @@ int tgt_tot_dirty_seq_show(struct seq_file *m, void *data)
 {
 	struct obd_device *obd = m->private;
 	struct tg_grants_data *tgd;
+	u64 tot;
 
 	LASSERT(obd != NULL);
 	tgd = &obd->u.obt.obt_lut->lut_tgd;
-	seq_printf(m, "%llu\n", tgd->tgd_tot_dirty);
+	tgt_grant_totals(tgd, &tot, NULL, NULL);
+	seq_printf(m, "%llu\n", tot);
 	return 0;
 }
 EXPORT_SYMBOL(tgt_tot_dirty_seq_show);
@@ -1553,10 +1716,12 @@ int tgt_tot_granted_seq_show(struct seq_file *m, void *data)
 {
 	struct obd_device *obd = m->private;
 	struct tg_grants_data *tgd;
+	u64 tot;
 
 	LASSERT(obd != NULL);
 	tgd = &obd->u.obt.obt_lut->lut_tgd;
-	seq_printf(m, "%llu\n", tgd->tgd_tot_granted);
+	tgt_grant_totals(tgd, NULL, &tot, NULL);
+	seq_printf(m, "%llu\n", tot);
 	return 0;
 }
 EXPORT_SYMBOL(tgt_tot_granted_seq_show);
@@ -1574,10 +1739,12 @@ int tgt_tot_pending_seq_show(struct seq_file *m, void *data)
 {
 	struct obd_device *obd = m->private;
 	struct tg_grants_data *tgd;
+	u64 tot;
 
 	LASSERT(obd != NULL);
 	tgd = &obd->u.obt.obt_lut->lut_tgd;
-	seq_printf(m, "%llu\n", tgd->tgd_tot_pending);
+	tgt_grant_totals(tgd, NULL, NULL, &tot);
+	seq_printf(m, "%llu\n", tot);
 	return 0;
 }
 EXPORT_SYMBOL(tgt_tot_pending_seq_show);
@@ -1554,14 +1554,77 @@ int tgt_io_thread_init(struct ptlrpc_thread *thread)
 	LASSERT(thread != NULL);
 	LASSERT(thread->t_data == NULL);
 
-	OBD_ALLOC_LARGE(tbc, sizeof(*tbc));
+	OBD_ALLOC_PTR(tbc);
 	if (tbc == NULL)
 		RETURN(-ENOMEM);
+
+	tbc->tbc_max_pages = DT_DEF_BRW_SIZE >> PAGE_SHIFT;
+	OBD_ALLOC_LARGE(tbc->local, tbc->tbc_max_pages * sizeof(*tbc->local));
+	if (tbc->local == NULL) {
+		OBD_FREE_PTR(tbc);
+		RETURN(-ENOMEM);
+	}
 	thread->t_data = tbc;
 	RETURN(0);
 }
 EXPORT_SYMBOL(tgt_io_thread_init);
 
+/**
+ * Make sure the per-thread niobuf_local array can hold all pages touched by
+ * the remote niobufs of a BRW request.
+ *
+ * Requests up to DT_DEF_BRW_SIZE never reallocate; larger ones (negotiated
+ * through ocd_brw_size) grow the array once per thread.
+ *
+ * \param[in] tbc	per-thread big cache
+ * \param[in] objcount	number of objects in \a ioo
+ * \param[in] ioo	objects the request is for
+ * \param[in] rnb	remote niobufs of the request, for all objects
+ *
+ * \retval 0		on success
+ * \retval -EPROTO	request spans more than PTLRPC_MAX_BRW_PAGES
+ * \retval -ENOMEM	reallocation failed
+ */
+static int tgt_big_cache_reserve(struct tgt_thread_big_cache *tbc,
+				 int objcount, struct obd_ioobj *ioo,
+				 struct niobuf_remote *rnb)
+{
+	struct niobuf_local *local;
+	int niocount = 0;
+	int npages = 0;
+	int size;
+	int i;
+
+	for (i = 0; i < objcount; i++)
+		niocount += ioo[i].ioo_bufcnt;
+
+	for (i = 0; i < niocount; i++) {
+		if (rnb[i].rnb_len == 0)
+			continue;
+		npages += ((rnb[i].rnb_offset + rnb[i].rnb_len - 1) >>
+			   PAGE_SHIFT) - (rnb[i].rnb_offset >> PAGE_SHIFT) + 1;
+		if (npages > PTLRPC_MAX_BRW_PAGES)
+			return -EPROTO;
+	}
+
+	if (likely(npages <= tbc->tbc_max_pages))
+		return 0;
+
+	/* round up to the next power of two to avoid repeated growing */
+	size = roundup_pow_of_two(npages);
+	if (size > PTLRPC_MAX_BRW_PAGES)
+		size = PTLRPC_MAX_BRW_PAGES;
+
+	OBD_ALLOC_LARGE(local, size * sizeof(*local));
+	if (local == NULL)
+		return -ENOMEM;
+
+	OBD_FREE_LARGE(tbc->local, tbc->tbc_max_pages * sizeof(*tbc->local));
+	tbc->local = local;
+	tbc->tbc_max_pages = size;
+	return 0;
+}
+
 /*
  * free per-thread pool created by tgt_thread_init().
  */
@@ -1579,7 +1642,9 @@ void tgt_io_thread_done(struct ptlrpc_thread *thread)
 	 */
 	tbc = thread->t_data;
 	if (tbc != NULL) {
-		OBD_FREE_LARGE(tbc, sizeof(*tbc));
+		OBD_FREE_LARGE(tbc->local,
+			       tbc->tbc_max_pages * sizeof(*tbc->local));
+		OBD_FREE_PTR(tbc);
 		thread->t_data = NULL;
 	}
 	EXIT;
@@ -2156,6 +2221,9 @@ int tgt_brw_read(struct tgt_session_info *tsi)
 	remote_nb = req_capsule_client_get(&req->rq_pill, &RMF_NIOBUF_REMOTE);
 	LASSERT(remote_nb != NULL); /* must exists after tgt_ost_body_unpack */
 
+	rc = tgt_big_cache_reserve(tbc, 1, ioo, remote_nb);
+	if (rc != 0)
+		RETURN(rc);
 	local_nb = tbc->local;
 
 	rc = tgt_brw_lock(exp, &tsi->tsi_resid, ioo, remote_nb, &lockh,
@@ -2180,7 +2248,7 @@ int tgt_brw_read(struct tgt_session_info *tsi)
 	repbody = req_capsule_server_get(&req->rq_pill, &RMF_OST_BODY);
 	repbody->oa = body->oa;
 
-	npages = PTLRPC_MAX_BRW_PAGES;
+	npages = tbc->tbc_max_pages;
 	rc = obd_preprw(tsi->tsi_env, OBD_BRW_READ, exp, &repbody->oa, 1,
 			ioo, remote_nb, &npages, local_nb);
 	if (rc != 0)
@@ -2494,6 +2562,9 @@ int tgt_brw_write(struct tgt_session_info *tsi)
 	CFS_FAIL_TIMEOUT(OBD_FAIL_OST_BRW_PAUSE_PACK, cfs_fail_val);
 	rcs = req_capsule_server_get(&req->rq_pill, &RMF_RCS);
 
+	rc = tgt_big_cache_reserve(tbc, objcount, ioo, remote_nb);
+	if (rc != 0)
+		GOTO(out, rc);
 	local_nb = tbc->local;
 
 	rc = tgt_brw_lock(exp, &tsi->tsi_resid, ioo, remote_nb, &lockh,
@@ -2529,7 +2600,7 @@ int tgt_brw_write(struct tgt_session_info *tsi)
 		GOTO(out_lock, rc = -ENOMEM);
 	repbody->oa = body->oa;
 
-	npages = PTLRPC_MAX_BRW_PAGES;
+	npages = tbc->tbc_max_pages;
 	rc = obd_preprw(tsi->tsi_env, OBD_BRW_WRITE, exp, &repbody->oa,
 			objcount, ioo, remote_nb, &npages, local_nb);
 	if (rc < 0)
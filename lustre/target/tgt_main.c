@@ -201,10 +201,13 @@ int tgt_init(const struct lu_env *env, struct lu_target *lut,
 	tgd->tgd_osfs_inflight = 0;
 
 	/* grant data */
-	spin_lock_init(&tgd->tgd_grant_lock);
-	tgd->tgd_tot_dirty = 0;
-	tgd->tgd_tot_granted = 0;
-	tgd->tgd_tot_pending = 0;
+	tgd->tgd_grant_lock = cfs_percpt_lock_alloc(cfs_cpt_tab);
+	if (tgd->tgd_grant_lock == NULL)
+		GOTO(out_put, rc = -ENOMEM);
+	tgd->tgd_pcpt = cfs_percpt_alloc(cfs_cpt_tab, sizeof(**tgd->tgd_pcpt));
+	if (tgd->tgd_pcpt == NULL)
+		GOTO(out_put, rc = -ENOMEM);
+	atomic_set(&tgd->tgd_tot_granted_clients, 0);
 	tgd->tgd_grant_compat_disable = 0;
 
 	/* populate cached statfs data */
@@ -227,7 +230,7 @@ int tgt_init(const struct lu_env *env, struct lu_target *lut,
 
 	OBD_ALLOC(lut->lut_client_bitmap, LR_MAX_CLIENTS >> 3);
 	if (lut->lut_client_bitmap == NULL)
-		RETURN(-ENOMEM);
+		GOTO(out_put, rc = -ENOMEM);
 
 	memset(&attr, 0, sizeof(attr));
 	attr.la_valid = LA_MODE;
@@ -320,6 +323,7 @@ out_put:
 			 LUT_REPLY_SLOTS_MAX_CHUNKS * sizeof(unsigned long *));
 	}
 	lut->lut_reply_bitmap = NULL;
+	tgt_grant_fini(tgd);
 	return rc;
 }
 EXPORT_SYMBOL(tgt_init);
@@ -368,6 +372,7 @@ void tgt_fini(const struct lu_env *env, struct lu_target *lut)
 		dt_object_put(env, lut->lut_last_rcvd);
 		lut->lut_last_rcvd = NULL;
 	}
+	/* grant data is released by tgt_grant_fini() after procfs cleanup */
 	EXIT;
 }
 EXPORT_SYMBOL(tgt_fini);
@@ -181,6 +181,67 @@ test_smoke () {
 }
 run_test smoke "lst regression test"
 
+# make batch writing from this node to one of its own NIDs
+test_local_nid_sub () {
+	local nid=$1
+
+	echo '#!/bin/bash'
+	echo 'set -e'
+
+	echo "$LST new_session --timeo 100000 hh"
+	echo "$LST add_group c $nid"
+	echo "$LST add_group s $nid"
+	echo "$LST add_batch b"
+	echo -n "$LST add_test --batch b --loop $lst_LOOP --concurrency 8"
+	echo " --from c --to s brw write check=full size=1M"
+	echo "$LST run b"
+	echo sleep 1
+	echo "$LST stat --bw --delay 5 --count 2 s"
+	echo "$LST stop b"
+	echo "$LST end_session"
+}
+
+test_local_nid () {
+	local param=/sys/module/lnet/parameters/local_nid_loopback
+	local addr=$(host_nids_address $HOSTNAME $NETTYPE | head -n 1)
+	local runlst=$TMP/local_nid.sh
+	local saved
+	local log
+	local rc
+	local lo
+
+	[ -n "$addr" ] || skip_env "no $NETTYPE NID on $HOSTNAME"
+
+	lst_prepare
+	[ -f $param ] || { lst_cleanup_all; skip "no $param"; }
+	saved=$(cat $param)
+
+	test_local_nid_sub $(nids_list $addr) > $runlst
+	cat $runlst
+
+	# bandwidth to our own NID through lolnd, then through the real LND
+	for lo in 1 0; do
+		echo $lo > $param
+		log=$TMP/$tfile.$lo.log
+
+		run_lst $runlst | tee $log
+		rc=${PIPESTATUS[0]}
+		if [ $rc != 0 ]; then
+			echo $saved > $param
+			_restore_mount
+			error "$runlst with local_nid_loopback=$lo failed: $rc"
+		fi
+	done
+	echo $saved > $param
+
+	for lo in 1 0; do
+		echo "local_nid_loopback=$lo:"
+		grep '^\[[RW]\]' $TMP/$tfile.$lo.log | tail -n 2
+	done
+	lst_cleanup_all
+}
+run_test local_nid "lst to a local NID with and without the loopback NI"
+
 complete $SECONDS
 _restore_mount
 check_and_cleanup_lustre
@@ -4692,6 +4692,32 @@ test_121() {
 }
 run_test 121 "lock replay timed out and race"
 
+test_122() {
+	local mdtname="mdt.$FSNAME-MDT0000"
+	local status
+	local count=200
+
+	mkdir -p $DIR/$tdir || error "mkdir $DIR/$tdir failed"
+	replay_barrier $SINGLEMDS
+	createmany -o $DIR/$tdir/$tfile- $count ||
+		error "createmany -o $DIR/$tdir/$tfile- failed"
+	fail $SINGLEMDS
+
+	status=$(do_facet $SINGLEMDS $LCTL get_param -n $mdtname.recovery_status)
+	echo "$status"
+	echo "$status" | grep -q "phase_request_replay_ms:" ||
+		error "no request replay phase in recovery_status"
+	echo "$status" | grep -q "replay_rate:" ||
+		error "no replay rate in recovery_status"
+	local replayed=$(echo "$status" | awk '/replayed_requests:/ { print $2 }')
+	(( replayed >= count )) ||
+		error "replayed $replayed requests, expected at least $count"
+
+	unlinkmany $DIR/$tdir/$tfile- $count ||
+		error "unlinkmany $DIR/$tdir/$tfile- failed"
+}
+run_test 122 "pipelined request replay and recovery phase statistics"
+
 complete $SECONDS
 check_and_cleanup_lustre
 exit_status
@@ -7878,6 +7878,35 @@ test_101g() {
 }
 run_test 101g "Big bulk(4/16 MiB) readahead"
 
+test_101h() {
+	remote_ost_nodsh && skip "remote OST with nodsh"
+
+	local osts=$(get_facets OST)
+	local list=$(comma_list $(osts_nodes))
+	local p="$TMP/$TESTSUITE-$TESTNAME.parameters"
+	local brw_size="obdfilter.*.brw_size"
+
+	$LFS setstripe -i 0 -c 1 $DIR/$tfile
+
+	save_lustre_params $osts "$brw_size" > $p
+	do_nodes $list $LCTL set_param -n $brw_size=64M ||
+		{ rm -f $p; skip "OST does not support 64MB RPCs"; }
+	stack_trap "restore_lustre_params < $p; rm -f $p; \
+		    remount_client $MOUNT" EXIT
+
+	echo "remount client to enable new RPC size"
+	remount_client $MOUNT || error "remount_client failed"
+
+	local max_brw=$($LCTL get_param osc.$FSNAME-OST0000-osc-[^mM]*.import |
+			awk '/max_brw_size/ { print $2 }')
+	[[ $max_brw -ge $((64 * 1048576)) ]] ||
+		skip "client negotiated max_brw_size $max_brw < 64MB"
+
+	test_101g_brw_size_test 64 || error "64MB RPC test failed"
+	test_101g_brw_size_test 16 || error "16MB RPC test failed"
+}
+run_test 101h "Big bulk(64 MiB) read/write with more bulk MDs per RPC"
+
 setup_test102() {
 	test_mkdir $DIR/$tdir
 	chown $RUNAS_ID $DIR/$tdir
@@ -11107,6 +11136,9 @@ test_134a() {
 	createmany -o $DIR/$tdir/f $nr ||
 		error "failed to create $nr files in $DIR/$tdir"
 	unused=$($LCTL get_param -n $nsdir.lock_unused_count)
+	local reclaimed=$(do_facet mds1 $LCTL get_param -n \
+			  ldlm.lock_reclaim_stats 2>/dev/null |
+			  awk '/^locks:/ { print $2 }')
 
 	#define OBD_FAIL_LDLM_WATERMARK_LOW     0x327
 	do_facet mds1 $LCTL set_param fail_loc=0x327
@@ -11122,6 +11154,17 @@ test_134a() {
 	[ $lck_cnt -lt $unused ] ||
 		error "No locks reclaimed, before:$unused, after:$lck_cnt"
 
+	# reclaim statistics are only available on newer servers
+	if [ -n "$reclaimed" ]; then
+		local after=$(do_facet mds1 $LCTL get_param -n \
+			      ldlm.lock_reclaim_stats |
+			      awk '/^locks:/ { print $2 }')
+
+		do_facet mds1 $LCTL get_param ldlm.lock_reclaim_stats
+		[ $after -gt $reclaimed ] ||
+			error "reclaim stats not updated: $reclaimed/$after"
+	fi
+
 	rm $DIR/$tdir/m
 	unlinkmany $DIR/$tdir/f $nr
 }
@@ -16457,6 +16500,62 @@ test_255c() {
 }
 run_test 255c "suite of ladvise lockahead tests"
 
+test_255d() {
+	[ $(lustre_version_code ost1) -lt $(version_code 2.10.50) ] &&
+		skip "lustre < 2.10.53 does not support lockahead"
+
+	local depth=$($LCTL get_param -n llite.*.lockahead_depth | head -n1)
+	local cmd="O"
+	local auto
+	local granted
+	local extents
+	local ext
+	local i
+
+	[ -n "$depth" ] || skip "no automatic lockahead on this client"
+	stack_trap "$LCTL set_param llite.*.lockahead_depth=$depth" EXIT
+	$LCTL set_param llite.*.lockahead_depth=4
+
+	$SETSTRIPE -c 1 -i 0 $DIR/$tfile || error "setstripe failed"
+	cancel_lru_locks osc
+	$LCTL set_param llite.*.stats=clear osc.*.osc_stats=clear
+	stack_trap "$LCTL set_param debug=\"$($LCTL get_param -n debug)\"" EXIT
+	$LCTL set_param debug=+vfstrace
+	$LCTL clear
+
+	# 4KiB writes every 16KiB through one file descriptor
+	for ((i = 0; i < 8; i++)); do
+		cmd+="z$((i * 16384))w4096"
+	done
+	$MULTIOP $DIR/$tfile ${cmd}c || error "multiop $cmd failed"
+	# lockahead replies are handled asynchronously
+	sleep 1
+
+	# the locks asked for must cover the next writes of this writer,
+	# [16KiB * n, 16KiB * n + 4KiB), not the gaps owned by other writers
+	extents=$($LCTL dk | awk -F'[][, ]+' -v f="$tfile:" \
+		  '$0 ~ f" lockahead .* requested" {
+			for (i = 1; i < NF; i++)
+				if ($i == "lockahead")
+					print $(i + 1)":"$(i + 2) }')
+	[ -n "$extents" ] || error "no lockahead extents in the debug log"
+	for ext in $extents; do
+		(( ${ext%:*} % 16384 == 0 &&
+		   ${ext#*:} == ${ext%:*} + 4095 &&
+		   ${ext%:*} >= 16384 )) ||
+			error "lockahead extent ${ext/:/-} is not a next stride"
+	done
+
+	auto=$($LCTL get_param -n llite.*.stats |
+	       awk '/lockahead_auto/ { print $2 }')
+	granted=$($LCTL get_param -n osc.*.osc_stats |
+		  awk '/lockahead_granted/ { sum += $2 } END { print sum }')
+	echo "lockahead requests $auto, granted $granted"
+	(( ${auto:-0} > 0 )) || error "no automatic lockahead requests"
+	(( ${granted:-0} > 0 )) || error "no lockahead locks granted"
+}
+run_test 255d "automatic lockahead for strided writes"
+
 test_256() {
 	[ $PARALLEL == "yes" ] && skip "skip parallel run"
 	remote_mds_nodsh && skip "remote MDS with nodsh"
@@ -18937,6 +19036,124 @@ test_415() {
 }
 run_test 415 "lock revoke is not missing"
 
+test_416() {
+	local queued
+
+	dd if=/dev/zero of=$DIR/$tfile bs=1M count=16 || error "dd failed"
+	sync
+	$LCTL get_param -n ptlrpcd_stats || error "cannot read ptlrpcd_stats"
+	queued=$($LCTL get_param -n ptlrpcd_stats |
+		 awk 'NR > 1 { sum += $3 } END { print sum }')
+	[ ${queued:-0} -gt 0 ] || error "no requests queued to ptlrpcd"
+	rm -f $DIR/$tfile
+}
+run_test 416 "ptlrpcd per-thread queue statistics"
+
+test_417() {
+	local osc="osc.$FSNAME-OST0000-osc-[^mM]*"
+	local orig=$($LCTL get_param -n $osc.max_rpcs_in_flight)
+	local max
+
+	$LCTL set_param $osc.max_rpcs_in_flight_auto=1 ||
+		skip "automatic max_rpcs_in_flight not supported"
+	stack_trap "$LCTL set_param $osc.max_rpcs_in_flight_auto=0 \
+		$osc.max_rpcs_in_flight_auto_max=256 \
+		$osc.max_rpcs_in_flight=$orig" EXIT
+	$LCTL set_param $osc.max_rpcs_in_flight_auto_max=16
+
+	$LFS setstripe -c 1 -i 0 $DIR/$tfile
+	dd if=/dev/zero of=$DIR/$tfile bs=4M count=64 oflag=direct ||
+		error "dd failed"
+	$LCTL get_param $osc.rpcs_in_flight_auto_history
+
+	max=$($LCTL get_param -n $osc.max_rpcs_in_flight)
+	[ $max -le 16 ] || error "max_rpcs_in_flight $max > 16"
+	rm -f $DIR/$tfile
+}
+run_test 417 "automatic max_rpcs_in_flight stays within bounds"
+
+test_418() {
+	local osc="osc.$FSNAME-OST0000-osc-[^mM]*"
+	local nlocks=8
+	local bl1
+	local bl2
+	local i
+
+	$LCTL get_param -n $osc.connect_flags | grep -q batch_ast ||
+		skip "OST does not support batched blocking ASTs"
+
+	$LFS setstripe -c 1 -i 0 $DIR/$tfile || error "setstripe failed"
+	cancel_lru_locks osc
+	# separate read locks on one object, all conflicting with the write
+	for ((i = 0; i < nlocks; i++)); do
+		$LFS ladvise -a lockahead -m READ -s $((i * 2))M -l 1M \
+			$DIR/$tfile || error "lockahead $i failed"
+	done
+
+	bl1=$($LCTL get_param -n ldlm.services.ldlm_cbd.stats |
+	      awk '/ldlm_bl_callback/ {print $2}')
+	dd if=/dev/zero of=$DIR/$tfile bs=$((nlocks * 2))M count=1 \
+		conv=notrunc || error "dd failed"
+	bl2=$($LCTL get_param -n ldlm.services.ldlm_cbd.stats |
+	      awk '/ldlm_bl_callback/ {print $2}')
+	echo "$((bl2 - bl1)) blocking AST RPCs for $nlocks locks"
+	(( bl2 - bl1 < nlocks )) ||
+		error "$((bl2 - bl1)) blocking AST RPCs for $nlocks locks"
+	rm -f $DIR/$tfile
+}
+run_test 418 "blocking ASTs for many locks of one client are batched"
+
+test_419() {
+	local ns="ldlm.namespaces.$FSNAME-MDT0000-mdc-*"
+	local nhot=10
+	local ncold=400
+	local prot
+
+	$LCTL get_param -n $ns.lru_protected_count > /dev/null ||
+		skip "no segmented lock LRU"
+
+	test_mkdir -i 0 $DIR/$tdir
+	createmany -o $DIR/$tdir/hot- $nhot || error "create hot failed"
+	createmany -o $DIR/$tdir/cold- $ncold || error "create cold failed"
+	cancel_lru_locks mdc
+
+	stack_trap "lru_resize_enable mdc" EXIT
+	$LCTL set_param $ns.lru_size=$((ncold / 4))
+
+	# locks have to be found in the LRU twice to be protected
+	stat $DIR/$tdir/hot-* > /dev/null || error "stat hot failed"
+	stat $DIR/$tdir/hot-* > /dev/null || error "restat hot failed"
+	stat $DIR/$tdir/hot-* > /dev/null || error "restat hot failed"
+	# one-time scan overflowing the LRU
+	ls -l $DIR/$tdir > /dev/null || error "ls failed"
+
+	prot=$($LCTL get_param -n $ns.lru_protected_count)
+	$LCTL get_param $ns.lru_probation_count $ns.lru_hit_rate
+	(( prot > 0 )) || error "no protected locks after scan"
+}
+run_test 419 "reused locks survive a one-time scan in the lock LRU"
+
+test_420() {
+	local ns="ldlm.namespaces.mdt-$FSNAME-MDT0000_UUID"
+	local dl1
+	local dl2
+
+	do_facet mds1 $LCTL get_param -n $ns.stats > /dev/null ||
+		skip "no ldlm namespace stats"
+
+	dd if=/dev/zero of=$DIR/$tfile-1 bs=1K count=1
+	dd if=/dev/zero of=$DIR/$tfile-2 bs=1K count=1
+	dl1=$(do_facet mds1 $LCTL get_param -n $ns.stats |
+	      awk '/flock_deadlocks/ {print $2}')
+	flocks_test 4 $DIR/$tfile-1 $DIR/$tfile-2 || error "flocks_test failed"
+	dl2=$(do_facet mds1 $LCTL get_param -n $ns.stats |
+	      awk '/flock_deadlocks/ {print $2}')
+	do_facet mds1 $LCTL get_param $ns.stats | grep flock
+	(( ${dl2:-0} > ${dl1:-0} )) || error "deadlock not counted"
+	rm -f $DIR/$tfile-1 $DIR/$tfile-2
+}
+run_test 420 "flock deadlocks are counted in ldlm namespace stats"
+
 prep_801() {
 	[[ $(lustre_version_code mds1) -lt $(version_code 2.9.55) ]] ||
 	[[ $(lustre_version_code ost1) -lt $(version_code 2.9.55) ]] &&
@@ -4440,6 +4440,30 @@ test_101c() {
 }
 run_test 101c "Discard DoM data on close-unlink"
 
+test_102() {
+	local old_debug=$(do_facet ost1 $LCTL get_param -n debug)
+	local i
+
+	$LFS setstripe -c 1 -i 0 $DIR1/$tfile || error "setstripe failed"
+	# two clients writing interleaved 64KiB chunks of the same object
+	for ((i = 0; i < 16; i += 2)); do
+		dd if=/dev/zero of=$DIR1/$tfile bs=64k count=1 seek=$i \
+			conv=notrunc oflag=sync 2>/dev/null ||
+			error "dd on $DIR1 failed"
+		dd if=/dev/zero of=$DIR2/$tfile bs=64k count=1 seek=$((i + 1)) \
+			conv=notrunc oflag=sync 2>/dev/null ||
+			error "dd on $DIR2 failed"
+	done
+
+	do_facet ost1 $LCTL set_param debug=+dlmtrace
+	do_facet ost1 $LCTL clear
+	do_facet ost1 $LCTL set_param -n ldlm.dump_namespaces ""
+	do_facet ost1 $LCTL dk | grep "Contention:" | grep -v "clients 0 " ||
+		error "no contention history on ost1"
+	do_facet ost1 $LCTL set_param debug="$old_debug"
+}
+run_test 102 "extent lock contention history of strided writers"
+
 log "cleanup: ======================================================"
 
 # kill and wait in each test only guarentee script finish, but command in script
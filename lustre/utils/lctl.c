@@ -130,9 +130,14 @@ command_t cmdlist[] = {
 	{"net_delay_add", jt_ptl_delay_add, 0, "Add LNet delay rule\n"
 	 "usage: net_delay_add <-s | --source NID>\n"
 	 "		       <-d | --dest NID>\n"
-	 "		       <<-r | --rate DROP_RATE> |\n"
+	 "		       <<-r | --rate DELAY_RATE> |\n"
 	 "			<-i | --interval SECONDS>>\n"
-	 "		       <-l | --latency SECONDS>\n"
+	 "		       <-l | --latency TIME[s|ms|us]>\n"
+	 "		       [<-j | --jitter> TIME[s|ms|us]]\n"
+	 "		       [<-D | --distribution> <uniform|normal|pareto>]\n"
+	 "		       [<-b | --bandwidth> BYTES_PER_SEC[K|M|G]]\n"
+	 "		       [<-B | --burst> BYTES[K|M|G]]\n"
+	 "		       [<-o | --reorder> REORDER_RATE]\n"
 	 "		       [<-p | --portal> PORTAL...]\n"
 	 "		       [<-m | --message> <PUT|ACK|GET|REPLY>...]\n"},
 	{"net_delay_del", jt_ptl_delay_del, 0, "remove LNet delay rule\n"
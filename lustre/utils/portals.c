@@ -1314,6 +1314,71 @@ fault_attr_ptl_parse(char *ptl_str, __u64 *mask_p)
 	return 0;
 }
 
+/* time with an optional unit of s (default), ms or us */
+static int
+fault_attr_time_parse(char *time_str, __u32 *usec_p)
+{
+	unsigned long long usec;
+	char *end;
+
+	usec = strtoull(time_str, &end, 0);
+	if (end == time_str)
+		goto failed;
+
+	if (*end == '\0' || !strcasecmp(end, "s"))
+		usec *= 1000000;
+	else if (!strcasecmp(end, "ms"))
+		usec *= 1000;
+	else if (strcasecmp(end, "us"))
+		goto failed;
+
+	if (usec > UINT_MAX)
+		goto failed;
+
+	*usec_p = usec;
+	return 0;
+failed:
+	fprintf(stderr, "invalid time: %s\n", time_str);
+	return -1;
+}
+
+static int
+fault_attr_dist_parse(char *dist_str, __u32 *dist_p)
+{
+	if (!strcasecmp(dist_str, "uniform")) {
+		*dist_p = LNET_DELAY_DIST_UNIFORM;
+		return 0;
+
+	} else if (!strcasecmp(dist_str, "normal")) {
+		*dist_p = LNET_DELAY_DIST_NORMAL;
+		return 0;
+
+	} else if (!strcasecmp(dist_str, "pareto")) {
+		*dist_p = LNET_DELAY_DIST_PARETO;
+		return 0;
+	}
+
+	fprintf(stderr, "unknown latency distribution %s\n", dist_str);
+	return -1;
+}
+
+/* size in bytes with an optional K/M/G/T suffix, converted to KiB */
+static int
+fault_attr_kib_parse(char *size_str, __u32 *kib_p)
+{
+	unsigned long long size;
+	unsigned long long units = 1;
+
+	if (llapi_parse_size(size_str, &size, &units, 0) != 0 ||
+	    size < 1024 || (size >> 10) > UINT_MAX) {
+		fprintf(stderr, "invalid size: %s\n", size_str);
+		return -1;
+	}
+
+	*kib_p = size >> 10;
+	return 0;
+}
+
 static int
 fault_attr_health_error_parse(char *error, __u32 *mask)
 {
@@ -1383,6 +1448,11 @@ fault_simul_rule_add(__u32 opc, char *name, int argc, char **argv)
 	{ .name = "portal",   .has_arg = required_argument, .val = 'p' },
 	{ .name = "message",  .has_arg = required_argument, .val = 'm' },
 	{ .name = "health_error",  .has_arg = required_argument, .val = 'e' },
+	{ .name = "jitter",   .has_arg = required_argument, .val = 'j' },
+	{ .name = "distribution", .has_arg = required_argument, .val = 'D' },
+	{ .name = "bandwidth", .has_arg = required_argument, .val = 'b' },
+	{ .name = "burst",    .has_arg = required_argument, .val = 'B' },
+	{ .name = "reorder",  .has_arg = required_argument, .val = 'o' },
 	{ .name = NULL } };
 
 	if (argc == 1) {
@@ -1391,7 +1461,8 @@ fault_simul_rule_add(__u32 opc, char *name, int argc, char **argv)
 		return -1;
 	}
 
-	optstr = opc == LNET_CTL_DROP_ADD ? "s:d:r:i:p:m:e:n" : "s:d:r:l:p:m:";
+	optstr = opc == LNET_CTL_DROP_ADD ? "s:d:r:i:p:m:e:n" :
+					    "s:d:r:i:l:p:m:j:D:b:B:o:";
 	memset(&attr, 0, sizeof(attr));
 	while (1) {
 		char c = getopt_long(argc, argv, optstr, opts, NULL);
@@ -1442,8 +1513,46 @@ fault_simul_rule_add(__u32 opc, char *name, int argc, char **argv)
 								   NULL, 0);
 			break;
 
-		case 'l': /* seconds to wait before activating rule */
-			attr.u.delay.la_latency = strtoul(optarg, NULL, 0);
+		case 'l': /* latency of delayed message */
+			rc = fault_attr_time_parse(optarg,
+						   &attr.u.delay.la_latency_us);
+			if (rc != 0)
+				goto getopt_failed;
+			/* NB: for kernel without la_latency_us */
+			attr.u.delay.la_latency = attr.u.delay.la_latency_us /
+						  1000000;
+			break;
+
+		case 'j': /* spread of latency */
+			rc = fault_attr_time_parse(optarg,
+						   &attr.u.delay.la_jitter_us);
+			if (rc != 0)
+				goto getopt_failed;
+			break;
+
+		case 'D': /* distribution of latency */
+			rc = fault_attr_dist_parse(optarg,
+						   &attr.u.delay.la_dist);
+			if (rc != 0)
+				goto getopt_failed;
+			break;
+
+		case 'b': /* bandwidth cap per second */
+			rc = fault_attr_kib_parse(optarg,
+						  &attr.u.delay.la_bandwidth);
+			if (rc != 0)
+				goto getopt_failed;
+			break;
+
+		case 'B': /* depth of token bucket */
+			rc = fault_attr_kib_parse(optarg,
+						  &attr.u.delay.la_burst);
+			if (rc != 0)
+				goto getopt_failed;
+			break;
+
+		case 'o': /* reorder rate */
+			attr.u.delay.la_reorder = strtoul(optarg, NULL, 0);
 			break;
 
 		case 'p': /* portal to filter */
@@ -1482,15 +1591,20 @@ fault_simul_rule_add(__u32 opc, char *name, int argc, char **argv)
 			return -1;
 		}
 	} else if (opc == LNET_CTL_DELAY_ADD) {
-		if (!((attr.u.delay.la_rate == 0) ^
-		      (attr.u.delay.la_interval == 0))) {
+		bool delay = attr.u.delay.la_rate != 0 ||
+			     attr.u.delay.la_interval != 0;
+
+		/* NB: bandwidth cap can work without delay rate/interval */
+		if ((attr.u.delay.la_rate != 0 &&
+		     attr.u.delay.la_interval != 0) ||
+		    (!delay && attr.u.delay.la_bandwidth == 0)) {
 			fprintf(stderr,
 				"please provide either delay rate or interval "
 				"but not both at the same time.\n");
 			return -1;
 		}
 
-		if (attr.u.delay.la_latency == 0) {
+		if (delay && attr.u.delay.la_latency_us == 0) {
 			fprintf(stderr, "latency cannot be zero\n");
 			return -1;
 		}
@@ -1708,20 +1822,39 @@ fault_simul_rule_list(__u32 opc, char *name, int argc, char **argv)
 			       (uintmax_t)stat.fs_reply);
 
 		} else if (opc == LNET_CTL_DELAY_LIST) {
-			printf("%s->%s (1/%d | %d, latency %d) ptl %#jx"
+			static const char * const dists[] = {
+				[LNET_DELAY_DIST_UNIFORM] = "uniform",
+				[LNET_DELAY_DIST_NORMAL] = "normal",
+				[LNET_DELAY_DIST_PARETO] = "pareto",
+			};
+			__u32 latency = attr.u.delay.la_latency_us;
+
+			if (latency == 0)
+				latency = attr.u.delay.la_latency * 1000000;
+
+			printf("%s->%s (1/%d | %d, latency %uus, jitter %uus "
+			       "%s, bandwidth %uKiB/s, burst %uKiB, "
+			       "reorder 1/%u) ptl %#jx"
 			       ", msg %x, %ju/%ju, PUT %ju"
-			       ", ACK %ju, GET %ju, REP %ju\n",
+			       ", ACK %ju, GET %ju, REP %ju"
+			       ", throttled %ju, reordered %ju\n",
 			       libcfs_nid2str(attr.fa_src),
 			       libcfs_nid2str(attr.fa_dst),
 			       attr.u.delay.la_rate, attr.u.delay.la_interval,
-			       attr.u.delay.la_latency,
+			       latency, attr.u.delay.la_jitter_us,
+			       attr.u.delay.la_dist < LNET_DELAY_DIST_MAX ?
+			       dists[attr.u.delay.la_dist] : "unknown",
+			       attr.u.delay.la_bandwidth,
+			       attr.u.delay.la_burst, attr.u.delay.la_reorder,
 			       (uintmax_t)attr.fa_ptl_mask, attr.fa_msg_mask,
 			       (uintmax_t)stat.u.delay.ls_delayed,
 			       (uintmax_t)stat.fs_count,
 			       (uintmax_t)stat.fs_put,
 			       (uintmax_t)stat.fs_ack,
 			       (uintmax_t)stat.fs_get,
-			       (uintmax_t)stat.fs_reply);
+			       (uintmax_t)stat.fs_reply,
+			       (uintmax_t)stat.u.delay.ls_throttled,
+			       (uintmax_t)stat.u.delay.ls_reordered);
 		}
 	}
 	printf("found total %d\n", pos);